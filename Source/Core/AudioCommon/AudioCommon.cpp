@@ -160,6 +160,7 @@ namespace AudioCommon
 		if (soundStream)
 		{
 			soundStream->GetMixer()->SetThrottle(SConfig::GetInstance().m_Framelimit == 2);
+			soundStream->GetMixer()->SetResamplerQuality((Resampler::Quality)SConfig::GetInstance().m_Resampler);
 			soundStream->SetVolume(SConfig::GetInstance().m_Volume);
 		}
 	}
@@ -2,10 +2,12 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include <algorithm>
+
 #include "AudioCommon/AudioCommon.h"
 #include "AudioCommon/Mixer.h"
-#include "Common/Atomic.h"
 #include "Common/CPUDetect.h"
+#include "Common/Timer.h"
 #include "Core/ConfigManager.h"
 #include "Core/Host.h"
 #include "Core/HW/AudioInterface.h"
@@ -18,43 +20,54 @@
 #include <tmmintrin.h>
 #endif
 
+// Each frame comes as two big endian samples, in the opposite order to the
+// one the backends want: reversing its four bytes fixes both.
+static void SwapFrames(u32* dest, const short* src, unsigned int count)
+{
+	unsigned int i = 0;
+#if _M_SSE >= 0x301 && !(defined __GNUC__ && !defined __SSSE3__)
+	if (cpu_info.bSSSE3)
+	{
+		const __m128i mask = _mm_set_epi8(12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+		for (; i + 4 <= count; i += 4)
+			_mm_storeu_si128((__m128i*)&dest[i], _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)&src[i * 2]), mask));
+	}
+#endif
+	for (; i < count; ++i)
+	{
+		u32 frame;
+		memcpy(&frame, &src[i * 2], sizeof(frame));
+		dest[i] = Common::swap32(frame);
+	}
+}
+
 // Executed from sound stream thread
 unsigned int CMixer::Mix(short* samples, unsigned int numSamples, bool consider_framelimit)
 {
 	if (!samples)
 		return 0;
 
-	std::lock_guard<std::mutex> lk(m_csMixing);
+	// Only ever held elsewhere while the emulator is paused, and then there's
+	// nothing to wait for.
+	std::unique_lock<std::mutex> lk(m_csMixing, std::try_to_lock);
 
-	if (PowerPC::GetState() != PowerPC::CPU_RUNNING)
+	if (!lk.owns_lock() || PowerPC::GetState() != PowerPC::CPU_RUNNING)
 	{
 		// Silence
 		memset(samples, 0, numSamples * 4);
 		return numSamples;
 	}
 
-	unsigned int currentSample = 0;
-
-	// Cache access in non-volatile variable
-	// This is the only function changing the read value, so it's safe to
-	// cache it locally although it's written here.
-	// The writing pointer will be modified outside, but it will only increase,
-	// so we will just ignore new written data while interpolating.
-	// Without this cache, the compiler wouldn't be allowed to optimize the
-	// interpolation loop.
-	u32 indexR = Common::AtomicLoad(m_indexR);
-	u32 indexW = Common::AtomicLoad(m_indexW);
+	const u64 start = Common::Timer::GetTimeUs();
 
-	float numLeft = ((indexW - indexR) & INDEX_MASK) / 2;
+	// Keep the buffer around the watermark by running the input a little
+	// faster or slower.
+	float numLeft = (float)(m_samples.Size() + m_resampler.GetBufferedFrames());
 	m_numLeftI = (numLeft + m_numLeftI*(CONTROL_AVG-1)) / CONTROL_AVG;
 	float offset = (m_numLeftI - LOW_WATERMARK) * CONTROL_FACTOR;
 	if (offset > MAX_FREQ_SHIFT) offset = MAX_FREQ_SHIFT;
 	if (offset < -MAX_FREQ_SHIFT) offset = -MAX_FREQ_SHIFT;
 
-	//render numleft sample pairs to samples[]
-	//advance indexR with sample position
-	//remember fractional offset
-
 	u32 framelimit = SConfig::GetInstance().m_Framelimit;
 	float aid_sample_rate = AudioInterface::GetAIDSampleRate() + offset;
 	if (consider_framelimit && framelimit > 2)
@@ -62,42 +75,7 @@ unsigned int CMixer::Mix(short* samples, unsigned int numSamples, bool consider_
 		aid_sample_rate = aid_sample_rate * (framelimit - 1) * 5 / VideoInterface::TargetRefreshRate;
 	}
 
-	static u32 frac = 0;
-	const u32 ratio = (u32)( 65536.0f * aid_sample_rate / (float)m_sampleRate );
-
-	if (ratio > 0x10000)
-		ERROR_LOG(AUDIO, "ratio out of range");
-
-	for (; currentSample < numSamples*2 && ((indexW-indexR) & INDEX_MASK) > 2; currentSample+=2) {
-		u32 indexR2 = indexR + 2; //next sample
-
-		s16 l1 = Common::swap16(m_buffer[indexR & INDEX_MASK]); //current
-		s16 l2 = Common::swap16(m_buffer[indexR2 & INDEX_MASK]); //next
-		int sampleL = ((l1 << 16) + (l2 - l1) * (u16)frac)  >> 16;
-		samples[currentSample+1] = sampleL;
-
-		s16 r1 = Common::swap16(m_buffer[(indexR + 1) & INDEX_MASK]); //current
-		s16 r2 = Common::swap16(m_buffer[(indexR2 + 1) & INDEX_MASK]); //next
-		int sampleR = ((r1 << 16) + (r2 - r1) * (u16)frac)  >> 16;
-		samples[currentSample] = sampleR;
-
-		frac += ratio;
-		indexR += 2 * (u16)(frac >> 16);
-		frac &= 0xffff;
-	}
-
-	// Padding
-	unsigned short s[2];
-	s[0] = Common::swap16(m_buffer[(indexR - 1) & INDEX_MASK]);
-	s[1] = Common::swap16(m_buffer[(indexR - 2) & INDEX_MASK]);
-	for (; currentSample < numSamples*2; currentSample+=2)
-	{
-		samples[currentSample] = s[0];
-		samples[currentSample+1] = s[1];
-	}
-
-	// Flush cached variable
-	Common::AtomicStore(m_indexR, indexR);
+	MixSamples(samples, numSamples, aid_sample_rate);
 
 	// Add the DTK Music
 	// Re-sampling is done inside
@@ -105,21 +83,37 @@ unsigned int CMixer::Mix(short* samples, unsigned int numSamples, bool consider_
 	if (m_logAudio)
 		g_wave_writer.AddStereoSamples(samples, numSamples);
 
+	const float mix_time = (float)(Common::Timer::GetTimeUs() - start);
+	m_mixTimeUs.store((mix_time + GetMixTimeUs() * (CONTROL_AVG - 1)) / CONTROL_AVG, std::memory_order_relaxed);
+
 	return numSamples;
 }
 
+unsigned int CMixer::MixSamples(short* samples, unsigned int numSamples, float inputRate)
+{
+	m_resampler.SetQuality(m_resamplerQuality);
+	const unsigned int mixed = m_resampler.Resample(samples, numSamples, (double)inputRate / m_sampleRate,
+		[this](u32* frames, u32 count) { return (u32)m_samples.PopMany(frames, count); });
+
+	// Padding
+	if (mixed)
+		memcpy(&m_lastFrame, &samples[(mixed - 1) * 2], sizeof(m_lastFrame));
+	if (mixed < numSamples)
+		m_underruns.fetch_add(1, std::memory_order_relaxed);
+	for (unsigned int i = mixed; i < numSamples; ++i)
+		memcpy(&samples[i * 2], &m_lastFrame, sizeof(m_lastFrame));
+
+	m_latencyMs.store((m_samples.Size() + m_resampler.GetBufferedFrames()) * 1000.0f / inputRate, std::memory_order_relaxed);
+
+	return mixed;
+}
 
 void CMixer::PushSamples(const short *samples, unsigned int num_samples)
 {
-	// Cache access in non-volatile variable
-	// indexR isn't allowed to cache in the audio throttling loop as it
-	// needs to get updates to not deadlock.
-	u32 indexW = Common::AtomicLoad(m_indexW);
-
 	if (m_throttle)
 	{
 		// The auto throttle function. This loop will put a ceiling on the CPU MHz.
-		while (num_samples * 2 + ((indexW - Common::AtomicLoad(m_indexR)) & INDEX_MASK) >= MAX_SAMPLES * 2)
+		while (num_samples + m_samples.Size() > MAX_SAMPLES)
 		{
 			if (*PowerPC::GetStatePtr() != PowerPC::CPU_RUNNING || soundStream->IsMuted())
 				break;
@@ -132,26 +126,19 @@ void CMixer::PushSamples(const short *samples, unsigned int num_samples)
 	}
 
 	// Check if we have enough free space
-	// indexW == m_indexR results in empty buffer, so indexR must always be smaller than indexW
-	if (num_samples * 2 + ((indexW - Common::AtomicLoad(m_indexR)) & INDEX_MASK) >= MAX_SAMPLES * 2)
+	if (num_samples + m_samples.Size() > MAX_SAMPLES)
 		return;
 
 	// AyuanX: Actual re-sampling work has been moved to sound thread
 	// to alleviate the workload on main thread
-	// and we simply store raw data here to make fast mem copy
-	int over_bytes = num_samples * 4 - (MAX_SAMPLES * 2 - (indexW & INDEX_MASK)) * sizeof(short);
-	if (over_bytes > 0)
+	// and we simply store raw data here
+	u32 frames[256];
+	while (num_samples)
 	{
-		memcpy(&m_buffer[indexW & INDEX_MASK], samples, num_samples * 4 - over_bytes);
-		memcpy(&m_buffer[0], samples + (num_samples * 4 - over_bytes) / sizeof(short), over_bytes);
+		const unsigned int count = std::min<unsigned int>(num_samples, ArraySize(frames));
+		SwapFrames(frames, samples, count);
+		m_samples.TryPushMany(frames, count);
+		samples += count * 2;
+		num_samples -= count;
 	}
-	else
-	{
-		memcpy(&m_buffer[indexW & INDEX_MASK], samples, num_samples * 4);
-	}
-
-	Common::AtomicAdd(m_indexW, num_samples * 2);
-
-	return;
 }
-
@@ -4,14 +4,16 @@
 
 #pragma once
 
+#include <atomic>
 #include <string>
 
+#include "AudioCommon/Resampler.h"
 #include "AudioCommon/WaveFile.h"
+#include "Common/SPSCQueue.h"
 #include "Common/StdMutex.h"
 
 // 16 bit Stereo
 #define MAX_SAMPLES     (1024 * 2) // 64ms
-#define INDEX_MASK      (MAX_SAMPLES * 2 - 1)
 
 #define LOW_WATERMARK   1280 // 40 ms
 #define MAX_FREQ_SHIFT  200  // per 32000 Hz
@@ -27,29 +29,40 @@ public:
 		, m_bits(16)
 		, m_channels(2)
 		, m_logAudio(0)
-		, m_indexW(0)
-		, m_indexR(0)
+		, m_throttle(false)
+		, m_lastFrame(0)
 		, m_numLeftI(0.0f)
+		, m_resamplerQuality(Resampler::QUALITY_SINC)
+		, m_latencyMs(0.0f)
+		, m_underruns(0)
+		, m_mixTimeUs(0.0f)
 	{
 		// AyuanX: The internal (Core & DSP) sample rate is fixed at 32KHz
 		// So when AI/DAC sample rate differs than 32KHz, we have to do re-sampling
 		m_sampleRate = BackendSampleRate;
 
-		memset(m_buffer, 0, sizeof(m_buffer));
-
 		INFO_LOG(AUDIO_INTERFACE, "Mixer is initialized (AISampleRate:%i, DACSampleRate:%i)", AISampleRate, DACSampleRate);
 	}
 
-	virtual ~CMixer() {}
+	virtual ~CMixer()
+	{
+		INFO_LOG(AUDIO_INTERFACE, "Mixer: %u underruns, %.1f us a mix", GetUnderruns(), GetMixTimeUs());
+	}
 
 	// Called from audio threads
 	virtual unsigned int Mix(short* samples, unsigned int numSamples, bool consider_framelimit = true);
 
+	// Resamples what was pushed, taken to be at inputRate, to fill samples,
+	// repeating the last frame if it runs out. Unlike Mix it leaves out the
+	// emulator: the DTK stream, logging, and whether it's running.
+	unsigned int MixSamples(short* samples, unsigned int numSamples, float inputRate);
+
 	// Called from main thread
 	virtual void PushSamples(const short* samples, unsigned int num_samples);
 	unsigned int GetSampleRate() const {return m_sampleRate;}
 
 	void SetThrottle(bool use) { m_throttle = use;}
+	void SetResamplerQuality(Resampler::Quality quality) { m_resamplerQuality = quality; }
 
 
 	virtual void StartLogAudio(const std::string& filename)
@@ -86,6 +99,13 @@ public:
 	float GetCurrentSpeed() const { return m_speed; }
 	void UpdateSpeed(volatile float val) { m_speed = val; }
 
+	// How long a sample pushed now would take to be mixed, how many times
+	// there wasn't enough to mix, and the time one Mix takes on average.
+	// Written by the audio thread, and safe to read from any other.
+	float GetLatencyMs() const { return m_latencyMs.load(std::memory_order_relaxed); }
+	u32 GetUnderruns() const { return m_underruns.load(std::memory_order_relaxed); }
+	float GetMixTimeUs() const { return m_mixTimeUs.load(std::memory_order_relaxed); }
+
 protected:
 	unsigned int m_sampleRate;
 	unsigned int m_aiSampleRate;
@@ -99,14 +119,23 @@ protected:
 
 	bool m_throttle;
 
-	short m_buffer[MAX_SAMPLES * 2];
-	volatile u32 m_indexW;
-	volatile u32 m_indexR;
+	// Pushed frames, already in the order and endianness the backends want,
+	// and the last one mixed, for padding.
+	Common::SPSCQueue<u32, MAX_SAMPLES> m_samples;
+	u32 m_lastFrame;
 
+	// Only keeps Mix out while the emulator is paused; pushing doesn't take it.
 	std::mutex m_csMixing;
 	float m_numLeftI;
 
+	Resampler m_resampler;
+	volatile Resampler::Quality m_resamplerQuality;
+
 	volatile float m_speed; // Current rate of the emulation (1.0 = 100% speed)
+
+	std::atomic<float> m_latencyMs;
+	std::atomic<u32> m_underruns;
+	std::atomic<float> m_mixTimeUs;
 private:
 
 };
@@ -0,0 +1,187 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "AudioCommon/Resampler.h"
+#include "Common/MathUtil.h"
+
+#if _M_X86
+#include <emmintrin.h>
+#endif
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// The Kaiser window's beta, trading how sharply the filter cuts off for how
+// much it lets through above that.
+static const double KAISER_BETA = 8.0;
+
+// Where the filter starts cutting off, as a fraction of the lower Nyquist
+// frequency.
+static const double PASSBAND = 0.9;
+
+static const u32 HISTORY = Resampler::TAPS / 2 - 1;
+
+// The modified Bessel function of the first kind of order zero, for the
+// Kaiser window.
+static double BesselI0(double x)
+{
+	double sum = 1.0, term = 1.0;
+	for (int k = 1; term > sum * 1e-12; ++k)
+	{
+		term *= (x / (2 * k)) * (x / (2 * k));
+		sum += term;
+	}
+	return sum;
+}
+
+static s16 ToS16(float sample)
+{
+	MathUtil::Clamp(&sample, -32768.0f, 32767.0f);
+	return (s16)lrintf(sample);
+}
+
+Resampler::Resampler(Quality quality)
+	: m_quality(quality)
+	, m_cutoff(0.0)
+{
+	Clear();
+}
+
+void Resampler::Clear()
+{
+	memset(m_input, 0, sizeof(m_input));
+	m_input_end = HISTORY;
+	m_position = HISTORY;
+}
+
+u32 Resampler::GetBufferedFrames() const
+{
+	return m_position < m_input_end ? (u32)(m_input_end - m_position) : 0;
+}
+
+void Resampler::BuildFilter(double cutoff)
+{
+	m_cutoff = cutoff;
+	for (u32 phase = 0; phase <= PHASES; ++phase)
+	{
+		float* weights = &m_filter[phase * TAPS * 2];
+		const double frac = (double)phase / PHASES;
+
+		double sum = 0.0;
+		double taps[TAPS];
+		for (u32 k = 0; k < TAPS; ++k)
+		{
+			// The distance from the input frame to where the output frame is.
+			const double x = (double)k - HISTORY - frac;
+			const double sinc = x == 0.0 ? 1.0 : sin(M_PI * cutoff * x) / (M_PI * cutoff * x);
+			const double w = x / (TAPS / 2);
+			const double window = w * w < 1.0 ? BesselI0(KAISER_BETA * sqrt(1.0 - w * w)) / BesselI0(KAISER_BETA) : 0.0;
+			taps[k] = sinc * window;
+			sum += taps[k];
+		}
+
+		// Normalized, so a constant signal comes out unchanged.
+		for (u32 k = 0; k < TAPS; ++k)
+			weights[k * 2] = weights[k * 2 + 1] = (float)(taps[k] / sum);
+	}
+}
+
+bool Resampler::Refill(const Source& source)
+{
+	// Keep the frames the filter still reaches back to.
+	const u32 first = std::min((u32)m_position - HISTORY, m_input_end);
+	memmove(m_input, &m_input[first * 2], (m_input_end - first) * 2 * sizeof(float));
+	m_input_end -= first;
+	m_position -= first;
+
+	u32 frames[INPUT_FRAMES + TAPS];
+	const u32 count = source(frames, INPUT_FRAMES + TAPS - m_input_end);
+	float* dest = &m_input[m_input_end * 2];
+	u32 i = 0;
+#if _M_X86
+	for (; i + 4 <= count; i += 4)
+	{
+		const __m128i samples = _mm_loadu_si128((const __m128i*)&frames[i]);
+		_mm_storeu_ps(dest + i * 2, _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(samples, samples), 16)));
+		_mm_storeu_ps(dest + i * 2 + 4, _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(samples, samples), 16)));
+	}
+#endif
+	const s16* samples = (const s16*)frames;
+	for (; i < count * 2; ++i)
+		dest[i] = samples[i];
+
+	m_input_end += count;
+	return count != 0;
+}
+
+u32 Resampler::Resample(s16* out, u32 count, double ratio, const Source& source)
+{
+	// Going down, the filter has to cut off below the output's Nyquist
+	// frequency rather than the input's.
+	const double cutoff = PASSBAND * std::min(1.0, 1.0 / ratio);
+	if (m_quality == QUALITY_SINC && std::abs(cutoff - m_cutoff) > m_cutoff * 0.01)
+		BuildFilter(cutoff);
+
+	u32 written = 0;
+	for (; written < count; ++written, out += 2)
+	{
+		while ((u32)m_position + TAPS / 2 >= m_input_end)
+		{
+			if (!Refill(source))
+				return written;
+		}
+
+		const u32 index = (u32)m_position;
+		const float frac = (float)(m_position - index);
+		m_position += ratio;
+
+		if (m_quality == QUALITY_LINEAR)
+		{
+			const float* in = &m_input[index * 2];
+			out[0] = ToS16(in[0] + (in[2] - in[0]) * frac);
+			out[1] = ToS16(in[1] + (in[3] - in[1]) * frac);
+			continue;
+		}
+
+		// Weights between those of the two nearest phases.
+		const float phase = frac * PHASES;
+		const u32 p = std::min((u32)phase, (u32)PHASES - 1);
+		const float t = phase - p;
+		const float* w0 = &m_filter[p * TAPS * 2];
+		const float* w1 = w0 + TAPS * 2;
+		const float* in = &m_input[(index - HISTORY) * 2];
+
+#if _M_X86
+		const __m128 t4 = _mm_set1_ps(t);
+		__m128 sum = _mm_setzero_ps();
+		for (u32 k = 0; k < TAPS * 2; k += 4)
+		{
+			const __m128 a = _mm_load_ps(w0 + k);
+			const __m128 w = _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(_mm_load_ps(w1 + k), a), t4));
+			sum = _mm_add_ps(sum, _mm_mul_ps(w, _mm_loadu_ps(in + k)));
+		}
+		// Left, right, left, right: add the halves and saturate to 16 bit.
+		sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+		const __m128i samples = _mm_cvtps_epi32(sum);
+		const u32 frame = _mm_cvtsi128_si32(_mm_packs_epi32(samples, samples));
+		memcpy(out, &frame, sizeof(frame));
+#else
+		float left = 0.0f, right = 0.0f;
+		for (u32 k = 0; k < TAPS * 2; k += 2)
+		{
+			left += (w0[k] + (w1[k] - w0[k]) * t) * in[k];
+			right += (w0[k + 1] + (w1[k + 1] - w0[k + 1]) * t) * in[k + 1];
+		}
+		out[0] = ToS16(left);
+		out[1] = ToS16(right);
+#endif
+	}
+
+	return written;
+}
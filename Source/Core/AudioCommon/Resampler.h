@@ -0,0 +1,76 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <functional>
+
+#include "Common/Common.h"
+#include "Common/CommonTypes.h"
+
+// Converts 16 bit stereo audio from one sample rate to another, pulling the
+// input from a source as it needs it. The ratio can change from one call to
+// the next, which is how the mixer keeps its buffer from running dry or full.
+class Resampler
+{
+public:
+	enum Quality
+	{
+		// Straight lines between the input samples. Cheap, but it dulls the
+		// highs and lets through images of them.
+		QUALITY_LINEAR,
+		// A windowed sinc filter, which keeps everything up to near the
+		// lower of the two Nyquist frequencies and little above.
+		QUALITY_SINC,
+	};
+
+	enum
+	{
+		// Input frames the sinc filter weighs for each output frame...
+		TAPS = 32,
+		// ...and the positions between two input frames its weights are
+		// worked out for. Those between are interpolated.
+		PHASES = 256,
+		// Input frames held at most.
+		INPUT_FRAMES = 1024,
+	};
+
+	// Fills frames, each a left and a right sample, with up to count frames
+	// and returns how many it did.
+	typedef std::function<u32(u32* frames, u32 count)> Source;
+
+	explicit Resampler(Quality quality = QUALITY_SINC);
+
+	Quality GetQuality() const { return m_quality; }
+	void SetQuality(Quality quality) { m_quality = quality; }
+
+	// Forgets the input taken so far, as if just constructed.
+	void Clear();
+
+	// Input frames taken from the source and not gone past yet.
+	u32 GetBufferedFrames() const;
+
+	// Writes up to count frames to out, going ratio input frames ahead for
+	// each. Returns how many it wrote before the source ran dry.
+	u32 Resample(s16* out, u32 count, double ratio, const Source& source);
+
+private:
+	// Moves what's still needed to the front, and tops it up from source.
+	// Returns false if nothing came.
+	bool Refill(const Source& source);
+	void BuildFilter(double cutoff);
+
+	Quality m_quality;
+
+	// Left and right interleaved, as floats, and where the next output frame
+	// is between them. The first TAPS / 2 - 1 frames are history.
+	GC_ALIGNED16(float m_input[(INPUT_FRAMES + TAPS) * 2]);
+	u32 m_input_end;
+	double m_position;
+
+	// Weights for each phase, each twice for left and right, plus one for a
+	// whole frame on to interpolate towards.
+	GC_ALIGNED16(float m_filter[(PHASES + 1) * TAPS * 2]);
+	double m_cutoff;
+};
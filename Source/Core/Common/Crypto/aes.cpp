@@ -0,0 +1,92 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include "Common/Common.h"
+#include "Common/CPUDetect.h"
+#include "Common/Crypto/aes.h"
+
+#ifdef _M_X86
+// Built with -maes on GCC and Clang; only called when the CPU supports it.
+#include <wmmintrin.h>
+#endif
+
+namespace AES
+{
+
+#ifdef _M_X86
+static void DecryptCBC_AESNI(const aes_context* ctx, u8* iv, const u8* src, u8* dst, size_t size)
+{
+	// aes_setkey_dec leaves the round keys in the order and form (with
+	// InvMixColumns applied to the inner ones) that AESDEC expects, whether or
+	// not PolarSSL uses AES-NI itself.
+	const int nr = ctx->nr;
+	const __m128i* rk = (const __m128i*)ctx->rk;
+	__m128i keys[15];
+	for (int r = 0; r <= nr; ++r)
+		keys[r] = _mm_loadu_si128(rk + r);
+
+	const __m128i* in = (const __m128i*)src;
+	__m128i* out = (__m128i*)dst;
+	const size_t num_blocks = size / 16;
+	__m128i prev = _mm_loadu_si128((const __m128i*)iv);
+
+	// Unlike encryption, CBC decryption of a block doesn't depend on the
+	// previous result, so four blocks go through the pipeline side by side.
+	size_t i = 0;
+	for (; i + 4 <= num_blocks; i += 4)
+	{
+		__m128i c0 = _mm_loadu_si128(in + i + 0);
+		__m128i c1 = _mm_loadu_si128(in + i + 1);
+		__m128i c2 = _mm_loadu_si128(in + i + 2);
+		__m128i c3 = _mm_loadu_si128(in + i + 3);
+		__m128i b0 = _mm_xor_si128(c0, keys[0]);
+		__m128i b1 = _mm_xor_si128(c1, keys[0]);
+		__m128i b2 = _mm_xor_si128(c2, keys[0]);
+		__m128i b3 = _mm_xor_si128(c3, keys[0]);
+		for (int r = 1; r < nr; ++r)
+		{
+			b0 = _mm_aesdec_si128(b0, keys[r]);
+			b1 = _mm_aesdec_si128(b1, keys[r]);
+			b2 = _mm_aesdec_si128(b2, keys[r]);
+			b3 = _mm_aesdec_si128(b3, keys[r]);
+		}
+		b0 = _mm_aesdeclast_si128(b0, keys[nr]);
+		b1 = _mm_aesdeclast_si128(b1, keys[nr]);
+		b2 = _mm_aesdeclast_si128(b2, keys[nr]);
+		b3 = _mm_aesdeclast_si128(b3, keys[nr]);
+		_mm_storeu_si128(out + i + 0, _mm_xor_si128(b0, prev));
+		_mm_storeu_si128(out + i + 1, _mm_xor_si128(b1, c0));
+		_mm_storeu_si128(out + i + 2, _mm_xor_si128(b2, c1));
+		_mm_storeu_si128(out + i + 3, _mm_xor_si128(b3, c2));
+		prev = c3;
+	}
+
+	for (; i < num_blocks; ++i)
+	{
+		__m128i c = _mm_loadu_si128(in + i);
+		__m128i b = _mm_xor_si128(c, keys[0]);
+		for (int r = 1; r < nr; ++r)
+			b = _mm_aesdec_si128(b, keys[r]);
+		b = _mm_aesdeclast_si128(b, keys[nr]);
+		_mm_storeu_si128(out + i, _mm_xor_si128(b, prev));
+		prev = c;
+	}
+
+	_mm_storeu_si128((__m128i*)iv, prev);
+}
+#endif
+
+void DecryptCBC(aes_context* ctx, u8* iv, const u8* src, u8* dst, size_t size)
+{
+#ifdef _M_X86
+	if (cpu_info.bAES)
+	{
+		DecryptCBC_AESNI(ctx, iv, src, dst, size);
+		return;
+	}
+#endif
+	aes_crypt_cbc(ctx, AES_DECRYPT, size, iv, src, dst);
+}
+
+}
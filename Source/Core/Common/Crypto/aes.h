@@ -0,0 +1,21 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include <polarssl/aes.h>
+
+#include "Common/CommonTypes.h"
+
+namespace AES
+{
+
+// Same as aes_crypt_cbc(ctx, AES_DECRYPT, size, iv, src, dst), but uses AES-NI
+// when the CPU has it, decrypting several blocks at once. ctx must have been
+// set up by aes_setkey_dec, size must be a multiple of 16, and src and dst
+// may be the same buffer. iv is updated for the next call.
+void DecryptCBC(aes_context* ctx, u8* iv, const u8* src, u8* dst, size_t size);
+
+}
@@ -0,0 +1,88 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#pragma once
+
+// a simple lockless thread-safe,
+// multiple writer, single reader queue
+
+// Writers only contend on a single atomic exchange. A writer preempted
+// between that exchange and linking its element hides the elements pushed
+// after it until it resumes; Pop() reports an empty queue meanwhile.
+
+#include <utility>
+
+#include "Common/Atomic.h"
+#include "Common/CommonTypes.h"
+
+namespace Common
+{
+
+template <typename T>
+class MPSCQueue
+{
+public:
+	MPSCQueue()
+	{
+		m_write_ptr = m_read_ptr = new ElementPtr();
+	}
+
+	~MPSCQueue()
+	{
+		Clear();
+		delete m_read_ptr;
+	}
+
+	bool Empty() const
+	{
+		return !AtomicLoad(m_read_ptr->next);
+	}
+
+	// Safe to call from any number of threads.
+	template <typename Arg>
+	void Push(Arg&& t)
+	{
+		ElementPtr* new_ptr = new ElementPtr();
+		new_ptr->current = std::forward<Arg>(t);
+		ElementPtr* prev = AtomicExchangeAcquire(m_write_ptr, new_ptr);
+		AtomicStoreRelease(prev->next, new_ptr);
+	}
+
+	// Only from the reader thread.
+	bool Pop(T& t)
+	{
+		ElementPtr* next = AtomicLoadAcquire(m_read_ptr->next);
+		if (!next)
+			return false;
+
+		t = std::move(next->current);
+		delete m_read_ptr;
+		m_read_ptr = next;
+		return true;
+	}
+
+	// Only from the reader thread.
+	void Clear()
+	{
+		T t;
+		while (Pop(t)) {}
+	}
+
+private:
+	// m_read_ptr always points to an element that has already been consumed
+	// (or the initial dummy); the queue's contents start at its next pointer.
+	class ElementPtr
+	{
+	public:
+		ElementPtr() : next(nullptr) {}
+
+		T current;
+		ElementPtr *volatile next;
+	};
+
+	ElementPtr *volatile m_write_ptr;
+	ElementPtr *m_read_ptr;
+};
+
+}
@@ -0,0 +1,84 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include "Common/ParallelFor.h"
+
+namespace Common
+{
+
+WorkerPool::WorkerPool(u32 num_workers)
+	: m_num_workers(std::max(1u, num_workers)), m_job_id(0), m_busy_workers(0), m_stop(false),
+	  m_func(nullptr), m_count(0), m_next_index(0)
+{
+	for (u32 w = 1; w < m_num_workers; ++w)
+		m_threads.emplace_back(&WorkerPool::WorkerThread, this, w);
+}
+
+WorkerPool::~WorkerPool()
+{
+	{
+		std::lock_guard<std::mutex> lk(m_lock);
+		m_stop = true;
+	}
+	m_work_cv.notify_all();
+	for (std::thread& t : m_threads)
+		t.join();
+}
+
+void WorkerPool::ParallelFor(u32 count, const std::function<void(u32, u32)>& func)
+{
+	if (count <= 1 || m_threads.empty())
+	{
+		for (u32 i = 0; i < count; ++i)
+			func(i, 0u);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lk(m_lock);
+		m_func = &func;
+		m_count = count;
+		m_next_index = 0;
+		m_busy_workers = (u32)m_threads.size();
+		m_job_id++;
+	}
+	m_work_cv.notify_all();
+
+	RunJob(0);
+
+	std::unique_lock<std::mutex> lk(m_lock);
+	m_done_cv.wait(lk, [&] { return m_busy_workers == 0; });
+	m_func = nullptr;
+}
+
+void WorkerPool::WorkerThread(u32 worker_id)
+{
+	Common::SetCurrentThreadName("Worker pool");
+
+	u64 last_job_id = 0;
+	std::unique_lock<std::mutex> lk(m_lock);
+	while (true)
+	{
+		m_work_cv.wait(lk, [&] { return m_stop || m_job_id != last_job_id; });
+		if (m_stop)
+			return;
+		last_job_id = m_job_id;
+
+		lk.unlock();
+		RunJob(worker_id);
+		lk.lock();
+
+		if (--m_busy_workers == 0)
+			m_done_cv.notify_one();
+	}
+}
+
+void WorkerPool::RunJob(u32 worker_id)
+{
+	u32 i;
+	while ((i = m_next_index++) < m_count)
+		(*m_func)(i, worker_id);
+}
+
+}
@@ -0,0 +1,95 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/Thread.h"
+
+namespace Common
+{
+
+// Number of threads worth using for CPU bound work on this machine.
+inline u32 GetNumWorkerThreads()
+{
+	u32 count = std::thread::hardware_concurrency();
+	return count ? count : 1;
+}
+
+// Calls func(index, worker) for every index in [0, count), spread over up to
+// max_workers threads, and returns once all calls have finished. The calling
+// thread takes part as worker 0; worker numbers are below max_workers, so
+// callers can keep per-worker scratch space indexed by them.
+//
+// Threads are started for each call, so this is meant for work measured in
+// milliseconds, not microseconds.
+template <typename Func>
+void ParallelFor(u32 count, u32 max_workers, Func func)
+{
+	const u32 num_workers = std::max(1u, std::min(count, max_workers));
+	if (num_workers == 1)
+	{
+		for (u32 i = 0; i < count; ++i)
+			func(i, 0u);
+		return;
+	}
+
+	std::atomic<u32> next_index(0);
+	auto worker = [&](u32 worker_id) {
+		u32 i;
+		while ((i = next_index++) < count)
+			func(i, worker_id);
+	};
+
+	std::vector<std::thread> threads;
+	threads.reserve(num_workers - 1);
+	for (u32 w = 1; w < num_workers; ++w)
+		threads.emplace_back(worker, w);
+	worker(0);
+	for (std::thread& t : threads)
+		t.join();
+}
+
+// Same as ParallelFor, but on threads that are started once and then wait for
+// work, for callers that need to split up work a few hundred microseconds
+// long many times per frame.
+class WorkerPool
+{
+public:
+	// Starts num_workers - 1 threads; the thread calling ParallelFor is the
+	// remaining worker, worker 0.
+	explicit WorkerPool(u32 num_workers);
+	~WorkerPool();
+
+	u32 GetNumWorkers() const { return m_num_workers; }
+
+	// Only one thread may call this at a time.
+	void ParallelFor(u32 count, const std::function<void(u32, u32)>& func);
+
+private:
+	void WorkerThread(u32 worker_id);
+	void RunJob(u32 worker_id);
+
+	u32 m_num_workers;
+	std::vector<std::thread> m_threads;
+
+	std::mutex m_lock;
+	std::condition_variable m_work_cv;
+	std::condition_variable m_done_cv;
+	// Incremented for every job, so workers can tell a new one from a spurious wakeup.
+	u64 m_job_id;
+	u32 m_busy_workers;
+	bool m_stop;
+
+	const std::function<void(u32, u32)>* m_func;
+	u32 m_count;
+	std::atomic<u32> m_next_index;
+};
+
+}
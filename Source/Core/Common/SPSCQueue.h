@@ -0,0 +1,102 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#pragma once
+
+// a lockless, bounded, single writer, single reader queue
+
+// Holds up to N elements in a fixed ring, so pushing and popping never
+// allocate. The writer and the reader each own one index, and only read the
+// other one's, which keeps them off each other's cache lines except to see
+// how far the other has got.
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+
+#include "Common/CommonTypes.h"
+
+namespace Common
+{
+
+template <typename T, size_t N>
+class SPSCQueue
+{
+	static_assert(N != 0 && (N & (N - 1)) == 0, "SPSCQueue size must be a power of two");
+
+public:
+	SPSCQueue() : m_read(0), m_write(0) {}
+
+	// Only for the writer. Returns false without pushing when the queue is full.
+	bool TryPush(const T& t)
+	{
+		const size_t write = m_write.load(std::memory_order_relaxed);
+		if (write - m_read.load(std::memory_order_acquire) == N)
+			return false;
+		m_data[write & (N - 1)] = t;
+		m_write.store(write + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Only for the reader. Returns false when the queue is empty.
+	bool Pop(T& t)
+	{
+		const size_t read = m_read.load(std::memory_order_relaxed);
+		if (read == m_write.load(std::memory_order_acquire))
+			return false;
+		t = m_data[read & (N - 1)];
+		m_read.store(read + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Only for the writer. Pushes all count elements, or returns false
+	// without pushing any when there isn't room for them all.
+	bool TryPushMany(const T* items, size_t count)
+	{
+		const size_t write = m_write.load(std::memory_order_relaxed);
+		if (N - (write - m_read.load(std::memory_order_acquire)) < count)
+			return false;
+		const size_t start = write & (N - 1);
+		const size_t first = std::min(count, N - start);
+		std::copy(items, items + first, &m_data[start]);
+		std::copy(items + first, items + count, &m_data[0]);
+		m_write.store(write + count, std::memory_order_release);
+		return true;
+	}
+
+	// Only for the reader. Pops up to count elements, and returns how many.
+	size_t PopMany(T* items, size_t count)
+	{
+		const size_t read = m_read.load(std::memory_order_relaxed);
+		count = std::min(count, m_write.load(std::memory_order_acquire) - read);
+		const size_t start = read & (N - 1);
+		const size_t first = std::min(count, N - start);
+		std::copy(&m_data[start], &m_data[start] + first, items);
+		std::copy(&m_data[0], &m_data[0] + (count - first), items + first);
+		m_read.store(read + count, std::memory_order_release);
+		return count;
+	}
+
+	// Exact on either side when the other one is idle, a snapshot otherwise.
+	size_t Size() const
+	{
+		return m_write.load(std::memory_order_acquire) - m_read.load(std::memory_order_acquire);
+	}
+
+	bool Empty() const { return Size() == 0; }
+
+	static size_t Capacity() { return N; }
+
+private:
+	T m_data[N];
+
+	// Keep the two indices on separate cache lines.
+	u8 m_pad0[64];
+	std::atomic<size_t> m_read;
+	u8 m_pad1[64];
+	std::atomic<size_t> m_write;
+	u8 m_pad2[64];
+};
+
+}
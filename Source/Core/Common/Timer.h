@@ -33,6 +33,8 @@ public:
 	u64 GetTimeElapsed();
 
 	static u32 GetTimeMs();
+	// Microsecond resolution, for measuring short intervals
+	static u64 GetTimeUs();
 
 private:
 	u64 m_LastTime;
@@ -109,6 +109,7 @@ static const struct
 	{ "UndoSaveState",       351 /* WXK_F12 */,   4 /* wxMOD_SHIFT */ },
 	{ "SaveStateFile",       0,                   0 /* wxMOD_NONE */ },
 	{ "LoadStateFile",       0,                   0 /* wxMOD_NONE */ },
+	{ "RewindState",         0,                   0 /* wxMOD_NONE */ },
 };
 
 SConfig::SConfig()
@@ -233,6 +234,8 @@ void SConfig::SaveSettings()
 	ini.Set("Core", "DSPThread",        m_LocalCoreStartupParameter.bDSPThread);
 	ini.Set("Core", "DSPHLE",           m_LocalCoreStartupParameter.bDSPHLE);
 	ini.Set("Core", "SkipIdle",         m_LocalCoreStartupParameter.bSkipIdle);
+	ini.Set("Core", "JITBlockProfile",  m_LocalCoreStartupParameter.bJITBlockProfile);
+	ini.Set("Core", "JITTieringThreshold", m_LocalCoreStartupParameter.iJITTieringThreshold);
 	ini.Set("Core", "DefaultGCM",       m_LocalCoreStartupParameter.m_strDefaultGCM);
 	ini.Set("Core", "DVDRoot",          m_LocalCoreStartupParameter.m_strDVDRoot);
 	ini.Set("Core", "Apploader",        m_LocalCoreStartupParameter.m_strApploader);
@@ -258,6 +261,9 @@ void SConfig::SaveSettings()
 	ini.Set("Core", "RunCompareClient", m_LocalCoreStartupParameter.bRunCompareClient);
 	ini.Set("Core", "FrameLimit",       m_Framelimit);
 	ini.Set("Core", "FrameSkip",        m_FrameSkip);
+	ini.Set("Core", "SaveStateCompression", m_LocalCoreStartupParameter.iSaveStateCompression);
+	ini.Set("Core", "DiscCacheSize",    m_LocalCoreStartupParameter.iDiscCacheSize);
+	ini.Set("Core", "RewindInterval",   m_LocalCoreStartupParameter.iRewindInterval);
 
 	// GFX Backend
 	ini.Set("Core", "GFXBackend", m_LocalCoreStartupParameter.m_strVideoBackend);
@@ -271,6 +277,8 @@ void SConfig::SaveSettings()
 	ini.Set("DSP", "DumpAudio", m_DumpAudio);
 	ini.Set("DSP", "Backend", sBackend);
 	ini.Set("DSP", "Volume", m_Volume);
+	ini.Set("DSP", "Resampler", m_Resampler);
+	ini.Set("DSP", "AXMixThreads", m_AXMixThreads);
 
 	// Fifo Player
 	ini.Set("FifoPlayer", "LoopReplay", m_LocalCoreStartupParameter.bLoopFifoReplay);
@@ -382,7 +390,7 @@ void SConfig::LoadSettings()
 #elif _M_ARM_32
 		ini.Get("Core", "CPUCore",      &m_LocalCoreStartupParameter.iCPUCore, 3);
 #else
-		ini.Get("Core", "CPUCore",      &m_LocalCoreStartupParameter.iCPUCore, 0);
+		ini.Get("Core", "CPUCore",      &m_LocalCoreStartupParameter.iCPUCore, 5);
 #endif
 		ini.Get("Core", "Fastmem",           &m_LocalCoreStartupParameter.bFastmem,      true);
 		ini.Get("Core", "DSPThread",         &m_LocalCoreStartupParameter.bDSPThread,    false);
@@ -404,6 +412,8 @@ void SConfig::LoadSettings()
 		ini.Get("Core", "BBA_MAC",           &m_bba_mac);
 		ini.Get("Core", "TimeProfiling",     &m_LocalCoreStartupParameter.bJITILTimeProfiling, false);
 		ini.Get("Core", "OutputIR",          &m_LocalCoreStartupParameter.bJITILOutputIR,      false);
+		ini.Get("Core", "JITBlockProfile",   &m_LocalCoreStartupParameter.bJITBlockProfile,    false);
+		ini.Get("Core", "JITTieringThreshold", &m_LocalCoreStartupParameter.iJITTieringThreshold, 0);
 		for (int i = 0; i < MAX_SI_CHANNELS; ++i)
 		{
 			ini.Get("Core", StringFromFormat("SIDevice%i", i), (u32*)&m_SIDevice[i], (i == 0) ? SIDEVICE_GC_CONTROLLER : SIDEVICE_NONE);
@@ -423,6 +433,9 @@ void SConfig::LoadSettings()
 		ini.Get("Core", "DCBZ",                      &m_LocalCoreStartupParameter.bDCBZOFF,          false);
 		ini.Get("Core", "FrameLimit",                &m_Framelimit,                                  1); // auto frame limit by default
 		ini.Get("Core", "FrameSkip",                 &m_FrameSkip,                                   0);
+		ini.Get("Core", "SaveStateCompression",      &m_LocalCoreStartupParameter.iSaveStateCompression, 0);
+		ini.Get("Core", "DiscCacheSize",             &m_LocalCoreStartupParameter.iDiscCacheSize,    8);
+		ini.Get("Core", "RewindInterval",            &m_LocalCoreStartupParameter.iRewindInterval,   0);
 
 		// GFX Backend
 		ini.Get("Core", "GFXBackend",  &m_LocalCoreStartupParameter.m_strVideoBackend, "");
@@ -446,6 +459,8 @@ void SConfig::LoadSettings()
 		ini.Get("DSP", "Backend", &sBackend, BACKEND_NULLSOUND);
 	#endif
 		ini.Get("DSP", "Volume", &m_Volume, 100);
+		ini.Get("DSP", "Resampler", &m_Resampler, 1);
+		ini.Get("DSP", "AXMixThreads", &m_AXMixThreads, 1);
 
 		ini.Get("FifoPlayer", "LoopReplay", &m_LocalCoreStartupParameter.bLoopFifoReplay, true);
 	}
@@ -82,6 +82,9 @@ struct SConfig : NonCopyable
 	bool m_DSPEnableJIT;
 	bool m_DumpAudio;
 	int m_Volume;
+	int m_Resampler;
+	// Threads to mix AX voices on; 1 is the DSP thread alone, 0 is automatic.
+	int m_AXMixThreads;
 	std::string sBackend;
 
 	SysConf* m_SYSCONF;
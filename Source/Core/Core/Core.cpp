@@ -603,6 +603,17 @@ bool PauseAndLock(bool doLock, bool unpauseOnUnlock)
 	return wasUnpaused;
 }
 
+void PauseAndLockFromCPUThread(bool doLock)
+{
+	_dbg_assert_(COMMON, IsCPUThread());
+
+	// Same order as PauseAndLock. The CPU is running, so it's unpaused again.
+	ExpansionInterface::PauseAndLock(doLock, true);
+	AudioCommon::PauseAndLock(doLock, true);
+	DSP::GetDSPEmulator()->PauseAndLock(doLock, true);
+	g_video_backend->PauseAndLock(doLock, true);
+}
+
 // Apply Frame Limit and Display FPS info
 // This should only be called from VI
 void VideoThrottle()
@@ -644,6 +655,7 @@ void Callback_VideoCopiedToXFB(bool video_update)
 	if (video_update)
 		Common::AtomicIncrement(DrawnFrame);
 	Movie::FrameUpdate();
+	State::FrameUpdate();
 }
 
 // Callback_ISOName: Let the DSP emulator get the game name
@@ -709,6 +721,13 @@ void UpdateTitle()
 					SystemTimers::GetTicksPerSecond() / 1000000,
 					_CoreParameter.bSkipIdle ? "~" : "",
 					TicksPercentage);
+
+			if (soundStream)
+			{
+				const CMixer* pMixer = soundStream->GetMixer();
+				SFPS += StringFromFormat(" | Audio: %.0f ms latency, %u underruns, %.0f us/mix",
+						pMixer->GetLatencyMs(), pMixer->GetUnderruns(), pMixer->GetMixTimeUs());
+			}
 		}
 	}
 	// This is our final "frame counter" string
@@ -80,4 +80,10 @@ void UpdateTitle();
 // the return value of the first call should be passed in as the second argument of the second call.
 bool PauseAndLock(bool doLock, bool unpauseOnUnlock=true);
 
+// For the CPU thread, in a CoreTiming event: pauses and locks everything
+// but the CPU, which is stopped there already. It leaves the nesting count
+// of PauseAndLock alone, since a host thread in PauseAndLock at the same
+// time waits for the CPU thread before it gets to the rest.
+void PauseAndLockFromCPUThread(bool doLock);
+
 }  // namespace
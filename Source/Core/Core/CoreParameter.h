@@ -78,6 +78,7 @@ enum Hotkey
 	HK_UNDO_SAVE_STATE,
 	HK_SAVE_STATE_FILE,
 	HK_LOAD_STATE_FILE,
+	HK_REWIND_STATE,
 
 	NUM_HOTKEYS,
 };
@@ -113,6 +114,10 @@ struct SCoreStartupParameter
 	bool bJITBranchOff;
 	bool bJITILTimeProfiling;
 	bool bJITILOutputIR;
+	// Record compiled blocks per game and compile them ahead of time on the next boot
+	bool bJITBlockProfile;
+	// Jit64 interprets a block until it has been reached this many times (0 = compile immediately)
+	int iJITTieringThreshold;
 
 	bool bFastmem;
 	bool bEnableFPRF;
@@ -141,6 +146,12 @@ struct SCoreStartupParameter
 	bool bVBeamSpeedHack;
 	bool bSyncGPU;
 	bool bFastDiscSpeed;
+	// Codec for compressed save state files (State::StateCompression)
+	int iSaveStateCompression;
+	// Size of the block cache of compressed images and drives, in MiB
+	int iDiscCacheSize;
+	// Frames between rewind states, 0 to keep none
+	int iRewindInterval;
 
 	int SelectedLanguage;
 
@@ -2,11 +2,12 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <cinttypes>
 #include <string>
 #include <vector>
 
-#include "Common/FifoQueue.h"
+#include "Common/MPSCQueue.h"
 #include "Common/StringUtil.h"
 #include "Common/Thread.h"
 
@@ -36,15 +37,28 @@ struct BaseEvent
 	int type;
 };
 
-typedef LinkedListItem<BaseEvent> Event;
+struct Event
+{
+	s64 time;
+	// Events due at the same time run in the order they were scheduled.
+	u64 fifo_order;
+	u64 userdata;
+	int type;
+	// Index of this event in event_positions[type].
+	u32 type_slot;
+};
 
 // STATE_TO_SAVE
-static Event *first;
-static std::mutex tsWriteLock;
-Common::FifoQueue<BaseEvent, false> tsQueue;
+// Pending events, as a binary min-heap ordered by (time, fifo_order).
+static std::vector<Event> event_queue;
+// For every event type, the heap index of each of its pending events. Kept up
+// to date as events move in the heap, so events can be found and removed by
+// type without searching the queue.
+static std::vector<std::vector<u32>> event_positions;
+static u64 event_fifo_id;
 
-// event pools
-Event *eventPool = nullptr;
+// Events scheduled from other threads, moved into event_queue by the CPU thread.
+static Common::MPSCQueue<BaseEvent> tsQueue;
 
 int downcount, slicelength;
 int maxSliceLength = MAX_SLICE_LENGTH;
@@ -62,20 +76,92 @@ int ev_lost;
 
 void (*advanceCallback)(int cyclesExecuted) = nullptr;
 
-Event* GetNewEvent()
+static bool EventLess(const Event& a, const Event& b)
+{
+	return (a.time < b.time) | ((a.time == b.time) & (a.fifo_order < b.fifo_order));
+}
+
+static std::vector<Event> GetSortedEvents()
+{
+	std::vector<Event> events(event_queue);
+	std::sort(events.begin(), events.end(), EventLess);
+	return events;
+}
+
+static void PlaceEvent(u32 index, const Event& ev)
 {
-	if (!eventPool)
-		return new Event;
+	event_queue[index] = ev;
+	event_positions[ev.type][ev.type_slot] = index;
+}
 
-	Event* ev = eventPool;
-	eventPool = ev->next;
-	return ev;
+// Fills the hole at index with ev, moving it up as far as it needs to go.
+static void SiftUp(u32 index, const Event& ev)
+{
+	while (index > 0)
+	{
+		u32 parent = (index - 1) / 2;
+		if (!EventLess(ev, event_queue[parent]))
+			break;
+		PlaceEvent(index, event_queue[parent]);
+		index = parent;
+	}
+	PlaceEvent(index, ev);
 }
 
-void FreeEvent(Event* ev)
+static void PushEvent(s64 time, int type, u64 userdata)
 {
-	ev->next = eventPool;
-	eventPool = ev;
+	std::vector<u32>& positions = event_positions[type];
+
+	Event ev;
+	ev.time = time;
+	ev.fifo_order = event_fifo_id++;
+	ev.userdata = userdata;
+	ev.type = type;
+	ev.type_slot = (u32)positions.size();
+
+	positions.push_back((u32)event_queue.size());
+	event_queue.emplace_back();
+	SiftUp((u32)event_queue.size() - 1, ev);
+}
+
+static void RemoveEventAt(u32 index)
+{
+	const int type = event_queue[index].type;
+	const u32 slot = event_queue[index].type_slot;
+	Event last = event_queue.back();
+	event_queue.pop_back();
+	const u32 size = (u32)event_queue.size();
+
+	// Unlink from the type's positions by moving its last entry into our slot.
+	std::vector<u32>& positions = event_positions[type];
+	u32 moved = positions.back();
+	positions.pop_back();
+	if (slot != positions.size())
+	{
+		positions[slot] = moved;
+		if (moved == size)
+			last.type_slot = slot;
+		else
+			event_queue[moved].type_slot = slot;
+	}
+
+	if (index == size)
+		return;
+
+	// Move the hole down to a leaf along the earliest children, then fill it
+	// with the last event. That event was a leaf, so it rarely has to move
+	// back up far, which saves a comparison per level over sifting it down.
+	while (true)
+	{
+		u32 child = index * 2 + 1;
+		if (child >= size)
+			break;
+		if (child + 1 < size)
+			child += EventLess(event_queue[child + 1], event_queue[child]);
+		PlaceEvent(index, event_queue[child]);
+		index = child;
+	}
+	SiftUp(index, last);
 }
 
 static void EmptyTimedCallback(u64 userdata, int cyclesLate) {}
@@ -101,14 +187,16 @@ int RegisterEvent(const std::string& name, TimedCallback callback)
 	}
 
 	event_types.push_back(type);
+	event_positions.emplace_back();
 	return (int)event_types.size() - 1;
 }
 
 void UnregisterAllEvents()
 {
-	if (first)
+	if (!event_queue.empty())
 		PanicAlertT("Cannot unregister events with events pending");
 	event_types.clear();
+	event_positions.clear();
 }
 
 void Init()
@@ -123,17 +211,10 @@ void Init()
 
 void Shutdown()
 {
-	std::lock_guard<std::mutex> lk(tsWriteLock);
 	MoveEvents();
 	ClearPendingEvents();
 	UnregisterAllEvents();
-
-	while (eventPool)
-	{
-		Event *ev = eventPool;
-		eventPool = ev->next;
-		delete ev;
-	}
+	std::vector<Event>().swap(event_queue);
 }
 
 void EventDoState(PointerWrap &p, BaseEvent* ev)
@@ -172,7 +253,6 @@ void EventDoState(PointerWrap &p, BaseEvent* ev)
 
 void DoState(PointerWrap &p)
 {
-	std::lock_guard<std::mutex> lk(tsWriteLock);
 	p.Do(downcount);
 	p.Do(slicelength);
 	p.Do(globalTimer);
@@ -185,7 +265,34 @@ void DoState(PointerWrap &p)
 
 	MoveEvents();
 
-	p.DoLinkedList<BaseEvent, GetNewEvent, FreeEvent, EventDoState>(first);
+	// Same layout as the linked list this used to be: each event in the order
+	// it will run, preceded by a 1 byte, then a 0 byte.
+	if (p.GetMode() == PointerWrap::MODE_READ)
+	{
+		ClearPendingEvents();
+		while (true)
+		{
+			u8 shouldExist = 0;
+			p.Do(shouldExist);
+			if (shouldExist != 1)
+				break;
+			BaseEvent ev;
+			EventDoState(p, &ev);
+			PushEvent(ev.time, ev.type, ev.userdata);
+		}
+	}
+	else
+	{
+		for (const Event& ev : GetSortedEvents())
+		{
+			u8 shouldExist = 1;
+			p.Do(shouldExist);
+			BaseEvent sevt = { ev.time, ev.userdata, ev.type };
+			EventDoState(p, &sevt);
+		}
+		u8 shouldExist = 0;
+		p.Do(shouldExist);
+	}
 	p.DoMarker("CoreTimingEvents");
 }
 
@@ -203,8 +310,7 @@ u64 GetIdleTicks()
 // schedule things to be executed on the main thread.
 void ScheduleEvent_Threadsafe(int cyclesIntoFuture, int event_type, u64 userdata)
 {
-	std::lock_guard<std::mutex> lk(tsWriteLock);
-	Event ne;
+	BaseEvent ne;
 	ne.time = globalTimer + cyclesIntoFuture;
 	ne.type = event_type;
 	ne.userdata = userdata;
@@ -227,30 +333,9 @@ void ScheduleEvent_Threadsafe_Immediate(int event_type, u64 userdata)
 
 void ClearPendingEvents()
 {
-	while (first)
-	{
-		Event *e = first->next;
-		FreeEvent(first);
-		first = e;
-	}
-}
-
-void AddEventToQueue(Event* ne)
-{
-	Event* prev = nullptr;
-	Event** pNext = &first;
-	for (;;)
-	{
-		Event*& next = *pNext;
-		if (!next || ne->time < next->time)
-		{
-			ne->next = next;
-			next = ne;
-			break;
-		}
-		prev = next;
-		pNext = &prev->next;
-	}
+	event_queue.clear();
+	for (auto& positions : event_positions)
+		positions.clear();
 }
 
 // This must be run ONLY from within the cpu thread
@@ -258,11 +343,7 @@ void AddEventToQueue(Event* ne)
 // than Advance
 void ScheduleEvent(int cyclesIntoFuture, int event_type, u64 userdata)
 {
-	Event *ne = GetNewEvent();
-	ne->userdata = userdata;
-	ne->type = event_type;
-	ne->time = globalTimer + cyclesIntoFuture;
-	AddEventToQueue(ne);
+	PushEvent(globalTimer + cyclesIntoFuture, event_type, userdata);
 }
 
 void RegisterAdvanceCallback(void (*callback)(int cyclesExecuted))
@@ -272,55 +353,14 @@ void RegisterAdvanceCallback(void (*callback)(int cyclesExecuted))
 
 bool IsScheduled(int event_type)
 {
-	if (!first)
-		return false;
-	Event *e = first;
-	while (e) {
-		if (e->type == event_type)
-			return true;
-		e = e->next;
-	}
-	return false;
+	return !event_positions[event_type].empty();
 }
 
 void RemoveEvent(int event_type)
 {
-	if (!first)
-		return;
-
-	while (first)
-	{
-		if (first->type == event_type)
-		{
-			Event *next = first->next;
-			FreeEvent(first);
-			first = next;
-		}
-		else
-		{
-			break;
-		}
-	}
-
-	if (!first)
-		return;
-
-	Event *prev = first;
-	Event *ptr = prev->next;
-	while (ptr)
-	{
-		if (ptr->type == event_type)
-		{
-			prev->next = ptr->next;
-			FreeEvent(ptr);
-			ptr = prev->next;
-		}
-		else
-		{
-			prev = ptr;
-			ptr = ptr->next;
-		}
-	}
+	std::vector<u32>& positions = event_positions[event_type];
+	while (!positions.empty())
+		RemoveEventAt(positions.back());
 }
 
 void RemoveAllEvents(int event_type)
@@ -354,22 +394,11 @@ void ProcessFifoWaitEvents()
 {
 	MoveEvents();
 
-	if (!first)
-		return;
-
-	while (first)
+	while (!event_queue.empty() && event_queue[0].time <= globalTimer)
 	{
-		if (first->time <= globalTimer)
-		{
-			Event* evt = first;
-			first = first->next;
-			event_types[evt->type].callback(evt->userdata, (int)(globalTimer - evt->time));
-			FreeEvent(evt);
-		}
-		else
-		{
-			break;
-		}
+		Event evt = event_queue[0];
+		RemoveEventAt(0);
+		event_types[evt.type].callback(evt.userdata, (int)(globalTimer - evt.time));
 	}
 }
 
@@ -377,13 +406,7 @@ void MoveEvents()
 {
 	BaseEvent sevt;
 	while (tsQueue.Pop(sevt))
-	{
-		Event *evt = GetNewEvent();
-		evt->time = sevt.time;
-		evt->userdata = sevt.userdata;
-		evt->type = sevt.type;
-		AddEventToQueue(evt);
-	}
+		PushEvent(sevt.time, sevt.type, sevt.userdata);
 }
 
 void Advance()
@@ -394,31 +417,23 @@ void Advance()
 	globalTimer += cyclesExecuted;
 	downcount = slicelength;
 
-	while (first)
+	while (!event_queue.empty() && event_queue[0].time <= globalTimer)
 	{
-		if (first->time <= globalTimer)
-		{
-			//LOG(POWERPC, "[Scheduler] %s     (%lld, %lld) ",
-			//             event_types[first->type].name ? event_types[first->type].name : "?", (u64)globalTimer, (u64)first->time);
-			Event* evt = first;
-			first = first->next;
-			event_types[evt->type].callback(evt->userdata, (int)(globalTimer - evt->time));
-			FreeEvent(evt);
-		}
-		else
-		{
-			break;
-		}
+		//LOG(POWERPC, "[Scheduler] %s     (%lld, %lld) ",
+		//             event_types[event_queue[0].type].name.c_str(), (u64)globalTimer, (u64)event_queue[0].time);
+		Event evt = event_queue[0];
+		RemoveEventAt(0);
+		event_types[evt.type].callback(evt.userdata, (int)(globalTimer - evt.time));
 	}
 
-	if (!first)
+	if (event_queue.empty())
 	{
 		WARN_LOG(POWERPC, "WARNING - no events in queue. Setting downcount to 10000");
 		downcount += 10000;
 	}
 	else
 	{
-		slicelength = (int)(first->time - globalTimer);
+		slicelength = (int)(event_queue[0].time - globalTimer);
 		if (slicelength > maxSliceLength)
 			slicelength = maxSliceLength;
 		downcount = slicelength;
@@ -430,12 +445,8 @@ void Advance()
 
 void LogPendingEvents()
 {
-	Event *ptr = first;
-	while (ptr)
-	{
-		INFO_LOG(POWERPC, "PENDING: Now: %" PRId64 " Pending: %" PRId64 " Type: %d", globalTimer, ptr->time, ptr->type);
-		ptr = ptr->next;
-	}
+	for (const Event& ev : GetSortedEvents())
+		INFO_LOG(POWERPC, "PENDING: Now: %" PRId64 " Pending: %" PRId64 " Type: %d", globalTimer, ev.time, ev.type);
 }
 
 void Idle()
@@ -459,19 +470,17 @@ void Idle()
 
 std::string GetScheduledEventsSummary()
 {
-	Event *ptr = first;
 	std::string text = "Scheduled events\n";
 	text.reserve(1000);
-	while (ptr)
+	for (const Event& ev : GetSortedEvents())
 	{
-		unsigned int t = ptr->type;
+		unsigned int t = ev.type;
 		if (t >= event_types.size())
 			PanicAlertT("Invalid event type %i", t);
 
-		const std::string& name = event_types[ptr->type].name;
+		const std::string& name = event_types[ev.type].name;
 
-		text += StringFromFormat("%s : %" PRIi64 " %016" PRIx64 "\n", name.c_str(), ptr->time, ptr->userdata);
-		ptr = ptr->next;
+		text += StringFromFormat("%s : %" PRIi64 " %016" PRIx64 "\n", name.c_str(), ev.time, ev.userdata);
 	}
 	return text;
 }
@@ -35,6 +35,7 @@
 #include "Core/DSP/DSPHWInterface.h"
 #include "Core/DSP/DSPInterpreter.h"
 #include "Core/DSP/DSPTables.h"
+#include "Core/HW/WriteTracker.h"
 
 #if _M_SSE >= 0x301 && !(defined __GNUC__ && !defined __SSSE3__)
 #include <tmmintrin.h>
@@ -305,6 +306,8 @@ static void gdsp_ddma_out(u16 dsp_addr, u32 addr, u32 size)
 		}
 	}
 
+	WriteTracker::Written(addr & 0x7FFFFFFF, size);
+
 	INFO_LOG(DSPLLE, "*** ddma_out DRAM_DSP (0x%04x) -> RAM (0x%08x) : size (0x%08x)", dsp_addr / 2, addr, size);
 }
 
@@ -13,6 +13,7 @@
 #include "Core/HW/GPFifo.h"
 #include "Core/HW/Memmap.h"
 #include "Core/HW/SystemTimers.h"
+#include "Core/HW/WriteTracker.h"
 #include "Core/PowerPC/PowerPC.h"
 
 #include "VideoCommon/BPMemory.h"
@@ -279,6 +280,7 @@ void FifoPlayer::WriteMemory(const MemoryUpdate& memUpdate)
 		mem = &Memory::m_pRAM[memUpdate.address & Memory::RAM_MASK];
 
 	memcpy(mem, memUpdate.data, memUpdate.size);
+	WriteTracker::Written(memUpdate.address, memUpdate.size);
 }
 
 void FifoPlayer::WriteFifo(u8 *data, u32 start, u32 end)
@@ -35,6 +35,7 @@
 #include "Core/HW/Memmap.h"
 #include "Core/HW/MMIO.h"
 #include "Core/HW/ProcessorInterface.h"
+#include "Core/HW/WriteTracker.h"
 #include "Core/PowerPC/PowerPC.h"
 
 namespace DSP
@@ -609,6 +610,7 @@ void Do_ARAM_DMA()
 
 		if (g_arDMA.ARAddr < g_ARAM.size)
 		{
+			const u32 start = g_arDMA.ARAddr, size = g_arDMA.Cnt.count;
 			while (g_arDMA.Cnt.count)
 			{
 				if ((g_ARAM_Info.Hex & 0xf) == 3)
@@ -632,6 +634,10 @@ void Do_ARAM_DMA()
 				g_arDMA.ARAddr += 8;
 				g_arDMA.Cnt.count -= 8;
 			}
+
+			// On the Wii, ARAM is EXRAM.
+			if (g_ARAM.wii_mode)
+				WriteTracker::Written(0x10000000 | start, size);
 		}
 		else
 		{
@@ -4,6 +4,7 @@
 
 #include "Common/FileUtil.h"
 #include "Common/MathUtil.h"
+#include "Common/ParallelFor.h"
 
 #include "Core/ConfigManager.h"
 #include "Core/HW/DSP.h"
@@ -22,6 +23,13 @@ CUCode_AX::CUCode_AX(DSPHLE* dsp_hle, u32 crc)
 	DSP::GenerateDSPInterruptFromDSPEmu(DSP::INT_DSP);
 
 	LoadResamplingCoefficients();
+
+	// One thread a core is plenty for a few dozen voices.
+	int mix_threads = SConfig::GetInstance().m_AXMixThreads;
+	if (mix_threads <= 0)
+		mix_threads = std::min(4u, Common::GetNumWorkerThreads());
+	if (mix_threads > 1)
+		m_mix_pool.reset(new Common::WorkerPool(mix_threads));
 }
 
 CUCode_AX::~CUCode_AX()
@@ -387,24 +395,21 @@ void CUCode_AX::ProcessPBList(u32 pb_addr)
 	// 32KHz to 48KHz, but AX always process at 32KHz.
 	const u32 spms = 32;
 
-	AXPB pb;
-
-	while (pb_addr)
-	{
-		AXBuffers buffers = {{
-			m_samples_left,
-			m_samples_right,
-			m_samples_surround,
-			m_samples_auxA_left,
-			m_samples_auxA_right,
-			m_samples_auxA_surround,
-			m_samples_auxB_left,
-			m_samples_auxB_right,
-			m_samples_auxB_surround
-		}};
+	AXBuffers buffers = {{
+		m_samples_left,
+		m_samples_right,
+		m_samples_surround,
+		m_samples_auxA_left,
+		m_samples_auxA_right,
+		m_samples_auxA_surround,
+		m_samples_auxB_left,
+		m_samples_auxB_right,
+		m_samples_auxB_surround
+	}};
 
-		if (!ReadPB(pb_addr, pb))
-			break;
+	// Processes the 5ms of a frame of a PB, mixing them to frame_buffers.
+	auto process = [this](AXPB& pb, const AXBuffers& frame_buffers) {
+		AXBuffers buffers = frame_buffers;
 
 		u32 updates_addr = HILO_TO_32(pb.updates.data);
 		u16* updates = (u16*)HLEMemory_Get_Pointer(updates_addr);
@@ -420,10 +425,48 @@ void CUCode_AX::ProcessPBList(u32 pb_addr)
 			for (u32 i = 0; i < sizeof (buffers.ptrs) / sizeof (buffers.ptrs[0]); ++i)
 				buffers.ptrs[i] += spms;
 		}
+	};
+
+	AXPB pb;
+
+	if (!m_mix_pool)
+	{
+		while (pb_addr)
+		{
+			if (!ReadPB(pb_addr, pb))
+				break;
+
+			process(pb, buffers);
+
+			WritePB(pb_addr, pb);
+			pb_addr = HILO_TO_32(pb.next_pb);
+		}
+		return;
+	}
 
-		WritePB(pb_addr, pb);
+	// Read the whole list first, so that the voices can be handed out.
+	// Processing a PB never changes where it links to, but its updates can,
+	// so follow the link with all of them applied.
+	std::vector<u32> pb_addrs;
+	std::vector<AXPB> pbs;
+	while (pb_addr)
+	{
+		if (!ReadPB(pb_addr, pb))
+			break;
+
+		pb_addrs.push_back(pb_addr);
+		pbs.push_back(pb);
+
+		u16* updates = (u16*)HLEMemory_Get_Pointer(HILO_TO_32(pb.updates.data));
+		for (int curr_ms = 0; curr_ms < 5; ++curr_ms)
+			ApplyUpdatesForMs(curr_ms, (u16*)&pb, pb.updates.num_updates, updates);
 		pb_addr = HILO_TO_32(pb.next_pb);
 	}
+
+	MixVoices(m_mix_pool.get(), pbs, buffers, process);
+
+	for (size_t i = 0; i < pbs.size(); ++i)
+		WritePB(pb_addrs[i], pbs[i]);
 }
 
 void CUCode_AX::MixAUXSamples(int aux_id, u32 write_addr, u32 read_addr)
@@ -12,9 +12,13 @@
 
 #pragma once
 
+#include <memory>
+
 #include "Core/HW/DSPHLE/UCodes/UCode_AXStructs.h"
 #include "Core/HW/DSPHLE/UCodes/UCodes.h"
 
+namespace Common { class WorkerPool; }
+
 // We can't directly use the mixer_control field from the PB because it does
 // not mean the same in all AX versions. The AX UCode converts the
 // mixer_control value to an AXMixControl bitfield.
@@ -96,6 +100,9 @@ protected:
 	bool m_coeffs_available;
 	s16 m_coeffs[0x800];
 
+	// Mixes the voices of long PB lists in parallel, if enabled.
+	std::unique_ptr<Common::WorkerPool> m_mix_pool;
+
 	void LoadResamplingCoefficients();
 
 	// Copy a command list from memory to our temp buffer
@@ -426,35 +426,32 @@ void CUCode_AXWii::ReinjectUpdatesFields(AXPBWii& pb, u16* num_updates, u32 upda
 
 void CUCode_AXWii::ProcessPBList(u32 pb_addr)
 {
-	AXPBWii pb;
-
-	while (pb_addr)
-	{
-		AXBuffers buffers = {{
-			m_samples_left,
-			m_samples_right,
-			m_samples_surround,
-			m_samples_auxA_left,
-			m_samples_auxA_right,
-			m_samples_auxA_surround,
-			m_samples_auxB_left,
-			m_samples_auxB_right,
-			m_samples_auxB_surround,
-			m_samples_auxC_left,
-			m_samples_auxC_right,
-			m_samples_auxC_surround,
-			m_samples_wm0,
-			m_samples_aux0,
-			m_samples_wm1,
-			m_samples_aux1,
-			m_samples_wm2,
-			m_samples_aux2,
-			m_samples_wm3,
-			m_samples_aux3
-		}};
+	AXBuffers buffers = {{
+		m_samples_left,
+		m_samples_right,
+		m_samples_surround,
+		m_samples_auxA_left,
+		m_samples_auxA_right,
+		m_samples_auxA_surround,
+		m_samples_auxB_left,
+		m_samples_auxB_right,
+		m_samples_auxB_surround,
+		m_samples_auxC_left,
+		m_samples_auxC_right,
+		m_samples_auxC_surround,
+		m_samples_wm0,
+		m_samples_aux0,
+		m_samples_wm1,
+		m_samples_aux1,
+		m_samples_wm2,
+		m_samples_aux2,
+		m_samples_wm3,
+		m_samples_aux3
+	}};
 
-		if (!ReadPB(pb_addr, pb))
-			break;
+	// Processes the 3ms of a frame of a PB, mixing them to frame_buffers.
+	auto process = [this](AXPBWii& pb, const AXBuffers& frame_buffers) {
+		AXBuffers buffers = frame_buffers;
 
 		u16 num_updates[3];
 		u16 updates[1024];
@@ -468,9 +465,7 @@ void CUCode_AXWii::ProcessPBList(u32 pb_addr)
 				             ConvertMixerControl(HILO_TO_32(pb.mixer_control)),
 				             m_coeffs_available ? m_coeffs : nullptr);
 
-				// Forward the buffers
-				for (u32 i = 0; i < sizeof (buffers.ptrs) / sizeof (buffers.ptrs[0]); ++i)
-					buffers.ptrs[i] += 32;
+				ForwardBuffersOneMs(buffers);
 			}
 			ReinjectUpdatesFields(pb, num_updates, updates_addr);
 		}
@@ -480,10 +475,53 @@ void CUCode_AXWii::ProcessPBList(u32 pb_addr)
 			             ConvertMixerControl(HILO_TO_32(pb.mixer_control)),
 			             m_coeffs_available ? m_coeffs : nullptr);
 		}
+	};
+
+	AXPBWii pb;
 
-		WritePB(pb_addr, pb);
+	if (!m_mix_pool)
+	{
+		while (pb_addr)
+		{
+			if (!ReadPB(pb_addr, pb))
+				break;
+
+			process(pb, buffers);
+
+			WritePB(pb_addr, pb);
+			pb_addr = HILO_TO_32(pb.next_pb);
+		}
+		return;
+	}
+
+	// Read the whole list first, as CUCode_AX::ProcessPBList does, following
+	// the links with the updates applied.
+	std::vector<u32> pb_addrs;
+	std::vector<AXPBWii> pbs;
+	while (pb_addr)
+	{
+		if (!ReadPB(pb_addr, pb))
+			break;
+
+		pb_addrs.push_back(pb_addr);
+		pbs.push_back(pb);
+
+		u16 num_updates[3];
+		u16 updates[1024];
+		u32 updates_addr;
+		if (ExtractUpdatesFields(pb, num_updates, updates, &updates_addr))
+		{
+			for (int curr_ms = 0; curr_ms < 3; ++curr_ms)
+				ApplyUpdatesForMs(curr_ms, (u16*)&pb, num_updates, updates);
+			ReinjectUpdatesFields(pb, num_updates, updates_addr);
+		}
 		pb_addr = HILO_TO_32(pb.next_pb);
 	}
+
+	MixVoices(m_mix_pool.get(), pbs, buffers, process);
+
+	for (size_t i = 0; i < pbs.size(); ++i)
+		WritePB(pb_addrs[i], pbs[i]);
 }
 
 void CUCode_AXWii::MixAUXSamples(int aux_id, u32 write_addr, u32 read_addr, u16 volume)
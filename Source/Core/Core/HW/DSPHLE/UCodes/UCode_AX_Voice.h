@@ -12,15 +12,21 @@
 #error UCode_AX_Voice.h included without specifying version
 #endif
 
-#include <functional>
+#include <algorithm>
+#include <vector>
 
 #include "Common/Common.h"
 #include "Common/MathUtil.h"
+#include "Common/ParallelFor.h"
 #include "Core/HW/DSP.h"
 #include "Core/HW/Memmap.h"
 #include "Core/HW/DSPHLE/UCodes/UCode_AX.h"
 #include "Core/HW/DSPHLE/UCodes/UCode_AXStructs.h"
 
+#if _M_X86
+#include <emmintrin.h>
+#endif
+
 #ifdef AX_GC
 # define PB_TYPE AXPB
 # define MAX_SAMPLES_PER_FRAME 32
@@ -127,130 +133,183 @@ void DumpPB(const PB_TYPE& pb)
 }
 #endif
 
-// Simulated accelerator state.
-static u32 acc_loop_addr, acc_end_addr;
-static u32* acc_cur_addr;
-static PB_TYPE* acc_pb;
-static bool acc_end_reached;
+// Simulated accelerator state, for the voice being processed. Each thread
+// mixing voices has its own.
+struct Accelerator
+{
+	u32 loop_addr, end_addr;
+	u32* cur_addr;
+	PB_TYPE* pb;
+	bool end_reached;
+};
 
 // Sets up the simulated accelerator.
-void AcceleratorSetup(PB_TYPE* pb, u32* cur_addr)
+void AcceleratorSetup(Accelerator* acc, PB_TYPE* pb, u32* cur_addr)
 {
-	acc_pb = pb;
-	acc_loop_addr = HILO_TO_32(pb->audio_addr.loop_addr);
-	acc_end_addr = HILO_TO_32(pb->audio_addr.end_addr);
-	acc_cur_addr = cur_addr;
-	acc_end_reached = false;
+	acc->pb = pb;
+	acc->loop_addr = HILO_TO_32(pb->audio_addr.loop_addr);
+	acc->end_addr = HILO_TO_32(pb->audio_addr.end_addr);
+	acc->cur_addr = cur_addr;
+	acc->end_reached = false;
 }
 
-// Reads a sample from the simulated accelerator. Also handles looping and
-// disabling streams that reached the end (this is done by an exception raised
-// by the accelerator on real hardware).
-u16 AcceleratorGetSample()
+// Reads count samples from the simulated accelerator. Also handles looping
+// and disabling streams that reached the end (this is done by an exception
+// raised by the accelerator on real hardware).
+//
+// Samples are decoded in runs up to the next end address check that could
+// hit, or ADPCM frame header, which come out the same as taking them one at
+// a time but without going back to the PB for each.
+void AcceleratorGetSamples(Accelerator& acc, s16* samples, u32 count)
 {
-	u16 ret;
-
-	// Have we reached the end address?
-	//
-	// On real hardware, this would raise an interrupt that is handled by the
-	// UCode. We simulate what this interrupt does here.
-	if ((*acc_cur_addr & ~1) == (acc_end_addr & ~1))
+	u32 i = 0;
+	while (i < count)
 	{
-		// loop back to loop_addr.
-		*acc_cur_addr = acc_loop_addr;
-
-		if (acc_pb->audio_addr.looping)
+		// Have we reached the end address?
+		//
+		// On real hardware, this would raise an interrupt that is handled by the
+		// UCode. We simulate what this interrupt does here.
+		const u32 end = acc.end_addr & ~1;
+		if ((*acc.cur_addr & ~1) == end)
 		{
-			// Set the ADPCM infos to continue processing at loop_addr.
-			//
-			// For some reason, yn1 and yn2 aren't set if the voice is not of
-			// stream type. This is what the AX UCode does and I don't really
-			// know why.
-			acc_pb->adpcm.pred_scale = acc_pb->adpcm_loop_info.pred_scale;
-			if (!acc_pb->is_stream)
+			// loop back to loop_addr.
+			*acc.cur_addr = acc.loop_addr;
+
+			if (acc.pb->audio_addr.looping)
 			{
-				acc_pb->adpcm.yn1 = acc_pb->adpcm_loop_info.yn1;
-				acc_pb->adpcm.yn2 = acc_pb->adpcm_loop_info.yn2;
+				// Set the ADPCM infos to continue processing at loop_addr.
+				//
+				// For some reason, yn1 and yn2 aren't set if the voice is not of
+				// stream type. This is what the AX UCode does and I don't really
+				// know why.
+				acc.pb->adpcm.pred_scale = acc.pb->adpcm_loop_info.pred_scale;
+				if (!acc.pb->is_stream)
+				{
+					acc.pb->adpcm.yn1 = acc.pb->adpcm_loop_info.yn1;
+					acc.pb->adpcm.yn2 = acc.pb->adpcm_loop_info.yn2;
+				}
 			}
-		}
-		else
-		{
-			// Non looping voice reached the end -> running = 0.
-			acc_pb->running = 0;
+			else
+			{
+				// Non looping voice reached the end -> running = 0.
+				acc.pb->running = 0;
 
 #ifdef AX_WII
-			// One of the few meaningful differences between AXGC and AXWii:
-			// while AXGC handles non looping voices ending by having 0000
-			// samples at the loop address, AXWii has the 0000 samples
-			// internally in DRAM and use an internal pointer to it (loop addr
-			// does not contain 0000 samples on AXWii!).
-			acc_end_reached = true;
+				// One of the few meaningful differences between AXGC and AXWii:
+				// while AXGC handles non looping voices ending by having 0000
+				// samples at the loop address, AXWii has the 0000 samples
+				// internally in DRAM and use an internal pointer to it (loop addr
+				// does not contain 0000 samples on AXWii!).
+				acc.end_reached = true;
 #endif
+			}
 		}
-	}
 
-	// See above for explanations about acc_end_reached.
-	if (acc_end_reached)
-		return 0;
+		// See above for explanations about acc.end_reached.
+		if (acc.end_reached)
+		{
+			memset(&samples[i], 0, (count - i) * sizeof(s16));
+			return;
+		}
 
-	switch (acc_pb->audio_addr.sample_format)
-	{
-		case 0x00: // ADPCM
+		u32 addr = *acc.cur_addr;
+		if (acc.pb->audio_addr.sample_format == 0x00 && (addr & 15) == 0)
+		{
+			// ADPCM frame header.
+			acc.pb->adpcm.pred_scale = DSP::ReadARAM((addr & ~15) >> 1);
+			addr += 2;
+		}
+
+		// The run goes on until the next address the end check above would
+		// hit on. The one for its first sample was just done, and not again
+		// after skipping a header.
+		const u32 to_end = end - addr;
+		u32 run = std::min(count - i, to_end ? to_end : 1);
+
+		switch (acc.pb->audio_addr.sample_format)
 		{
-			// ADPCM decoding, not much to explain here.
-			if ((*acc_cur_addr & 15) == 0)
+			case 0x00: // ADPCM
 			{
-				acc_pb->adpcm.pred_scale = DSP::ReadARAM((*acc_cur_addr & ~15) >> 1);
-				*acc_cur_addr += 2;
-			}
+				// ADPCM decoding, not much to explain here.
+				run = std::min(run, 16 - (addr & 15));
+
+				const int scale = 1 << (acc.pb->adpcm.pred_scale & 0xF);
+				const int coef_idx = (acc.pb->adpcm.pred_scale >> 4) & 0x7;
 
-			int scale = 1 << (acc_pb->adpcm.pred_scale & 0xF);
-			int coef_idx = (acc_pb->adpcm.pred_scale >> 4) & 0x7;
+				const s32 coef1 = acc.pb->adpcm.coefs[coef_idx * 2 + 0];
+				const s32 coef2 = acc.pb->adpcm.coefs[coef_idx * 2 + 1];
+				s16 yn1 = acc.pb->adpcm.yn1, yn2 = acc.pb->adpcm.yn2;
 
-			s32 coef1 = acc_pb->adpcm.coefs[coef_idx * 2 + 0];
-			s32 coef2 = acc_pb->adpcm.coefs[coef_idx * 2 + 1];
+				u8 byte = DSP::ReadARAM(addr >> 1);
+				for (u32 j = 0; j < run; ++j, ++addr)
+				{
+					if (j && !(addr & 1))
+						byte = DSP::ReadARAM(addr >> 1);
+					int temp = (addr & 1) ? (byte & 0xF) : (byte >> 4);
 
-			int temp = (*acc_cur_addr & 1) ?
-					(DSP::ReadARAM(*acc_cur_addr >> 1) & 0xF) :
-					(DSP::ReadARAM(*acc_cur_addr >> 1) >> 4);
+					if (temp >= 8)
+						temp -= 16;
 
-			if (temp >= 8)
-				temp -= 16;
+					int val = (scale * temp) + ((0x400 + coef1 * yn1 + coef2 * yn2) >> 11);
+					MathUtil::Clamp(&val, -0x7FFF, 0x7FFF);
 
-			int val = (scale * temp) + ((0x400 + coef1 * acc_pb->adpcm.yn1 + coef2 * acc_pb->adpcm.yn2) >> 11);
-			MathUtil::Clamp(&val, -0x7FFF, 0x7FFF);
+					yn2 = yn1;
+					yn1 = val;
+					samples[i + j] = val;
+				}
+
+				acc.pb->adpcm.yn1 = yn1;
+				acc.pb->adpcm.yn2 = yn2;
+				break;
+			}
 
-			acc_pb->adpcm.yn2 = acc_pb->adpcm.yn1;
-			acc_pb->adpcm.yn1 = val;
-			*acc_cur_addr += 1;
-			ret = val;
-			break;
+			case 0x0A: // 16-bit PCM audio
+				for (u32 j = 0; j < run; ++j, ++addr)
+					samples[i + j] = (DSP::ReadARAM(addr * 2) << 8) | DSP::ReadARAM(addr * 2 + 1);
+				acc.pb->adpcm.yn2 = run > 1 ? samples[i + run - 2] : acc.pb->adpcm.yn1;
+				acc.pb->adpcm.yn1 = samples[i + run - 1];
+				break;
+
+			case 0x19: // 8-bit PCM audio
+				for (u32 j = 0; j < run; ++j, ++addr)
+					samples[i + j] = DSP::ReadARAM(addr) << 8;
+				acc.pb->adpcm.yn2 = run > 1 ? samples[i + run - 2] : acc.pb->adpcm.yn1;
+				acc.pb->adpcm.yn1 = samples[i + run - 1];
+				break;
+
+			default:
+				ERROR_LOG(DSPHLE, "Unknown sample format: %d", acc.pb->audio_addr.sample_format);
+				run = 1;
+				samples[i] = 0;
+				break;
 		}
 
-		case 0x0A: // 16-bit PCM audio
-			ret = (DSP::ReadARAM(*acc_cur_addr * 2) << 8) | DSP::ReadARAM(*acc_cur_addr * 2 + 1);
-			acc_pb->adpcm.yn2 = acc_pb->adpcm.yn1;
-			acc_pb->adpcm.yn1 = ret;
-			*acc_cur_addr += 1;
-			break;
-
-		case 0x19: // 8-bit PCM audio
-			ret = DSP::ReadARAM(*acc_cur_addr) << 8;
-			acc_pb->adpcm.yn2 = acc_pb->adpcm.yn1;
-			acc_pb->adpcm.yn1 = ret;
-			*acc_cur_addr += 1;
-			break;
-
-		default:
-			ERROR_LOG(DSPHLE, "Unknown sample format: %d", acc_pb->audio_addr.sample_format);
-			return 0;
+		*acc.cur_addr = addr;
+		i += run;
 	}
+}
+
+// How many input samples ResampleAudio goes through to make count output
+// samples, from the same arguments.
+u32 ResampleInputCount(u32 count, u32 curr_pos, u32 ratio, int srctype)
+{
+	if (srctype != SRCTYPE_LINEAR && srctype != SRCTYPE_POLYPHASE)
+		return count;
 
-	return ret;
+	u32 read_samples_count = 0;
+	for (u32 i = 0; i < count; ++i)
+	{
+		curr_pos += ratio;
+		read_samples_count += curr_pos >> 16;
+		curr_pos &= 0xFFFF;
+	}
+	return read_samples_count;
 }
 
-// Reads samples from the input callback, resamples them to <count> samples at
-// the wanted sample rate (computed from the ratio, see below).
+// Resamples the input samples to <count> samples at the wanted sample rate
+// (computed from the ratio, see below). <input> starts with four samples of
+// room, which this fills from <last_samples>, followed by as many samples as
+// ResampleInputCount says.
 //
 // If srctype is SRCTYPE_POLYPHASE, coefficients need to be provided as well
 // (or the srctype will automatically be changed to LINEAR).
@@ -269,11 +328,14 @@ u16 AcceleratorGetSample()
 // We start getting samples not from sample 0, but 0.<curr_pos_frac>. This
 // avoids discontinuities in the audio stream, especially with very low ratios
 // which interpolate a lot of values between two "real" samples.
-u32 ResampleAudio(std::function<s16(u32)> input_callback, s16* output, u32 count,
-                  s16* last_samples, u32 curr_pos, u32 ratio, int srctype,
-                  const s16* coeffs)
+u32 ResampleAudio(s16* input, s16* output, u32 count, s16* last_samples,
+                  u32 curr_pos, u32 ratio, int srctype, const s16* coeffs)
 {
-	int read_samples_count = 0;
+	memcpy(input, last_samples, 4 * sizeof (s16));
+
+	// With <read> samples read so far, the last four are input[read] to
+	// input[read + 3].
+	u32 read = 0;
 
 	// TODO(delroth): find out why the polyphase resampling algorithm causes
 	// audio glitches in Wii games with non integral ratios.
@@ -281,104 +343,55 @@ u32 ResampleAudio(std::function<s16(u32)> input_callback, s16* output, u32 count
 	// If DSP DROM coefficients are available, support polyphase resampling.
 	if (0) // if (coeffs && srctype == SRCTYPE_POLYPHASE)
 	{
-		s16 temp[4];
-		u32 idx = 0;
-
-		temp[idx++ & 3] = last_samples[0];
-		temp[idx++ & 3] = last_samples[1];
-		temp[idx++ & 3] = last_samples[2];
-		temp[idx++ & 3] = last_samples[3];
-
 		for (u32 i = 0; i < count; ++i)
 		{
 			curr_pos += ratio;
-			while (curr_pos >= 0x10000)
-			{
-				temp[idx++ & 3] = input_callback(read_samples_count++);
-				curr_pos -= 0x10000;
-			}
+			read += curr_pos >> 16;
+			curr_pos &= 0xFFFF;
 
 			u16 curr_pos_frac = ((curr_pos & 0xFFFF) >> 9) << 2;
 			const s16* c = &coeffs[curr_pos_frac];
+			const s16* t = &input[read];
 
-			s64 t0 = temp[idx++ & 3];
-			s64 t1 = temp[idx++ & 3];
-			s64 t2 = temp[idx++ & 3];
-			s64 t3 = temp[idx++ & 3];
-
-			s64 samp = (t0 * c[0] + t1 * c[1] + t2 * c[2] + t3 * c[3]) >> 15;
+			s64 samp = ((s64)t[0] * c[0] + (s64)t[1] * c[1] + (s64)t[2] * c[2] + (s64)t[3] * c[3]) >> 15;
 
 			output[i] = (s16)samp;
 		}
 
-		last_samples[3] = temp[--idx & 3];
-		last_samples[2] = temp[--idx & 3];
-		last_samples[1] = temp[--idx & 3];
-		last_samples[0] = temp[--idx & 3];
+		memcpy(last_samples, &input[read], 4 * sizeof (s16));
 	}
 	else if (srctype == SRCTYPE_LINEAR || srctype == SRCTYPE_POLYPHASE)
 	{
-		// This is the circular buffer containing samples to use for the
-		// interpolation. It is initialized with the values from the PB, and it
-		// will be stored back to the PB at the end.
-		s16 temp[4];
-		u32 idx = 0;
-
-		temp[idx++ & 3] = last_samples[0];
-		temp[idx++ & 3] = last_samples[1];
-		temp[idx++ & 3] = last_samples[2];
-		temp[idx++ & 3] = last_samples[3];
-
-		for (u32 i = 0; i < count; ++i)
+		if (ratio == 0x10000 && curr_pos == 0)
 		{
-			curr_pos += ratio;
-
-			// While our current position is >= 1.0, push new samples to the
-			// circular buffer.
-			while (curr_pos >= 0x10000)
-			{
-				temp[idx++ & 3] = input_callback(read_samples_count++);
-				curr_pos -= 0x10000;
-			}
-
-			// Get our current fractional position, used to know how much of
-			// curr0 and how much of curr1 the output sample should be.
-			u16 curr_frac = curr_pos & 0xFFFF;
-			u16 inv_curr_frac = -curr_frac;
-
-			// Interpolate! If curr_frac is 0, we can simply take the last
-			// sample without any multiplying.
-			s16 sample;
-			if (curr_frac)
-			{
-				s32 s0 = temp[idx++ & 3];
-				s32 s1 = temp[idx++ & 3];
-
-				sample = ((s0 * inv_curr_frac) + (s1 * curr_frac)) >> 16;
-				idx += 2;
-			}
-			else
+			// The same rate, and on a sample: nothing to interpolate.
+			memcpy(output, &input[1], count * sizeof (s16));
+			read = count;
+		}
+		else
+		{
+			for (u32 i = 0; i < count; ++i)
 			{
-				sample = temp[idx++ & 3];
-				idx += 3;
+				curr_pos += ratio;
+				read += curr_pos >> 16;
+				curr_pos &= 0xFFFF;
+
+				// Interpolate between the oldest two of the last four samples
+				// read, by how far between them the current position is. If
+				// it's right on the first, that's the sample as it is.
+				s32 s0 = input[read];
+				s32 s1 = input[read + 1];
+				output[i] = ((s0 * (0x10000 - (s32)curr_pos)) + (s1 * (s32)curr_pos)) >> 16;
 			}
-
-			output[i] = sample;
 		}
 
-		// Update the four last_samples values.
-		last_samples[3] = temp[--idx & 3];
-		last_samples[2] = temp[--idx & 3];
-		last_samples[1] = temp[--idx & 3];
-		last_samples[0] = temp[--idx & 3];
+		memcpy(last_samples, &input[read], 4 * sizeof (s16));
 	}
 	else // SRCTYPE_NEAREST
 	{
 		// No sample rate conversion here: simply read samples from the
 		// accelerator to the output buffer.
-		for (u32 i = 0; i < count; ++i)
-			output[i] = input_callback(i);
-
+		memcpy(output, &input[4], count * sizeof (s16));
 		memcpy(last_samples, output + count - 4, 4 * sizeof (u16));
 	}
 
@@ -390,14 +403,28 @@ u32 ResampleAudio(std::function<s16(u32)> input_callback, s16* output, u32 count
 void GetInputSamples(PB_TYPE& pb, s16* samples, u16 count, const s16* coeffs)
 {
 	u32 cur_addr = HILO_TO_32(pb.audio_addr.cur_addr);
-	AcceleratorSetup(&pb, &cur_addr);
+	Accelerator acc;
+	AcceleratorSetup(&acc, &pb, &cur_addr);
 
 	if (coeffs)
 		coeffs += pb.coef_select * 0x200;
-	u32 curr_pos = ResampleAudio([](u32) { return AcceleratorGetSample(); },
-	                             samples, count, pb.src.last_samples,
-	                             pb.src.cur_addr_frac, HILO_TO_32(pb.src.ratio),
-	                             pb.src_type, coeffs);
+
+	// Decode all the resampler needs in one go. Within the valid range of
+	// ratios, up to 4.0, that fits on the stack.
+	const u32 ratio = HILO_TO_32(pb.src.ratio);
+	const u32 input_count = ResampleInputCount(count, pb.src.cur_addr_frac, ratio, pb.src_type);
+	s16 input_buffer[4 + MAX_SAMPLES_PER_FRAME * 4 + 1];
+	std::vector<s16> large_input;
+	s16* input = input_buffer;
+	if (input_count > ArraySize(input_buffer) - 4)
+	{
+		large_input.resize(4 + input_count);
+		input = large_input.data();
+	}
+	AcceleratorGetSamples(acc, &input[4], input_count);
+
+	u32 curr_pos = ResampleAudio(input, samples, count, pb.src.last_samples,
+	                             pb.src.cur_addr_frac, ratio, pb.src_type, coeffs);
 	pb.src.cur_addr_frac = (curr_pos & 0xFFFF);
 
 	// Update current position in the PB.
@@ -405,6 +432,49 @@ void GetInputSamples(PB_TYPE& pb, s16* samples, u16 count, const s16* coeffs)
 	pb.audio_addr.cur_addr_lo = (u16)(cur_addr & 0xFFFF);
 }
 
+#if _M_X86
+// (s16)((sample * volume) >> 15) for eight signed samples and unsigned
+// volumes, as the scalar code does it on 32 bits.
+inline __m128i MulVolume(__m128i samples, __m128i volumes)
+{
+	const __m128i lo = _mm_mullo_epi16(samples, volumes);
+	// The high half as if the volumes were signed, then corrected for those
+	// of 0x8000 and up.
+	__m128i hi = _mm_mulhi_epi16(samples, volumes);
+	hi = _mm_add_epi16(hi, _mm_and_si128(samples, _mm_srai_epi16(volumes, 15)));
+	return _mm_or_si128(_mm_slli_epi16(hi, 1), _mm_srli_epi16(lo, 15));
+}
+
+// The volumes of eight samples from volume on, going up by delta each.
+inline __m128i VolumeRamp(u16 volume, u16 delta)
+{
+	const __m128i steps = _mm_setr_epi16(0, 1, 2, 3, 4, 5, 6, 7);
+	return _mm_add_epi16(_mm_set1_epi16(volume), _mm_mullo_epi16(_mm_set1_epi16(delta), steps));
+}
+#endif
+
+// Apply a volume ramp to samples in place, moving volume on to where it ends.
+void ApplyVolume(s16* samples, u32 count, u16& volume, u16 volume_delta)
+{
+	u32 i = 0;
+#if _M_X86
+	__m128i volumes = VolumeRamp(volume, volume_delta);
+	const __m128i step = _mm_set1_epi16((s16)(volume_delta * 8));
+	for (; i + 8 <= count; i += 8)
+	{
+		__m128i* ptr = (__m128i*)&samples[i];
+		_mm_storeu_si128(ptr, MulVolume(_mm_loadu_si128(ptr), volumes));
+		volumes = _mm_add_epi16(volumes, step);
+	}
+	volume += volume_delta * i;
+#endif
+	for (; i < count; ++i)
+	{
+		samples[i] = ((s32)samples[i] * volume) >> 15;
+		volume += volume_delta;
+	}
+}
+
 // Add samples to an output buffer, with optional volume ramping.
 void MixAdd(int* out, const s16* input, u32 count, u16* pvol, s16* dpop, bool ramp)
 {
@@ -417,7 +487,23 @@ void MixAdd(int* out, const s16* input, u32 count, u16* pvol, s16* dpop, bool ra
 	if (!ramp)
 		volume_delta = 0;
 
-	for (u32 i = 0; i < count; ++i)
+	u32 i = 0;
+#if _M_X86
+	__m128i volumes = VolumeRamp(volume, volume_delta);
+	const __m128i step = _mm_set1_epi16((s16)(volume_delta * 8));
+	for (; i + 8 <= count; i += 8)
+	{
+		const __m128i samples = MulVolume(_mm_loadu_si128((const __m128i*)&input[i]), volumes);
+		__m128i* dst = (__m128i*)&out[i];
+		_mm_storeu_si128(dst, _mm_add_epi32(_mm_loadu_si128(dst), _mm_srai_epi32(_mm_unpacklo_epi16(samples, samples), 16)));
+		_mm_storeu_si128(dst + 1, _mm_add_epi32(_mm_loadu_si128(dst + 1), _mm_srai_epi32(_mm_unpackhi_epi16(samples, samples), 16)));
+		volumes = _mm_add_epi16(volumes, step);
+		*dpop = (s16)_mm_extract_epi16(samples, 7);
+	}
+	volume += volume_delta * i;
+#endif
+
+	for (; i < count; ++i)
 	{
 		s64 sample = input[i];
 		sample *= volume;
@@ -452,11 +538,7 @@ void ProcessVoice(PB_TYPE& pb, const AXBuffers& buffers, u16 count, AXMixControl
 	GetInputSamples(pb, samples, count, coeffs);
 
 	// Apply a global volume ramp using the volume envelope parameters.
-	for (u32 i = 0; i < count; ++i)
-	{
-		samples[i] = ((s32)samples[i] * pb.vol_env.cur_volume) >> 15;
-		pb.vol_env.cur_volume += pb.vol_env.cur_volume_delta;
-	}
+	ApplyVolume(samples, count, pb.vol_env.cur_volume, pb.vol_env.cur_volume_delta);
 
 	// Optionally, execute a low pass filter
 	// TODO: LPF code is currently broken, causing Super Monkey Ball sound
@@ -523,8 +605,9 @@ void ProcessVoice(PB_TYPE& pb, const AXBuffers& buffers, u16 count, AXMixControl
 
 		// We use ratio 0x55555 == (5 * 65536 + 21845) / 65536 == 5.3333 which
 		// is the nearest we can get to 96/18
-		u32 curr_pos = ResampleAudio([&samples](u32 i) { return samples[i]; },
-		                             wm_samples, wm_count, pb.remote_src.last_samples,
+		s16 wm_input[4 + MAX_SAMPLES_PER_FRAME];
+		memcpy(&wm_input[4], samples, count * sizeof (s16));
+		u32 curr_pos = ResampleAudio(wm_input, wm_samples, wm_count, pb.remote_src.last_samples,
 		                             pb.remote_src.cur_addr_frac, 0x55555,
 		                             SRCTYPE_POLYPHASE, coeffs);
 		pb.remote_src.cur_addr_frac = curr_pos & 0xFFFF;
@@ -555,4 +638,82 @@ void ProcessVoice(PB_TYPE& pb, const AXBuffers& buffers, u16 count, AXMixControl
 #endif
 }
 
+// Samples in each of the AXBuffers for a whole frame.
+u32 GetBufferSize(u32 index)
+{
+#ifdef AX_GC
+	return 32 * 5;
+#else
+	// Main and AUX, then Wii remote.
+	return index < 12 ? 32 * 3 : 6 * 3;
+#endif
+}
+
+#ifdef AX_WII
+// Moves each of the buffers on by the samples of one ms, for old AXWii
+// which mixes ms per ms: 32 for main and AUX, 6 for the Wii remote.
+void ForwardBuffersOneMs(AXBuffers& buffers)
+{
+	for (u32 i = 0; i < sizeof (buffers.ptrs) / sizeof (buffers.ptrs[0]); ++i)
+		buffers.ptrs[i] += GetBufferSize(i) / 3;
+}
+#endif
+
+// PB lists with fewer voices than this are mixed on the calling thread, as
+// handing them out would cost more than it saves.
+const size_t MIN_PARALLEL_VOICES = 16;
+
+// Calls process(pb, buffers) for each of the PBs, to mix a frame of them
+// into buffers. With a pool and enough voices, each worker takes a share of
+// the list in order and mixes it into zeroed buffers of its own, which are
+// then added up share by share. The mixing only ever adds integers, so the
+// output is the same to the bit as mixing them one after another, whatever
+// the number of workers.
+template <typename Process>
+void MixVoices(Common::WorkerPool* pool, std::vector<PB_TYPE>& pbs, const AXBuffers& buffers, Process process)
+{
+	if (!pool || pool->GetNumWorkers() == 1 || pbs.size() < MIN_PARALLEL_VOICES)
+	{
+		for (PB_TYPE& pb : pbs)
+			process(pb, buffers);
+		return;
+	}
+
+	const u32 num_buffers = sizeof (buffers.ptrs) / sizeof (buffers.ptrs[0]);
+	const u32 num_shares = pool->GetNumWorkers();
+
+	// Laid out one after another like the UCode's own buffers.
+	u32 share_size = 0;
+	for (u32 i = 0; i < num_buffers; ++i)
+		share_size += GetBufferSize(i);
+	std::vector<int> shares(share_size * num_shares);
+
+	pool->ParallelFor(num_shares, [&](u32 share, u32) {
+		AXBuffers share_buffers;
+		int* ptr = &shares[share * share_size];
+		for (u32 i = 0; i < num_buffers; ++i)
+		{
+			share_buffers.ptrs[i] = ptr;
+			ptr += GetBufferSize(i);
+		}
+
+		const size_t first = pbs.size() * share / num_shares;
+		const size_t last = pbs.size() * (share + 1) / num_shares;
+		for (size_t i = first; i < last; ++i)
+			process(pbs[i], share_buffers);
+	});
+
+	for (u32 share = 0; share < num_shares; ++share)
+	{
+		const int* ptr = &shares[share * share_size];
+		for (u32 i = 0; i < num_buffers; ++i)
+		{
+			const u32 size = GetBufferSize(i);
+			for (u32 j = 0; j < size; ++j)
+				buffers.ptrs[i][j] += ptr[j];
+			ptr += size;
+		}
+	}
+}
+
 } // namespace
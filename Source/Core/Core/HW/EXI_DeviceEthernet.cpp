@@ -7,6 +7,7 @@
 #include "Core/HW/EXI_Device.h"
 #include "Core/HW/EXI_DeviceEthernet.h"
 #include "Core/HW/Memmap.h"
+#include "Core/HW/WriteTracker.h"
 
 // XXX: The BBA stores multi-byte elements as little endian.
 // Multiple parts of this implementation depend on dolphin
@@ -193,6 +194,7 @@ void CEXIETHERNET::DMARead(u32 addr, u32 size)
 	DEBUG_LOG(SP1, "DMA read: %08x %x", addr, size);
 
 	memcpy(Memory::GetPointer(addr), &mBbaMem[transfer.address], size);
+	WriteTracker::Written(addr, size);
 
 	transfer.address += size;
 }
@@ -14,6 +14,7 @@
 #include "Core/HW/EXI_Device.h"
 #include "Core/HW/EXI_DeviceMemoryCard.h"
 #include "Core/HW/GCMemcard.h"
+#include "Core/HW/MemoryCardWriter.h"
 #include "Core/HW/Sram.h"
 
 #define MC_STATUS_BUSY              0x80
@@ -75,6 +76,8 @@ CEXIMemoryCard::CEXIMemoryCard(const int index)
 
 	card_id = 0xc221; // It's a Nintendo brand memcard
 
+	MemoryCardWriter::Recover(m_strFilename);
+
 	File::IOFile pFile(m_strFilename, "rb");
 	if (pFile)
 	{
@@ -100,63 +103,36 @@ CEXIMemoryCard::CEXIMemoryCard(const int index)
 		WARN_LOG(EXPANSIONINTERFACE, "No memory card found. Will create a new one.");
 	}
 	SetCardFlashID(memory_card_content, card_index);
-}
 
-void innerFlush(FlushData* data)
-{
-	File::IOFile pFile(data->filename, "r+b");
+	m_bExiting = false;
+	m_writer.reset(new MemoryCardWriter(m_strFilename, memory_card_size, [this] {
+		if (!m_bExiting)
+			Core::DisplayMessage(StringFromFormat("Wrote memory card %c contents to %s",
+				card_index ? 'B' : 'A', m_strFilename.c_str()).c_str(), 4000);
+	}));
+	// A new card is written whole the first time.
 	if (!pFile)
-	{
-		std::string dir;
-		SplitPath(data->filename, &dir, nullptr, nullptr);
-		if (!File::IsDirectory(dir))
-			File::CreateFullPath(dir);
-		pFile.Open(data->filename, "wb");
-	}
-
-	if (!pFile) // Note - pFile changed inside above if
-	{
-		PanicAlertT("Could not write memory card file %s.\n\n"
-			"Are you running Dolphin from a CD/DVD, or is the save file maybe write protected?\n\n"
-			"Are you receiving this after moving the emulator directory?\nIf so, then you may "
-			"need to re-specify your memory card location in the options.", data->filename.c_str());
-		return;
-	}
-
-	pFile.WriteBytes(data->memcardContent, data->memcardSize);
-
-	if (!data->bExiting)
-		Core::DisplayMessage(StringFromFormat("Wrote memory card %c contents to %s",
-			data->memcardIndex ? 'B' : 'A', data->filename.c_str()).c_str(), 4000);
-	return;
+		m_writer->MarkAllDirty();
 }
 
 // Flush memory card contents to disc
 void CEXIMemoryCard::Flush(bool exiting)
 {
-	if (!m_bDirty)
+	// The writer stays dirty after a flush that failed, to retry it.
+	if (!m_bDirty && !m_writer->IsDirty())
 		return;
 
 	if (!Core::g_CoreStartupParameter.bEnableMemcardSaving)
 		return;
 
-	if (flushThread.joinable())
-	{
-		flushThread.join();
-	}
-
 	if (!exiting)
 		Core::DisplayMessage(StringFromFormat("Writing to memory card %c", card_index ? 'B' : 'A'), 1000);
 
-	flushData.filename = m_strFilename;
-	flushData.memcardContent = memory_card_content;
-	flushData.memcardIndex = card_index;
-	flushData.memcardSize = memory_card_size;
-	flushData.bExiting = exiting;
-
-	flushThread = std::thread(innerFlush, &flushData);
+	// Read by the writing thread once the flush is queued.
+	m_bExiting = exiting;
+	m_writer->Flush(memory_card_content);
 	if (exiting)
-		flushThread.join();
+		m_writer->Wait();
 
 	m_bDirty = false;
 }
@@ -165,13 +141,9 @@ CEXIMemoryCard::~CEXIMemoryCard()
 {
 	CoreTiming::RemoveEvent(et_this_card);
 	Flush(true);
+	m_writer.reset();
 	delete[] memory_card_content;
 	memory_card_content = nullptr;
-
-	if (flushThread.joinable())
-	{
-		flushThread.join();
-	}
 }
 
 bool CEXIMemoryCard::IsPresent()
@@ -196,12 +168,6 @@ void CEXIMemoryCard::CmdDoneLater(u64 cycles)
 
 void CEXIMemoryCard::SetCS(int cs)
 {
-	// So that memory card won't be invalidated during flushing
-	if (flushThread.joinable())
-	{
-		flushThread.join();
-	}
-
 	if (cs)  // not-selected to selected
 	{
 		m_uPosition = 0;
@@ -214,6 +180,7 @@ void CEXIMemoryCard::SetCS(int cs)
 			if (m_uPosition > 2)
 			{
 				memset(memory_card_content + (address & (memory_card_size-1)), 0xFF, 0x2000);
+				m_writer->MarkDirty(address & (memory_card_size-1), 0x2000);
 				status |= MC_STATUS_BUSY;
 				status &= ~MC_STATUS_READY;
 
@@ -227,6 +194,7 @@ void CEXIMemoryCard::SetCS(int cs)
 			if (m_uPosition > 2)
 			{
 				memset(memory_card_content, 0xFF, memory_card_size);
+				m_writer->MarkAllDirty();
 				status &= ~MC_STATUS_BUSY;
 				m_bDirty = true;
 			}
@@ -239,6 +207,9 @@ void CEXIMemoryCard::SetCS(int cs)
 				int i=0;
 				status &= ~0x80;
 
+				// The address wraps within its page.
+				m_writer->MarkDirty(address & ~0x1FF, 0x200);
+
 				while (count--)
 				{
 					memory_card_content[address] = programming_buffer[i++];
@@ -443,11 +414,8 @@ void CEXIMemoryCard::PauseAndLock(bool doLock, bool unpauseOnUnlock)
 	if (doLock)
 	{
 		// we don't exactly have anything to pause,
-		// but let's make sure the flush thread isn't running.
-		if (flushThread.joinable())
-		{
-			flushThread.join();
-		}
+		// but let's make sure the flushes queued are written.
+		m_writer->Wait();
 	}
 }
 
@@ -476,6 +444,9 @@ void CEXIMemoryCard::DoState(PointerWrap &p)
 		p.Do(memory_card_size);
 		p.DoArray(memory_card_content, memory_card_size);
 		p.Do(card_index);
+
+		if (p.GetMode() == PointerWrap::MODE_READ)
+			m_writer->MarkAllDirty();
 	}
 }
 
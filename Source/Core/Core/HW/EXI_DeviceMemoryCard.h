@@ -4,16 +4,10 @@
 
 #pragma once
 
-#include "Common/Thread.h"
+#include <memory>
+#include <string>
 
-// Data structure to be passed to the flushing thread.
-struct FlushData
-{
-	bool bExiting;
-	std::string filename;
-	u8 *memcardContent;
-	int memcardSize, memcardIndex;
-};
+class MemoryCardWriter;
 
 class CEXIMemoryCard : public IEXIDevice
 {
@@ -36,7 +30,8 @@ private:
 	// Scheduled when a command that required delayed end signaling is done.
 	static void CmdDoneCallback(u64 userdata, int cyclesLate);
 
-	// Flushes the memory card contents to disk.
+	// Queues the changed memory card contents to be written to disk, and
+	// waits for them when exiting.
 	void Flush(bool exiting = false);
 
 	// Signals that the command that was previously executed is now done.
@@ -84,8 +79,8 @@ private:
 	int memory_card_size; //! in bytes, must be power of 2.
 	u8 *memory_card_content;
 
-	FlushData flushData;
-	std::thread flushThread;
+	std::unique_ptr<MemoryCardWriter> m_writer;
+	bool m_bExiting;
 
 protected:
 	virtual void TransferByte(u8 &byte) override;
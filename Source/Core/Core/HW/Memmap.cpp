@@ -30,6 +30,7 @@
 #include "Core/HW/SI.h"
 #include "Core/HW/VideoInterface.h"
 #include "Core/HW/WII_IPC.h"
+#include "Core/HW/WriteTracker.h"
 #include "Core/PowerPC/PowerPC.h"
 #include "Core/PowerPC/JitCommon/JitBase.h"
 
@@ -150,6 +151,15 @@ void Init()
 	if (bFakeVMEM) flags |= MV_FAKE_VMEM;
 	base = MemoryMap_Setup(views, num_views, flags, &g_arena);
 
+#if _M_X86_64
+	// Watched pages are caught by the fastmem exception handler, which is only
+	// installed with fastmem on.
+	const SCoreStartupParameter& startup = SConfig::GetInstance().m_LocalCoreStartupParameter;
+	WriteTracker::Init(startup.bFastmem && !bMMU ? base : nullptr, wii);
+#else
+	WriteTracker::Init(nullptr, wii);
+#endif
+
 	mmio_mapping = new MMIO::Mapping();
 
 	if (wii)
@@ -175,6 +185,9 @@ void DoState(PointerWrap &p)
 	if (wii)
 		p.DoArray(m_pEXRAM, EXRAM_SIZE);
 	p.DoMarker("Memory EXRAM");
+
+	if (p.GetMode() == PointerWrap::MODE_READ)
+		WriteTracker::Reset();
 }
 
 void Shutdown()
@@ -183,6 +196,7 @@ void Shutdown()
 	u32 flags = 0;
 	if (SConfig::GetInstance().m_LocalCoreStartupParameter.bWii) flags |= MV_WII_ONLY;
 	if (bFakeVMEM) flags |= MV_FAKE_VMEM;
+	WriteTracker::Shutdown();
 	MemoryMap_Shutdown(views, num_views, flags, &g_arena);
 	g_arena.ReleaseSpace();
 	base = nullptr;
@@ -198,6 +212,7 @@ void Clear()
 		memset(m_pL1Cache, 0, L1_CACHE_SIZE);
 	if (SConfig::GetInstance().m_LocalCoreStartupParameter.bWii && m_pEXRAM)
 		memset(m_pEXRAM, 0, EXRAM_SIZE);
+	WriteTracker::Reset();
 }
 
 bool AreMemoryBreakpointsActivated()
@@ -218,6 +233,7 @@ u32 Read_Instruction(const u32 em_address)
 void WriteBigEData(const u8 *_pData, const u32 _Address, const size_t _iSize)
 {
 	memcpy(GetPointer(_Address), _pData, _iSize);
+	WriteTracker::Written(_Address, (u32)_iSize);
 }
 
 void Memset(const u32 _Address, const u8 _iValue, const u32 _iLength)
@@ -226,6 +242,7 @@ void Memset(const u32 _Address, const u8 _iValue, const u32 _iLength)
 	if (ptr != nullptr)
 	{
 		memset(ptr,_iValue,_iLength);
+		WriteTracker::Written(_Address, _iLength);
 	}
 	else
 	{
@@ -242,6 +259,7 @@ void DMA_LCToMemory(const u32 _MemAddr, const u32 _CacheAddr, const u32 _iNumBlo
 	if ((dst != nullptr) && (src != nullptr) && (_MemAddr & 3) == 0 && (_CacheAddr & 3) == 0)
 	{
 		memcpy(dst, src, 32 * _iNumBlocks);
+		WriteTracker::Written(_MemAddr, 32 * _iNumBlocks);
 	}
 	else
 	{
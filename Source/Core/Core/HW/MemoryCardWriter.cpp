@@ -0,0 +1,321 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <cstring>
+
+#include "Common/Common.h"
+#include "Common/FileUtil.h"
+#include "Common/Hash.h"
+#include "Common/StringUtil.h"
+
+#include "Core/HW/MemoryCardWriter.h"
+
+// The journal is the header, the index of each block, the blocks, and the
+// Adler-32 of all that. It's written under another name and renamed into
+// place, so that it only exists once complete.
+static const u32 JOURNAL_MAGIC = 0x4A434D44; // "DMCJ"
+
+struct JournalHeader
+{
+	u32 magic;
+	u32 card_size;
+	u32 num_blocks;
+};
+
+MemoryCardWriter::MemoryCardWriter(const std::string& filename, u32 size, std::function<void()> written)
+	: m_filename(filename)
+	, m_size(size)
+	, m_written(written)
+	, m_dirty(size / BLOCK_SIZE, false)
+	, m_num_dirty(0)
+	, m_writing(false)
+	, m_stop(false)
+	, m_lost(false)
+{
+	m_thread = std::thread(&MemoryCardWriter::FlushThread, this);
+}
+
+MemoryCardWriter::~MemoryCardWriter()
+{
+	{
+		std::lock_guard<std::mutex> lk(m_lock);
+		m_stop = true;
+	}
+	m_queued.notify_one();
+	m_thread.join();
+}
+
+void MemoryCardWriter::MarkDirty(u32 offset, u32 length)
+{
+	if (!length || offset >= m_size)
+		return;
+
+	const u32 last = (std::min(offset + length, m_size) - 1) / BLOCK_SIZE;
+	for (u32 block = offset / BLOCK_SIZE; block <= last; ++block)
+	{
+		if (!m_dirty[block])
+		{
+			m_dirty[block] = true;
+			m_num_dirty++;
+		}
+	}
+}
+
+void MemoryCardWriter::MarkAllDirty()
+{
+	MarkDirty(0, m_size);
+}
+
+bool MemoryCardWriter::IsDirty() const
+{
+	std::lock_guard<std::mutex> lk(m_lock);
+	return m_num_dirty != 0 || m_lost;
+}
+
+void MemoryCardWriter::Flush(const u8* content)
+{
+	{
+		std::lock_guard<std::mutex> lk(m_lock);
+		if (m_lost)
+		{
+			m_lost = false;
+			MarkAllDirty();
+		}
+	}
+
+	if (!m_num_dirty)
+		return;
+
+	Blocks blocks;
+	for (u32 block = 0; block < m_dirty.size(); ++block)
+	{
+		if (m_dirty[block])
+		{
+			const u8* data = content + block * BLOCK_SIZE;
+			blocks[block].assign(data, data + BLOCK_SIZE);
+			m_dirty[block] = false;
+		}
+	}
+	m_num_dirty = 0;
+
+	std::lock_guard<std::mutex> lk(m_lock);
+	if (m_queue.size() < MAX_QUEUED_FLUSHES)
+	{
+		m_queue.push_back(std::move(blocks));
+		m_queued.notify_one();
+	}
+	else
+	{
+		// Rather than wait for the disk, write these along with the last.
+		for (auto& block : blocks)
+			m_queue.back()[block.first] = std::move(block.second);
+	}
+}
+
+void MemoryCardWriter::Wait()
+{
+	std::unique_lock<std::mutex> lk(m_lock);
+	m_done.wait(lk, [this] { return m_queue.empty() && !m_writing; });
+}
+
+void MemoryCardWriter::FlushThread()
+{
+	Common::SetCurrentThreadName("Memcard flush");
+
+	while (true)
+	{
+		Blocks blocks;
+		{
+			std::unique_lock<std::mutex> lk(m_lock);
+			m_queued.wait(lk, [this] { return m_stop || !m_queue.empty(); });
+			// Everything queued is written before stopping.
+			if (m_queue.empty())
+				return;
+			blocks = std::move(m_queue.front());
+			m_queue.pop_front();
+			m_writing = true;
+		}
+
+		const bool written = Write(blocks);
+		if (written && m_written)
+			m_written();
+
+		{
+			std::lock_guard<std::mutex> lk(m_lock);
+			// The blocks that didn't make it are no longer dirty, and whatever
+			// failed may have left the card half written, so all of it is
+			// written again next time.
+			if (!written)
+				m_lost = true;
+			m_writing = false;
+		}
+		m_done.notify_all();
+	}
+}
+
+bool MemoryCardWriter::Write(const Blocks& blocks)
+{
+	File::IOFile file;
+	if (File::GetSize(m_filename) != m_size)
+	{
+		// Without the rest of the card, only a flush of all of it can make
+		// a new file. The next one will be.
+		if (blocks.size() != m_dirty.size())
+		{
+			WARN_LOG(EXPANSIONINTERFACE, "Memory card %s is gone, writing all of it next time.", m_filename.c_str());
+			return false;
+		}
+
+		std::string dir;
+		SplitPath(m_filename, &dir, nullptr, nullptr);
+		if (!File::IsDirectory(dir))
+			File::CreateFullPath(dir);
+		file.Open(m_filename, "wb");
+	}
+	else
+	{
+		// The journal of a flush that failed is finished first. Writing a new
+		// one over it would lose the only good copy of its blocks.
+		const std::string journal = GetJournalPath(m_filename);
+		if (File::Exists(journal))
+		{
+			Recover(m_filename);
+			if (File::Exists(journal))
+			{
+				ERROR_LOG(EXPANSIONINTERFACE, "Could not finish memory card journal %s", journal.c_str());
+				return false;
+			}
+		}
+
+		if (!WriteJournal(m_filename, m_size, blocks))
+		{
+			ERROR_LOG(EXPANSIONINTERFACE, "Could not write memory card journal %s", GetJournalPath(m_filename).c_str());
+			return false;
+		}
+		file.Open(m_filename, "r+b");
+	}
+
+	if (!file)
+	{
+		PanicAlertT("Could not write memory card file %s.\n\n"
+			"Are you running Dolphin from a CD/DVD, or is the save file maybe write protected?\n\n"
+			"Are you receiving this after moving the emulator directory?\nIf so, then you may "
+			"need to re-specify your memory card location in the options.", m_filename.c_str());
+		return false;
+	}
+
+	// Blocks are in order, so runs of them are written in one go.
+	u32 next_block = (u32)-1;
+	for (const auto& block : blocks)
+	{
+		if ((block.first != next_block && !file.Seek((s64)block.first * BLOCK_SIZE, SEEK_SET)) ||
+		    !file.WriteBytes(block.second.data(), BLOCK_SIZE))
+		{
+			ERROR_LOG(EXPANSIONINTERFACE, "Could not write memory card %s", m_filename.c_str());
+			return false;
+		}
+		next_block = block.first + 1;
+	}
+
+	// On failure the journal stays, to be finished before the next flush.
+	if (!file.Flush())
+		return false;
+	file.Close();
+	File::Delete(GetJournalPath(m_filename));
+	return true;
+}
+
+std::string MemoryCardWriter::GetJournalPath(const std::string& filename)
+{
+	return filename + ".journal";
+}
+
+bool MemoryCardWriter::WriteJournal(const std::string& filename, u32 size, const Blocks& blocks)
+{
+	JournalHeader header;
+	header.magic = JOURNAL_MAGIC;
+	header.card_size = size;
+	header.num_blocks = (u32)blocks.size();
+
+	std::vector<u8> journal(sizeof(header) + blocks.size() * (sizeof(u32) + BLOCK_SIZE));
+	memcpy(journal.data(), &header, sizeof(header));
+	u8* index = journal.data() + sizeof(header);
+	u8* data = index + blocks.size() * sizeof(u32);
+	for (const auto& block : blocks)
+	{
+		memcpy(index, &block.first, sizeof(u32));
+		memcpy(data, block.second.data(), BLOCK_SIZE);
+		index += sizeof(u32);
+		data += BLOCK_SIZE;
+	}
+	const u32 checksum = HashAdler32(journal.data(), journal.size());
+
+	const std::string path = GetJournalPath(filename);
+	const std::string temp_path = path + ".tmp";
+	{
+		File::IOFile file(temp_path, "wb");
+		if (!file.WriteBytes(journal.data(), journal.size()) || !file.WriteBytes(&checksum, sizeof(checksum)) || !file.Flush())
+			return false;
+	}
+	return File::RenameSync(temp_path, path);
+}
+
+bool MemoryCardWriter::Recover(const std::string& filename)
+{
+	const std::string path = GetJournalPath(filename);
+	File::Delete(path + ".tmp");
+	if (!File::Exists(path))
+		return false;
+
+	std::vector<u8> journal;
+	{
+		File::IOFile file(path, "rb");
+		journal.resize((size_t)file.GetSize());
+		if (!file.ReadBytes(journal.data(), journal.size()))
+			journal.clear();
+	}
+
+	JournalHeader header;
+	u32 checksum;
+	bool valid = journal.size() >= sizeof(header) + sizeof(checksum);
+	if (valid)
+	{
+		memcpy(&header, journal.data(), sizeof(header));
+		memcpy(&checksum, &journal[journal.size() - sizeof(checksum)], sizeof(checksum));
+		valid = header.magic == JOURNAL_MAGIC && header.num_blocks <= header.card_size / BLOCK_SIZE &&
+			journal.size() == sizeof(header) + header.num_blocks * (sizeof(u32) + BLOCK_SIZE) + sizeof(checksum) &&
+			checksum == HashAdler32(journal.data(), journal.size() - sizeof(checksum)) &&
+			File::GetSize(filename) == header.card_size;
+	}
+
+	bool written = false;
+	if (valid)
+	{
+		File::IOFile file(filename, "r+b");
+		written = file.IsGood();
+		const u8* index = journal.data() + sizeof(header);
+		const u8* data = index + header.num_blocks * sizeof(u32);
+		for (u32 i = 0; written && i < header.num_blocks; ++i)
+		{
+			u32 block;
+			memcpy(&block, index + i * sizeof(u32), sizeof(block));
+			if (block < header.card_size / BLOCK_SIZE)
+				written = file.Seek((s64)block * BLOCK_SIZE, SEEK_SET) && file.WriteBytes(data + i * BLOCK_SIZE, BLOCK_SIZE);
+		}
+		written = written && file.Flush();
+		if (!written)
+		{
+			ERROR_LOG(EXPANSIONINTERFACE, "Could not finish writing memory card %s from its journal", filename.c_str());
+			return false;
+		}
+		NOTICE_LOG(EXPANSIONINTERFACE, "Finished writing %u blocks of memory card %s from its journal", header.num_blocks, filename.c_str());
+	}
+	else
+	{
+		WARN_LOG(EXPANSIONINTERFACE, "Dropping incomplete memory card journal %s", path.c_str());
+	}
+
+	File::Delete(path);
+	return written;
+}
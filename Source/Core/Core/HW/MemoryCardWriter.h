@@ -0,0 +1,85 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <deque>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "Common/Common.h"
+#include "Common/Thread.h"
+
+// Writes the blocks of a memory card that changed back to its file, on a
+// thread of its own, so that saving doesn't rewrite the whole card.
+//
+// Every flush is first written to a journal next to the card, and only then
+// to the card itself, so a crash in the middle of writing the card can be
+// finished from the journal the next time the card is opened (see Recover).
+class MemoryCardWriter : NonCopyable
+{
+public:
+	enum
+	{
+		// A sector of the card, the smallest unit erased.
+		BLOCK_SIZE = 0x2000,
+		// Flushes waiting to be written. Any more are merged into the last one.
+		MAX_QUEUED_FLUSHES = 2,
+	};
+
+	// Card data by block index.
+	typedef std::map<u32, std::vector<u8>> Blocks;
+
+	// written is called on the writing thread after each flush that made it
+	// to the file.
+	MemoryCardWriter(const std::string& filename, u32 size, std::function<void()> written = nullptr);
+	// Waits for the queued flushes to be written.
+	~MemoryCardWriter();
+
+	void MarkDirty(u32 offset, u32 length);
+	void MarkAllDirty();
+	// Also true after a flush failed, until the card is flushed again.
+	bool IsDirty() const;
+
+	// Queues the dirty blocks of content, the whole card, to be written, and
+	// marks them clean. Doesn't wait for the disk.
+	void Flush(const u8* content);
+	// Waits for every flush queued to be written.
+	void Wait();
+
+	static std::string GetJournalPath(const std::string& filename);
+	// Writes blocks to the journal of the card filename, or returns false.
+	static bool WriteJournal(const std::string& filename, u32 size, const Blocks& blocks);
+	// Finishes writing the card from the journal left by a flush that didn't
+	// complete, and removes it. A journal that wasn't complete itself is
+	// dropped, since the card wasn't touched yet then. Returns whether the
+	// card was written.
+	static bool Recover(const std::string& filename);
+
+private:
+	void FlushThread();
+	bool Write(const Blocks& blocks);
+
+	std::string m_filename;
+	u32 m_size;
+	std::function<void()> m_written;
+
+	// Only touched by the thread calling Flush.
+	std::vector<bool> m_dirty;
+	u32 m_num_dirty;
+
+	// Protected by m_lock.
+	mutable std::mutex m_lock;
+	std::condition_variable m_queued;
+	std::condition_variable m_done;
+	std::deque<Blocks> m_queue;
+	bool m_writing;
+	bool m_stop;
+	// Set when a flush failed, so the next one writes the whole card.
+	bool m_lost;
+
+	std::thread m_thread;
+};
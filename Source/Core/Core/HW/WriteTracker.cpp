@@ -0,0 +1,238 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <atomic>
+#include <mutex>
+
+#include "Common/MemoryUtil.h"
+#include "Core/HW/Memmap.h"
+#include "Core/HW/WriteTracker.h"
+
+namespace WriteTracker
+{
+
+enum
+{
+	NUM_RAM_PAGES = Memory::RAM_SIZE >> PAGE_SHIFT,
+	NUM_EXRAM_PAGES = Memory::EXRAM_SIZE >> PAGE_SHIFT,
+	NUM_PAGES = NUM_RAM_PAGES + NUM_EXRAM_PAGES,
+
+	EXRAM_OFFSET = 0x10000000,
+};
+
+// The mirrors the JIT's stores go to, by their offset from base.
+static const u32 s_mirrors[] = { 0x80000000, 0xC0000000 };
+
+// For each page, twice the number of writes noticed, plus one while it's
+// watched. Only changed with s_lock held, so that whether a page is watched
+// always matches whether it's protected.
+static std::atomic<u32> s_pages[NUM_PAGES];
+static std::mutex s_lock;
+
+static u8* s_base;
+static bool s_wii;
+
+// Pages first to last hold address to address + size, all in either RAM or
+// EXRAM. Returns false for anything else.
+static bool GetPages(u32 address, u32 size, u32* first, u32* last)
+{
+	if (!s_base || size == 0)
+		return false;
+
+	const u32 offset = address & 0x0FFFFFFF;
+	switch (address >> 28)
+	{
+	case 0x0:
+	case 0x8:
+	case 0xC:
+		if ((u64)offset + size > Memory::RAM_SIZE)
+			return false;
+		*first = offset >> PAGE_SHIFT;
+		*last = (offset + size - 1) >> PAGE_SHIFT;
+		return true;
+
+	case 0x1:
+	case 0x9:
+	case 0xD:
+		if (!s_wii || (u64)offset + size > Memory::EXRAM_SIZE)
+			return false;
+		*first = NUM_RAM_PAGES + (offset >> PAGE_SHIFT);
+		*last = NUM_RAM_PAGES + ((offset + size - 1) >> PAGE_SHIFT);
+		return true;
+
+	default:
+		return false;
+	}
+}
+
+// Pages first to last, which are all in either RAM or EXRAM.
+static void SetProtection(u32 first, u32 last, bool protect)
+{
+	const u32 offset = first < NUM_RAM_PAGES
+		? first << PAGE_SHIFT
+		: EXRAM_OFFSET + ((first - NUM_RAM_PAGES) << PAGE_SHIFT);
+	const size_t size = (size_t)(last - first + 1) << PAGE_SHIFT;
+
+	for (u32 mirror : s_mirrors)
+	{
+		if (protect)
+			WriteProtectMemory(s_base + mirror + offset, size);
+		else
+			UnWriteProtectMemory(s_base + mirror + offset, size);
+	}
+}
+
+// Counts a write to each watched page from first to last and unprotects them.
+// Call with s_lock held.
+static void Unwatch(u32 first, u32 last)
+{
+	u32 run = first;
+	for (u32 page = first; page <= last; ++page)
+	{
+		const u32 state = s_pages[page].load();
+		if (state & 1)
+		{
+			s_pages[page].store(state + 1);
+			continue;
+		}
+		if (run < page)
+			SetProtection(run, page - 1, false);
+		run = page + 1;
+	}
+	if (run <= last)
+		SetProtection(run, last, false);
+}
+
+void Init(u8* base, bool wii)
+{
+	std::lock_guard<std::mutex> lk(s_lock);
+
+	// The counts carry on from before, so nothing taken then matches now.
+	for (std::atomic<u32>& page : s_pages)
+		page.store((page.load() & ~1) + 2);
+
+	s_base = base;
+	s_wii = wii;
+}
+
+void Shutdown()
+{
+	std::lock_guard<std::mutex> lk(s_lock);
+	if (s_base)
+		Unwatch(0, s_wii ? NUM_PAGES - 1 : NUM_RAM_PAGES - 1);
+	s_base = nullptr;
+}
+
+bool IsEnabled()
+{
+	return s_base != nullptr;
+}
+
+void Watch(u32 address, u32 size)
+{
+	u32 first, last;
+	if (!GetPages(address, size, &first, &last))
+		return;
+
+	std::lock_guard<std::mutex> lk(s_lock);
+	u32 run = first;
+	for (u32 page = first; page <= last; ++page)
+	{
+		const u32 state = s_pages[page].load();
+		if (!(state & 1))
+		{
+			s_pages[page].store(state | 1);
+			continue;
+		}
+		if (run < page)
+			SetProtection(run, page - 1, true);
+		run = page + 1;
+	}
+	if (run <= last)
+		SetProtection(run, last, true);
+}
+
+u64 GetWriteCount(u32 address, u32 size)
+{
+	u32 first, last;
+	if (!GetPages(address, size, &first, &last))
+		return UNWATCHED;
+
+	// The counts only go up, so their sum changes when any of them does.
+	u64 count = 0;
+	for (u32 page = first; page <= last; ++page)
+	{
+		const u32 state = s_pages[page].load();
+		if (!(state & 1))
+			return UNWATCHED;
+		count += state;
+	}
+	return count;
+}
+
+void Written(u32 address, u32 size)
+{
+	u32 first, last;
+	if (!GetPages(address, size, &first, &last))
+		return;
+
+	// This is on the interpreter's path for every store, so don't take the
+	// lock unless there's something to do. A page that starts being watched
+	// after this looks is read after the write anyway.
+	u32 page = first;
+	while (page <= last && !(s_pages[page].load() & 1))
+		++page;
+	if (page > last)
+		return;
+
+	std::lock_guard<std::mutex> lk(s_lock);
+	Unwatch(page, last);
+}
+
+void Reset()
+{
+	std::lock_guard<std::mutex> lk(s_lock);
+	if (s_base)
+		Unwatch(0, s_wii ? NUM_PAGES - 1 : NUM_RAM_PAGES - 1);
+}
+
+bool HandleFault(uintptr_t host_address)
+{
+	if (!s_base || host_address < (uintptr_t)s_base)
+		return false;
+	const u64 address = host_address - (uintptr_t)s_base;
+	if (address >= 0x100000000ULL)
+		return false;
+
+	// Only the mirrors in s_mirrors are ever protected.
+	const u32 offset = (u32)address & 0x0FFFFFFF;
+	u32 page;
+	switch (address >> 28)
+	{
+	case 0x8:
+	case 0xC:
+		if (offset >= Memory::RAM_SIZE)
+			return false;
+		page = offset >> PAGE_SHIFT;
+		break;
+
+	case 0x9:
+	case 0xD:
+		if (!s_wii || offset >= Memory::EXRAM_SIZE)
+			return false;
+		page = NUM_RAM_PAGES + (offset >> PAGE_SHIFT);
+		break;
+
+	default:
+		return false;
+	}
+
+	// If the page isn't watched anymore, another thread unprotected it after
+	// this one faulted, and the write can just be retried.
+	std::lock_guard<std::mutex> lk(s_lock);
+	Unwatch(page, page);
+	return true;
+}
+
+}
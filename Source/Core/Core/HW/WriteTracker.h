@@ -0,0 +1,52 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include "Common/CommonTypes.h"
+
+// Counts writes to the pages of emulated RAM someone is watching, so that the
+// texture cache can tell a texture wasn't touched without hashing it again.
+//
+// Watched pages are write protected in the mirrors the JIT stores through
+// (0x80000000 and 0xC0000000, and 0x90000000 and 0xD0000000 for EXRAM). The
+// first store to one faults into HandleFault, which counts the write and
+// lifts the protection until the page is watched again. Everything else
+// writes through m_pRAM or the physical mirror and has to call Written after
+// it's done: the interpreter, DMA, disc reads, EFB copies and so on.
+namespace WriteTracker
+{
+
+enum
+{
+	PAGE_SHIFT = 12,
+	PAGE_SIZE = 1 << PAGE_SHIFT,
+};
+
+// What GetWriteCount returns for a range that isn't all watched.
+const u64 UNWATCHED = ~0ULL;
+
+// base is Memory::base, with RAM (and EXRAM on the Wii) mapped at the usual
+// addresses. Nothing is tracked without one.
+void Init(u8* base, bool wii);
+void Shutdown();
+bool IsEnabled();
+
+// Starts watching the pages of the range that weren't watched yet.
+void Watch(u32 address, u32 size);
+// Changes whenever a write to the range is noticed. Taken after Watch and
+// before reading the range, it tells whether anything was written since.
+// UNWATCHED if any page of the range isn't watched.
+u64 GetWriteCount(u32 address, u32 size);
+
+// Counts a write that didn't go through the protected mirrors.
+void Written(u32 address, u32 size);
+// Counts a write to all of RAM, e.g. from loading a save state.
+void Reset();
+
+// Called by the exception handler. Returns whether host_address is in a
+// page that was watched, and can now be written.
+bool HandleFault(uintptr_t host_address);
+
+}
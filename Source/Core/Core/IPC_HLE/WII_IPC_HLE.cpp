@@ -36,6 +36,7 @@ They will also generate a true or false return for UpdateInterrupts() in WII_IPC
 #include "Core/HW/Memmap.h"
 #include "Core/HW/SystemTimers.h"
 #include "Core/HW/WII_IPC.h"
+#include "Core/HW/WriteTracker.h"
 
 #include "Core/IPC_HLE/WII_IPC_HLE.h"
 #include "Core/IPC_HLE/WII_IPC_HLE_Device.h"
@@ -82,6 +83,39 @@ static int enque_reply;
 
 static u64 last_reply_time;
 
+// Devices write their results straight into RAM, past the write tracker,
+// some of them on other threads long after the command came in. Their
+// buffers are counted as written when the reply is made.
+static void TrackReplyWrites(u32 _Address)
+{
+	if (!WriteTracker::IsEnabled())
+		return;
+
+	// Replied commands have 8 in place of the command, which is moved to +8.
+	u32 Command = Memory::Read_U32(_Address);
+	if (Command == 8)
+		Command = Memory::Read_U32(_Address + 8);
+
+	switch (Command)
+	{
+	case COMMAND_READ:
+		WriteTracker::Written(Memory::Read_U32(_Address + 0xC), Memory::Read_U32(_Address + 0x10));
+		break;
+
+	case COMMAND_IOCTL:
+		WriteTracker::Written(Memory::Read_U32(_Address + 0x18), Memory::Read_U32(_Address + 0x1C));
+		break;
+
+	case COMMAND_IOCTLV:
+	{
+		SIOCtlVBuffer buffers(_Address);
+		for (const SIOCtlVBuffer::SBuffer& buffer : buffers.PayloadBuffer)
+			WriteTracker::Written(buffer.m_Address, buffer.m_Size);
+		break;
+	}
+	}
+}
+
 void EnqueReplyCallback(u64 userdata, int)
 {
 	std::lock_guard<std::mutex> lk(s_reply_queue);
@@ -531,6 +565,7 @@ void ExecuteCommand(u32 _Address)
 		Memory::Write_U32(8, _Address);
 		// IOS seems to write back the command that was responded to
 		Memory::Write_U32(Command, _Address + 8);
+		TrackReplyWrites(_Address);
 
 		// Ensure replies happen in order, fairly ugly
 		// Without this, tons of games fail now that DI commands have different reply delays
@@ -589,6 +624,7 @@ void Update()
 		std::lock_guard<std::mutex> lk(s_reply_queue);
 		if (reply_queue.size())
 		{
+			TrackReplyWrites(reply_queue.front());
 			WII_IPCInterface::GenerateReply(reply_queue.front());
 			INFO_LOG(WII_IPC_HLE, "<<-- Reply to IPC Request @ 0x%08x", reply_queue.front());
 			reply_queue.pop_front();
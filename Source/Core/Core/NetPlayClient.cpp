@@ -41,6 +41,30 @@ NetPad::NetPad(const SPADStatus* const pad_status)
 	nLo |= (u32)((u8)pad_status->substickX << 24);
 }
 
+static NetPlayInputChannel::Entry PadToEntry(const NetPad& np)
+{
+	NetPlayInputChannel::Entry entry(8);
+	for (int i = 0; i < 4; ++i)
+	{
+		entry[i] = (u8)(np.nHi >> (24 - i * 8));
+		entry[i + 4] = (u8)(np.nLo >> (24 - i * 8));
+	}
+	return entry;
+}
+
+static NetPad EntryToPad(const NetPlayInputChannel::Entry& entry)
+{
+	NetPad np;
+	np.nHi = 0;
+	np.nLo = 0;
+	for (int i = 0; i < 4; ++i)
+	{
+		np.nHi = np.nHi << 8 | entry[i];
+		np.nLo = np.nLo << 8 | entry[i + 4];
+	}
+	return np;
+}
+
 // called from ---GUI--- thread
 NetPlayClient::~NetPlayClient()
 {
@@ -53,10 +77,13 @@ NetPlayClient::~NetPlayClient()
 		m_do_loop = false;
 		m_thread.join();
 	}
+
+	if (m_udp_thread.joinable())
+		m_udp_thread.join();
 }
 
 // called from ---GUI--- thread
-NetPlayClient::NetPlayClient(const std::string& address, const u16 port, NetPlayUI* dialog, const std::string& name) : m_dialog(dialog), m_is_running(false), m_do_loop(true)
+NetPlayClient::NetPlayClient(const std::string& address, const u16 port, NetPlayUI* dialog, const std::string& name) : m_dialog(dialog), m_is_running(false), m_do_loop(true), m_server_address(address), m_server_udp_port(0)
 {
 	m_target_buffer_size = 20;
 	ClearBuffers();
@@ -248,6 +275,36 @@ unsigned int NetPlayClient::OnData(sf::Packet& packet)
 		}
 		break;
 
+	case NP_MSG_UDP_INPUT :
+		{
+			u16 port = 0;
+			packet >> port;
+
+			// Any port will do, the server replies to the one it sees.
+			for (u32 local_port = port + 1; local_port <= 0xFFFF && local_port < port + 64u; ++local_port)
+			{
+				if (m_udp_socket.Bind((unsigned short)local_port))
+					break;
+			}
+
+			if (m_udp_socket.GetPort())
+			{
+				m_server_udp_port = port;
+				m_udp_thread = std::thread(std::mem_fun(&NetPlayClient::UDPThreadFunc), this);
+
+				// until it gets this, the server sends us input over TCP
+				sf::Packet spac;
+				spac << (MessageId)NP_MSG_UDP_INPUT;
+				std::lock_guard<std::recursive_mutex> lks(m_crit.send);
+				m_socket.Send(spac);
+			}
+			else
+			{
+				WARN_LOG(NETPLAY, "Couldn't open a UDP port, sending input over TCP.");
+			}
+		}
+		break;
+
 	case NP_MSG_CHANGE_GAME :
 		{
 			{
@@ -277,6 +334,12 @@ unsigned int NetPlayClient::OnData(sf::Packet& packet)
 			g_NetPlaySettings.m_EXIDevice[1] = (TEXIDevices) tmp;
 			}
 
+			if (m_server_udp_port)
+			{
+				std::lock_guard<std::recursive_mutex> lks(m_crit.send);
+				m_input.reset(new NetPlayInputChannel(m_current_game, m_pid));
+			}
+
 			m_dialog->OnMsgStartGame();
 		}
 		break;
@@ -365,6 +428,62 @@ void NetPlayClient::ThreadFunc()
 	return;
 }
 
+// called from ---UDP--- thread
+void NetPlayClient::UDPThreadFunc()
+{
+	sf::Selector<sf::SocketUDP> selector;
+	selector.Add(m_udp_socket);
+	std::vector<char> buffer(0x10000);
+
+	while (m_do_loop)
+	{
+		if (selector.Wait(0.005f))
+		{
+			std::size_t size = 0;
+			sf::IPAddress address;
+			unsigned short port = 0;
+			if (m_udp_socket.Receive(buffer.data(), buffer.size(), size, address, port) == sf::Socket::Done)
+			{
+				sf::Packet rpac;
+				rpac.Append(buffer.data(), size);
+				OnDatagram(rpac);
+			}
+		}
+
+		// resend what wasn't acknowledged, or just let the server know we're here
+		std::lock_guard<std::recursive_mutex> lks(m_crit.send);
+		if (m_input && m_input->ShouldSend(Common::Timer::GetTimeMs()))
+			SendInput();
+	}
+
+	m_udp_socket.Close();
+}
+
+// called from ---UDP--- thread
+void NetPlayClient::OnDatagram(sf::Packet& packet)
+{
+	u32 game = 0;
+	PlayerId pid = 0;
+	if (!NetPlayInputChannel::ReadHeader(packet, game, pid))
+		return;
+
+	std::lock_guard<std::recursive_mutex> lks(m_crit.send);
+
+	// if this is input from the last game still being received, ignore it
+	if (!m_input || m_input->GetGame() != game)
+		return;
+
+	// trusting server for good streams
+	// add to pad and wiimote buffers
+	m_input->Receive(packet, [this](u8 stream, const NetPlayInputChannel::Entry& entry)
+	{
+		if (stream >= NetPlayInputChannel::FIRST_WIIMOTE_STREAM)
+			m_wiimote_buffer[stream - NetPlayInputChannel::FIRST_WIIMOTE_STREAM].Push(entry);
+		else if (entry.size() == 8)
+			m_pad_buffer[stream].Push(EntryToPad(entry));
+	});
+}
+
 // called from ---GUI--- thread
 void NetPlayClient::GetPlayerList(std::string& list, std::vector<int>& pid_list)
 {
@@ -429,19 +548,36 @@ void NetPlayClient::SendChatMessage(const std::string& msg)
 // called from ---CPU--- thread
 void NetPlayClient::SendPadState(const PadMapping in_game_pad, const NetPad& np)
 {
+	std::lock_guard<std::recursive_mutex> lks(m_crit.send);
+
+	// sent with the other local pads by GetNetPads
+	if (m_input)
+	{
+		m_input->Push(in_game_pad, PadToEntry(np));
+		return;
+	}
+
 	// send to server
 	sf::Packet spac;
 	spac << (MessageId)NP_MSG_PAD_DATA;
 	spac << in_game_pad;
 	spac << np.nHi << np.nLo;
 
-	std::lock_guard<std::recursive_mutex> lks(m_crit.send);
 	m_socket.Send(spac);
 }
 
 // called from ---CPU--- thread
 void NetPlayClient::SendWiimoteState(const PadMapping in_game_pad, const NetWiimote& nw)
 {
+	std::lock_guard<std::recursive_mutex> lks(m_crit.send);
+
+	// sent by WiimoteUpdate
+	if (m_input)
+	{
+		m_input->Push(NetPlayInputChannel::FIRST_WIIMOTE_STREAM + in_game_pad, nw);
+		return;
+	}
+
 	// send to server
 	sf::Packet spac;
 	spac << (MessageId)NP_MSG_WIIMOTE_DATA;
@@ -452,10 +588,17 @@ void NetPlayClient::SendWiimoteState(const PadMapping in_game_pad, const NetWiim
 		spac << it;
 	}
 
-	std::lock_guard<std::recursive_mutex> lks(m_crit.send);
 	m_socket.Send(spac);
 }
 
+// called from ---CPU--- thread and ---UDP--- thread, with the send lock held
+void NetPlayClient::SendInput()
+{
+	sf::Packet spac;
+	m_input->BuildDatagram(spac, Common::Timer::GetTimeMs());
+	m_udp_socket.Send(spac.GetData(), spac.GetDataSize(), m_server_address, m_server_udp_port);
+}
+
 // called from ---GUI--- thread
 bool NetPlayClient::StartGame(const std::string &path)
 {
@@ -603,6 +746,13 @@ bool NetPlayClient::GetNetPads(const u8 pad_nb, const SPADStatus* const pad_stat
 			// send
 			SendPadState(in_game_num, np);
 		}
+
+		// Over UDP, all the local pads go in one datagram, after the last.
+		if (m_input && LocalPadToInGamePad(pad_nb + 1) == 4)
+		{
+			std::lock_guard<std::recursive_mutex> lks(m_crit.send);
+			SendInput();
+		}
 	}
 
 	// Now, we need to swap out the local value with the values
@@ -664,6 +814,12 @@ bool NetPlayClient::WiimoteUpdate(int _number, u8* data, const u8 size)
 
 				SendWiimoteState(in_game_num, nw);
 			} while (m_wiimote_buffer[in_game_num].Size() <= m_target_buffer_size * 200 / 120); // TODO: add a seperate setting for wiimote buffer?
+
+			if (m_input)
+			{
+				std::lock_guard<std::recursive_mutex> lks(m_crit.send);
+				SendInput();
+			}
 		}
 		else
 		{
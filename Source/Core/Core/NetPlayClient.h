@@ -6,6 +6,7 @@
 
 #include <functional>
 #include <map>
+#include <memory>
 #include <queue>
 #include <sstream>
 
@@ -17,6 +18,7 @@
 #include "Common/Thread.h"
 #include "Common/Timer.h"
 
+#include "Core/NetPlayInputChannel.h"
 #include "Core/NetPlayProto.h"
 
 #include "InputCommon/GCPadStatus.h"
@@ -61,6 +63,7 @@ class NetPlayClient
 {
 public:
 	void ThreadFunc();
+	void UDPThreadFunc();
 
 	NetPlayClient(const std::string& address, const u16 port, NetPlayUI* dialog, const std::string& name);
 	~NetPlayClient();
@@ -118,11 +121,21 @@ protected:
 
 	bool m_is_recording;
 
+	// When the server has input sent over UDP, where to, and the input of
+	// the current game. Protected by m_crit.send.
+	sf::SocketUDP m_udp_socket;
+	sf::IPAddress m_server_address;
+	unsigned short m_server_udp_port;
+	std::unique_ptr<NetPlayInputChannel> m_input;
+	std::thread   m_udp_thread;
+
 private:
 	void UpdateDevices();
 	void SendPadState(const PadMapping in_game_pad, const NetPad& np);
 	void SendWiimoteState(const PadMapping in_game_pad, const NetWiimote& nw);
+	void SendInput();
 	unsigned int OnData(sf::Packet& packet);
+	void OnDatagram(sf::Packet& packet);
 
 	PlayerId m_pid;
 	std::map<PlayerId, Player> m_players;
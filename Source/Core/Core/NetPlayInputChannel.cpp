@@ -0,0 +1,138 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <algorithm>
+
+#include "Core/NetPlayInputChannel.h"
+
+// A datagram is the header, the game and the player it's from, then the
+// number of the next entry expected of each stream anything was received of,
+// then the entries not acknowledged of each stream with any:
+//
+//   u32 game, PlayerId pid
+//   u8 count, count * { u8 stream, u32 received }
+//   u8 count, count * { u8 stream, u32 first, u8 entries, entries * { u8 size, size * u8 } }
+
+NetPlayInputChannel::NetPlayInputChannel(u32 game, PlayerId pid, u32 max_entries)
+	: m_game(game)
+	, m_pid(pid)
+	, m_max_entries(max_entries)
+	, m_last_sent_ms(0)
+	, m_ack_pending(false)
+{
+}
+
+void NetPlayInputChannel::Push(u8 stream, const Entry& entry)
+{
+	m_streams[stream].unacked.push_back(entry);
+}
+
+bool NetPlayInputChannel::ShouldSend(u32 now_ms) const
+{
+	bool pending = m_ack_pending;
+	for (const Stream& s : m_streams)
+		pending |= !s.unacked.empty();
+
+	return now_ms - m_last_sent_ms >= (u32)(pending ? RESEND_INTERVAL_MS : KEEPALIVE_INTERVAL_MS);
+}
+
+void NetPlayInputChannel::BuildDatagram(sf::Packet& packet, u32 now_ms)
+{
+	packet << m_game << m_pid;
+
+	u8 count = 0;
+	for (const Stream& s : m_streams)
+		count += s.received != 0;
+	packet << count;
+	for (u8 i = 0; i < NUM_STREAMS; ++i)
+	{
+		if (m_streams[i].received)
+			packet << i << m_streams[i].received;
+	}
+
+	count = 0;
+	for (const Stream& s : m_streams)
+		count += !s.unacked.empty();
+	packet << count;
+	for (u8 i = 0; i < NUM_STREAMS; ++i)
+	{
+		const Stream& s = m_streams[i];
+		if (s.unacked.empty())
+			continue;
+
+		const u8 entries = (u8)std::min<size_t>(s.unacked.size(), m_max_entries);
+		packet << i << s.acked << entries;
+		for (u8 e = 0; e < entries; ++e)
+		{
+			const Entry& entry = s.unacked[e];
+			packet << (u8)entry.size();
+			packet.Append(entry.data(), entry.size());
+		}
+	}
+
+	m_last_sent_ms = now_ms;
+	m_ack_pending = false;
+}
+
+bool NetPlayInputChannel::ReadHeader(sf::Packet& packet, u32& game, PlayerId& pid)
+{
+	packet >> game >> pid;
+	return packet;
+}
+
+bool NetPlayInputChannel::Receive(sf::Packet& packet, const EntryReceiver& receiver)
+{
+	u8 count = 0;
+	packet >> count;
+	for (u8 i = 0; i < count; ++i)
+	{
+		u8 stream = 0;
+		u32 received = 0;
+		packet >> stream >> received;
+		if (!packet || stream >= NUM_STREAMS)
+			return false;
+
+		// Acknowledgements can come late, or out of order.
+		Stream& s = m_streams[stream];
+		if (received > s.acked && received - s.acked <= s.unacked.size())
+		{
+			s.unacked.erase(s.unacked.begin(), s.unacked.begin() + (received - s.acked));
+			s.acked = received;
+		}
+	}
+
+	packet >> count;
+	Entry entry;
+	for (u8 i = 0; i < count; ++i)
+	{
+		u8 stream = 0, entries = 0;
+		u32 first = 0;
+		packet >> stream >> first >> entries;
+		if (!packet || stream >= NUM_STREAMS)
+			return false;
+
+		Stream& s = m_streams[stream];
+		for (u32 e = 0; e < entries; ++e)
+		{
+			u8 size = 0;
+			packet >> size;
+			entry.resize(size);
+			for (u8& b : entry)
+				packet >> b;
+			if (!packet)
+				return false;
+
+			// Entries already received are dropped. The other end only ever
+			// sends from the last we acknowledged, so there are no gaps.
+			if (first + e == s.received)
+			{
+				receiver(stream, entry);
+				s.received++;
+				m_ack_pending = true;
+			}
+		}
+	}
+
+	return true;
+}
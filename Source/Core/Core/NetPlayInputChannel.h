@@ -0,0 +1,90 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <deque>
+#include <functional>
+#include <vector>
+
+#include <SFML/Network.hpp>
+
+#include "Common/CommonTypes.h"
+
+#include "Core/NetPlayProto.h"
+
+// One end of the link NetPlay can send input over by UDP instead of TCP,
+// between a client and the server. It only builds and reads the datagrams;
+// sending them is up to the owner.
+//
+// Input goes as streams of entries, one stream for each in-game pad and
+// wiimote, every entry with a sequence number in its stream. Each datagram
+// carries the entries of all the streams the other end hasn't acknowledged
+// yet, up to a limit, so a datagram lost costs nothing once the next one
+// arrives, and one late doesn't hold up those after it as it would over TCP.
+// The acknowledgements go along with the input the other way.
+class NetPlayInputChannel
+{
+public:
+	enum
+	{
+		// The in-game pads, then the wiimotes.
+		NUM_STREAMS = 8,
+		FIRST_WIIMOTE_STREAM = 4,
+		// Entries of each stream carried in a datagram at most, enough for a
+		// round trip of half a second at 60 fps. The rest wait for those to be
+		// acknowledged.
+		MAX_ENTRIES = 32,
+		// How long after the last datagram to send another while anything
+		// isn't acknowledged...
+		RESEND_INTERVAL_MS = 20,
+		// ...and otherwise, which is how the server learns where a client is.
+		KEEPALIVE_INTERVAL_MS = 250,
+	};
+
+	typedef std::vector<u8> Entry;
+	typedef std::function<void(u8 stream, const Entry& entry)> EntryReceiver;
+
+	// Datagrams of another game than game aren't meant for this channel.
+	NetPlayInputChannel(u32 game, PlayerId pid, u32 max_entries = MAX_ENTRIES);
+
+	u32 GetGame() const { return m_game; }
+
+	// Queues the next entry of stream, to go with every datagram until
+	// acknowledged.
+	void Push(u8 stream, const Entry& entry);
+
+	// Whether a datagram is due at now_ms, to resend, acknowledge or keep
+	// alive. Input just pushed should rather be sent right away.
+	bool ShouldSend(u32 now_ms) const;
+	void BuildDatagram(sf::Packet& packet, u32 now_ms);
+
+	// Reads who sent a datagram, to find the channel for the rest of it.
+	static bool ReadHeader(sf::Packet& packet, u32& game, PlayerId& pid);
+	// Reads the rest of a datagram, passing receiver the entries which
+	// weren't received before, each stream in order. Returns false if the
+	// datagram was malformed.
+	bool Receive(sf::Packet& packet, const EntryReceiver& receiver);
+
+private:
+	struct Stream
+	{
+		Stream() : acked(0), received(0) {}
+
+		// Entries pushed and not acknowledged, the first numbered acked.
+		std::deque<Entry> unacked;
+		u32 acked;
+		// The number of the next entry to be received.
+		u32 received;
+	};
+
+	u32 m_game;
+	PlayerId m_pid;
+	u32 m_max_entries;
+	Stream m_streams[NUM_STREAMS];
+
+	u32 m_last_sent_ms;
+	// Received anything the other end doesn't know yet we have.
+	bool m_ack_pending;
+};
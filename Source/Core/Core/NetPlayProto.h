@@ -28,7 +28,7 @@ struct Rpt : public std::vector<u8>
 
 typedef std::vector<u8> NetWiimote;
 
-#define NETPLAY_VERSION  "Dolphin NetPlay 2014-01-08"
+#define NETPLAY_VERSION  "Dolphin NetPlay 2014-06-01"
 
 const int NETPLAY_INITIAL_GCTIME = 1272737767;
 
@@ -44,6 +44,7 @@ enum
 	NP_MSG_PAD_DATA         = 0x60,
 	NP_MSG_PAD_MAPPING      = 0x61,
 	NP_MSG_PAD_BUFFER       = 0x62,
+	NP_MSG_UDP_INPUT        = 0x63,
 
 	NP_MSG_WIIMOTE_DATA     = 0x70,
 	NP_MSG_WIIMOTE_MAPPING  = 0x71,
@@ -2,6 +2,8 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include <algorithm>
+
 #include "Core/NetPlayServer.h"
 
 NetPlayServer::~NetPlayServer()
@@ -13,6 +15,12 @@ NetPlayServer::~NetPlayServer()
 		m_socket.Close();
 	}
 
+	if (m_udp_thread.joinable())
+	{
+		m_udp_thread.join();
+		m_udp_socket.Close();
+	}
+
 #ifdef USE_UPNP
 	if (m_upnp_thread.joinable())
 		m_upnp_thread.join();
@@ -22,17 +30,28 @@ NetPlayServer::~NetPlayServer()
 }
 
 // called from ---GUI--- thread
-NetPlayServer::NetPlayServer(const u16 port) : is_connected(false), m_is_running(false)
+NetPlayServer::NetPlayServer(const u16 port, const bool udp_input) : is_connected(false), m_is_running(false), m_udp_input(false)
 {
 	memset(m_pad_map, -1, sizeof(m_pad_map));
 	memset(m_wiimote_map, -1, sizeof(m_wiimote_map));
 	if (m_socket.Listen(port))
 	{
+		// before the threads start, as OnConnect tells clients about it
+		if (udp_input)
+		{
+			if (m_udp_socket.Bind(port))
+				m_udp_input = true;
+			else
+				WARN_LOG(NETPLAY, "Couldn't bind UDP port %d, sending input over TCP.", port);
+		}
+
 		is_connected = true;
 		m_do_loop = true;
 		m_selector.Add(m_socket);
-		m_thread = std::thread(std::mem_fun(&NetPlayServer::ThreadFunc), this);
 		m_target_buffer_size = 20;
+		m_thread = std::thread(std::mem_fun(&NetPlayServer::ThreadFunc), this);
+		if (m_udp_input)
+			m_udp_thread = std::thread(std::mem_fun(&NetPlayServer::UDPThreadFunc), this);
 	}
 }
 
@@ -69,12 +88,13 @@ void NetPlayServer::ThreadFunc()
 			if (ready_socket == m_socket)
 			{
 				sf::SocketTCP accept_socket;
-				m_socket.Accept(accept_socket);
+				sf::IPAddress address;
+				m_socket.Accept(accept_socket, &address);
 
 				unsigned int error;
 				{
 				std::lock_guard<std::recursive_mutex> lkg(m_crit.game);
-				error = OnConnect(accept_socket);
+				error = OnConnect(accept_socket, address);
 				}
 
 				if (error)
@@ -123,8 +143,144 @@ void NetPlayServer::ThreadFunc()
 	return;
 }
 
+// called from ---UDP--- thread
+void NetPlayServer::UDPThreadFunc()
+{
+	sf::Selector<sf::SocketUDP> selector;
+	selector.Add(m_udp_socket);
+	std::vector<char> buffer(0x10000);
+
+	while (m_do_loop)
+	{
+		if (selector.Wait(0.005f))
+		{
+			std::size_t size = 0;
+			sf::IPAddress address;
+			unsigned short port = 0;
+			if (m_udp_socket.Receive(buffer.data(), buffer.size(), size, address, port) == sf::Socket::Done)
+			{
+				sf::Packet rpac;
+				rpac.Append(buffer.data(), size);
+				OnDatagram(rpac, address, port);
+			}
+		}
+
+		// resend what wasn't acknowledged
+		std::lock_guard<std::recursive_mutex> lkp(m_crit.players);
+		const u32 now = Common::Timer::GetTimeMs();
+		for (std::pair<const sf::SocketTCP, Client>& p : m_players)
+		{
+			if (p.second.input && p.second.input->ShouldSend(now))
+				SendInput(p.second, now);
+		}
+	}
+}
+
+// called from ---UDP--- thread
+void NetPlayServer::OnDatagram(sf::Packet& packet, const sf::IPAddress& address, unsigned short port)
+{
+	u32 game = 0;
+	PlayerId pid = 0;
+	if (!NetPlayInputChannel::ReadHeader(packet, game, pid))
+		return;
+
+	std::lock_guard<std::recursive_mutex> lkp(m_crit.players);
+	auto it = std::find_if(m_players.begin(), m_players.end(), [&](const std::pair<const sf::SocketTCP, Client>& p)
+	{
+		return p.second.pid == pid && p.second.address == address;
+	});
+	if (it == m_players.end())
+		return;
+
+	// This is the port as we see it, through any NAT.
+	Client& player = it->second;
+	player.udp_port = port;
+
+	// if this is input from the last game still being received, ignore it
+	if (!player.input || player.input->GetGame() != game)
+		return;
+
+	bool relayed = false;
+	const bool valid = player.input->Receive(packet, [&](u8 stream, const NetPlayInputChannel::Entry& entry)
+	{
+		// Only relay what's from the player's own pads and wiimotes.
+		const PadMapping mapping = stream < NetPlayInputChannel::FIRST_WIIMOTE_STREAM ?
+			m_pad_map[stream] : m_wiimote_map[stream - NetPlayInputChannel::FIRST_WIIMOTE_STREAM];
+		if (mapping != player.pid)
+			return;
+
+		for (std::pair<const sf::SocketTCP, Client>& p : m_players)
+		{
+			if (p.second.pid == player.pid)
+				continue;
+			if (p.second.input)
+				p.second.input->Push(stream, entry);
+			else
+				SendInputOverTCP(p.second, stream, entry);
+		}
+		relayed = true;
+	});
+
+	if (!valid)
+		WARN_LOG(NETPLAY, "Malformed input datagram from player %d", pid);
+
+	// All the input in this datagram goes on in one to each client.
+	if (relayed)
+	{
+		const u32 now = Common::Timer::GetTimeMs();
+		for (std::pair<const sf::SocketTCP, Client>& p : m_players)
+		{
+			if (p.second.pid != player.pid && p.second.input)
+				SendInput(p.second, now);
+		}
+	}
+}
+
+// called from ---UDP--- thread
+void NetPlayServer::SendInput(Client& client, u32 now_ms)
+{
+	// Nowhere to send it until the client sends something.
+	if (!client.udp_port)
+		return;
+
+	sf::Packet spac;
+	client.input->BuildDatagram(spac, now_ms);
+	m_udp_socket.Send(spac.GetData(), spac.GetDataSize(), client.address, client.udp_port);
+}
+
+// called from ---UDP--- thread, for clients that take input over TCP
+void NetPlayServer::SendInputOverTCP(Client& client, u8 stream, const NetPlayInputChannel::Entry& entry)
+{
+	sf::Packet spac;
+	if (stream < NetPlayInputChannel::FIRST_WIIMOTE_STREAM)
+	{
+		if (entry.size() != 8)
+			return;
+
+		u32 hi = 0, lo = 0;
+		for (int i = 0; i < 4; ++i)
+		{
+			hi = hi << 8 | entry[i];
+			lo = lo << 8 | entry[i + 4];
+		}
+		spac << (MessageId)NP_MSG_PAD_DATA;
+		spac << (PadMapping)stream << hi << lo;
+	}
+	else
+	{
+		spac << (MessageId)NP_MSG_WIIMOTE_DATA;
+		spac << (PadMapping)(stream - NetPlayInputChannel::FIRST_WIIMOTE_STREAM);
+		spac << (u8)entry.size();
+		for (u8 byte : entry)
+			spac << byte;
+	}
+
+	std::lock_guard<std::recursive_mutex> lks(m_crit.send);
+	client.socket.Send(spac);
+}
+
 // called from ---NETPLAY--- thread
-unsigned int NetPlayServer::OnConnect(sf::SocketTCP& socket)
+unsigned int NetPlayServer::OnConnect(sf::SocketTCP& socket, const sf::IPAddress& address)
 {
 	sf::Packet rpac;
 	// TODO: make this not hang / check if good packet
@@ -149,6 +305,10 @@ unsigned int NetPlayServer::OnConnect(sf::SocketTCP& socket)
 
 	Client player;
 	player.socket = socket;
+	player.address = address;
+	// input goes over TCP until the client says it opened a UDP port
+	player.udp_input = false;
+	player.udp_port = 0;
 	rpac >> player.revision;
 	rpac >> player.name;
 
@@ -195,6 +355,15 @@ unsigned int NetPlayServer::OnConnect(sf::SocketTCP& socket)
 	spac << (u32)m_target_buffer_size;
 	socket.Send(spac);
 
+	// tell the new client to send input over UDP
+	if (m_udp_input)
+	{
+		spac.Clear();
+		spac << (MessageId)NP_MSG_UDP_INPUT;
+		spac << (u16)m_udp_socket.GetPort();
+		socket.Send(spac);
+	}
+
 	// sync values with new client
 	for (const auto& p : m_players)
 	{
@@ -209,7 +378,7 @@ unsigned int NetPlayServer::OnConnect(sf::SocketTCP& socket)
 	// add client to the player list
 	{
 	std::lock_guard<std::recursive_mutex> lkp(m_crit.players);
-	m_players[socket] = player;
+	m_players[socket] = std::move(player);
 	std::lock_guard<std::recursive_mutex> lks(m_crit.send);
 	UpdatePadMapping(); // sync pad mappings with everyone
 	UpdateWiimoteMapping();
@@ -381,6 +550,18 @@ unsigned int NetPlayServer::OnData(sf::Packet& packet, sf::SocketTCP& socket)
 		}
 		break;
 
+	case NP_MSG_UDP_INPUT :
+		{
+			if (!m_udp_input)
+				break;
+
+			std::lock_guard<std::recursive_mutex> lkp(m_crit.players);
+			player.udp_input = true;
+			if (m_is_running)
+				player.input.reset(new NetPlayInputChannel(m_current_game, 0));
+		}
+		break;
+
 	case NP_MSG_PAD_DATA :
 		{
 			// if this is pad data from the last game still being received, ignore it
@@ -556,6 +737,13 @@ bool NetPlayServer::StartGame(const std::string &path)
 	std::lock_guard<std::recursive_mutex> lks(m_crit.send);
 	SendToClients(spac);
 
+	// input of the last game is no use now
+	for (std::pair<const sf::SocketTCP, Client>& p : m_players)
+	{
+		if (p.second.udp_input)
+			p.second.input.reset(new NetPlayInputChannel(m_current_game, 0));
+	}
+
 	m_is_running = true;
 
 	return true;
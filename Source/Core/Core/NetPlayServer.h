@@ -6,6 +6,7 @@
 
 #include <functional>
 #include <map>
+#include <memory>
 #include <queue>
 #include <sstream>
 
@@ -16,14 +17,18 @@
 #include "Common/Thread.h"
 #include "Common/Timer.h"
 
+#include "Core/NetPlayInputChannel.h"
 #include "Core/NetPlayProto.h"
 
 class NetPlayServer
 {
 public:
 	void ThreadFunc();
+	void UDPThreadFunc();
 
-	NetPlayServer(const u16 port);
+	// With udp_input, clients send input over UDP on the same port, rather
+	// than along with everything else over TCP.
+	NetPlayServer(const u16 port, const bool udp_input = false);
 	~NetPlayServer();
 
 	bool ChangeGame(const std::string& game);
@@ -58,12 +63,23 @@ private:
 		sf::SocketTCP socket;
 		u32 ping;
 		u32 current_game;
+
+		// Where input is sent over UDP, the port once the client has sent
+		// anything from it, and the input of the current game. Clients that
+		// couldn't open a UDP port send and get input over TCP instead.
+		sf::IPAddress address;
+		bool udp_input;
+		unsigned short udp_port;
+		std::unique_ptr<NetPlayInputChannel> input;
 	};
 
 	void SendToClients(sf::Packet& packet, const PlayerId skip_pid = 0);
-	unsigned int OnConnect(sf::SocketTCP& socket);
+	unsigned int OnConnect(sf::SocketTCP& socket, const sf::IPAddress& address);
 	unsigned int OnDisconnect(sf::SocketTCP& socket);
 	unsigned int OnData(sf::Packet& packet, sf::SocketTCP& socket);
+	void OnDatagram(sf::Packet& packet, const sf::IPAddress& address, unsigned short port);
+	void SendInput(Client& client, u32 now_ms);
+	void SendInputOverTCP(Client& client, u8 stream, const NetPlayInputChannel::Entry& entry);
 	void UpdatePadMapping();
 	void UpdateWiimoteMapping();
 
@@ -94,6 +110,10 @@ private:
 	std::thread m_thread;
 	sf::Selector<sf::SocketTCP> m_selector;
 
+	bool m_udp_input;
+	sf::SocketUDP m_udp_socket;
+	std::thread m_udp_thread;
+
 #ifdef USE_UPNP
 	static void mapPortThread(const u16 port);
 	static void unmapPortThread();
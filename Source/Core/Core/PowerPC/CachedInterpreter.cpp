@@ -0,0 +1,209 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <algorithm>
+
+#include "Common/Atomic.h"
+#include "Core/Core.h"
+#include "Core/CoreTiming.h"
+#include "Core/HLE/HLE.h"
+#include "Core/HW/Memmap.h"
+#include "Core/PowerPC/CachedInterpreter.h"
+#include "Core/PowerPC/PowerPC.h"
+#include "Core/PowerPC/PPCTables.h"
+
+void CachedInterpreter::Init()
+{
+	m_code.reserve(CODE_CAPACITY);
+	m_block_cache.Init();
+}
+
+void CachedInterpreter::Shutdown()
+{
+	m_block_cache.Shutdown();
+	std::vector<Instruction>().swap(m_code);
+}
+
+void CachedInterpreter::ClearCache()
+{
+	m_block_cache.Clear();
+	m_code.clear();
+}
+
+void CachedInterpreter::Run()
+{
+	// The interpreter checks breakpoints on every instruction.
+	if (Core::g_CoreStartupParameter.bEnableDebugging)
+	{
+		Interpreter::getInstance()->Run();
+		return;
+	}
+
+	while (!PowerPC::GetState())
+	{
+		RunSlice();
+
+		CoreTiming::Advance();
+
+		if (PowerPC::ppcState.Exceptions)
+		{
+			PowerPC::CheckExceptions();
+			PC = NPC;
+		}
+	}
+}
+
+void CachedInterpreter::SingleStep()
+{
+	Interpreter::getInstance()->SingleStep();
+}
+
+void CachedInterpreter::RunSlice()
+{
+	const u8 **code_pointers = m_block_cache.GetCodePointers();
+	while (CoreTiming::downcount > 0)
+	{
+		int block_num = m_block_cache.GetBlockNumberFromStartAddress(PC);
+		if (block_num < 0)
+		{
+			Jit(PC);
+			block_num = m_block_cache.GetBlockNumberFromStartAddress(PC);
+		}
+
+		if (block_num >= 0)
+		{
+			CoreTiming::downcount -= ExecuteBlock((const Instruction *)code_pointers[block_num]);
+		}
+		else
+		{
+			// Not decodable, e.g. an instruction fetch exception: the
+			// interpreter deals with it.
+			Interpreter::m_EndBlock = true;
+			CoreTiming::downcount -= Interpreter::getInstance()->SingleStepInner();
+		}
+	}
+}
+
+// Follows Interpreter::SingleStepInner instruction for instruction, minus the
+// decoding.
+int CachedInterpreter::ExecuteBlock(const Instruction *code)
+{
+	int cycles = 0;
+	Interpreter::m_EndBlock = false;
+	for (;; ++code)
+	{
+		if (code->flags)
+		{
+			if (code->flags & FLAG_END_OF_BLOCK)
+				break;
+
+			if (code->flags & FLAG_HLE)
+			{
+				code->func(code->inst);
+				if (code->flags & FLAG_HLE_REPLACE)
+				{
+					cycles += code->cycles;
+					PC = NPC;
+					break;
+				}
+				continue;
+			}
+
+			if ((code->flags & FLAG_CHECK_FPU) && !((UReg_MSR&)MSR).FP)
+			{
+				cycles += code->cycles;
+				NPC = PC + sizeof(UGeckoInstruction);
+				Common::AtomicOr(PowerPC::ppcState.Exceptions, EXCEPTION_FPU_UNAVAILABLE);
+				PowerPC::CheckExceptions();
+				PC = NPC;
+				break;
+			}
+		}
+
+		cycles += code->cycles;
+		NPC = PC + sizeof(UGeckoInstruction);
+		code->func(code->inst);
+		if (PowerPC::ppcState.Exceptions & EXCEPTION_DSI)
+		{
+			PowerPC::CheckExceptions();
+			PC = NPC;
+			break;
+		}
+		PC = NPC;
+
+		// Branches, rfi, sc and a few others end the block when they run.
+		if (Interpreter::m_EndBlock)
+			break;
+	}
+	return cycles;
+}
+
+void CachedInterpreter::Jit(u32 em_address)
+{
+	if (m_code.size() + MAX_BLOCK_INSTRUCTIONS + 2 > CODE_CAPACITY || m_block_cache.IsFull())
+		ClearCache();
+
+	const size_t start = m_code.size();
+	bool replaced = false;
+
+	// Like the interpreter, only look for HLE hooks where a block starts.
+	u32 function = HLE::GetFunctionIndex(em_address);
+	if (function != 0)
+	{
+		int type = HLE::GetFunctionTypeByIndex(function);
+		if ((type == HLE::HLE_HOOK_START || type == HLE::HLE_HOOK_REPLACE) &&
+		    HLE::IsEnabled(HLE::GetFunctionFlagsByIndex(function)))
+		{
+			replaced = type == HLE::HLE_HOOK_REPLACE;
+			Instruction hle = { Interpreter::HLEFunction, UGeckoInstruction(function), 1,
+			                    (u16)(FLAG_HLE | (replaced ? FLAG_HLE_REPLACE : 0)) };
+			m_code.push_back(hle);
+		}
+	}
+
+	// Reading an instruction can raise an exception with the MMU on. Only the
+	// first instruction of a page can fail, so stop at page boundaries and
+	// let the next block find out.
+	const bool mmu = Core::g_CoreStartupParameter.bMMU && !Core::g_CoreStartupParameter.bTLBHack;
+
+	u32 num_instructions = 0;
+	for (u32 address = em_address; !replaced && num_instructions < MAX_BLOCK_INSTRUCTIONS; address += 4)
+	{
+		if (num_instructions != 0 && mmu && (address & 0xFFF) == 0)
+			break;
+
+		UGeckoInstruction inst(Memory::Read_Opcode(address));
+		Interpreter::_interpreterInstruction func = GetInterpreterOp(inst);
+		// Covers a failed read as well, which returns 0.
+		if (func == Interpreter::unknown_instruction)
+			break;
+
+		const GekkoOPInfo *opinfo = GetOpInfo(inst);
+		Instruction instruction = { func, inst, (u16)(opinfo->numCyclesMinusOne + 1),
+		                            (u16)((opinfo->flags & FL_USE_FPU) ? FLAG_CHECK_FPU : 0) };
+		m_code.push_back(instruction);
+		num_instructions++;
+
+		if (opinfo->flags & FL_ENDBLOCK)
+			break;
+	}
+
+	if (num_instructions == 0 && !replaced)
+	{
+		// Leave it to the interpreter.
+		m_code.resize(start);
+		return;
+	}
+
+	Instruction end = { nullptr, UGeckoInstruction(0), 0, FLAG_END_OF_BLOCK };
+	m_code.push_back(end);
+
+	int block_num = m_block_cache.AllocateBlock(em_address);
+	JitBlock *b = m_block_cache.GetBlock(block_num);
+	b->checkedEntry = b->normalEntry = (const u8 *)&m_code[start];
+	b->codeSize = (u32)((m_code.size() - start) * sizeof(Instruction));
+	b->originalSize = std::max(num_instructions, 1u);
+	b->runCount = 0;
+	m_block_cache.FinalizeBlock(block_num, false, b->normalEntry);
+}
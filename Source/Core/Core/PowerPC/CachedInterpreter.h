@@ -0,0 +1,90 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Core/PowerPC/Interpreter/Interpreter.h"
+#include "Core/PowerPC/JitCommon/JitBase.h"
+
+// Runs the interpreter's instruction handlers, but decodes each block of
+// PowerPC code only once: the first time a block runs, its instructions are
+// looked up in the interpreter tables and stored as a list of handler calls,
+// which later runs of the block just walk through. For hosts without a JIT,
+// or when the JIT is disabled.
+//
+// Blocks live in the same block cache as JIT blocks, so icbi and the other
+// cache invalidation paths drop them the same way.
+class CachedInterpreter : public JitBase
+{
+public:
+	CachedInterpreter() {}
+
+	void Init() override;
+	void Shutdown() override;
+	void ClearCache() override;
+
+	void Run() override;
+	void SingleStep() override;
+
+	const char *GetName() override { return "Cached Interpreter"; }
+
+	JitBaseBlockCache *GetBlockCache() override { return &m_block_cache; }
+
+	void Jit(u32 em_address) override;
+
+	const u8 *BackPatch(u8 *codePtr, u32 em_address, void *ctx) override { return nullptr; }
+	const CommonAsmRoutinesBase *GetAsmRoutines() override { return nullptr; }
+	bool IsInCodeSpace(u8 *ptr) override { return false; }
+
+	// Runs blocks until CoreTiming::downcount runs out, without advancing
+	// CoreTiming or taking pending exceptions.
+	void RunSlice();
+
+private:
+	enum
+	{
+		// Longer runs of straight-line code are split into several blocks.
+		MAX_BLOCK_INSTRUCTIONS = 256,
+		// The cache is flushed when it can't take a block of the maximum size.
+		CODE_CAPACITY = 1024 * 1024,
+	};
+
+	enum InstructionFlags
+	{
+		// Marks the end of a block; func is unused.
+		FLAG_END_OF_BLOCK = 1 << 0,
+		// Raises a floating point unavailable exception instead if MSR.FP is clear.
+		FLAG_CHECK_FPU = 1 << 1,
+		// An HLE hook at the start of the block; inst holds the function index.
+		FLAG_HLE = 1 << 2,
+		// The HLE function replaces the original code, which doesn't run.
+		FLAG_HLE_REPLACE = 1 << 3,
+	};
+
+	struct Instruction
+	{
+		Interpreter::_interpreterInstruction func;
+		UGeckoInstruction inst;
+		u16 cycles;
+		u16 flags;
+	};
+
+	class BlockCache : public JitBaseBlockCache
+	{
+	private:
+		// Blocks are never linked, and nothing runs a block without looking it up first.
+		void WriteLinkBlock(u8* location, const u8* address) override {}
+		void WriteDestroyBlock(const u8* location, u32 address) override {}
+	};
+
+	static int ExecuteBlock(const Instruction *code);
+
+	BlockCache m_block_cache;
+	// Instructions of all blocks, each block followed by an end marker. The
+	// capacity is reserved up front, so blocks can point into it.
+	std::vector<Instruction> m_code;
+};
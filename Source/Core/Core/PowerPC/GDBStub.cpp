@@ -20,6 +20,7 @@
 #endif
 
 #include "Core/Host.h"
+#include "Core/HW/WriteTracker.h"
 #include "Core/PowerPC/GDBStub.h"
 
 #define GDB_BFR_MAX  10000
@@ -608,6 +609,7 @@ static void gdb_write_mem()
 	if (!dst)
 		return gdb_reply("E00");
 	hex2mem(dst, cmd_bfr + i + 1, len);
+	WriteTracker::Written(addr, len);
 	gdb_reply("OK");
 }
 
@@ -2,6 +2,7 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include <cinttypes>
 #include <map>
 
 // for the PROFILER stuff
@@ -10,10 +11,13 @@
 #endif
 
 #include "Common/Common.h"
+#include "Common/StringUtil.h"
+#include "Common/Timer.h"
 #include "Core/PatchEngine.h"
 #include "Core/HLE/HLE.h"
 #include "Core/HW/ProcessorInterface.h"
 #include "Core/PowerPC/Profiler.h"
+#include "Core/PowerPC/Interpreter/Interpreter.h"
 #include "Core/PowerPC/Jit64/Jit.h"
 #include "Core/PowerPC/Jit64/Jit64_Tables.h"
 #include "Core/PowerPC/Jit64/JitAsm.h"
@@ -181,10 +185,30 @@ void Jit64::Init()
 
 	blocks.Init();
 	asm_routines.Init();
+
+	tier_threshold = 0;
+	memset(&tier_stats, 0, sizeof(tier_stats));
+	if (Core::g_CoreStartupParameter.iJITTieringThreshold > 0 && !Core::g_CoreStartupParameter.bEnableDebugging)
+	{
+		tier_threshold = std::min(Core::g_CoreStartupParameter.iJITTieringThreshold, 0xFFFF);
+		tier_counters.assign(TIER_COUNTERS_SIZE, 0);
+	}
+
+	block_profile.Clear();
+	block_profile_filename.clear();
+	block_profile_warmed = false;
+	const std::string& game_id = Core::g_CoreStartupParameter.GetUniqueID();
+	if (Core::g_CoreStartupParameter.bJITBlockProfile && !Core::g_CoreStartupParameter.bEnableDebugging &&
+	    !Core::g_CoreStartupParameter.bJITNoBlockCache && !game_id.empty())
+	{
+		block_profile_filename = JitBlockProfile::GetFilename(game_id);
+		block_profile.Load(block_profile_filename);
+	}
 }
 
 void Jit64::ClearCache()
 {
+	LogTieringStats();
 	blocks.Clear();
 	trampolines.ClearCodeSpace();
 	ClearCodeSpace();
@@ -192,6 +216,10 @@ void Jit64::ClearCache()
 
 void Jit64::Shutdown()
 {
+	if (!block_profile_filename.empty())
+		block_profile.Save(block_profile_filename);
+	LogTieringStats();
+
 	FreeCodeSpace();
 
 	blocks.Shutdown();
@@ -387,14 +415,103 @@ void Jit64::Trace()
 
 void STACKALIGN Jit64::Jit(u32 em_address)
 {
+	if (tier_threshold && InterpretColdBlock(em_address))
+		return;
+
 	if (GetSpaceLeft() < 0x10000 || blocks.IsFull() || Core::g_CoreStartupParameter.bJITNoBlockCache)
 	{
 		ClearCache();
 	}
 
+	if (!block_profile_filename.empty())
+		WarmFromProfile(em_address);
+
+	u64 compile_start = tier_threshold ? Common::Timer::GetTimeUs() : 0;
+
 	int block_num = blocks.AllocateBlock(em_address);
 	JitBlock *b = blocks.GetBlock(block_num);
 	blocks.FinalizeBlock(block_num, jo.enableBlocklink, DoJit(em_address, &code_buffer, b));
+
+	if (tier_threshold)
+	{
+		tier_stats.blocks_compiled++;
+		tier_stats.compile_time_us += Common::Timer::GetTimeUs() - compile_start;
+	}
+
+	if (!block_profile_filename.empty())
+		block_profile.RecordBlock(em_address, b->originalSize);
+}
+
+// Returns false if the block at em_address should be compiled now. Otherwise
+// runs it through the interpreter and charges its cycles; the dispatcher
+// picks up at the new PC.
+bool Jit64::InterpretColdBlock(u32 em_address)
+{
+	// HLE hooks are applied when compiling; the interpreter only checks them after a branch.
+	if (HLE::GetFunctionIndex(em_address))
+		return false;
+
+	u16& counter = tier_counters[(em_address >> 2) & (TIER_COUNTERS_SIZE - 1)];
+	if (counter == 0)
+		tier_stats.cold_blocks++;
+	if (++counter >= tier_threshold)
+	{
+		counter = 0;
+		return false;
+	}
+
+	tier_stats.blocks_interpreted++;
+	Interpreter* const interpreter = Interpreter::getInstance();
+	Interpreter::m_EndBlock = false;
+	int cycles = 0;
+	while (!Interpreter::m_EndBlock)
+		cycles += interpreter->SingleStepInner();
+	CoreTiming::downcount -= cycles;
+	return true;
+}
+
+std::string Jit64::TieringStats::Summary(u32 threshold, int num_blocks, size_t code_used) const
+{
+	// Every counter that started but never reached the threshold is a compile we skipped.
+	u64 skipped = cold_blocks > blocks_compiled ? cold_blocks - blocks_compiled : 0;
+	u64 avg_compile_us = blocks_compiled ? compile_time_us / blocks_compiled : 0;
+	return StringFromFormat("Tiering (threshold %u): %" PRIu64 " blocks compiled in %" PRIu64 " ms, "
+	                        "%" PRIu64 " interpreted runs, ~%" PRIu64 " compiles skipped (~%" PRIu64 " ms saved), "
+	                        "code cache %d blocks / %u KiB used",
+	                        threshold, blocks_compiled, compile_time_us / 1000,
+	                        blocks_interpreted, skipped, skipped * avg_compile_us / 1000,
+	                        num_blocks, (u32)(code_used / 1024));
+}
+
+void Jit64::LogTieringStats()
+{
+	if (!tier_threshold)
+		return;
+
+	NOTICE_LOG(DYNA_REC, "%s", tier_stats.Summary(tier_threshold, blocks.GetNumBlocks(), CODE_SIZE - GetSpaceLeft()).c_str());
+}
+
+// Compiles the profiled blocks whose code is in memory. The first call after
+// boot takes the whole profile; later misses pick up blocks on the same page,
+// which catches code loaded after boot (overlays, RELs) as it first runs.
+void Jit64::WarmFromProfile(u32 em_address)
+{
+	std::vector<u32> addresses;
+	block_profile.TakeWarmBlocks(em_address, block_profile_warmed, &addresses);
+	block_profile_warmed = true;
+
+	for (u32 address : addresses)
+	{
+		// Never let warming force a cache flush.
+		if (GetSpaceLeft() < 0x20000 || blocks.GetNumBlocks() >= blocks.GetMaxNumBlocks() / 2)
+			break;
+		if (address == em_address || blocks.GetBlockNumberFromStartAddress(address) != -1)
+			continue;
+
+		int block_num = blocks.AllocateBlock(address);
+		JitBlock *b = blocks.GetBlock(block_num);
+		blocks.FinalizeBlock(block_num, jo.enableBlocklink, DoJit(address, &code_buffer, b));
+	}
 }
 
 const u8* Jit64::DoJit(u32 em_address, PPCAnalyst::CodeBuffer *code_buf, JitBlock *b)
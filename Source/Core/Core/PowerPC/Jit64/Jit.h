@@ -35,6 +35,7 @@
 #include "Core/PowerPC/JitCommon/Jit_Util.h"
 #include "Core/PowerPC/JitCommon/JitBackpatch.h"
 #include "Core/PowerPC/JitCommon/JitBase.h"
+#include "Core/PowerPC/JitCommon/JitBlockProfile.h"
 #include "Core/PowerPC/JitCommon/JitCache.h"
 
 class Jit64 : public Jitx86Base
@@ -48,8 +49,43 @@ private:
 	PPCAnalyst::CodeBuffer code_buffer;
 	Jit64AsmRoutineManager asm_routines;
 
+	// Blocks compiled in earlier sessions of the running game.
+	JitBlockProfile block_profile;
+	std::string block_profile_filename;
+	bool block_profile_warmed;
+
+	void WarmFromProfile(u32 em_address);
+
+	// Tiered compilation: a block is run through the interpreter until it has
+	// been reached tier_threshold times, so code that only runs a few times
+	// never costs a compile or code space. Counters are indexed by a hash of
+	// the address; a collision only promotes a block early.
+	enum
+	{
+		TIER_COUNTERS_SIZE = 0x10000,
+	};
 public:
-	Jit64() : code_buffer(32000) {}
+	struct TieringStats
+	{
+		u64 blocks_interpreted;   // interpreter runs instead of a compiled block
+		u64 cold_blocks;          // times a counter started from zero
+		u64 blocks_compiled;
+		u64 compile_time_us;
+
+		// What LogTieringStats logs, with code_used bytes of the code cache in num_blocks blocks.
+		std::string Summary(u32 threshold, int num_blocks, size_t code_used) const;
+	};
+
+private:
+	std::vector<u16> tier_counters;
+	u32 tier_threshold;
+	TieringStats tier_stats;
+
+	bool InterpretColdBlock(u32 em_address);
+	void LogTieringStats();
+
+public:
+	Jit64() : code_buffer(32000), block_profile_warmed(false), tier_threshold(0) {}
 	~Jit64() {}
 
 	void Init() override;
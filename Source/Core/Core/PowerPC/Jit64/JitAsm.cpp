@@ -156,9 +156,20 @@ void Jit64AsmRoutineManager::Generate()
 			MOV(32, R(ABI_PARAM1), M(&PowerPC::ppcState.pc));
 			CALL((void *)&Jit);
 #endif
+			// With tiering, Jit may have interpreted a block instead, which
+			// spends downcount like compiled code would.
+			FixupBranch interpretedTiming;
+			bool tiered = Core::g_CoreStartupParameter.iJITTieringThreshold > 0;
+			if (tiered)
+			{
+				CMP(32, M(&CoreTiming::downcount), Imm8(0));
+				interpretedTiming = J_CC(CC_LE, true);
+			}
 			JMP(dispatcherNoCheck); // no point in special casing this
 
 		SetJumpTarget(bail);
+		if (tiered)
+			SetJumpTarget(interpretedTiming);
 		doTiming = GetCodePtr();
 
 		testExternalExceptions = GetCodePtr();
@@ -7,6 +7,7 @@
 
 #include "Common/Common.h"
 
+#include "Core/HW/WriteTracker.h"
 #include "Core/PowerPC/Jit64/Jit.h"
 #include "Core/PowerPC/Jit64/JitAsm.h"
 #include "Core/PowerPC/Jit64/JitRegCache.h"
@@ -311,8 +312,10 @@ void Jit64::stX(UGeckoInstruction inst)
 				gpr.UnlockAllX();
 				return;
 			}
-			else if (Memory::IsRAMAddress(addr))
+			else if (Memory::IsRAMAddress(addr) && !WriteTracker::IsEnabled())
 			{
+				// This stores through the physical mirror, which the write tracker
+				// doesn't protect, so with it on the store goes through Write_*.
 				MOV(32, R(EAX), gpr.R(s));
 				BSWAP(accessSize, EAX);
 				WriteToConstRamAddress(accessSize, R(EAX), addr);
@@ -0,0 +1,164 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <algorithm>
+
+#include "Core/PowerPC/JitCommon/JitBlockIndex.h"
+
+void JitBlockRangeIndex::Init()
+{
+	m_pages.resize(NUM_PAGES);
+	m_page_listed.assign(NUM_PAGES, false);
+	Clear();
+}
+
+void JitBlockRangeIndex::Shutdown()
+{
+	std::vector<std::vector<Entry>>().swap(m_pages);
+	std::vector<u32>().swap(m_used_pages);
+	std::vector<bool>().swap(m_page_listed);
+	m_num_entries = 0;
+}
+
+void JitBlockRangeIndex::Clear()
+{
+	for (u32 page : m_used_pages)
+	{
+		m_pages[page].clear();
+		m_page_listed[page] = false;
+	}
+	m_used_pages.clear();
+	m_num_entries = 0;
+}
+
+void JitBlockRangeIndex::Insert(u32 start, u32 end, int block_num)
+{
+	const u32 first_page = start >> PAGE_SHIFT;
+	const u32 last_page = std::min<u32>(end >> PAGE_SHIFT, NUM_PAGES - 1);
+	bool replaced = false;
+
+	for (u32 page = first_page; page <= last_page; ++page)
+	{
+		std::vector<Entry>& bucket = m_pages[page];
+		auto it = std::find_if(bucket.begin(), bucket.end(), [&](const Entry& e) {
+			return e.start == start && e.end == end;
+		});
+		if (it != bucket.end())
+		{
+			it->block_num = block_num;
+			replaced = true;
+			continue;
+		}
+
+		if (!m_page_listed[page])
+		{
+			m_page_listed[page] = true;
+			m_used_pages.push_back(page);
+		}
+		Entry e = { start, end, block_num };
+		bucket.push_back(e);
+	}
+
+	if (!replaced)
+		m_num_entries++;
+}
+
+void JitBlockRangeIndex::RemoveFromPage(u32 page, int block_num)
+{
+	std::vector<Entry>& bucket = m_pages[page];
+	for (size_t i = 0; i < bucket.size(); ++i)
+	{
+		if (bucket[i].block_num == block_num)
+		{
+			bucket[i] = bucket.back();
+			bucket.pop_back();
+			return;
+		}
+	}
+}
+
+void JitBlockRangeIndex::Extract(u32 start, u32 length, std::vector<int>* out)
+{
+	if (length == 0 || m_num_entries == 0)
+		return;
+
+	u32 last = start + length - 1;
+	if (last < start)
+		last = 0xFFFFFFFF;
+
+	const u32 first_page = start >> PAGE_SHIFT;
+	const u32 last_page = std::min<u32>(last >> PAGE_SHIFT, NUM_PAGES - 1);
+
+	for (u32 page = first_page; page <= last_page && m_num_entries != 0; ++page)
+	{
+		std::vector<Entry>& bucket = m_pages[page];
+		size_t i = 0;
+		while (i < bucket.size())
+		{
+			const Entry e = bucket[i];
+			if (e.start > last || e.end < start)
+			{
+				++i;
+				continue;
+			}
+
+			out->push_back(e.block_num);
+			bucket[i] = bucket.back();
+			bucket.pop_back();
+
+			// Drop the block from the other pages it spans so it is only reported once.
+			const u32 block_last_page = std::min<u32>(e.end >> PAGE_SHIFT, NUM_PAGES - 1);
+			for (u32 p = e.start >> PAGE_SHIFT; p <= block_last_page; ++p)
+			{
+				if (p != page)
+					RemoveFromPage(p, e.block_num);
+			}
+			m_num_entries--;
+		}
+	}
+}
+
+void JitBlockLinkIndex::Init()
+{
+	m_buckets.resize(NUM_BUCKETS);
+	m_bucket_listed.assign(NUM_BUCKETS, false);
+	Clear();
+}
+
+void JitBlockLinkIndex::Shutdown()
+{
+	std::vector<std::vector<Entry>>().swap(m_buckets);
+	std::vector<u32>().swap(m_used_buckets);
+	std::vector<bool>().swap(m_bucket_listed);
+}
+
+void JitBlockLinkIndex::Clear()
+{
+	for (u32 bucket : m_used_buckets)
+	{
+		m_buckets[bucket].clear();
+		m_bucket_listed[bucket] = false;
+	}
+	m_used_buckets.clear();
+}
+
+void JitBlockLinkIndex::Insert(u32 exit_address, int source_block)
+{
+	const u32 bucket = Bucket(exit_address);
+	if (!m_bucket_listed[bucket])
+	{
+		m_bucket_listed[bucket] = true;
+		m_used_buckets.push_back(bucket);
+	}
+	Entry e = { exit_address, source_block };
+	m_buckets[bucket].push_back(e);
+}
+
+void JitBlockLinkIndex::Erase(u32 exit_address)
+{
+	std::vector<Entry>& bucket = m_buckets[Bucket(exit_address)];
+	bucket.erase(std::remove_if(bucket.begin(), bucket.end(), [&](const Entry& e) {
+		return e.exit_address == exit_address;
+	}), bucket.end());
+}
@@ -0,0 +1,106 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <vector>
+
+#include "Common/CommonTypes.h"
+
+// Flat lookup structures used by JitBaseBlockCache to find blocks by the
+// memory they were compiled from, and to find the blocks that jump to a given
+// address. Both are arrays of small contiguous buckets, so icbi, linking and
+// block destruction only touch a few cache lines instead of walking a tree
+// over every compiled block.
+
+// Maps physical address ranges to block numbers. Every block is registered in
+// each page its code spans; an invalidation only scans the pages it covers.
+class JitBlockRangeIndex
+{
+public:
+	enum
+	{
+		PAGE_SHIFT = 12,
+		NUM_PAGES = 0x20000000 >> PAGE_SHIFT,
+	};
+
+	JitBlockRangeIndex() : m_num_entries(0) {}
+
+	void Init();
+	void Shutdown();
+	void Clear();
+
+	// start and end are inclusive physical addresses. A block registered with
+	// the same range as an existing one replaces it.
+	void Insert(u32 start, u32 end, int block_num);
+
+	// Removes every block intersecting [start, start + length) from the index
+	// and appends their numbers to out. Each block is reported once.
+	void Extract(u32 start, u32 length, std::vector<int>* out);
+
+	bool IsEmpty() const { return m_num_entries == 0; }
+
+private:
+	struct Entry
+	{
+		u32 start;
+		u32 end;
+		int block_num;
+	};
+
+	void RemoveFromPage(u32 page, int block_num);
+
+	std::vector<std::vector<Entry>> m_pages;
+	// Pages that received an entry since the last Clear(), so clearing
+	// doesn't have to visit the whole address space.
+	std::vector<u32> m_used_pages;
+	std::vector<bool> m_page_listed;
+	u32 m_num_entries;
+};
+
+// Reverse link lookup: exit address -> blocks that have an exit to it.
+// Addresses are hashed into a fixed number of buckets, each a flat array.
+class JitBlockLinkIndex
+{
+public:
+	enum
+	{
+		NUM_BUCKETS_SHIFT = 16,
+		NUM_BUCKETS = 1 << NUM_BUCKETS_SHIFT,
+	};
+
+	void Init();
+	void Shutdown();
+	void Clear();
+
+	void Insert(u32 exit_address, int source_block);
+	void Erase(u32 exit_address);
+
+	template <typename Func>
+	void ForEachSource(u32 exit_address, Func func) const
+	{
+		for (const Entry& e : m_buckets[Bucket(exit_address)])
+		{
+			if (e.exit_address == exit_address)
+				func(e.source_block);
+		}
+	}
+
+private:
+	struct Entry
+	{
+		u32 exit_address;
+		int source_block;
+	};
+
+	static u32 Bucket(u32 address)
+	{
+		// Fibonacci hashing; the low two bits of an instruction address are always zero.
+		return ((address >> 2) * 0x9E3779B1) >> (32 - NUM_BUCKETS_SHIFT);
+	}
+
+	std::vector<std::vector<Entry>> m_buckets;
+	std::vector<u32> m_used_buckets;
+	std::vector<bool> m_bucket_listed;
+};
@@ -0,0 +1,195 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <algorithm>
+
+#include "Common/Common.h"
+#include "Common/FileUtil.h"
+#include "Common/Hash.h"
+#include "Core/HW/Memmap.h"
+#include "Core/PowerPC/JitCommon/JitBlockProfile.h"
+
+// On disk format:
+// header{
+//  u32 'JBPF';
+//  u32 version;
+//  u32 sizeof(ProfileEntry);
+//  u32 num_entries;
+// }
+// ProfileEntry entries[num_entries];
+
+static const u32 PROFILE_MAGIC = 0x4650424A; // "JBPF"
+static const u32 PROFILE_VERSION = 1;
+
+struct ProfileHeader
+{
+	u32 magic;
+	u32 version;
+	u32 entry_size;
+	u32 num_entries;
+};
+
+// Entry has tail padding, so it isn't written out as is.
+struct ProfileEntry
+{
+	u32 address;
+	u32 num_instructions;
+	u64 code_hash;
+	u32 compile_count;
+	u32 reserved;
+};
+static_assert(sizeof(ProfileEntry) == 24, "ProfileEntry must not have padding");
+
+std::string JitBlockProfile::GetFilename(const std::string& game_id)
+{
+	return File::GetUserPath(D_CACHE_IDX) + game_id + ".jitprofile";
+}
+
+bool JitBlockProfile::Load(const std::string& filename)
+{
+	Clear();
+
+	File::IOFile f(filename, "rb");
+	ProfileHeader header;
+	if (!f.ReadArray(&header, 1) || header.magic != PROFILE_MAGIC ||
+	    header.version != PROFILE_VERSION || header.entry_size != sizeof(ProfileEntry) ||
+	    header.num_entries > MAX_ENTRIES)
+	{
+		return false;
+	}
+
+	std::vector<ProfileEntry> entries(header.num_entries);
+	if (header.num_entries && !f.ReadArray(&entries[0], entries.size()))
+		return false;
+
+	for (const ProfileEntry& p : entries)
+	{
+		if (p.num_instructions == 0)
+			continue;
+		Entry e = { p.address, p.num_instructions, p.code_hash, p.compile_count };
+		m_entries[e.address] = e;
+		m_pending[Page(e.address)].push_back(e);
+		m_num_pending++;
+	}
+
+	INFO_LOG(DYNA_REC, "Loaded %u blocks from JIT profile %s", m_num_pending, filename.c_str());
+	return true;
+}
+
+bool JitBlockProfile::Save(const std::string& filename) const
+{
+	std::vector<Entry> entries;
+	entries.reserve(m_entries.size());
+	for (const auto& e : m_entries)
+		entries.push_back(e.second);
+
+	std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+		return a.compile_count != b.compile_count ? a.compile_count > b.compile_count : a.address < b.address;
+	});
+	if (entries.size() > MAX_ENTRIES)
+		entries.resize(MAX_ENTRIES);
+
+	std::vector<ProfileEntry> out(entries.size());
+	for (size_t i = 0; i < entries.size(); ++i)
+	{
+		const Entry& e = entries[i];
+		ProfileEntry p = { e.address, e.num_instructions, e.code_hash, e.compile_count, 0 };
+		out[i] = p;
+	}
+
+	File::IOFile f(filename, "wb");
+	ProfileHeader header = { PROFILE_MAGIC, PROFILE_VERSION, sizeof(ProfileEntry), (u32)out.size() };
+	if (!f.WriteArray(&header, 1) ||
+	    (!out.empty() && !f.WriteArray(&out[0], out.size())))
+	{
+		ERROR_LOG(DYNA_REC, "Failed to write JIT profile %s", filename.c_str());
+		return false;
+	}
+	return true;
+}
+
+void JitBlockProfile::Clear()
+{
+	m_entries.clear();
+	m_pending.clear();
+	m_num_pending = 0;
+}
+
+void JitBlockProfile::RecordBlock(u32 address, u32 num_instructions)
+{
+	u64 hash = HashCode(address, num_instructions);
+	if (hash == 0)
+		return;
+
+	auto it = m_entries.find(address);
+	if (it != m_entries.end() && it->second.code_hash == hash &&
+	    it->second.num_instructions == num_instructions)
+	{
+		it->second.compile_count++;
+		return;
+	}
+
+	Entry e = { address, num_instructions, hash, 1 };
+	m_entries[address] = e;
+}
+
+void JitBlockProfile::TakeWarmBlocks(u32 address, bool page_only, std::vector<u32>* out)
+{
+	if (m_num_pending == 0)
+		return;
+
+	std::vector<Entry> taken;
+	auto take_from_page = [&](std::vector<Entry>& entries) {
+		auto keep = std::remove_if(entries.begin(), entries.end(), [&](const Entry& e) {
+			// Code that doesn't match stays pending: it may be loaded later.
+			if (HashCode(e.address, e.num_instructions) != e.code_hash)
+				return false;
+			taken.push_back(e);
+			return true;
+		});
+		m_num_pending -= (u32)(entries.end() - keep);
+		entries.erase(keep, entries.end());
+	};
+
+	if (page_only)
+	{
+		auto it = m_pending.find(Page(address));
+		if (it != m_pending.end())
+			take_from_page(it->second);
+	}
+	else
+	{
+		for (auto& page : m_pending)
+			take_from_page(page.second);
+	}
+
+	std::stable_sort(taken.begin(), taken.end(), [](const Entry& a, const Entry& b) {
+		return a.compile_count > b.compile_count;
+	});
+	for (const Entry& e : taken)
+		out->push_back(e.address);
+}
+
+u64 JitBlockProfile::HashCode(u32 address, u32 num_instructions)
+{
+	// Blocks that follow branches aren't contiguous in memory, so this may
+	// cover code that isn't part of the block. That can only cause a spurious
+	// mismatch, never compiling code that differs from what was profiled:
+	// the block is always compiled from what is in memory right now.
+	u32 end = address + num_instructions * 4 - 1;
+	if (num_instructions == 0 || end < address ||
+	    !Memory::IsRAMAddress(address, false, true) || !Memory::IsRAMAddress(end, false, true))
+	{
+		return 0;
+	}
+
+	const u8* ptr = Memory::GetPointer(address);
+	if (!ptr || Memory::GetPointer(end) != ptr + num_instructions * 4 - 1)
+		return 0;
+
+	// Not GetHash64: its implementation depends on the host CPU, and a profile
+	// should stay valid when copied to another machine.
+	u64 hash = GetMurmurHash3(ptr, num_instructions * 4, 0);
+	return hash ? hash : 1;
+}
@@ -0,0 +1,71 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+
+// Per-game record of the blocks the JIT compiled during a session, used to
+// compile them ahead of time on the next boot instead of one by one as the
+// game first reaches them.
+//
+// Every entry carries a hash of the PowerPC code it was compiled from. An
+// entry is only used when the code currently in memory hashes the same, so a
+// profile taken from a different revision of the game, or code that has not
+// been loaded yet, is never compiled.
+class JitBlockProfile
+{
+public:
+	struct Entry
+	{
+		u32 address;
+		u32 num_instructions;
+		u64 code_hash;
+		// Number of times the block was compiled, over all sessions; blocks
+		// that keep getting compiled again are the ones worth warming first.
+		u32 compile_count;
+	};
+
+	enum
+	{
+		// Keep the profile file bounded; the coldest entries are dropped first.
+		MAX_ENTRIES = 32768,
+	};
+
+	JitBlockProfile() : m_num_pending(0) {}
+
+	static std::string GetFilename(const std::string& game_id);
+
+	bool Load(const std::string& filename);
+	bool Save(const std::string& filename) const;
+	void Clear();
+
+	// Called whenever a block has been compiled.
+	void RecordBlock(u32 address, u32 num_instructions);
+
+	// Appends the addresses of profiled blocks that have not been compiled yet
+	// in this session and whose code in memory still matches the profile,
+	// hottest first. With page_only set, only blocks in the same 4 KiB page as
+	// address are considered. Returned blocks are not returned again.
+	void TakeWarmBlocks(u32 address, bool page_only, std::vector<u32>* out);
+
+	bool HasPendingBlocks() const { return m_num_pending != 0; }
+
+	// Hash of num_instructions instructions at address, or 0 if the range is
+	// not backed by RAM.
+	static u64 HashCode(u32 address, u32 num_instructions);
+
+private:
+	static u32 Page(u32 address) { return address >> 12; }
+
+	// Everything known about the game's blocks, from disk and this session.
+	std::unordered_map<u32, Entry> m_entries;
+	// Loaded entries that have not been compiled yet, by page.
+	std::unordered_map<u32, std::vector<Entry>> m_pending;
+	u32 m_num_pending;
+};
@@ -46,6 +46,8 @@ using namespace Gen;
 #endif
 		blocks = new JitBlock[MAX_NUM_BLOCKS];
 		blockCodePointers = new const u8*[MAX_NUM_BLOCKS];
+		links_to.Init();
+		block_map.Init();
 		if (iCache == nullptr && iCacheEx == nullptr && iCacheVMEM == nullptr)
 		{
 			iCache = new u8[JIT_ICACHE_SIZE];
@@ -70,6 +72,8 @@ using namespace Gen;
 	{
 		delete[] blocks;
 		delete[] blockCodePointers;
+		links_to.Shutdown();
+		block_map.Shutdown();
 		if (iCache != nullptr)
 			delete[] iCache;
 		iCache = nullptr;
@@ -106,8 +110,8 @@ using namespace Gen;
 		{
 			DestroyBlock(i, false);
 		}
-		links_to.clear();
-		block_map.clear();
+		links_to.Clear();
+		block_map.Clear();
 		valid_block.reset();
 		num_blocks = 0;
 		memset(blockCodePointers, 0, sizeof(u8*)*MAX_NUM_BLOCKS);
@@ -182,12 +186,12 @@ using namespace Gen;
 		for (u32 i = 0; i < (b.originalSize + 7) / 8; ++i)
 			valid_block[pAddr / 32 + i] = true;
 
-		block_map[std::make_pair(pAddr + 4 * b.originalSize - 1, pAddr)] = block_num;
+		block_map.Insert(pAddr, pAddr + 4 * b.originalSize - 1, block_num);
 		if (block_link)
 		{
 			for (const auto& e : b.linkData)
 			{
-				links_to.insert(std::pair<u32, int>(e.exitAddress, block_num));
+				links_to.Insert(e.exitAddress, block_num);
 			}
 
 			LinkBlock(block_num);
@@ -280,40 +284,28 @@ using namespace Gen;
 		}
 	}
 
-	using namespace std;
-
 	void JitBaseBlockCache::LinkBlock(int i)
 	{
 		LinkBlockExits(i);
 		JitBlock &b = blocks[i];
-		pair<multimap<u32, int>::iterator, multimap<u32, int>::iterator> ppp;
-		// equal_range(b) returns pair<iterator,iterator> representing the range
-		// of element with key b
-		ppp = links_to.equal_range(b.originalAddress);
-		if (ppp.first == ppp.second)
-			return;
-		for (multimap<u32, int>::iterator iter = ppp.first; iter != ppp.second; ++iter) {
-			// PanicAlert("Linking block %i to block %i", iter->second, i);
-			LinkBlockExits(iter->second);
-		}
+		links_to.ForEachSource(b.originalAddress, [this](int source) {
+			// PanicAlert("Linking block %i to block %i", source, i);
+			LinkBlockExits(source);
+		});
 	}
 
 	void JitBaseBlockCache::UnlinkBlock(int i)
 	{
 		JitBlock &b = blocks[i];
-		pair<multimap<u32, int>::iterator, multimap<u32, int>::iterator> ppp;
-		ppp = links_to.equal_range(b.originalAddress);
-		if (ppp.first == ppp.second)
-			return;
-		for (multimap<u32, int>::iterator iter = ppp.first; iter != ppp.second; ++iter) {
-			JitBlock &sourceBlock = blocks[iter->second];
+		links_to.ForEachSource(b.originalAddress, [this, &b](int source) {
+			JitBlock &sourceBlock = blocks[source];
 			for (auto& e : sourceBlock.linkData)
 			{
 				if (e.exitAddress == b.originalAddress)
 					e.linkStatus = false;
 			}
-		}
-		links_to.erase(b.originalAddress);
+		});
+		links_to.Erase(b.originalAddress);
 	}
 
 	void JitBaseBlockCache::DestroyBlock(int block_num, bool invalidate)
@@ -357,20 +349,15 @@ using namespace Gen;
 		}
 
 		// destroy JIT blocks
-		// !! this works correctly under assumption that any two overlapping blocks end at the same address
 		if (destroy_block)
 		{
-			std::map<pair<u32,u32>, u32>::iterator it1 = block_map.lower_bound(std::make_pair(pAddr, 0)), it2 = it1;
-			while (it2 != block_map.end() && it2->first.second < pAddr + length)
-		{
-				JitBlock &b = blocks[it2->second];
-				*GetICachePtr(b.originalAddress) = JIT_ICACHE_INVALID_WORD;
-				DestroyBlock(it2->second, true);
-				++it2;
-			}
-			if (it1 != it2)
+			invalidated_blocks.clear();
+			block_map.Extract(pAddr, length, &invalidated_blocks);
+			for (int block_num : invalidated_blocks)
 			{
-				block_map.erase(it1, it2);
+				JitBlock &b = blocks[block_num];
+				*GetICachePtr(b.originalAddress) = JIT_ICACHE_INVALID_WORD;
+				DestroyBlock(block_num, true);
 			}
 		}
 
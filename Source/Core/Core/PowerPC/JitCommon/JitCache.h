@@ -5,10 +5,10 @@
 #pragma once
 
 #include <bitset>
-#include <map>
 #include <vector>
 
 #include "Core/PowerPC/Gekko.h"
+#include "Core/PowerPC/JitCommon/JitBlockIndex.h"
 #include "Core/PowerPC/PPCAnalyst.h"
 
 // Define this in order to get VTune profile support for the Jit generated code.
@@ -70,8 +70,9 @@ class JitBaseBlockCache
 	const u8 **blockCodePointers;
 	JitBlock *blocks;
 	int num_blocks;
-	std::multimap<u32, int> links_to;
-	std::map<std::pair<u32,u32>, u32> block_map; // (end_addr, start_addr) -> number
+	JitBlockLinkIndex links_to;   // exit address -> source blocks
+	JitBlockRangeIndex block_map; // physical code range -> block number
+	std::vector<int> invalidated_blocks; // scratch space for InvalidateICache
 	std::bitset<0x20000000 / 32> valid_block;
 	enum
 	{
@@ -101,6 +102,7 @@ public:
 	void Reset();
 
 	bool IsFull() const;
+	int GetMaxNumBlocks() const { return MAX_NUM_BLOCKS; }
 
 	// Code Cache
 	JitBlock *GetBlock(int block_num);
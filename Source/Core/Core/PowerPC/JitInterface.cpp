@@ -12,6 +12,7 @@
 
 #include "Core/ConfigManager.h"
 #include "Core/HW/Memmap.h"
+#include "Core/PowerPC/CachedInterpreter.h"
 #include "Core/PowerPC/JitInterface.h"
 #include "Core/PowerPC/PPCSymbolDB.h"
 #include "Core/PowerPC/Profiler.h"
@@ -73,6 +74,11 @@ namespace JitInterface
 				break;
 			}
 			#endif
+			case 5:
+			{
+				ptr = new CachedInterpreter();
+				break;
+			}
 			default:
 			{
 				PanicAlert("Unrecognizable cpu_core: %d", core);
@@ -112,6 +118,11 @@ namespace JitInterface
 				break;
 			}
 			#endif
+			case 5:
+			{
+				// Uses the interpreter tables, which are always set up.
+				break;
+			}
 			default:
 			{
 				PanicAlert("Unrecognizable cpu_core: %d", core);
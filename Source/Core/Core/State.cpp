@@ -2,9 +2,15 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include <atomic>
+#include <deque>
+#include <memory>
 #include <lzo/lzo1x.h>
+#include <zlib.h>
 
 #include "Common/Common.h"
+#include "Common/Hash.h"
+#include "Common/ParallelFor.h"
 #include "Common/StringUtil.h"
 #include "Common/Thread.h"
 #include "Common/Timer.h"
@@ -38,12 +44,85 @@ static const u32 IN_LEN = 128 * 1024u;
 
 static const u32 OUT_LEN = IN_LEN + (IN_LEN / 16) + 64 + 3;
 
-static unsigned char __LZO_MMODEL out[OUT_LEN];
+// Compressed states are split into chunks of this many bytes, each
+// compressed on its own so that saving and loading can use every core.
+static const u32 CHUNK_SIZE = 1024 * 1024;
 
-#define HEAP_ALLOC(var, size) \
-	lzo_align_t __LZO_MMODEL var[((size) + (sizeof(lzo_align_t) - 1)) / sizeof(lzo_align_t)]
+// Compressed states start with a ChunkedStateHeader after the StateHeader.
+// Older compressed states start with the size of their first LZO block there,
+// which is never larger than OUT_LEN, so they can still be told apart and loaded.
+static const u32 CHUNKED_STATE_MAGIC = 0x4B484353; // "SCHK"
 
-static HEAP_ALLOC(wrkmem, LZO1X_1_MEM_COMPRESS);
+struct ChunkedStateHeader
+{
+	u32 magic;
+	u32 compression;
+	u32 chunk_size;
+	u32 num_chunks;
+	// Followed by u32 compressed_size[num_chunks], then the chunks themselves.
+	// Chunk i decompresses to chunk_size bytes (less for the last one) at
+	// offset i * chunk_size of the state, so every chunk can be decompressed
+	// independently, straight into the buffer DoState reads from.
+};
+
+struct StateCodec
+{
+	const char* name;
+	// Size of the per-thread scratch space compress needs.
+	size_t work_size;
+	size_t (*max_compressed_size)(size_t size);
+	// *dst_size holds the space available at dst on entry.
+	bool (*compress)(const u8* src, size_t size, u8* dst, size_t* dst_size, void* work);
+	// Fails unless src decompresses to exactly dst_size bytes.
+	bool (*decompress)(const u8* src, size_t size, u8* dst, size_t dst_size);
+};
+
+static size_t LZOMaxCompressedSize(size_t size)
+{
+	return size + (size / 16) + 64 + 3;
+}
+
+static bool LZOCompress(const u8* src, size_t size, u8* dst, size_t* dst_size, void* work)
+{
+	lzo_uint out_len = 0;
+	if (lzo1x_1_compress(src, (lzo_uint)size, dst, &out_len, work) != LZO_E_OK)
+		return false;
+	*dst_size = out_len;
+	return true;
+}
+
+static bool LZODecompress(const u8* src, size_t size, u8* dst, size_t dst_size)
+{
+	lzo_uint out_len = (lzo_uint)dst_size;
+	return lzo1x_decompress_safe(src, (lzo_uint)size, dst, &out_len, nullptr) == LZO_E_OK &&
+	       out_len == dst_size;
+}
+
+static size_t ZlibMaxCompressedSize(size_t size)
+{
+	return compressBound((uLong)size);
+}
+
+static bool ZlibCompress(const u8* src, size_t size, u8* dst, size_t* dst_size, void* work)
+{
+	uLongf out_len = (uLongf)*dst_size;
+	if (compress2(dst, &out_len, src, (uLong)size, Z_BEST_SPEED) != Z_OK)
+		return false;
+	*dst_size = out_len;
+	return true;
+}
+
+static bool ZlibDecompress(const u8* src, size_t size, u8* dst, size_t dst_size)
+{
+	uLongf out_len = (uLongf)dst_size;
+	return uncompress(dst, &out_len, src, (uLong)size) == Z_OK && out_len == dst_size;
+}
+
+// Indexed by StateCompression.
+static const StateCodec s_codecs[NUM_STATE_COMPRESSIONS] = {
+	{ "LZO", LZO1X_1_MEM_COMPRESS, LZOMaxCompressedSize, LZOCompress, LZODecompress },
+	{ "zlib", 0, ZlibMaxCompressedSize, ZlibCompress, ZlibDecompress },
+};
 
 static std::string g_last_filename;
 
@@ -60,8 +139,54 @@ static Common::Event g_compressAndDumpStateSyncEvent;
 
 static std::thread g_save_thread;
 
+// Rewind states are kept in memory as the pages of the serialized state that
+// differ from a full keyframe state. Nearly all of a state is MEM1, MEM2 and
+// ARAM, which sit at the same offsets from one state to the next, so most
+// pages hash the same as in the keyframe.
+static const u32 REWIND_PAGE_SIZE = 4096;
+// Oldest states are dropped beyond this.
+static const u32 MAX_REWIND_STATES = 64;
+// Take a new keyframe once this many deltas refer to the current one, or as
+// soon as a delta would hold more than 1/REWIND_MAX_DELTA_FRACTION of the state.
+static const u32 REWIND_KEYFRAME_INTERVAL = 16;
+static const u32 REWIND_MAX_DELTA_FRACTION = 4;
+
+struct RewindKeyframe
+{
+	std::vector<u8> data;
+	std::vector<u64> page_hashes;
+	u32 num_deltas;
+};
+
+struct RewindState
+{
+	std::shared_ptr<RewindKeyframe> keyframe;
+	// Pages that differ from the keyframe, and their contents back to back.
+	// The last page of the state may be shorter than REWIND_PAGE_SIZE.
+	std::vector<u32> pages;
+	std::vector<u8> data;
+};
+
+static std::deque<RewindState> g_rewind_states;
+static std::mutex g_cs_rewind;
+
+// States are serialized into this, so deltas don't need a new buffer each time.
+// Pending is set while it holds a state that hasn't been pushed yet.
+static std::vector<u8> g_rewind_buffer;
+static bool g_rewind_pending = false;
+static std::mutex g_cs_rewind_buffer;
+
+// Every iRewindInterval frames, a CoreTiming event serializes the state on
+// the CPU thread, where the core is stopped anyway, and wakes up the rewind
+// thread to work out the delta.
+static int g_rewind_event_type;
+static std::thread g_rewind_thread;
+static Common::Event g_rewind_event;
+static std::atomic<bool> g_rewind_thread_running(false);
+static u32 g_rewind_frame_counter = 0;
+
 // Don't forget to increase this after doing changes on the savestate system
-static const u32 STATE_VERSION = 22;
+static const u32 STATE_VERSION = 24;
 
 enum
 {
@@ -127,10 +252,9 @@ void LoadFromBuffer(std::vector<u8>& buffer)
 	Core::PauseAndLock(false, wasUnpaused);
 }
 
-void SaveToBuffer(std::vector<u8>& buffer)
+// Everything must be paused.
+static void SaveToBufferLocked(std::vector<u8>& buffer)
 {
-	bool wasUnpaused = Core::PauseAndLock(true);
-
 	u8* ptr = nullptr;
 	PointerWrap p(&ptr, PointerWrap::MODE_MEASURE);
 
@@ -141,7 +265,12 @@ void SaveToBuffer(std::vector<u8>& buffer)
 	ptr = &buffer[0];
 	p.SetMode(PointerWrap::MODE_WRITE);
 	DoState(p);
+}
 
+void SaveToBuffer(std::vector<u8>& buffer)
+{
+	bool wasUnpaused = Core::PauseAndLock(true);
+	SaveToBufferLocked(buffer);
 	Core::PauseAndLock(false, wasUnpaused);
 }
 
@@ -156,6 +285,193 @@ void VerifyBuffer(std::vector<u8>& buffer)
 	Core::PauseAndLock(false, wasUnpaused);
 }
 
+static void HashRewindPages(const std::vector<u8>& buffer, std::vector<u64>* hashes)
+{
+	const u32 num_pages = (u32)((buffer.size() + REWIND_PAGE_SIZE - 1) / REWIND_PAGE_SIZE);
+	hashes->resize(num_pages);
+
+	// Hand out pages in batches; one page is far too little work per call.
+	static const u32 PAGES_PER_BATCH = 256;
+	const u32 num_batches = (num_pages + PAGES_PER_BATCH - 1) / PAGES_PER_BATCH;
+	Common::ParallelFor(num_batches, Common::GetNumWorkerThreads(), [&](u32 batch, u32 worker) {
+		const u32 end = std::min(num_pages, (batch + 1) * PAGES_PER_BATCH);
+		for (u32 page = batch * PAGES_PER_BATCH; page < end; ++page)
+		{
+			const size_t offset = (size_t)page * REWIND_PAGE_SIZE;
+			const int len = (int)std::min<size_t>(REWIND_PAGE_SIZE, buffer.size() - offset);
+			(*hashes)[page] = GetMurmurHash3(&buffer[offset], len, 0);
+		}
+	});
+}
+
+void PushRewindState(std::vector<u8>& buffer)
+{
+	if (buffer.empty())
+		return;
+
+	std::vector<u64> hashes;
+	HashRewindPages(buffer, &hashes);
+
+	std::lock_guard<std::mutex> lk(g_cs_rewind);
+
+	RewindState state;
+	std::shared_ptr<RewindKeyframe> keyframe;
+	if (!g_rewind_states.empty())
+		keyframe = g_rewind_states.back().keyframe;
+
+	// A different size means the layout moved, and every later page with it.
+	bool new_keyframe = !keyframe || keyframe->data.size() != buffer.size() ||
+	                    keyframe->num_deltas >= REWIND_KEYFRAME_INTERVAL;
+	if (!new_keyframe)
+	{
+		const size_t max_delta = buffer.size() / REWIND_MAX_DELTA_FRACTION;
+		for (u32 page = 0; page < (u32)hashes.size(); ++page)
+		{
+			const size_t offset = (size_t)page * REWIND_PAGE_SIZE;
+			const size_t len = std::min<size_t>(REWIND_PAGE_SIZE, buffer.size() - offset);
+
+			// Equal hashes only say the page is very likely unchanged.
+			if (hashes[page] == keyframe->page_hashes[page] &&
+			    memcmp(&buffer[offset], &keyframe->data[offset], len) == 0)
+				continue;
+
+			if (state.data.size() + len > max_delta)
+			{
+				new_keyframe = true;
+				break;
+			}
+			state.pages.push_back(page);
+			state.data.insert(state.data.end(), &buffer[offset], &buffer[offset] + len);
+		}
+	}
+
+	if (new_keyframe)
+	{
+		keyframe = std::make_shared<RewindKeyframe>();
+		keyframe->data.swap(buffer);
+		keyframe->page_hashes.swap(hashes);
+		keyframe->num_deltas = 0;
+		state.pages.clear();
+		state.data.clear();
+	}
+	else
+	{
+		keyframe->num_deltas++;
+	}
+
+	state.keyframe = keyframe;
+	g_rewind_states.push_back(std::move(state));
+	if (g_rewind_states.size() > MAX_REWIND_STATES)
+		g_rewind_states.pop_front();
+}
+
+bool PopRewindState(std::vector<u8>& buffer)
+{
+	std::lock_guard<std::mutex> lk(g_cs_rewind);
+	if (g_rewind_states.empty())
+		return false;
+
+	const RewindState& state = g_rewind_states.back();
+	buffer = state.keyframe->data;
+
+	const u8* src = state.data.empty() ? nullptr : &state.data[0];
+	for (u32 page : state.pages)
+	{
+		const size_t offset = (size_t)page * REWIND_PAGE_SIZE;
+		const size_t len = std::min<size_t>(REWIND_PAGE_SIZE, buffer.size() - offset);
+		memcpy(&buffer[offset], src, len);
+		src += len;
+	}
+	g_rewind_states.pop_back();
+	return true;
+}
+
+// Needs g_cs_rewind_buffer.
+static void PushPendingRewindState()
+{
+	if (g_rewind_pending)
+	{
+		PushRewindState(g_rewind_buffer);
+		g_rewind_pending = false;
+	}
+}
+
+void SaveRewindState()
+{
+	std::lock_guard<std::mutex> lk(g_cs_rewind_buffer);
+	PushPendingRewindState();
+	SaveToBuffer(g_rewind_buffer);
+	PushRewindState(g_rewind_buffer);
+}
+
+bool LoadRewindState()
+{
+	{
+		std::lock_guard<std::mutex> lk(g_cs_rewind_buffer);
+		PushPendingRewindState();
+	}
+
+	std::vector<u8> buffer;
+	if (!PopRewindState(buffer))
+		return false;
+
+	LoadFromBuffer(buffer);
+	return true;
+}
+
+void ClearRewindStates()
+{
+	std::lock_guard<std::mutex> lk(g_cs_rewind);
+	g_rewind_states.clear();
+}
+
+static void RewindCallback(u64 userdata, int cyclesLate)
+{
+	// Rather than hold up the CPU while the last state is still being
+	// pushed, or while the host is saving one, skip this one. Host threads
+	// hold the lock while they wait for the CPU thread to pause.
+	std::unique_lock<std::mutex> lk(g_cs_rewind_buffer, std::try_to_lock);
+	if (!lk.owns_lock() || g_rewind_pending)
+		return;
+
+	Core::PauseAndLockFromCPUThread(true);
+	SaveToBufferLocked(g_rewind_buffer);
+	Core::PauseAndLockFromCPUThread(false);
+
+	g_rewind_pending = true;
+	lk.unlock();
+	g_rewind_event.Set();
+}
+
+static void RewindThreadFunc()
+{
+	Common::SetCurrentThreadName("Rewind thread");
+
+	while (true)
+	{
+		g_rewind_event.Wait();
+		if (!g_rewind_thread_running.load())
+			break;
+
+		std::lock_guard<std::mutex> lk(g_cs_rewind_buffer);
+		PushPendingRewindState();
+	}
+}
+
+void FrameUpdate()
+{
+	const int interval = SConfig::GetInstance().m_LocalCoreStartupParameter.iRewindInterval;
+	if (interval <= 0 || !g_rewind_thread_running.load())
+		return;
+
+	// This runs on the GPU thread in dual core mode.
+	if (++g_rewind_frame_counter >= (u32)interval)
+	{
+		g_rewind_frame_counter = 0;
+		CoreTiming::ScheduleEvent_Threadsafe(0, g_rewind_event_type);
+	}
+}
+
 // return state number not in map
 int GetEmptySlot(std::map<double, int> m)
 {
@@ -199,6 +515,104 @@ std::map<double, int> GetSavedStates()
 	return m;
 }
 
+static u32 GetNumChunks(size_t size, u32 chunk_size)
+{
+	return (u32)((size + chunk_size - 1) / chunk_size);
+}
+
+static bool WriteChunkedState(File::IOFile& f, const u8* data, size_t size, u32 compression)
+{
+	const StateCodec& codec = s_codecs[compression];
+	const u32 num_chunks = GetNumChunks(size, CHUNK_SIZE);
+	const u32 num_workers = Common::GetNumWorkerThreads();
+
+	std::vector<std::vector<u8>> chunks(num_chunks);
+	std::vector<std::vector<u64>> work(std::min(num_chunks, num_workers));
+	std::atomic<bool> failed(false);
+
+	Common::ParallelFor(num_chunks, num_workers, [&](u32 i, u32 worker) {
+		const size_t offset = (size_t)i * CHUNK_SIZE;
+		const size_t len = std::min<size_t>(CHUNK_SIZE, size - offset);
+
+		std::vector<u64>& scratch = work[worker];
+		if (scratch.size() * sizeof(u64) < codec.work_size)
+			scratch.resize((codec.work_size + sizeof(u64) - 1) / sizeof(u64));
+
+		std::vector<u8>& chunk = chunks[i];
+		chunk.resize(codec.max_compressed_size(len));
+		size_t out_len = chunk.size();
+		if (!codec.compress(data + offset, len, &chunk[0], &out_len, scratch.empty() ? nullptr : &scratch[0]))
+			failed = true;
+		chunk.resize(out_len);
+	});
+
+	if (failed)
+	{
+		PanicAlertT("Internal %s Error - compression failed", codec.name);
+		return false;
+	}
+
+	ChunkedStateHeader chunked_header = { CHUNKED_STATE_MAGIC, compression, CHUNK_SIZE, num_chunks };
+	std::vector<u32> chunk_sizes(num_chunks);
+	for (u32 i = 0; i < num_chunks; ++i)
+		chunk_sizes[i] = (u32)chunks[i].size();
+
+	bool ok = f.WriteArray(&chunked_header, 1);
+	ok = ok && (num_chunks == 0 || f.WriteArray(&chunk_sizes[0], num_chunks));
+	for (u32 i = 0; ok && i < num_chunks; ++i)
+		ok = chunks[i].empty() || f.WriteBytes(&chunks[i][0], chunks[i].size());
+	return ok;
+}
+
+// Reads the chunks of a state written by WriteChunkedState into buffer,
+// which is already size bytes long.
+static bool ReadChunkedState(File::IOFile& f, std::vector<u8>& buffer)
+{
+	const size_t size = buffer.size();
+
+	ChunkedStateHeader chunked_header;
+	if (!f.ReadArray(&chunked_header, 1) || chunked_header.magic != CHUNKED_STATE_MAGIC ||
+	    chunked_header.compression >= NUM_STATE_COMPRESSIONS || chunked_header.chunk_size == 0 ||
+	    chunked_header.num_chunks != GetNumChunks(size, chunked_header.chunk_size))
+	{
+		PanicAlertT("Invalid state file header");
+		return false;
+	}
+
+	const StateCodec& codec = s_codecs[chunked_header.compression];
+	const u32 num_chunks = chunked_header.num_chunks;
+	const u32 chunk_size = chunked_header.chunk_size;
+
+	std::vector<u32> chunk_sizes(num_chunks);
+	std::vector<u64> chunk_offsets(num_chunks + 1, 0);
+	if (num_chunks && !f.ReadArray(&chunk_sizes[0], num_chunks))
+		return false;
+	for (u32 i = 0; i < num_chunks; ++i)
+		chunk_offsets[i + 1] = chunk_offsets[i] + chunk_sizes[i];
+
+	std::vector<u8> compressed((size_t)chunk_offsets[num_chunks]);
+	if (!compressed.empty() && !f.ReadBytes(&compressed[0], compressed.size()))
+	{
+		PanicAlertT("State file is truncated");
+		return false;
+	}
+
+	std::atomic<bool> failed(false);
+	Common::ParallelFor(num_chunks, Common::GetNumWorkerThreads(), [&](u32 i, u32 worker) {
+		const size_t offset = (size_t)i * chunk_size;
+		const size_t len = std::min<size_t>(chunk_size, size - offset);
+		if (!codec.decompress(&compressed[0] + chunk_offsets[i], chunk_sizes[i], &buffer[offset], len))
+			failed = true;
+	});
+
+	if (failed)
+	{
+		PanicAlertT("Internal %s Error - decompression failed\nTry loading the state again", codec.name);
+		return false;
+	}
+	return true;
+}
+
 struct CompressAndDumpState_args
 {
 	std::vector<u8>* buffer_vector;
@@ -257,32 +671,15 @@ void CompressAndDumpState(CompressAndDumpState_args save_args)
 
 	if (header.size != 0) // non-zero header size means the state is compressed
 	{
-		lzo_uint i = 0;
-		while (true)
-		{
-			lzo_uint32 cur_len = 0;
-			lzo_uint out_len = 0;
-
-			if ((i + IN_LEN) >= buffer_size)
-			{
-				cur_len = (lzo_uint32)(buffer_size - i);
-			}
-			else
-			{
-				cur_len = IN_LEN;
-			}
-
-			if (lzo1x_1_compress(buffer_data + i, cur_len, out, &out_len, wrkmem) != LZO_E_OK)
-				PanicAlertT("Internal LZO Error - compression failed");
-
-			// The size of the data to write is 'out_len'
-			f.WriteArray((lzo_uint32*)&out_len, 1);
-			f.WriteBytes(out, out_len);
+		u32 compression = SConfig::GetInstance().m_LocalCoreStartupParameter.iSaveStateCompression;
+		if (compression >= NUM_STATE_COMPRESSIONS)
+			compression = STATE_COMPRESSION_LZO;
 
-			if (cur_len != IN_LEN)
-				break;
-
-			i += cur_len;
+		if (!WriteChunkedState(f, buffer_data, buffer_size, compression))
+		{
+			Core::DisplayMessage("Could not save state", 2000);
+			g_compressAndDumpStateSyncEvent.Set();
+			return;
 		}
 	}
 	else // uncompressed
@@ -382,6 +779,20 @@ void LoadFileStateData(const std::string& filename, std::vector<u8>& ret_data)
 
 		buffer.resize(header.size);
 
+		u32 magic = 0;
+		f.ReadArray(&magic, 1);
+		f.Seek(-(s64)sizeof(magic), SEEK_CUR);
+
+		if (magic == CHUNKED_STATE_MAGIC)
+		{
+			if (!ReadChunkedState(f, buffer))
+				return;
+			ret_data.swap(buffer);
+			return;
+		}
+
+		// States saved before the chunked format: a sequence of LZO blocks.
+		std::vector<u8> in(OUT_LEN);
 		lzo_uint i = 0;
 		while (true)
 		{
@@ -391,8 +802,14 @@ void LoadFileStateData(const std::string& filename, std::vector<u8>& ret_data)
 			if (!f.ReadArray(&cur_len, 1))
 				break;
 
-			f.ReadBytes(out, cur_len);
-			const int res = lzo1x_decompress(out, cur_len, &buffer[i], &new_len, nullptr);
+			if (cur_len > OUT_LEN)
+			{
+				PanicAlertT("Invalid state file header");
+				return;
+			}
+
+			f.ReadBytes(&in[0], cur_len);
+			const int res = lzo1x_decompress(&in[0], cur_len, &buffer[i], &new_len, nullptr);
 			if (res != LZO_E_OK)
 			{
 				// This doesn't seem to happen anymore.
@@ -534,10 +951,26 @@ void Init()
 {
 	if (lzo_init() != LZO_E_OK)
 		PanicAlertT("Internal LZO Error - lzo_init() failed");
+
+	ClearRewindStates();
+	g_rewind_event_type = CoreTiming::RegisterEvent("RewindState", RewindCallback);
+	if (SConfig::GetInstance().m_LocalCoreStartupParameter.iRewindInterval > 0)
+	{
+		g_rewind_frame_counter = 0;
+		g_rewind_thread_running.store(true);
+		g_rewind_thread = std::thread(RewindThreadFunc);
+	}
 }
 
 void Shutdown()
 {
+	if (g_rewind_thread.joinable())
+	{
+		g_rewind_thread_running.store(false);
+		g_rewind_event.Set();
+		g_rewind_thread.join();
+	}
+
 	Flush();
 
 	// swapping with an empty vector, rather than clear()ing
@@ -551,6 +984,13 @@ void Shutdown()
 		std::lock_guard<std::mutex> lk(g_cs_undo_load_buffer);
 		std::vector<u8>().swap(g_undo_load_buffer);
 	}
+
+	ClearRewindStates();
+	{
+		std::lock_guard<std::mutex> lk(g_cs_rewind_buffer);
+		std::vector<u8>().swap(g_rewind_buffer);
+		g_rewind_pending = false;
+	}
 }
 
 static std::string MakeStateFilename(int number)
@@ -23,6 +23,14 @@ struct StateHeader
 	double time;
 };
 
+// Codecs for compressed states, stored in the file (keep the values stable).
+enum StateCompression
+{
+	STATE_COMPRESSION_LZO = 0,  // fastest
+	STATE_COMPRESSION_ZLIB = 1, // smaller files
+	NUM_STATE_COMPRESSIONS
+};
+
 void Init();
 
 void Shutdown();
@@ -48,6 +56,22 @@ void SaveToBuffer(std::vector<u8>& buffer);
 void LoadFromBuffer(std::vector<u8>& buffer);
 void VerifyBuffer(std::vector<u8>& buffer);
 
+// Rewind: keeps recent states in memory, storing only what changed since a
+// full keyframe state. LoadRewindState loads the newest one and drops it, so
+// repeated calls go further back; it returns false once there are none left.
+// With iRewindInterval set, a state is saved every that many frames.
+void SaveRewindState();
+bool LoadRewindState();
+void ClearRewindStates();
+
+// The in-memory half of the above, on serialized states. Push may take
+// ownership of the buffer's memory and leave it empty.
+void PushRewindState(std::vector<u8>& buffer);
+bool PopRewindState(std::vector<u8>& buffer);
+
+// Called by the core every time a frame is drawn
+void FrameUpdate();
+
 void LoadLastSaved(int i = 1);
 void SaveFirstSaved();
 void UndoSaveState();
@@ -2,7 +2,11 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include <algorithm>
+
+#include "Core/ConfigManager.h"
 #include "Core/VolumeHandler.h"
+#include "DiscIO/Blob.h"
 #include "DiscIO/VolumeCreator.h"
 
 namespace VolumeHandler
@@ -36,6 +40,8 @@ bool SetVolumeName(const std::string& _rFullPath)
 		g_pVolume = nullptr;
 	}
 
+	int cache_size = std::max(1, SConfig::GetInstance().m_LocalCoreStartupParameter.iDiscCacheSize);
+	DiscIO::SetSectorCacheSize((u32)std::min(cache_size, 1024) * 1024 * 1024);
 	g_pVolume = DiscIO::CreateVolumeFromFilename(_rFullPath);
 
 	return (g_pVolume != nullptr);
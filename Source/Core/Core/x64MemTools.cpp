@@ -14,6 +14,7 @@
 
 #include "Core/MemTools.h"
 #include "Core/HW/Memmap.h"
+#include "Core/HW/WriteTracker.h"
 #include "Core/PowerPC/JitInterface.h"
 #include "Core/PowerPC/PowerPC.h"
 #ifndef _M_GENERIC
@@ -43,6 +44,10 @@ void print_trace(const char * msg)
 
 bool DoFault(u64 bad_address, SContext *ctx)
 {
+	// A store to a page that's being watched for writes, from anywhere.
+	if (WriteTracker::HandleFault((uintptr_t)bad_address))
+		return true;
+
 	if (!JitInterface::IsInCodeSpace((u8*) ctx->CTX_PC))
 	{
 		// Let's not prevent debugging.
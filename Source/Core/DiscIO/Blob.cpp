@@ -2,13 +2,16 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <cinttypes>
 #include <cstddef>
 #include <cstring>
 #include <string>
 
 #include "Common/CDUtils.h"
-#include "Common/CommonTypes.h"
+#include "Common/Common.h"
 #include "Common/FileUtil.h"
+#include "Common/Timer.h"
 
 #include "DiscIO/Blob.h"
 #include "DiscIO/CISOBlob.h"
@@ -23,47 +26,189 @@ namespace DiscIO
 // Provides caching and split-operation-to-block-operations facilities.
 // Used for compressed blob reading and direct drive reading.
 
+static u32 s_cache_size = 8 * 1024 * 1024;
+
+// Sequential reads in a row before the read-ahead thread is started.
+static const u32 READ_AHEAD_TRIGGER = 3;
+
+static const u64 NO_BLOCK = (u64)(s64)-1;
+
+void SetSectorCacheSize(u32 size)
+{
+	s_cache_size = size;
+}
+
+SectorReader::SectorReader()
+	: m_blocksize(0), m_lru_head(0), m_lru_tail(0), m_pinned_slot(0),
+	  m_next_sequential_block(NO_BLOCK), m_sequential_reads(0),
+	  m_read_ahead_next(0), m_read_ahead_end(0), m_read_ahead_blocks(0),
+	  m_read_ahead_stop(false)
+{
+	memset(&m_stats, 0, sizeof(m_stats));
+}
+
 void SectorReader::SetSectorSize(int blocksize)
 {
-	for (int i = 0; i < CACHE_SIZE; i++)
+	const u32 num_slots = std::max<u32>(4, s_cache_size / blocksize);
+
+	m_blocksize = blocksize;
+	m_cache.resize((size_t)num_slots * blocksize);
+	m_cache_tags.assign(num_slots, NO_BLOCK);
+	m_cache_read_ahead.assign(num_slots, false);
+	m_cache_index.clear();
+
+	m_lru_prev.resize(num_slots);
+	m_lru_next.resize(num_slots);
+	for (u32 i = 0; i < num_slots; ++i)
 	{
-		cache[i] = new u8[blocksize];
-		cache_tags[i] = (u64)(s64) - 1;
+		m_lru_prev[i] = i - 1;
+		m_lru_next[i] = i + 1;
 	}
-	m_blocksize = blocksize;
+	m_lru_head = 0;
+	m_lru_tail = num_slots - 1;
+	m_fetch_buffer.resize(blocksize);
+	m_read_ahead_buffer.resize(blocksize);
+
+	// Read ahead up to a quarter of the cache, so it can't push out what is in use.
+	m_read_ahead_blocks = std::max<u32>(1, num_slots / 4);
 }
 
 SectorReader::~SectorReader()
 {
-	for (u8*& block : cache)
+	StopReadAhead();
+
+	const CacheStats stats = GetCacheStats();
+	if (stats.hits + stats.misses)
 	{
-		delete [] block;
+		INFO_LOG(DISCIO, "Sector cache: %" PRIu64 " hits, %" PRIu64 " misses, "
+		         "%" PRIu64 " blocks read ahead (%" PRIu64 " used), "
+		         "GetBlock %" PRIu64 " us on the reading thread, %" PRIu64 " us ahead",
+		         stats.hits, stats.misses, stats.read_ahead_blocks, stats.read_ahead_hits,
+		         stats.fetch_time_us, stats.read_ahead_time_us);
 	}
 }
 
+SectorReader::CacheStats SectorReader::GetCacheStats() const
+{
+	std::lock_guard<std::mutex> lk(m_cache_lock);
+	return m_stats;
+}
+
+bool SectorReader::FindBlock(u64 block_num, u32* slot)
+{
+	auto it = m_cache_index.find(block_num);
+	if (it == m_cache_index.end())
+		return false;
+	*slot = it->second;
+	return true;
+}
+
+void SectorReader::Unlink(u32 slot)
+{
+	if (slot == m_lru_head)
+		m_lru_head = m_lru_next[slot];
+	else
+		m_lru_next[m_lru_prev[slot]] = m_lru_next[slot];
+
+	if (slot == m_lru_tail)
+		m_lru_tail = m_lru_prev[slot];
+	else
+		m_lru_prev[m_lru_next[slot]] = m_lru_prev[slot];
+}
+
+void SectorReader::MakeMostRecent(u32 slot)
+{
+	if (slot == m_lru_head)
+		return;
+
+	Unlink(slot);
+	m_lru_next[slot] = m_lru_head;
+	m_lru_prev[m_lru_head] = slot;
+	m_lru_head = slot;
+}
+
+u32 SectorReader::InsertBlock(u64 block_num, const u8* data)
+{
+	// Evict the least recently used block. There are always at least four slots.
+	u32 slot = m_lru_tail;
+	if (slot == m_pinned_slot)
+		slot = m_lru_prev[slot];
+
+	if (m_cache_tags[slot] != NO_BLOCK)
+		m_cache_index.erase(m_cache_tags[slot]);
+
+	memcpy(GetSlot(slot), data, m_blocksize);
+	m_cache_tags[slot] = block_num;
+	m_cache_read_ahead[slot] = false;
+	m_cache_index[block_num] = slot;
+	MakeMostRecent(slot);
+	return slot;
+}
+
 const u8 *SectorReader::GetBlockData(u64 block_num)
 {
-	// TODO : Expand usage of the cache to more than one block :P
-	if (cache_tags[0] == block_num)
+	u32 slot;
 	{
-		return cache[0];
+		std::lock_guard<std::mutex> lk(m_cache_lock);
+		if (FindBlock(block_num, &slot))
+		{
+			m_stats.hits++;
+			if (m_cache_read_ahead[slot])
+			{
+				m_stats.read_ahead_hits++;
+				m_cache_read_ahead[slot] = false;
+			}
+			MakeMostRecent(slot);
+			m_pinned_slot = slot;
+			return GetSlot(slot);
+		}
+		m_stats.misses++;
 	}
-	else
+
+	// Lock order is m_block_lock, then m_cache_lock.
+	std::lock_guard<std::mutex> block_lk(m_block_lock);
+
+	// Catching up with the read-ahead thread is common: the block we waited
+	// for the lock on may be the one it just fetched.
 	{
-		GetBlock(block_num, cache[0]);
-		cache_tags[0] = block_num;
-		return cache[0];
+		std::lock_guard<std::mutex> lk(m_cache_lock);
+		if (FindBlock(block_num, &slot))
+		{
+			if (m_cache_read_ahead[slot])
+			{
+				m_stats.read_ahead_hits++;
+				m_cache_read_ahead[slot] = false;
+			}
+			MakeMostRecent(slot);
+			m_pinned_slot = slot;
+			return GetSlot(slot);
+		}
 	}
+
+	u64 start = Common::Timer::GetTimeUs();
+	GetBlock(block_num, &m_fetch_buffer[0]);
+	u64 fetch_time = Common::Timer::GetTimeUs() - start;
+
+	std::lock_guard<std::mutex> lk(m_cache_lock);
+	m_stats.fetch_time_us += fetch_time;
+	slot = InsertBlock(block_num, &m_fetch_buffer[0]);
+	m_pinned_slot = slot;
+	return GetSlot(slot);
 }
 
 bool SectorReader::Read(u64 offset, u64 size, u8* out_ptr)
 {
+	if (size == 0)
+		return true;
+
 	u64 startingBlock = offset / m_blocksize;
 	u64 remain = size;
 
 	int positionInBlock = (int)(offset % m_blocksize);
 	u64 block = startingBlock;
 
+	UpdateReadAhead(startingBlock, (offset + size - 1) / m_blocksize);
+
 	while (remain > 0)
 	{
 		// Check if we are ready to do a large block read. > instead of >= so we don't bother if remain is only one block.
@@ -118,6 +263,90 @@ bool SectorReader::ReadMultipleAlignedBlocks(u64 block_num, u64 num_blocks, u8 *
 	return true;
 }
 
+void SectorReader::UpdateReadAhead(u64 first_block, u64 last_block)
+{
+	// Reads that pick up in the block the previous one ended in count too.
+	if (first_block == m_next_sequential_block || first_block + 1 == m_next_sequential_block)
+	{
+		m_sequential_reads++;
+	}
+	else
+	{
+		// Drop what is left of the window; those blocks won't be read any time soon.
+		if (m_sequential_reads >= READ_AHEAD_TRIGGER)
+		{
+			std::lock_guard<std::mutex> lk(m_cache_lock);
+			m_read_ahead_next = m_read_ahead_end = 0;
+		}
+		m_sequential_reads = 0;
+	}
+	m_next_sequential_block = last_block + 1;
+
+	if (m_sequential_reads < READ_AHEAD_TRIGGER)
+		return;
+
+	const u64 num_blocks = (GetDataSize() + m_blocksize - 1) / m_blocksize;
+
+	std::lock_guard<std::mutex> lk(m_cache_lock);
+	if (m_read_ahead_next <= last_block || m_read_ahead_next > m_read_ahead_end)
+		m_read_ahead_next = last_block + 1;
+	m_read_ahead_end = std::min(num_blocks, last_block + 1 + m_read_ahead_blocks);
+
+	if (!m_read_ahead_thread.joinable())
+		m_read_ahead_thread = std::thread(&SectorReader::ReadAheadThread, this);
+	m_read_ahead_cv.notify_one();
+}
+
+void SectorReader::ReadAheadThread()
+{
+	Common::SetCurrentThreadName("Disc read-ahead");
+
+	std::unique_lock<std::mutex> lk(m_cache_lock);
+	while (true)
+	{
+		while (!m_read_ahead_stop && m_read_ahead_next >= m_read_ahead_end)
+			m_read_ahead_cv.wait(lk);
+		if (m_read_ahead_stop)
+			return;
+
+		const u64 block_num = m_read_ahead_next++;
+		u32 slot;
+		if (FindBlock(block_num, &slot))
+			continue;
+
+		lk.unlock();
+		u64 fetch_time;
+		{
+			std::lock_guard<std::mutex> block_lk(m_block_lock);
+			u64 start = Common::Timer::GetTimeUs();
+			GetBlock(block_num, &m_read_ahead_buffer[0]);
+			fetch_time = Common::Timer::GetTimeUs() - start;
+		}
+		lk.lock();
+
+		m_stats.read_ahead_time_us += fetch_time;
+		if (!FindBlock(block_num, &slot))
+		{
+			slot = InsertBlock(block_num, &m_read_ahead_buffer[0]);
+			m_cache_read_ahead[slot] = true;
+			m_stats.read_ahead_blocks++;
+		}
+	}
+}
+
+void SectorReader::StopReadAhead()
+{
+	if (!m_read_ahead_thread.joinable())
+		return;
+
+	{
+		std::lock_guard<std::mutex> lk(m_cache_lock);
+		m_read_ahead_stop = true;
+		m_read_ahead_cv.notify_one();
+	}
+	m_read_ahead_thread.join();
+}
+
 IBlobReader* CreateBlobReader(const std::string& filename)
 {
 	if (cdio_is_cdrom(filename))
@@ -15,7 +15,11 @@
 // automatically do the right thing.
 
 #include <string>
+#include <unordered_map>
+#include <vector>
+
 #include "Common/CommonTypes.h"
+#include "Common/Thread.h"
 
 namespace DiscIO
 {
@@ -37,40 +41,108 @@ protected:
 
 // Provides caching and split-operation-to-block-operations facilities.
 // Used for compressed blob reading and direct drive reading.
-// Currently only uses a single entry cache.
-// Multi-block reads are not cached.
+//
+// Blocks are kept in an LRU cache (see SetSectorCacheSize). Once reads turn
+// sequential, a read-ahead thread fetches the blocks that follow, so that
+// decompressing them or reading them from a drive happens off the thread
+// calling Read.
+//
+// GetBlock is never called from two threads at once. Subclasses must call
+// StopReadAhead in their destructor, since the read-ahead thread calls
+// GetBlock, and must hold m_block_lock in any override of
+// ReadMultipleAlignedBlocks that reads from the same source.
 class SectorReader : public IBlobReader
 {
-private:
-	enum { CACHE_SIZE = 32 };
-	int m_blocksize;
-	u8* cache[CACHE_SIZE];
-	u64 cache_tags[CACHE_SIZE];
-	int cache_age[CACHE_SIZE];
+public:
+	struct CacheStats
+	{
+		u64 hits;
+		u64 misses;
+		// Blocks fetched by the read-ahead thread, and how many of them were read.
+		u64 read_ahead_blocks;
+		u64 read_ahead_hits;
+		// Time spent in GetBlock on the reading thread and on the read-ahead thread.
+		u64 fetch_time_us;
+		u64 read_ahead_time_us;
+	};
+
+	virtual ~SectorReader();
+
+	// A pointer returned by GetBlockData is invalidated as soon as GetBlockData, Read, or ReadMultipleAlignedBlocks is called again.
+	const u8 *GetBlockData(u64 block_num);
+	virtual bool Read(u64 offset, u64 size, u8 *out_ptr) override;
+
+	CacheStats GetCacheStats() const;
 
 protected:
+	SectorReader();
+
 	void SetSectorSize(int blocksize);
+	void StopReadAhead();
 	virtual void GetBlock(u64 block_num, u8 *out) = 0;
 	// This one is uncached. The default implementation is to simply call GetBlockData multiple times and memcpy.
 	virtual bool ReadMultipleAlignedBlocks(u64 block_num, u64 num_blocks, u8 *out_ptr);
 
-public:
-	virtual ~SectorReader();
+	std::mutex m_block_lock;
+
+private:
+	u8* GetSlot(u32 slot) { return &m_cache[(size_t)slot * m_blocksize]; }
+	// All need m_cache_lock.
+	bool FindBlock(u64 block_num, u32* slot);
+	u32 InsertBlock(u64 block_num, const u8* data);
+	void Unlink(u32 slot);
+	void MakeMostRecent(u32 slot);
+
+	void UpdateReadAhead(u64 first_block, u64 last_block);
+	void ReadAheadThread();
+
+	int m_blocksize;
+
+	// Protected by m_cache_lock, along with the read-ahead state and m_stats.
+	mutable std::mutex m_cache_lock;
+	std::vector<u8> m_cache;
+	std::vector<u64> m_cache_tags;
+	std::vector<bool> m_cache_read_ahead; // read ahead and not used yet
+	std::unordered_map<u64, u32> m_cache_index;
+	// Every slot, from the most to the least recently used, as a doubly linked list.
+	std::vector<u32> m_lru_prev;
+	std::vector<u32> m_lru_next;
+	u32 m_lru_head;
+	u32 m_lru_tail;
+	// Slot of the last GetBlockData result; the read-ahead thread leaves it be.
+	u32 m_pinned_slot;
+	std::vector<u8> m_fetch_buffer;
+	CacheStats m_stats;
+
+	// Sequential access detection, only touched by the reading thread.
+	u64 m_next_sequential_block;
+	u32 m_sequential_reads;
+
+	std::thread m_read_ahead_thread;
+	std::condition_variable m_read_ahead_cv;
+	u64 m_read_ahead_next;
+	u64 m_read_ahead_end;
+	u32 m_read_ahead_blocks;
+	bool m_read_ahead_stop;
+	std::vector<u8> m_read_ahead_buffer;
 
-	// A pointer returned by GetBlockData is invalidated as soon as GetBlockData, Read, or ReadMultipleAlignedBlocks is called again.
-	const u8 *GetBlockData(u64 block_num);
-	virtual bool Read(u64 offset, u64 size, u8 *out_ptr) override;
 	friend class DriveReader;
 };
 
+// Size in bytes of the block cache of SectorReaders created after this call.
+void SetSectorCacheSize(u32 size);
+
 // Factory function - examines the path to choose the right type of IBlobReader, and returns one.
 IBlobReader* CreateBlobReader(const std::string& filename);
 
 typedef void (*CompressCB)(const char *text, float percent, void* arg);
 
+// Blocks are compressed and decompressed on num_threads worker threads, or one
+// per core if it is 0; the output doesn't depend on the number of threads.
+// compression_level is a zlib level (1-9).
 bool CompressFileToBlob(const std::string& infile, const std::string& outfile, u32 sub_type = 0, int sector_size = 16384,
-		CompressCB callback = nullptr, void *arg = nullptr);
+		CompressCB callback = nullptr, void *arg = nullptr, int compression_level = 9, u32 num_threads = 0);
 bool DecompressBlobToFile(const std::string& infile, const std::string& outfile,
-		CompressCB callback = nullptr, void *arg = nullptr);
+		CompressCB callback = nullptr, void *arg = nullptr, u32 num_threads = 0);
 
 }  // namespace
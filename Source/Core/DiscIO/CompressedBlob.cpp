@@ -11,12 +11,17 @@
 #include <cinttypes>
 #include <cstdio>
 #include <cstring>
+#include <memory>
 #include <string>
+#include <vector>
 #include <zlib.h>
 
 #include "Common/Common.h"
 #include "Common/FileUtil.h"
 #include "Common/Hash.h"
+#include "Common/ParallelFor.h"
+#include "Common/StringUtil.h"
+#include "Common/Thread.h"
 #include "DiscIO/Blob.h"
 #include "DiscIO/CompressedBlob.h"
 #include "DiscIO/DiscScrubber.h"
@@ -60,6 +65,7 @@ CompressedBlobReader* CompressedBlobReader::Create(const std::string& filename)
 
 CompressedBlobReader::~CompressedBlobReader()
 {
+	StopReadAhead();
 	delete [] zlib_buffer;
 	delete [] block_pointers;
 	delete [] hashes;
@@ -80,7 +86,16 @@ u64 CompressedBlobReader::GetBlockCompressedSize(u64 block_num) const
 
 void CompressedBlobReader::GetBlock(u64 block_num, u8 *out_ptr)
 {
-	bool uncompressed = false;
+	bool uncompressed;
+	u32 comp_block_size = ReadCompressedBlock(block_num, zlib_buffer, &uncompressed);
+	std::string error;
+	if (!DecompressBlock(block_num, zlib_buffer, comp_block_size, uncompressed, out_ptr, &error))
+		PanicAlert("%s", error.c_str());
+}
+
+u32 CompressedBlobReader::ReadCompressedBlock(u64 block_num, u8* buffer, bool* uncompressed)
+{
+	*uncompressed = false;
 	u32 comp_block_size = (u32)GetBlockCompressedSize(block_num);
 	u64 offset = block_pointers[block_num] + data_offset;
 
@@ -88,26 +103,36 @@ void CompressedBlobReader::GetBlock(u64 block_num, u8 *out_ptr)
 	{
 		if (comp_block_size != header.block_size)
 			PanicAlert("Uncompressed block with wrong size");
-		uncompressed = true;
+		*uncompressed = true;
 		offset &= ~(1ULL << 63);
 	}
 
+	if (comp_block_size > (u32)zlib_buffer_size)
+	{
+		PanicAlert("Block %" PRIu64 " of %s is too large.", block_num, file_name.c_str());
+		comp_block_size = zlib_buffer_size;
+	}
+
 	// clear unused part of zlib buffer. maybe this can be deleted when it works fully.
-	memset(zlib_buffer + comp_block_size, 0, zlib_buffer_size - comp_block_size);
+	memset(buffer + comp_block_size, 0, zlib_buffer_size - comp_block_size);
 
 	m_file.Seek(offset, SEEK_SET);
-	m_file.ReadBytes(zlib_buffer, comp_block_size);
+	m_file.ReadBytes(buffer, comp_block_size);
+	return comp_block_size;
+}
 
-	u8* source = zlib_buffer;
-	u8* dest = out_ptr;
+bool CompressedBlobReader::DecompressBlock(u64 block_num, const u8* source, u32 comp_block_size,
+                                           bool uncompressed, u8* dest, std::string* error) const
+{
+	error->clear();
 
 	// First, check hash.
 	u32 block_hash = HashAdler32(source, comp_block_size);
 	if (block_hash != hashes[block_num])
-		PanicAlert("Hash of block %" PRIu64 " is %08x instead of %08x.\n"
-		           "Your ISO, %s, is corrupt.",
-		           block_num, block_hash, hashes[block_num],
-		           file_name.c_str());
+		*error += StringFromFormat("Hash of block %" PRIu64 " is %08x instead of %08x.\n"
+		                           "Your ISO, %s, is corrupt.\n",
+		                           block_num, block_hash, hashes[block_num],
+		                           file_name.c_str());
 
 	if (uncompressed)
 	{
@@ -117,11 +142,11 @@ void CompressedBlobReader::GetBlock(u64 block_num, u8 *out_ptr)
 	{
 		z_stream z;
 		memset(&z, 0, sizeof(z));
-		z.next_in  = source;
+		z.next_in  = const_cast<u8*>(source);
 		z.avail_in = comp_block_size;
 		if (z.avail_in > header.block_size)
 		{
-			PanicAlert("We have a problem");
+			*error += "We have a problem\n";
 		}
 		z.next_out  = dest;
 		z.avail_out = header.block_size;
@@ -132,16 +157,135 @@ void CompressedBlobReader::GetBlock(u64 block_num, u8 *out_ptr)
 		{
 			// this seem to fire wrongly from time to time
 			// to be sure, don't use compressed isos :P
-			PanicAlert("Failure reading block %" PRIu64 " - out of data and not at end.", block_num);
+			*error += StringFromFormat("Failure reading block %" PRIu64 " - out of data and not at end.\n", block_num);
 		}
 		inflateEnd(&z);
 		if (uncomp_size != header.block_size)
-			PanicAlert("Wrong block size");
+			*error += "Wrong block size\n";
+	}
+
+	return error->empty();
+}
+
+namespace
+{
+
+// Runs read(block, slot) and write(block, slot) on the calling thread, in
+// block order, and process(slot, worker) on a pool of worker threads, with up
+// to slots.size() blocks in flight. Keeping all file access on one thread
+// keeps it sequential, and keeps the output independent of the scheduling.
+// Returns false as soon as read or write does.
+template <typename Slot, typename ReadFunc, typename ProcessFunc, typename WriteFunc>
+bool RunBlockPipeline(u64 num_blocks, u32 num_workers, std::vector<Slot>& slots,
+                      ReadFunc read, ProcessFunc process, WriteFunc write)
+{
+	const u32 num_slots = (u32)slots.size();
+	std::mutex lock;
+	std::condition_variable work_cv, done_cv;
+	std::vector<bool> done(num_slots, false);
+	u64 next_read = 0, next_process = 0, next_write = 0;
+	bool stop = false;
+
+	auto worker = [&](u32 worker_id) {
+		std::unique_lock<std::mutex> lk(lock);
+		while (true)
+		{
+			work_cv.wait(lk, [&] { return stop || next_process < next_read; });
+			if (stop)
+				return;
+
+			u64 block = next_process++;
+			lk.unlock();
+			process(slots[block % num_slots], worker_id);
+			lk.lock();
+			done[block % num_slots] = true;
+			if (block == next_write)
+				done_cv.notify_one();
+		}
+	};
+
+	std::vector<std::thread> threads;
+	for (u32 i = 0; i < num_workers; ++i)
+		threads.emplace_back(worker, i);
+
+	bool success = true;
+	while (next_write < num_blocks)
+	{
+		const u32 write_slot = next_write % num_slots;
+		bool can_read = next_read < num_blocks && next_read - next_write < num_slots;
+		bool can_write;
+		{
+			std::unique_lock<std::mutex> lk(lock);
+			if (!can_read)
+				done_cv.wait(lk, [&] { return (bool)done[write_slot]; });
+			can_write = done[write_slot];
+		}
+
+		if (can_write)
+		{
+			if (!write(next_write, slots[write_slot]))
+			{
+				success = false;
+				break;
+			}
+			std::lock_guard<std::mutex> lk(lock);
+			done[write_slot] = false;
+			next_write++;
+		}
+		else
+		{
+			if (!read(next_read, slots[next_read % num_slots]))
+			{
+				success = false;
+				break;
+			}
+			std::lock_guard<std::mutex> lk(lock);
+			next_read++;
+			work_cv.notify_one();
+		}
 	}
+
+	{
+		std::lock_guard<std::mutex> lk(lock);
+		stop = true;
+	}
+	work_cv.notify_all();
+	for (std::thread& t : threads)
+		t.join();
+	return success;
+}
+
+// Enough blocks in flight to keep every worker busy while the calling thread
+// waits on the disk.
+u32 GetNumPipelineSlots(u32 num_workers)
+{
+	return num_workers * 4;
+}
+
+struct CompressSlot
+{
+	std::vector<u8> in_buf;
+	std::vector<u8> out_buf;
+	u32 comp_size;
+	bool stored;
+};
+
+struct DecompressSlot
+{
+	u64 block_num;
+	std::vector<u8> comp_buf;
+	std::vector<u8> out_buf;
+	u32 comp_size;
+	bool uncompressed;
+	// Set by the worker; alerted on by the calling thread.
+	bool ok;
+	std::string error;
+};
+
 }
 
 bool CompressFileToBlob(const std::string& infile, const std::string& outfile, u32 sub_type,
-						int block_size, CompressCB callback, void* arg)
+						int block_size, CompressCB callback, void* arg, int compression_level, u32 num_threads)
 {
 	bool scrubbing = false;
 
@@ -166,9 +310,13 @@ bool CompressFileToBlob(const std::string& infile, const std::string& outfile, u
 	File::IOFile f(outfile, "wb");
 
 	if (!f || !inf)
+	{
+		DiscScrubber::Cleanup();
 		return false;
+	}
 
-	callback("Files opened, ready to compress.", 0, arg);
+	if (callback)
+		callback("Files opened, ready to compress.", 0, arg);
 
 	CompressedBlobHeader header;
 	header.magic_cookie = kBlobCookie;
@@ -179,106 +327,120 @@ bool CompressFileToBlob(const std::string& infile, const std::string& outfile, u
 	// round upwards!
 	header.num_blocks = (u32)((header.data_size + (block_size - 1)) / block_size);
 
-	u64* offsets = new u64[header.num_blocks];
-	u32* hashes = new u32[header.num_blocks];
-	u8* out_buf = new u8[block_size];
-	u8* in_buf = new u8[block_size];
+	std::vector<u64> offsets(header.num_blocks);
+	std::vector<u32> hashes(header.num_blocks);
 
 	// seek past the header (we will write it at the end)
 	f.Seek(sizeof(CompressedBlobHeader), SEEK_CUR);
 	// seek past the offset and hash tables (we will write them at the end)
 	f.Seek((sizeof(u64) + sizeof(u32)) * header.num_blocks, SEEK_CUR);
 
-	// Now we are ready to write compressed data!
-	u64 position = 0;
-	int num_compressed = 0;
-	int num_stored = 0;
-	int progress_monitor = max<int>(1, header.num_blocks / 1000);
-
-	for (u32 i = 0; i < header.num_blocks; i++)
+	const u32 num_workers = num_threads ? num_threads : Common::GetNumWorkerThreads();
+	std::vector<CompressSlot> slots(GetNumPipelineSlots(num_workers));
+	for (CompressSlot& slot : slots)
 	{
-		if (i % progress_monitor == 0)
-		{
-			const u64 inpos = inf.Tell();
-			int ratio = 0;
-			if (inpos != 0)
-				ratio = (int)(100 * position / inpos);
-			char temp[512];
-			sprintf(temp, "%i of %i blocks. Compression ratio %i%%", i, header.num_blocks, ratio);
-			callback(temp, (float)i / (float)header.num_blocks, arg);
-		}
+		slot.in_buf.resize(block_size);
+		slot.out_buf.resize(block_size);
+	}
 
-		offsets[i] = position;
-		// u64 start = i * header.block_size;
-		// u64 size = header.block_size;
-		std::fill(in_buf, in_buf + header.block_size, 0);
-		if (scrubbing)
-			DiscScrubber::GetNextBlock(inf, in_buf);
-		else
-			inf.ReadBytes(in_buf, header.block_size);
-		z_stream z;
+	// One stream per worker, reset between blocks. Every block is still
+	// compressed on its own, so which worker handles it doesn't matter.
+	std::vector<z_stream> streams(num_workers);
+	u32 num_streams = 0;
+	for (z_stream& z : streams)
+	{
 		memset(&z, 0, sizeof(z));
-		z.zalloc = Z_NULL;
-		z.zfree  = Z_NULL;
-		z.opaque = Z_NULL;
-		z.next_in   = in_buf;
-		z.avail_in  = header.block_size;
-		z.next_out  = out_buf;
-		z.avail_out = block_size;
-		int retval = deflateInit(&z, 9);
-
-		if (retval != Z_OK)
-		{
-			ERROR_LOG(DISCIO, "Deflate failed");
-			goto cleanup;
-		}
+		if (deflateInit(&z, compression_level) != Z_OK)
+			break;
+		num_streams++;
+	}
 
-		int status = deflate(&z, Z_FINISH);
-		int comp_size = block_size - z.avail_out;
-		if ((status != Z_STREAM_END) || (z.avail_out < 10))
-		{
-			//PanicAlert("%i %i Store %i", i*block_size, position, comp_size);
-			// let's store uncompressed
-			offsets[i] |= 0x8000000000000000ULL;
-			f.WriteBytes(in_buf, block_size);
-			hashes[i] = HashAdler32(in_buf, block_size);
-			position += block_size;
-			num_stored++;
-		}
-		else
-		{
-			// let's store compressed
-			//PanicAlert("Comp %i to %i", block_size, comp_size);
-			f.WriteBytes(out_buf, comp_size);
-			hashes[i] = HashAdler32(out_buf, comp_size);
-			position += comp_size;
-			num_compressed++;
-		}
+	u64 position = 0;
+	int progress_monitor = max<int>(1, header.num_blocks / 1000);
+	bool success = false;
 
-		deflateEnd(&z);
+	if (num_streams != num_workers)
+	{
+		ERROR_LOG(DISCIO, "Deflate failed");
+	}
+	else
+	{
+		auto read = [&](u64 i, CompressSlot& slot) {
+			std::fill(slot.in_buf.begin(), slot.in_buf.end(), 0);
+			if (scrubbing)
+				DiscScrubber::GetNextBlock(inf, &slot.in_buf[0]);
+			else
+				inf.ReadBytes(&slot.in_buf[0], header.block_size);
+			return true;
+		};
+
+		auto process = [&](CompressSlot& slot, u32 worker) {
+			z_stream& z = streams[worker];
+			deflateReset(&z);
+			z.next_in   = &slot.in_buf[0];
+			z.avail_in  = header.block_size;
+			z.next_out  = &slot.out_buf[0];
+			z.avail_out = block_size;
+
+			int status = deflate(&z, Z_FINISH);
+			slot.comp_size = block_size - z.avail_out;
+			// store uncompressed if it doesn't fit, or barely fits
+			slot.stored = (status != Z_STREAM_END) || (z.avail_out < 10);
+		};
+
+		auto write = [&](u64 i, CompressSlot& slot) {
+			if (callback && i % progress_monitor == 0)
+			{
+				int ratio = 0;
+				if (i != 0)
+					ratio = (int)(100 * position / (i * block_size));
+				char temp[512];
+				sprintf(temp, "%i of %i blocks. Compression ratio %i%%", (int)i, header.num_blocks, ratio);
+				callback(temp, (float)i / (float)header.num_blocks, arg);
+			}
+
+			offsets[i] = position;
+			if (slot.stored)
+			{
+				offsets[i] |= 0x8000000000000000ULL;
+				hashes[i] = HashAdler32(&slot.in_buf[0], block_size);
+				position += block_size;
+				return f.WriteBytes(&slot.in_buf[0], block_size);
+			}
+			else
+			{
+				hashes[i] = HashAdler32(&slot.out_buf[0], slot.comp_size);
+				position += slot.comp_size;
+				return f.WriteBytes(&slot.out_buf[0], slot.comp_size);
+			}
+		};
+
+		success = RunBlockPipeline(header.num_blocks, num_workers, slots, read, process, write);
 	}
 
-	header.compressed_data_size = position;
-
-	// Okay, go back and fill in headers
-	f.Seek(0, SEEK_SET);
-	f.WriteArray(&header, 1);
-	f.WriteArray(offsets, header.num_blocks);
-	f.WriteArray(hashes, header.num_blocks);
+	for (u32 i = 0; i < num_streams; ++i)
+		deflateEnd(&streams[i]);
 
-cleanup:
-	// Cleanup
-	delete[] in_buf;
-	delete[] out_buf;
-	delete[] offsets;
-	delete[] hashes;
+	if (success)
+	{
+		header.compressed_data_size = position;
+
+		// Okay, go back and fill in headers
+		f.Seek(0, SEEK_SET);
+		success = f.WriteArray(&header, 1) &&
+		          (header.num_blocks == 0 ||
+		           (f.WriteArray(&offsets[0], header.num_blocks) &&
+		            f.WriteArray(&hashes[0], header.num_blocks)));
+	}
 
 	DiscScrubber::Cleanup();
-	callback("Done compressing disc image.", 1.0f, arg);
-	return true;
+	if (callback)
+		callback("Done compressing disc image.", 1.0f, arg);
+	return success;
 }
 
-bool DecompressBlobToFile(const std::string& infile, const std::string& outfile, CompressCB callback, void* arg)
+bool DecompressBlobToFile(const std::string& infile, const std::string& outfile, CompressCB callback, void* arg,
+                          u32 num_threads)
 {
 	if (!IsCompressedBlob(infile))
 	{
@@ -286,38 +448,50 @@ bool DecompressBlobToFile(const std::string& infile, const std::string& outfile,
 		return false;
 	}
 
-	CompressedBlobReader* reader = CompressedBlobReader::Create(infile);
+	std::unique_ptr<CompressedBlobReader> reader(CompressedBlobReader::Create(infile));
 	if (!reader)
 		return false;
 
 	File::IOFile f(outfile, "wb");
 	if (!f)
-	{
-		delete reader;
 		return false;
-	}
 
 	const CompressedBlobHeader &header = reader->GetHeader();
-	u8* buffer = new u8[header.block_size];
 	int progress_monitor = max<int>(1, header.num_blocks / 100);
 
-	for (u64 i = 0; i < header.num_blocks; i++)
+	const u32 num_workers = num_threads ? num_threads : Common::GetNumWorkerThreads();
+	std::vector<DecompressSlot> slots(GetNumPipelineSlots(num_workers));
+	for (DecompressSlot& slot : slots)
 	{
-		if (i % progress_monitor == 0)
-		{
-			callback("Unpacking", (float)i / (float)header.num_blocks, arg);
-		}
-		reader->Read(i * header.block_size, header.block_size, buffer);
-		f.WriteBytes(buffer, header.block_size);
+		slot.comp_buf.resize(reader->GetMaxCompressedBlockSize());
+		slot.out_buf.resize(header.block_size);
 	}
 
-	delete[] buffer;
-
-	f.Resize(header.data_size);
+	auto read = [&](u64 i, DecompressSlot& slot) {
+		slot.block_num = i;
+		slot.comp_size = reader->ReadCompressedBlock(i, &slot.comp_buf[0], &slot.uncompressed);
+		return true;
+	};
+
+	auto process = [&](DecompressSlot& slot, u32 worker) {
+		slot.ok = reader->DecompressBlock(slot.block_num, &slot.comp_buf[0], slot.comp_size, slot.uncompressed,
+		                                  &slot.out_buf[0], &slot.error);
+	};
+
+	auto write = [&](u64 i, DecompressSlot& slot) {
+		// Alerts can't be raised from the workers, so problems are reported
+		// here, in block order, and the block is written anyway as before.
+		if (!slot.ok)
+			PanicAlert("%s", slot.error.c_str());
+		if (callback && i % progress_monitor == 0)
+			callback("Unpacking", (float)i / (float)header.num_blocks, arg);
+		return f.WriteBytes(&slot.out_buf[0], header.block_size);
+	};
 
-	delete reader;
+	if (!RunBlockPipeline(header.num_blocks, num_workers, slots, read, process, write))
+		return false;
 
-	return true;
+	return f.Resize(header.data_size);
 }
 
 bool IsCompressedBlob(const std::string& filename)
@@ -53,6 +53,17 @@ public:
 	u64 GetRawSize() const override { return file_size; }
 	u64 GetBlockCompressedSize(u64 block_num) const;
 	void GetBlock(u64 block_num, u8* out_ptr) override;
+
+	// GetBlock split in two, so blocks can be decompressed on other threads.
+	// ReadCompressedBlock reads the stored data of a block into buffer, which
+	// must hold GetMaxCompressedBlockSize() bytes, and returns its size. It
+	// must not be called while Read is in use. DecompressBlock checks the data
+	// and decompresses it into out_ptr, and may be called from any thread; it
+	// doesn't alert, but returns false and describes what went wrong in error.
+	u32 ReadCompressedBlock(u64 block_num, u8* buffer, bool* uncompressed);
+	bool DecompressBlock(u64 block_num, const u8* source, u32 size, bool uncompressed, u8* out_ptr,
+	                     std::string* error) const;
+	u32 GetMaxCompressedBlockSize() const { return zlib_buffer_size; }
 private:
 	CompressedBlobReader(const std::string& filename);
 
@@ -64,6 +64,7 @@ DriveReader::DriveReader(const std::string& drive)
 
 DriveReader::~DriveReader()
 {
+	StopReadAhead();
 #ifdef _WIN32
 #ifdef _LOCKDRIVE // Do we want to lock the drive?
 	// Unlock the disc in the CD-ROM drive.
@@ -116,6 +117,7 @@ void DriveReader::GetBlock(u64 block_num, u8* out_ptr)
 
 bool DriveReader::ReadMultipleAlignedBlocks(u64 block_num, u64 num_blocks, u8* out_ptr)
 {
+	std::lock_guard<std::mutex> lk(m_block_lock);
 #ifdef _WIN32
 	u32 NotUsed;
 	u64 offset = m_blocksize * block_num;
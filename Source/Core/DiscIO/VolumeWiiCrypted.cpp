@@ -2,6 +2,7 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <cstddef>
 #include <cstring>
 #include <string>
@@ -10,6 +11,7 @@
 #include <polarssl/sha1.h>
 
 #include "Common/Common.h"
+#include "Common/Crypto/aes.h"
 #include "DiscIO/Blob.h"
 #include "DiscIO/Volume.h"
 #include "DiscIO/VolumeGC.h"
@@ -21,14 +23,16 @@ namespace DiscIO
 CVolumeWiiCrypted::CVolumeWiiCrypted(IBlobReader* _pReader, u64 _VolumeOffset,
 									 const unsigned char* _pVolumeKey)
 	: m_pReader(_pReader),
-	m_pBuffer(nullptr),
 	m_VolumeOffset(_VolumeOffset),
 	dataOffset(0x20000),
-	m_LastDecryptedBlockOffset(-1)
+	m_RawBuffer(MAX_BATCH_CLUSTERS * CLUSTER_SIZE),
+	m_ClusterCache(CLUSTER_CACHE_SIZE * CLUSTER_DATA_SIZE),
+	m_ClusterTags(CLUSTER_CACHE_SIZE, (u64)-1),
+	m_ClusterAges(CLUSTER_CACHE_SIZE, 0),
+	m_ClusterAge(0)
 {
 	m_AES_ctx = new aes_context;
 	aes_setkey_dec(m_AES_ctx, _pVolumeKey, 128);
-	m_pBuffer = new u8[0x8000];
 }
 
 
@@ -36,8 +40,6 @@ CVolumeWiiCrypted::~CVolumeWiiCrypted()
 {
 	delete m_pReader; // is this really our responsibility?
 	m_pReader = nullptr;
-	delete[] m_pBuffer;
-	m_pBuffer = nullptr;
 	delete m_AES_ctx;
 	m_AES_ctx = nullptr;
 }
@@ -63,30 +65,38 @@ bool CVolumeWiiCrypted::Read(u64 _ReadOffset, u64 _Length, u8* _pBuffer) const
 
 	while (_Length > 0)
 	{
-		static unsigned char IV[16];
-
 		// math block offset
-		u64 Block  = _ReadOffset / 0x7C00;
-		u64 Offset = _ReadOffset % 0x7C00;
+		u64 Block  = _ReadOffset / CLUSTER_DATA_SIZE;
+		u64 Offset = _ReadOffset % CLUSTER_DATA_SIZE;
 
-		// read current block
-		if (!m_pReader->Read(m_VolumeOffset + dataOffset + Block * 0x8000, 0x8000, m_pBuffer))
+		// Whole clusters go straight to the buffer, bypassing the cache, so
+		// that streaming large files doesn't evict everything else.
+		if (Offset == 0 && _Length >= CLUSTER_DATA_SIZE && !IsClusterCached(Block))
 		{
-			return(false);
-		}
+			u64 NumBlocks = 1;
+			while (NumBlocks < MAX_BATCH_CLUSTERS && (NumBlocks + 1) * CLUSTER_DATA_SIZE <= _Length &&
+			       !IsClusterCached(Block + NumBlocks))
+			{
+				NumBlocks++;
+			}
 
-		if (m_LastDecryptedBlockOffset != Block)
-		{
-			memcpy(IV, m_pBuffer + 0x3d0, 16);
-			aes_crypt_cbc(m_AES_ctx, AES_DECRYPT, 0x7C00, IV, m_pBuffer + 0x400, m_LastDecryptedBlock);
+			if (!DecryptClusters(Block, NumBlocks, _pBuffer))
+				return(false);
 
-			m_LastDecryptedBlockOffset = Block;
+			_Length     -= NumBlocks * CLUSTER_DATA_SIZE;
+			_pBuffer    += NumBlocks * CLUSTER_DATA_SIZE;
+			_ReadOffset += NumBlocks * CLUSTER_DATA_SIZE;
+			continue;
 		}
 
-		// copy the encrypted data
-		u64 MaxSizeToCopy = 0x7C00 - Offset;
+		const u8* DecryptedBlock = GetDecryptedCluster(Block);
+		if (!DecryptedBlock)
+			return(false);
+
+		// copy the decrypted data
+		u64 MaxSizeToCopy = CLUSTER_DATA_SIZE - Offset;
 		u64 CopySize = (_Length > MaxSizeToCopy) ? MaxSizeToCopy : _Length;
-		memcpy(_pBuffer, &m_LastDecryptedBlock[Offset], (size_t)CopySize);
+		memcpy(_pBuffer, DecryptedBlock + Offset, (size_t)CopySize);
 
 		// increase buffers
 		_Length -= CopySize;
@@ -97,6 +107,54 @@ bool CVolumeWiiCrypted::Read(u64 _ReadOffset, u64 _Length, u8* _pBuffer) const
 	return(true);
 }
 
+bool CVolumeWiiCrypted::IsClusterCached(u64 cluster) const
+{
+	return m_ClusterIndex.count(cluster) != 0;
+}
+
+const u8* CVolumeWiiCrypted::GetDecryptedCluster(u64 cluster) const
+{
+	auto it = m_ClusterIndex.find(cluster);
+	if (it != m_ClusterIndex.end())
+	{
+		m_ClusterAges[it->second] = ++m_ClusterAge;
+		return &m_ClusterCache[it->second * CLUSTER_DATA_SIZE];
+	}
+
+	u32 slot = (u32)(std::min_element(m_ClusterAges.begin(), m_ClusterAges.end()) - m_ClusterAges.begin());
+	u8* data = &m_ClusterCache[slot * CLUSTER_DATA_SIZE];
+	if (m_ClusterTags[slot] != (u64)-1)
+		m_ClusterIndex.erase(m_ClusterTags[slot]);
+	m_ClusterTags[slot] = (u64)-1;
+	m_ClusterAges[slot] = 0;
+
+	if (!DecryptClusters(cluster, 1, data))
+		return nullptr;
+
+	m_ClusterTags[slot] = cluster;
+	m_ClusterAges[slot] = ++m_ClusterAge;
+	m_ClusterIndex[cluster] = slot;
+	return data;
+}
+
+bool CVolumeWiiCrypted::DecryptClusters(u64 first_cluster, u64 num_clusters, u8* out) const
+{
+	if (!m_pReader->Read(m_VolumeOffset + dataOffset + first_cluster * CLUSTER_SIZE,
+	                     num_clusters * CLUSTER_SIZE, &m_RawBuffer[0]))
+	{
+		return false;
+	}
+
+	for (u64 i = 0; i < num_clusters; ++i)
+	{
+		const u8* raw = &m_RawBuffer[i * CLUSTER_SIZE];
+		u8 IV[16];
+		memcpy(IV, raw + 0x3d0, 16);
+		AES::DecryptCBC(m_AES_ctx, IV, raw + 0x400, out + i * CLUSTER_DATA_SIZE, CLUSTER_DATA_SIZE);
+	}
+	return true;
+}
+
 bool CVolumeWiiCrypted::GetTitleID(u8* _pBuffer) const
 {
 	// Tik is at m_VolumeOffset size 0x2A4
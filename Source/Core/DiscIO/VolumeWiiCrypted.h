@@ -5,6 +5,7 @@
 #pragma once
 
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include <polarssl/aes.h>
 
@@ -40,16 +41,39 @@ public:
 	bool CheckIntegrity() const override;
 
 private:
+	enum
+	{
+		CLUSTER_SIZE = 0x8000,
+		CLUSTER_DATA_SIZE = 0x7C00,
+		// Decrypted clusters kept around, about 1 MiB.
+		CLUSTER_CACHE_SIZE = 32,
+		// Uncached whole clusters of a read are decrypted this many at a time,
+		// straight into the caller's buffer.
+		MAX_BATCH_CLUSTERS = 16,
+	};
+
+	// Returns the decrypted data of a cluster, or nullptr if it can't be
+	// read. The pointer stays valid until the next call.
+	const u8* GetDecryptedCluster(u64 cluster) const;
+	bool IsClusterCached(u64 cluster) const;
+	bool DecryptClusters(u64 first_cluster, u64 num_clusters, u8* out) const;
+
 	IBlobReader* m_pReader;
 
-	u8* m_pBuffer;
 	aes_context* m_AES_ctx;
 
 	u64 m_VolumeOffset;
 	u64 dataOffset;
 
-	mutable u64 m_LastDecryptedBlockOffset;
-	mutable unsigned char m_LastDecryptedBlock[0x8000];
+	// Raw clusters, for up to MAX_BATCH_CLUSTERS.
+	mutable std::vector<u8> m_RawBuffer;
+
+	// LRU cache of decrypted clusters.
+	mutable std::vector<u8> m_ClusterCache;
+	mutable std::vector<u64> m_ClusterTags;
+	mutable std::vector<u64> m_ClusterAges;
+	mutable std::unordered_map<u64, u32> m_ClusterIndex;
+	mutable u64 m_ClusterAge;
 };
 
 } // namespace
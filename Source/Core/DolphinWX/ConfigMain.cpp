@@ -60,6 +60,7 @@ struct CPUCore
 };
 const CPUCore CPUCores[] = {
 	{0, wxTRANSLATE("Interpreter (VERY slow)")},
+	{5, wxTRANSLATE("Cached Interpreter (slow)")},
 #ifdef _M_ARM
 	{3, wxTRANSLATE("Arm JIT (experimental)")},
 	{4, wxTRANSLATE("Arm JITIL (experimental)")},
@@ -149,6 +150,7 @@ EVT_CHECKBOX(ID_DUMP_AUDIO, CConfigMain::AudioSettingsChanged)
 EVT_CHECKBOX(ID_DPL2DECODER, CConfigMain::AudioSettingsChanged)
 EVT_CHOICE(ID_BACKEND, CConfigMain::AudioSettingsChanged)
 EVT_SLIDER(ID_VOLUME, CConfigMain::AudioSettingsChanged)
+EVT_CHOICE(ID_RESAMPLER, CConfigMain::AudioSettingsChanged)
 
 EVT_CHECKBOX(ID_INTERFACE_CONFIRMSTOP, CConfigMain::DisplaySettingsChanged)
 EVT_CHECKBOX(ID_INTERFACE_USEPANICHANDLERS, CConfigMain::DisplaySettingsChanged)
@@ -277,6 +279,10 @@ void CConfigMain::InitializeGUILists()
 	arrayStringFor_DSPEngine.Add(_("DSP LLE recompiler"));
 	arrayStringFor_DSPEngine.Add(_("DSP LLE interpreter (slow)"));
 
+	// Resampler, in the order of Resampler::Quality
+	arrayStringFor_Resampler.Add(_("Linear (fast)"));
+	arrayStringFor_Resampler.Add(_("Windowed sinc"));
+
 	// Gamecube page
 	// GC Language arrayStrings
 	arrayStringFor_GCSystemLang.Add(_("English"));
@@ -380,6 +386,7 @@ void CConfigMain::InitializeGUIValues()
 	DPL2Decoder->SetValue(startup_params.bDPL2Decoder);
 	Latency->Enable(std::string(SConfig::GetInstance().sBackend) == BACKEND_OPENAL);
 	Latency->SetValue(startup_params.iLatency);
+	ResamplerSelection->SetSelection(SConfig::GetInstance().m_Resampler);
 	// add backends to the list
 	AddAudioBackends();
 
@@ -537,6 +544,7 @@ void CConfigMain::InitializeGUITooltips()
 #endif
 
 	Latency->SetToolTip(_("Sets the latency (in ms).  Higher values may reduce audio crackling. OpenAL backend only."));
+	ResamplerSelection->SetToolTip(_("How the game's audio is converted to the rate of the output.\nWindowed sinc sounds clearer, linear costs less CPU."));
 }
 
 void CConfigMain::CreateGUIControls()
@@ -659,6 +667,7 @@ void CConfigMain::CreateGUIControls()
 	VolumeText = new wxStaticText(AudioPage, wxID_ANY, wxT(""));
 	BackendSelection = new wxChoice(AudioPage, ID_BACKEND, wxDefaultPosition, wxDefaultSize, wxArrayBackends, 0, wxDefaultValidator, wxEmptyString);
 	Latency = new wxSpinCtrl(AudioPage, ID_LATENCY, "", wxDefaultPosition, wxDefaultSize, wxSP_ARROW_KEYS, 0, 30);
+	ResamplerSelection = new wxChoice(AudioPage, ID_RESAMPLER, wxDefaultPosition, wxDefaultSize, arrayStringFor_Resampler);
 
 	Latency->Bind(wxEVT_COMMAND_SPINCTRL_UPDATED, &CConfigMain::AudioSettingsChanged, this);
 
@@ -685,6 +694,8 @@ void CConfigMain::CreateGUIControls()
 	sBackend->Add(BackendSelection, wxGBPosition(0, 1), wxDefaultSpan, wxALL, 5);
 	sBackend->Add(TEXT_BOX(AudioPage, _("Latency:")), wxGBPosition(1, 0), wxDefaultSpan, wxALIGN_CENTER_VERTICAL|wxALL, 5);
 	sBackend->Add(Latency, wxGBPosition(1, 1), wxDefaultSpan, wxALL, 5);
+	sBackend->Add(TEXT_BOX(AudioPage, _("Resampler:")), wxGBPosition(2, 0), wxDefaultSpan, wxALIGN_CENTER_VERTICAL|wxALL, 5);
+	sBackend->Add(ResamplerSelection, wxGBPosition(2, 1), wxDefaultSpan, wxALL, 5);
 	wxStaticBoxSizer *sbBackend = new wxStaticBoxSizer(wxHORIZONTAL, AudioPage, _("Backend Settings"));
 	sbBackend->Add(sBackend, 0, wxEXPAND);
 
@@ -977,6 +988,11 @@ void CConfigMain::AudioSettingsChanged(wxCommandEvent& event)
 		SConfig::GetInstance().m_LocalCoreStartupParameter.iLatency = Latency->GetValue();
 		break;
 
+	case ID_RESAMPLER:
+		SConfig::GetInstance().m_Resampler = ResamplerSelection->GetSelection();
+		AudioCommon::UpdateSoundStream();
+		break;
+
 	default:
 		SConfig::GetInstance().m_DumpAudio = DumpAudio->GetValue();
 		break;
@@ -93,6 +93,7 @@ private:
 		ID_LATENCY,
 		ID_BACKEND,
 		ID_VOLUME,
+		ID_RESAMPLER,
 
 		// Interface settings
 		ID_INTERFACE_CONFIRMSTOP,
@@ -168,6 +169,7 @@ private:
 	wxArrayString wxArrayBackends;
 	wxChoice*   BackendSelection;
 	wxSpinCtrl* Latency;
+	wxChoice*   ResamplerSelection;
 
 	// Interface
 	wxCheckBox* ConfirmStop;
@@ -233,6 +235,7 @@ private:
 	wxArrayString arrayStringFor_Framelimit;
 	wxArrayString arrayStringFor_CPUEngine;
 	wxArrayString arrayStringFor_DSPEngine;
+	wxArrayString arrayStringFor_Resampler;
 	wxArrayString arrayStringFor_FullscreenResolution;
 	wxArrayString arrayStringFor_InterfaceLang;
 	wxArrayString arrayStringFor_GCSystemLang;
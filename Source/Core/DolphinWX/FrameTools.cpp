@@ -197,6 +197,7 @@ void CFrame::CreateMenu()
 	loadMenu->Append(IDM_LOADSTATEFILE,  GetMenuLabel(HK_LOAD_STATE_FILE));
 
 	loadMenu->Append(IDM_UNDOLOADSTATE, GetMenuLabel(HK_UNDO_LOAD_STATE));
+	loadMenu->Append(IDM_REWINDSTATE, GetMenuLabel(HK_REWIND_STATE));
 	loadMenu->AppendSeparator();
 
 	for (unsigned int i = 1; i <= State::NUM_STATES; i++)
@@ -458,6 +459,7 @@ wxString CFrame::GetMenuLabel(int Id)
 		case HK_SAVE_FIRST_STATE: Label = wxString("Save Oldest State"); break;
 		case HK_UNDO_LOAD_STATE: Label = wxString("Undo Load State"); break;
 		case HK_UNDO_SAVE_STATE: Label = wxString("Undo Save State"); break;
+		case HK_REWIND_STATE: Label = wxString("Rewind State"); break;
 
 		default:
 			Label = wxString::Format(_("Undefined %i"), Id);
@@ -1561,6 +1563,12 @@ void CFrame::OnUndoSaveState(wxCommandEvent& WXUNUSED (event))
 		State::UndoSaveState();
 }
 
+void CFrame::OnRewindState(wxCommandEvent& WXUNUSED (event))
+{
+	if (Core::IsRunningAndStarted() && !State::LoadRewindState())
+		Core::DisplayMessage("No rewind state left", 2000);
+}
+
 
 void CFrame::OnLoadState(wxCommandEvent& event)
 {
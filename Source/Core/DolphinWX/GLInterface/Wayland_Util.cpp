@@ -199,6 +199,8 @@ keyboard_handle_key(void *data, struct wl_keyboard *keyboard,
 	}
 	else if (key == KEY_F9)
 		Core::SaveScreenShot();
+	else if (key == KEY_F10)
+		State::LoadRewindState();
 	else if (key == KEY_F11)
 		State::LoadLastSaved();
 	else if (key == KEY_F12) {
@@ -216,6 +216,8 @@ void X11_MainLoop()
 					}
 					else if (key == XK_F9)
 						Core::SaveScreenShot();
+					else if (key == XK_F10)
+						State::LoadRewindState();
 					else if (key == XK_F11)
 						State::LoadLastSaved();
 					else if (key == XK_F12)
@@ -141,7 +141,8 @@ NetPlaySetupDiag::NetPlaySetupDiag(wxWindow* const parent, const CGameListCtrl*
 		"All memory cards must be identical between players or disabled.\n"
 		"Wiimote support is probably terrible. Don't use it.\n"
 		"\n"
-		"The host must have the chosen TCP port open/forwarded!\n"));
+		"The host must have the chosen TCP port open/forwarded,\n"
+		"and the UDP port of the same number for input over UDP!\n"));
 
 	wxBoxSizer* const top_szr = new wxBoxSizer(wxHORIZONTAL);
 	top_szr->Add(ip_lbl, 0, wxCENTER | wxRIGHT, 5);
@@ -176,9 +177,15 @@ NetPlaySetupDiag::NetPlaySetupDiag(wxWindow* const parent, const CGameListCtrl*
 
 	FillWithGameNames(m_game_lbox, *game_list);
 
+	bool udp_input;
+	netplay_section.Get("UDPInput", &udp_input, false);
+	m_udp_chk = new wxCheckBox(host_tab, wxID_ANY, _("Send input over UDP"));
+	m_udp_chk->SetValue(udp_input);
+
 	wxBoxSizer* const top_szr = new wxBoxSizer(wxHORIZONTAL);
 	top_szr->Add(port_lbl, 0, wxCENTER | wxRIGHT, 5);
 	top_szr->Add(m_host_port_text, 0);
+	top_szr->Add(m_udp_chk, 0, wxALL | wxALIGN_RIGHT, 5);
 #ifdef USE_UPNP
 	m_upnp_chk = new wxCheckBox(host_tab, wxID_ANY, _("Forward port (UPnP)"));
 	top_szr->Add(m_upnp_chk, 0, wxALL | wxALIGN_RIGHT, 5);
@@ -225,6 +232,7 @@ NetPlaySetupDiag::~NetPlaySetupDiag()
 	netplay_section.Set("Address", WxStrToStr(m_connect_ip_text->GetValue()));
 	netplay_section.Set("ConnectPort", WxStrToStr(m_connect_port_text->GetValue()));
 	netplay_section.Set("HostPort", WxStrToStr(m_host_port_text->GetValue()));
+	netplay_section.Set("UDPInput", m_udp_chk->GetValue());
 
 	inifile.Save(dolphin_ini);
 	main_frame->g_NetPlaySetupDiag = nullptr;
@@ -271,7 +279,7 @@ void NetPlaySetupDiag::OnHost(wxCommandEvent&)
 
 	unsigned long port = 0;
 	m_host_port_text->GetValue().ToULong(&port);
-	netplay_server = new NetPlayServer(u16(port));
+	netplay_server = new NetPlayServer(u16(port), m_udp_chk->GetValue());
 	netplay_server->ChangeGame(game);
 	netplay_server->AdjustPadBufferSize(INITIAL_PAD_BUFFER_SIZE);
 	if (netplay_server->is_connected)
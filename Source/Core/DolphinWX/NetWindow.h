@@ -48,6 +48,7 @@ private:
 	wxTextCtrl* m_connect_ip_text;
 
 	wxListBox*  m_game_lbox;
+	wxCheckBox* m_udp_chk;
 #ifdef USE_UPNP
 	wxCheckBox* m_upnp_chk;
 #endif
@@ -25,6 +25,7 @@
 #include "Common/StringUtil.h"
 
 #include "Core/HW/Memmap.h"
+#include "Core/HW/WriteTracker.h"
 
 #include "VideoBackends/OGL/FramebufferManager.h"
 #include "VideoBackends/OGL/Globals.h"
@@ -317,6 +318,7 @@ void TextureCache::TCacheEntry::FromRenderTarget(u32 dstAddr, unsigned int dstFo
 			dstFormat,
 			scaleByHalf,
 			srcRect);
+		WriteTracker::Written(addr, encoded_size);
 
 		u8* dst = Memory::GetPointer(addr);
 		u64 const new_hash = GetHash64(dst,encoded_size,g_ActiveConfig.iSafeTextureCache_ColorSamples);
@@ -7,9 +7,12 @@
 
 #include "VideoBackends/Software/BPMemLoader.h"
 #include "VideoBackends/Software/EfbCopy.h"
+#include "VideoBackends/Software/Pipeline.h"
 #include "VideoBackends/Software/Rasterizer.h"
 #include "VideoBackends/Software/SWPixelEngine.h"
 #include "VideoBackends/Software/Tev.h"
+#include "VideoBackends/Software/TevJit.h"
+#include "VideoBackends/Software/TextureSampler.h"
 
 #include "VideoCommon/TextureDecoder.h"
 #include "VideoCommon/VideoCommon.h"
@@ -23,6 +26,9 @@ void InitBPMemory()
 
 void SWLoadBPReg(u32 value)
 {
+	// Queued triangles are drawn with the state they were submitted with.
+	Pipeline::Flush();
+
 	//handle the mask register
 	int address = value >> 24;
 	int oldval = ((u32*)&bpmem)[address];
@@ -39,6 +45,17 @@ void SWLoadBPReg(u32 value)
 
 void SWBPWritten(int address, int newvalue)
 {
+	if ((address >= BPMEM_TX_SETMODE0 && address < BPMEM_TX_SETTLUT + 4) ||
+	    (address >= BPMEM_TX_SETMODE0_4 && address < BPMEM_TX_SETLUT_4 + 4))
+		TextureSampler::Invalidate();
+
+	if (address == BPMEM_GENMODE || address == BPMEM_ALPHACOMPARE ||
+	    (address >= BPMEM_IND_CMD && address < BPMEM_IND_CMD + 16) ||
+	    (address >= BPMEM_TREF && address < BPMEM_TREF + 8) ||
+	    (address >= BPMEM_TEV_COLOR_ENV && address < BPMEM_TEV_COLOR_ENV + 32) ||
+	    (address >= BPMEM_TEV_KSEL && address < BPMEM_TEV_KSEL + 8))
+		TevJit::Invalidate();
+
 	switch (address)
 	{
 	case BPMEM_SCISSORTL:
@@ -112,9 +129,15 @@ void SWBPWritten(int address, int newvalue)
 				memcpy_gc(texMem + tlutTMemAddr, ptr, tlutXferCount);
 			else
 				PanicAlert("Invalid palette pointer %08x %08x %08x", bpmem.tmem_config.tlut_src, bpmem.tmem_config.tlut_src << 5, (bpmem.tmem_config.tlut_src & 0xFFFFF)<< 5);
+
+			TextureSampler::Invalidate();
 			break;
 		}
 
+	case BPMEM_TEXINVALIDATE: // The game changed texture memory
+		TextureSampler::Invalidate();
+		break;
+
 	case BPMEM_PRELOAD_MODE:
 		if (newvalue != 0)
 		{
@@ -151,6 +174,8 @@ void SWBPWritten(int address, int newvalue)
 					src_ptr += TMEM_LINE_SIZE * 2;
 				}
 			}
+
+			TextureSampler::Invalidate();
 		}
 		break;
 
@@ -14,6 +14,7 @@
 #include "VideoBackends/Software/SWStatistics.h"
 #include "VideoBackends/Software/SWVideoConfig.h"
 #include "VideoBackends/Software/TextureEncoder.h"
+#include "VideoBackends/Software/TextureSampler.h"
 
 static const float s_gammaLUT[] =
 {
@@ -68,6 +69,9 @@ namespace EfbCopy
 			u8 *dest_ptr = Memory::GetPointer(bpmem.copyTexDest << 5);
 
 			TextureEncoder::Encode(dest_ptr);
+
+			// The copy may overwrite a texture.
+			TextureSampler::Invalidate();
 		}
 	}
 
@@ -0,0 +1,314 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <memory>
+
+#include "Common/Common.h"
+#include "Common/SPSCQueue.h"
+#include "Common/Thread.h"
+#include "Common/Timer.h"
+
+#include "VideoBackends/Software/Pipeline.h"
+#include "VideoBackends/Software/Rasterizer.h"
+#include "VideoBackends/Software/SetupUnit.h"
+#include "VideoBackends/Software/SWStatistics.h"
+#include "VideoBackends/Software/SWVideoConfig.h"
+#include "VideoBackends/Software/TransformUnit.h"
+
+namespace Pipeline
+{
+
+enum
+{
+	BATCH_SIZE = 256,
+	MAX_PRIMITIVES = 32,
+	// Enough for every stage to have a batch and one waiting.
+	NUM_BATCHES = 8,
+};
+
+// What the transform and setup of a run of vertices in a batch depend on,
+// from the vertex format of their primitive.
+struct Primitive
+{
+	u32 firstVertex;
+	u8 primitiveType;
+	u8 normalElements;
+	bool hasNormal;
+	bool texGenSpecialCase;
+	// False when the primitive started in an earlier batch.
+	bool begins;
+};
+
+struct Batch
+{
+	u32 numVertices;
+	u32 numPrimitives;
+	Primitive primitives[MAX_PRIMITIVES];
+	InputVertexData input[BATCH_SIZE];
+	OutputVertexData output[BATCH_SIZE];
+};
+
+// Batches handed from one thread to the next. Every batch is in exactly one
+// queue or owned by one stage, so pushing never finds a queue full.
+struct Link
+{
+	Common::SPSCQueue<Batch*, NUM_BATCHES> queue;
+	// Set after every push, for the reader to wait on when the queue is empty.
+	Common::Event pushed;
+
+	void Push(Batch *batch)
+	{
+		// Should that ever change, wait for the reader rather than lose the batch.
+		while (!queue.TryPush(batch))
+		{
+			_assert_msg_(VIDEO, false, "Software pipeline queue is full");
+			Common::YieldCPU();
+		}
+		pushed.Set();
+	}
+
+	Batch* Pop(u32 &stalls)
+	{
+		Batch *batch;
+		while (!queue.Pop(batch))
+		{
+			stalls++;
+			pushed.Wait();
+		}
+		return batch;
+	}
+};
+
+static SetupUnit s_setupUnit;
+static Primitive s_primitive;
+static bool s_newPrimitive;
+
+static bool s_threaded;
+static std::unique_ptr<Batch[]> s_batches;
+// The batch being filled by the thread submitting vertices.
+static Batch *s_batch;
+static Link s_free;
+static Link s_toTransform;
+static Link s_toSetup;
+static std::thread s_transformThread;
+static std::thread s_setupThread;
+
+static void TransformVertices(const InputVertexData *src, OutputVertexData *dst, u32 count, const Primitive &primitive)
+{
+	TransformUnit::TransformVertices(src, dst, count, primitive.hasNormal, primitive.normalElements != 0, primitive.texGenSpecialCase);
+}
+
+// Calls func(primitive, begin, end) for the runs of vertices in the batch.
+template <typename Func>
+static void ForEachPrimitive(const Batch &batch, Func func)
+{
+	for (u32 i = 0; i < batch.numPrimitives; ++i)
+	{
+		const u32 end = i + 1 < batch.numPrimitives ? batch.primitives[i + 1].firstVertex : batch.numVertices;
+		func(batch.primitives[i], batch.primitives[i].firstVertex, end);
+	}
+}
+
+static void TransformThread()
+{
+	Common::SetCurrentThreadName("Software transform");
+
+	u32 stalls = 0;
+	while (Batch *batch = s_toTransform.Pop(stalls))
+	{
+		const u64 start = Common::Timer::GetTimeUs();
+		ForEachPrimitive(*batch, [batch](const Primitive &primitive, u32 begin, u32 end) {
+			TransformVertices(&batch->input[begin], &batch->output[begin], end - begin, primitive);
+		});
+		ADDSTAT(swstats.thisFrame.transformBusyUs, (u32)(Common::Timer::GetTimeUs() - start));
+		ADDSTAT(swstats.thisFrame.transformStalls, stalls);
+		stalls = 0;
+
+		s_toSetup.Push(batch);
+	}
+
+	// Pass the stop on.
+	s_toSetup.Push(nullptr);
+}
+
+static void SetupThread()
+{
+	Common::SetCurrentThreadName("Software setup");
+
+	u32 stalls = 0;
+	while (Batch *batch = s_toSetup.Pop(stalls))
+	{
+		const u64 start = Common::Timer::GetTimeUs();
+		ForEachPrimitive(*batch, [batch](const Primitive &primitive, u32 begin, u32 end) {
+			if (primitive.begins)
+				s_setupUnit.Init(primitive.primitiveType);
+			for (u32 i = begin; i < end; ++i)
+			{
+				memcpy(s_setupUnit.GetVertex(), &batch->output[i], sizeof(OutputVertexData));
+				s_setupUnit.SetupVertex();
+			}
+		});
+		ADDSTAT(swstats.thisFrame.setupBusyUs, (u32)(Common::Timer::GetTimeUs() - start));
+		ADDSTAT(swstats.thisFrame.setupStalls, stalls);
+		stalls = 0;
+
+		s_free.Push(batch);
+	}
+}
+
+static bool UseThreads()
+{
+	// The hardware rasterizer draws with OpenGL, which only works on this
+	// thread, and the debug dumps need each object drawn when it ends.
+	return g_SWVideoConfig.bThreadedPipeline && !g_SWVideoConfig.bHwRasterizer &&
+		!g_SWVideoConfig.bDumpObjects && !g_SWVideoConfig.bDumpTevStages && !g_SWVideoConfig.bDumpTevTextureFetches;
+}
+
+// Only call these with nothing in flight.
+static void StartThreads()
+{
+	if (!s_batches)
+		s_batches.reset(new Batch[NUM_BATCHES]);
+	for (u32 i = 0; i < NUM_BATCHES; ++i)
+		s_free.Push(&s_batches[i]);
+	s_batch = nullptr;
+
+	s_transformThread = std::thread(TransformThread);
+	s_setupThread = std::thread(SetupThread);
+	s_threaded = true;
+}
+
+static void StopThreads()
+{
+	s_toTransform.Push(nullptr);
+	s_transformThread.join();
+	s_setupThread.join();
+
+	Batch *batch;
+	while (s_free.queue.Pop(batch)) {}
+	s_batches.reset();
+	s_threaded = false;
+}
+
+static void SendBatch()
+{
+	if (s_batch->numVertices)
+	{
+		INCSTAT(swstats.thisFrame.pipelineBatches);
+		s_toTransform.Push(s_batch);
+		s_batch = nullptr;
+	}
+}
+
+// Waits for the threads to finish everything submitted.
+static void Drain()
+{
+	if (s_batch)
+	{
+		SendBatch();
+		// Nothing was submitted to it, so it goes back.
+		if (s_batch)
+		{
+			s_free.Push(s_batch);
+			s_batch = nullptr;
+		}
+	}
+
+	// Every batch comes back to the free queue once it's set up.
+	const u64 start = Common::Timer::GetTimeUs();
+	while (s_free.queue.Size() != NUM_BATCHES)
+		s_free.pushed.Wait();
+	ADDSTAT(swstats.thisFrame.flushWaitUs, (u32)(Common::Timer::GetTimeUs() - start));
+}
+
+void Init()
+{
+	s_primitive = Primitive();
+	s_newPrimitive = true;
+	s_threaded = false;
+	s_batch = nullptr;
+}
+
+void Shutdown()
+{
+	if (s_threaded)
+	{
+		Drain();
+		StopThreads();
+	}
+}
+
+void BeginPrimitive(u8 primitiveType, u8 normalElements, bool hasNormal, bool texGenSpecialCase)
+{
+	s_primitive.primitiveType = primitiveType;
+	s_primitive.normalElements = normalElements;
+	s_primitive.hasNormal = hasNormal;
+	s_primitive.texGenSpecialCase = texGenSpecialCase;
+	s_newPrimitive = true;
+}
+
+void SubmitVertex(const InputVertexData *vertex)
+{
+	if (!s_threaded)
+	{
+		if (s_newPrimitive)
+		{
+			s_setupUnit.Init(s_primitive.primitiveType);
+			s_newPrimitive = false;
+		}
+		TransformVertices(vertex, s_setupUnit.GetVertex(), 1, s_primitive);
+		s_setupUnit.SetupVertex();
+		return;
+	}
+
+	if (s_batch && (s_batch->numVertices == BATCH_SIZE || (s_newPrimitive && s_batch->numPrimitives == MAX_PRIMITIVES)))
+		SendBatch();
+
+	if (!s_batch)
+	{
+		u32 stalls = 0;
+		s_batch = s_free.Pop(stalls);
+		ADDSTAT(swstats.thisFrame.loaderStalls, stalls);
+		s_batch->numVertices = 0;
+		s_batch->numPrimitives = 0;
+	}
+
+	// A batch always starts with a primitive, continuing one if need be.
+	if (s_newPrimitive || s_batch->numPrimitives == 0)
+	{
+		Primitive &primitive = s_batch->primitives[s_batch->numPrimitives++];
+		primitive = s_primitive;
+		primitive.firstVertex = s_batch->numVertices;
+		primitive.begins = s_newPrimitive;
+		s_newPrimitive = false;
+	}
+
+	memcpy(&s_batch->input[s_batch->numVertices++], vertex, sizeof(InputVertexData));
+}
+
+void Flush()
+{
+	if (s_threaded)
+		Drain();
+
+	Rasterizer::Flush();
+
+	// Nothing is in flight, so this is the time to follow the setting.
+	if (s_threaded != UseThreads())
+	{
+		if (s_threaded)
+			StopThreads();
+		else
+			StartThreads();
+	}
+}
+
+void DoState(PointerWrap &p)
+{
+	Flush();
+	s_setupUnit.DoState(p);
+}
+
+}
@@ -0,0 +1,31 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include "Common/ChunkFile.h"
+#include "Common/Common.h"
+#include "VideoBackends/Software/NativeVertexFormat.h"
+
+// Takes loaded vertices through transform, setup and clipping to the
+// rasterizer. With g_SWVideoConfig.bThreadedPipeline, transform and setup
+// each run on a thread of their own, taking vertices in batches, so that
+// loading, transforming, setting up and drawing overlap. Everything still
+// happens in the order it was submitted.
+namespace Pipeline
+{
+	void Init();
+	void Shutdown();
+
+	// The vertices submitted from here on belong to a new primitive.
+	void BeginPrimitive(u8 primitiveType, u8 normalElements, bool hasNormal, bool texGenSpecialCase);
+	void SubmitVertex(const InputVertexData *vertex);
+
+	// Waits until everything submitted so far is drawn. Call it from the
+	// thread submitting vertices before anything that affects transforming
+	// or drawing changes, or anything reads the EFB.
+	void Flush();
+
+	void DoState(PointerWrap &p);
+}
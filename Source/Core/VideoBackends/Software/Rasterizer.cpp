@@ -2,21 +2,37 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include <memory>
+#include <vector>
+
 #include "Common/Common.h"
+#include "Common/CPUDetect.h"
+#include "Common/ParallelFor.h"
 
 #include "VideoBackends/Software/BPMemLoader.h"
 #include "VideoBackends/Software/EfbInterface.h"
 #include "VideoBackends/Software/HwRasterizer.h"
 #include "VideoBackends/Software/Rasterizer.h"
-#include "VideoBackends/Software/SWPixelEngine.h"
 #include "VideoBackends/Software/SWStatistics.h"
 #include "VideoBackends/Software/SWVideoConfig.h"
 #include "VideoBackends/Software/Tev.h"
 #include "VideoBackends/Software/XFMemLoader.h"
 
+#if _M_SSE >= 0x401
+#include <smmintrin.h>
+#endif
 
 #define BLOCK_SIZE 2
 
+// Screen tiles drawn by the threads. A multiple of BLOCK_SIZE, so that every
+// block is in one tile.
+#define TILE_SIZE 64
+#define TILES_X ((EFB_WIDTH + TILE_SIZE - 1) / TILE_SIZE)
+#define TILES_Y ((EFB_HEIGHT + TILE_SIZE - 1) / TILE_SIZE)
+
+// Triangles queued before they are drawn anyway.
+#define MAX_QUEUED_TRIANGLES 2048
+
 #define CLAMP(x, a, b) (x>b)?b:(x<a)?a:x
 
 // returns approximation of log2(f) in s28.4
@@ -32,54 +48,105 @@ static inline s32 FixedLog2(float f)
 
 namespace Rasterizer
 {
-Slope ZSlope;
-Slope WSlope;
-Slope ColorSlopes[2][4];
-Slope TexSlopes[8][3];
+// Everything needed to draw a triangle, worked out when it is submitted.
+struct Triangle
+{
+	Slope ZSlope;
+	Slope WSlope;
+	Slope ColorSlopes[2][4];
+	Slope TexSlopes[8][3];
+
+	// ColorSlopes again, with the components next to each other.
+	float ColorF0[2][4];
+	float ColorDfdx[2][4];
+	float ColorDfdy[2][4];
+
+	s32 vertex0X;
+	s32 vertex0Y;
+	float vertexOffsetX;
+	float vertexOffsetY;
+
+	// Vertices in 28.4 fixed point.
+	s32 X1, X2, X3;
+	s32 Y1, Y2, Y3;
+
+	// Blocks to look at. minx and miny are multiples of BLOCK_SIZE.
+	s32 minx, maxx, miny, maxy;
+};
+
+// The per-pixel state of one drawing thread.
+struct Worker
+{
+	Tev tev;
+	RasterBlock rasterBlock;
+};
 
-s32 vertex0X;
-s32 vertex0Y;
-float vertexOffsetX;
-float vertexOffsetY;
+// The triangle being set up. Its z slope is kept for zfreeze.
+static Triangle s_setup;
 
 s32 scissorLeft = 0;
 s32 scissorTop = 0;
 s32 scissorRight = 0;
 s32 scissorBottom = 0;
 
-Tev tev;
-RasterBlock rasterBlock;
+// The first worker is the video thread's, and the one in save states.
+static std::vector<std::unique_ptr<Worker>> s_workers;
+static std::unique_ptr<Common::WorkerPool> s_pool;
+
+// Triangles waiting to be drawn by the threads, and the ones touching each tile,
+// in the order they were submitted.
+static std::vector<Triangle> s_queue;
+static std::vector<u32> s_tile_triangles[TILES_X * TILES_Y];
 
 void DoState(PointerWrap &p)
 {
-	ZSlope.DoState(p);
-	WSlope.DoState(p);
-	for (auto& color_slopes_1d : ColorSlopes)
+	Flush();
+
+	s_setup.ZSlope.DoState(p);
+	s_setup.WSlope.DoState(p);
+	for (auto& color_slopes_1d : s_setup.ColorSlopes)
 		for (Slope& color_slope : color_slopes_1d)
 			color_slope.DoState(p);
-	for (auto& tex_slopes_1d : TexSlopes)
+	for (auto& tex_slopes_1d : s_setup.TexSlopes)
 		for (Slope& tex_slope : tex_slopes_1d)
 			tex_slope.DoState(p);
-	p.Do(vertex0X);
-	p.Do(vertex0Y);
-	p.Do(vertexOffsetX);
-	p.Do(vertexOffsetY);
+	p.Do(s_setup.vertex0X);
+	p.Do(s_setup.vertex0Y);
+	p.Do(s_setup.vertexOffsetX);
+	p.Do(s_setup.vertexOffsetY);
 	p.Do(scissorLeft);
 	p.Do(scissorTop);
 	p.Do(scissorRight);
 	p.Do(scissorBottom);
-	tev.DoState(p);
-	p.Do(rasterBlock);
+	s_workers[0]->tev.DoState(p);
+	p.Do(s_workers[0]->rasterBlock);
+
+	for (size_t i = 1; i < s_workers.size(); ++i)
+		s_workers[i]->tev.CopyState(s_workers[0]->tev);
 }
 
 void Init()
 {
-	tev.Init();
+	s_pool.reset();
+	s_queue.clear();
+	for (auto& tile : s_tile_triangles)
+		tile.clear();
+
+	s_workers.clear();
+	// Value-initialized, so the TEV registers start out as zero.
+	s_workers.emplace_back(new Worker());
+	s_workers[0]->tev.Init();
 
 	// Set initial z reference plane in the unlikely case that zfreeze is enabled when drawing the first primitive.
 	// TODO: This is just a guess!
-	ZSlope.dfdx = ZSlope.dfdy = 0.f;
-	ZSlope.f0 = 1.f;
+	s_setup.ZSlope.dfdx = s_setup.ZSlope.dfdy = 0.f;
+	s_setup.ZSlope.f0 = 1.f;
+}
+
+void Shutdown()
+{
+	s_pool.reset();
+	s_workers.resize(1);
 }
 
 inline int iround(float x)
@@ -113,31 +180,35 @@ void SetScissor()
 
 void SetTevReg(int reg, int comp, bool konst, s16 color)
 {
-	tev.SetRegColor(reg, comp, konst, color);
+	for (auto& worker : s_workers)
+		worker->tev.SetRegColor(reg, comp, konst, color);
 }
 
-inline void Draw(s32 x, s32 y, s32 xi, s32 yi)
+inline void Draw(const Triangle &tri, Worker &worker, s32 x, s32 y, s32 xi, s32 yi)
 {
-	INCSTAT(swstats.thisFrame.rasterizedPixels);
+	Tev &tev = worker.tev;
+	RasterBlock &rasterBlock = worker.rasterBlock;
 
-	float dx = vertexOffsetX + (float)(x - vertex0X);
-	float dy = vertexOffsetY + (float)(y - vertex0Y);
+	tev.Counts.rasterized++;
 
-	s32 z = (s32)ZSlope.GetValue(dx, dy);
+	float dx = tri.vertexOffsetX + (float)(x - tri.vertex0X);
+	float dy = tri.vertexOffsetY + (float)(y - tri.vertex0Y);
+
+	s32 z = (s32)tri.ZSlope.GetValue(dx, dy);
 	if (z < 0 || z > 0x00ffffff)
 		return;
 
 	if (bpmem.UseEarlyDepthTest() && g_SWVideoConfig.bZComploc)
 	{
 		// TODO: Test if perf regs are incremented even if test is disabled
-		SWPixelEngine::pereg.IncZInputQuadCount(true);
+		tev.Counts.zInput[1]++;
 		if (bpmem.zmode.testenable)
 		{
 			// early z
 			if (!EfbInterface::ZCompare(x, y, z))
 				return;
 		}
-		SWPixelEngine::pereg.IncZOutputQuadCount(true);
+		tev.Counts.zOutput[1]++;
 	}
 
 	RasterBlockPixel& pixel = rasterBlock.Pixel[xi][yi];
@@ -147,16 +218,40 @@ inline void Draw(s32 x, s32 y, s32 xi, s32 yi)
 	tev.Position[2] = z;
 
 	//  colors
-	for (unsigned int i = 0; i < bpmem.genMode.numcolchans; i++)
+#if _M_SSE >= 0x401
+	if (cpu_info.bSSE4_1)
 	{
-		for (int comp = 0; comp < 4; comp++)
+		const __m128 vdx = _mm_set1_ps(dx);
+		const __m128 vdy = _mm_set1_ps(dy);
+		const __m128i low16 = _mm_set1_epi32(0xffff);
+		const __m128i low_bytes = _mm_setr_epi8(0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+		for (unsigned int i = 0; i < bpmem.genMode.numcolchans; i++)
+		{
+			__m128 value = _mm_add_ps(_mm_loadu_ps(tri.ColorF0[i]), _mm_mul_ps(_mm_loadu_ps(tri.ColorDfdx[i]), vdx));
+			value = _mm_add_ps(value, _mm_mul_ps(_mm_loadu_ps(tri.ColorDfdy[i]), vdy));
+
+			// Same as below, in 32 bit lanes.
+			__m128i color = _mm_and_si128(_mm_cvttps_epi32(value), low16);
+			color = _mm_and_si128(color, _mm_andnot_si128(_mm_srli_epi32(color, 8), low16));
+
+			u32 packed = _mm_cvtsi128_si32(_mm_shuffle_epi8(color, low_bytes));
+			memcpy(tev.Color[i], &packed, sizeof(packed));
+		}
+	}
+	else
+#endif
+	{
+		for (unsigned int i = 0; i < bpmem.genMode.numcolchans; i++)
 		{
-			u16 color = (u16)ColorSlopes[i][comp].GetValue(dx, dy);
+			for (int comp = 0; comp < 4; comp++)
+			{
+				u16 color = (u16)tri.ColorSlopes[i][comp].GetValue(dx, dy);
 
-			// clamp color value to 0
-			u16 mask = ~(color >> 8);
+				// clamp color value to 0
+				u16 mask = ~(color >> 8);
 
-			tev.Color[i][comp] = color & mask;
+				tev.Color[i][comp] = color & mask;
+			}
 		}
 	}
 
@@ -183,16 +278,16 @@ inline void Draw(s32 x, s32 y, s32 xi, s32 yi)
 	tev.Draw();
 }
 
-void InitTriangle(float X1, float Y1, s32 xi, s32 yi)
+void InitTriangle(Triangle *tri, float X1, float Y1, s32 xi, s32 yi)
 {
-	vertex0X = xi;
-	vertex0Y = yi;
+	tri->vertex0X = xi;
+	tri->vertex0Y = yi;
 
 	// adjust a little less than 0.5
 	const float adjust = 0.495f;
 
-	vertexOffsetX = ((float)xi - X1) + adjust;
-	vertexOffsetY = ((float)yi - Y1) + adjust;
+	tri->vertexOffsetX = ((float)xi - X1) + adjust;
+	tri->vertexOffsetY = ((float)yi - Y1) + adjust;
 }
 
 void InitSlope(Slope *slope, float f1, float f2, float f3, float DX31, float DX12, float DY12, float DY31)
@@ -207,7 +302,7 @@ void InitSlope(Slope *slope, float f1, float f2, float f3, float DX31, float DX1
 	slope->f0 = f1;
 }
 
-inline void CalculateLOD(s32 &lod, bool &linear, u32 texmap, u32 texcoord)
+inline void CalculateLOD(const RasterBlock &rasterBlock, s32 &lod, bool &linear, u32 texmap, u32 texcoord)
 {
 	FourTexUnits& texUnit = bpmem.tex[(texmap >> 2) & 1];
 	u8 subTexmap = texmap & 3;
@@ -220,17 +315,17 @@ inline void CalculateLOD(s32 &lod, bool &linear, u32 texmap, u32 texcoord)
 	float sDelta, tDelta;
 	if (tm0.diag_lod)
 	{
-		float *uv0 = rasterBlock.Pixel[0][0].Uv[texcoord];
-		float *uv1 = rasterBlock.Pixel[1][1].Uv[texcoord];
+		const float *uv0 = rasterBlock.Pixel[0][0].Uv[texcoord];
+		const float *uv1 = rasterBlock.Pixel[1][1].Uv[texcoord];
 
 		sDelta = fabsf(uv0[0] - uv1[0]);
 		tDelta = fabsf(uv0[1] - uv1[1]);
 	}
 	else
 	{
-		float *uv0 = rasterBlock.Pixel[0][0].Uv[texcoord];
-		float *uv1 = rasterBlock.Pixel[1][0].Uv[texcoord];
-		float *uv2 = rasterBlock.Pixel[0][1].Uv[texcoord];
+		const float *uv0 = rasterBlock.Pixel[0][0].Uv[texcoord];
+		const float *uv1 = rasterBlock.Pixel[1][0].Uv[texcoord];
+		const float *uv2 = rasterBlock.Pixel[0][1].Uv[texcoord];
 
 		sDelta = max(fabsf(uv0[0] - uv1[0]), fabsf(uv0[0] - uv2[0]));
 		tDelta = max(fabsf(uv0[1] - uv1[1]), fabsf(uv0[1] - uv2[1]));
@@ -253,18 +348,68 @@ inline void CalculateLOD(s32 &lod, bool &linear, u32 texmap, u32 texcoord)
 	lod = CLAMP(lod, (s32)tm1.min_lod, (s32)tm1.max_lod);
 }
 
-void BuildBlock(s32 blockX, s32 blockY)
+#if _M_SSE >= 0x401
+static inline __m128 GetValues(const Slope &slope, __m128 dx, __m128 dy)
 {
+	__m128 value = _mm_add_ps(_mm_set1_ps(slope.f0), _mm_mul_ps(_mm_set1_ps(slope.dfdx), dx));
+	return _mm_add_ps(value, _mm_mul_ps(_mm_set1_ps(slope.dfdy), dy));
+}
+
+// The loop in BuildBlock, with the four pixels of the block in the lanes.
+static void BuildBlockPixelsSSE4(const Triangle &tri, RasterBlock &rasterBlock, s32 blockX, s32 blockY)
+{
+	static_assert(BLOCK_SIZE == 2, "A lane per pixel");
+
+	const s32 x = blockX - tri.vertex0X;
+	const s32 y = blockY - tri.vertex0Y;
+	const __m128 dx = _mm_add_ps(_mm_set1_ps(tri.vertexOffsetX), _mm_cvtepi32_ps(_mm_setr_epi32(x, x + 1, x, x + 1)));
+	const __m128 dy = _mm_add_ps(_mm_set1_ps(tri.vertexOffsetY), _mm_cvtepi32_ps(_mm_setr_epi32(y, y, y + 1, y + 1)));
+
+	const __m128 invW = _mm_div_ps(_mm_set1_ps(1.0f), GetValues(tri.WSlope, dx, dy));
+
+	float values[3][4];
+	_mm_storeu_ps(values[0], invW);
+	for (int lane = 0; lane < 4; lane++)
+		rasterBlock.Pixel[lane & 1][lane >> 1].InvW = values[0][lane];
+
+	for (unsigned int i = 0; i < bpmem.genMode.numtexgens; i++)
+	{
+		__m128 projection = invW;
+		if (swxfregs.texMtxInfo[i].projection)
+		{
+			__m128 q = _mm_mul_ps(GetValues(tri.TexSlopes[i][2], dx, dy), invW);
+			projection = _mm_blendv_ps(invW, _mm_div_ps(invW, q), _mm_cmpneq_ps(q, _mm_setzero_ps()));
+		}
+
+		_mm_storeu_ps(values[1], _mm_mul_ps(GetValues(tri.TexSlopes[i][0], dx, dy), projection));
+		_mm_storeu_ps(values[2], _mm_mul_ps(GetValues(tri.TexSlopes[i][1], dx, dy), projection));
+		for (int lane = 0; lane < 4; lane++)
+		{
+			RasterBlockPixel& pixel = rasterBlock.Pixel[lane & 1][lane >> 1];
+			pixel.Uv[i][0] = values[1][lane];
+			pixel.Uv[i][1] = values[2][lane];
+		}
+	}
+}
+#endif
+
+void BuildBlock(const Triangle &tri, RasterBlock &rasterBlock, s32 blockX, s32 blockY)
+{
+#if _M_SSE >= 0x401
+	if (cpu_info.bSSE4_1)
+		BuildBlockPixelsSSE4(tri, rasterBlock, blockX, blockY);
+	else
+#endif
 	for (s32 yi = 0; yi < BLOCK_SIZE; yi++)
 	{
 		for (s32 xi = 0; xi < BLOCK_SIZE; xi++)
 		{
 			RasterBlockPixel& pixel = rasterBlock.Pixel[xi][yi];
 
-			float dx = vertexOffsetX + (float)(xi + blockX - vertex0X);
-			float dy = vertexOffsetY + (float)(yi + blockY - vertex0Y);
+			float dx = tri.vertexOffsetX + (float)(xi + blockX - tri.vertex0X);
+			float dy = tri.vertexOffsetY + (float)(yi + blockY - tri.vertex0Y);
 
-			float invW = 1.0f / WSlope.GetValue(dx, dy);
+			float invW = 1.0f / tri.WSlope.GetValue(dx, dy);
 			pixel.InvW = invW;
 
 			// tex coords
@@ -273,13 +418,13 @@ void BuildBlock(s32 blockX, s32 blockY)
 				float projection = invW;
 				if (swxfregs.texMtxInfo[i].projection)
 				{
-					float q = TexSlopes[i][2].GetValue(dx, dy) * invW;
+					float q = tri.TexSlopes[i][2].GetValue(dx, dy) * invW;
 					if (q != 0.0f)
 						projection = invW / q;
 				}
 
-				pixel.Uv[i][0] = TexSlopes[i][0].GetValue(dx, dy) * projection;
-				pixel.Uv[i][1] = TexSlopes[i][1].GetValue(dx, dy) * projection;
+				pixel.Uv[i][0] = tri.TexSlopes[i][0].GetValue(dx, dy) * projection;
+				pixel.Uv[i][1] = tri.TexSlopes[i][1].GetValue(dx, dy) * projection;
 			}
 		}
 	}
@@ -292,7 +437,7 @@ void BuildBlock(s32 blockX, s32 blockY)
 		u32 texcoord = indref & 3;
 		indref >>= 3;
 
-		CalculateLOD(rasterBlock.IndirectLod[i], rasterBlock.IndirectLinear[i], texmap, texcoord);
+		CalculateLOD(rasterBlock, rasterBlock.IndirectLod[i], rasterBlock.IndirectLinear[i], texmap, texcoord);
 	}
 
 	for (unsigned int i = 0; i <= bpmem.genMode.numtevstages; i++)
@@ -304,32 +449,17 @@ void BuildBlock(s32 blockX, s32 blockY)
 			u32 texmap = order.getTexMap(stageOdd);
 			u32 texcoord = order.getTexCoord(stageOdd);
 
-			CalculateLOD(rasterBlock.TextureLod[i], rasterBlock.TextureLinear[i], texmap, texcoord);
+			CalculateLOD(rasterBlock, rasterBlock.TextureLod[i], rasterBlock.TextureLinear[i], texmap, texcoord);
 		}
 	}
 }
 
-void DrawTriangleFrontFace(OutputVertexData *v0, OutputVertexData *v1, OutputVertexData *v2)
+// Draws the part of a triangle whose blocks start inside the given rectangle,
+// which has to start on a block boundary.
+static void DrawTriangle(const Triangle &tri, Worker &worker, s32 left, s32 top, s32 right, s32 bottom)
 {
-	INCSTAT(swstats.thisFrame.numTrianglesDrawn);
-
-	if (g_SWVideoConfig.bHwRasterizer)
-	{
-		HwRasterizer::DrawTriangleFrontFace(v0, v1, v2);
-		return;
-	}
-
-	// adapted from http://www.devmaster.net/forums/showthread.php?t=1884
-
-	// 28.4 fixed-pou32 coordinates. rounded to nearest and adjusted to match hardware output
-	// could also take floor and adjust -8
-	const s32 Y1 = iround(16.0f * v0->screenPosition[1]) - 9;
-	const s32 Y2 = iround(16.0f * v1->screenPosition[1]) - 9;
-	const s32 Y3 = iround(16.0f * v2->screenPosition[1]) - 9;
-
-	const s32 X1 = iround(16.0f * v0->screenPosition[0]) - 9;
-	const s32 X2 = iround(16.0f * v1->screenPosition[0]) - 9;
-	const s32 X3 = iround(16.0f * v2->screenPosition[0]) - 9;
+	const s32 X1 = tri.X1, X2 = tri.X2, X3 = tri.X3;
+	const s32 Y1 = tri.Y1, Y2 = tri.Y2, Y3 = tri.Y3;
 
 	// Deltas
 	const s32 DX12 = X1 - X2;
@@ -349,57 +479,6 @@ void DrawTriangleFrontFace(OutputVertexData *v0, OutputVertexData *v1, OutputVer
 	const s32 FDY23 = DY23 << 4;
 	const s32 FDY31 = DY31 << 4;
 
-	// Bounding rectangle
-	s32 minx = (min(min(X1, X2), X3) + 0xF) >> 4;
-	s32 maxx = (max(max(X1, X2), X3) + 0xF) >> 4;
-	s32 miny = (min(min(Y1, Y2), Y3) + 0xF) >> 4;
-	s32 maxy = (max(max(Y1, Y2), Y3) + 0xF) >> 4;
-
-	// scissor
-	minx = max(minx, scissorLeft);
-	maxx = min(maxx, scissorRight);
-	miny = max(miny, scissorTop);
-	maxy = min(maxy, scissorBottom);
-
-	if (minx >= maxx || miny >= maxy)
-		return;
-
-	// Setup slopes
-	float fltx1 = v0->screenPosition.x;
-	float flty1 = v0->screenPosition.y;
-	float fltdx31 = v2->screenPosition.x - fltx1;
-	float fltdx12 = fltx1 - v1->screenPosition.x;
-	float fltdy12 = flty1 - v1->screenPosition.y;
-	float fltdy31 = v2->screenPosition.y - flty1;
-
-	InitTriangle(fltx1, flty1, (X1 + 0xF) >> 4, (Y1 + 0xF) >> 4);
-
-	float w[3] = { 1.0f / v0->projectedPosition.w, 1.0f / v1->projectedPosition.w, 1.0f / v2->projectedPosition.w };
-	InitSlope(&WSlope, w[0], w[1], w[2], fltdx31, fltdx12, fltdy12, fltdy31);
-
-	// TODO: The zfreeze emulation is not quite correct, yet!
-	// Many things might prevent us from reaching this line (culling, clipping, scissoring).
-	// However, the zslope is always guaranteed to be calculated unless all vertices are trivially rejected during clipping!
-	// We're currently sloppy at this since we abort early if any of the culling/clipping/scissoring tests fail.
-	if (!bpmem.genMode.zfreeze || !g_SWVideoConfig.bZFreeze)
-		InitSlope(&ZSlope, v0->screenPosition[2], v1->screenPosition[2], v2->screenPosition[2], fltdx31, fltdx12, fltdy12, fltdy31);
-
-	for (unsigned int i = 0; i < bpmem.genMode.numcolchans; i++)
-	{
-		for (int comp = 0; comp < 4; comp++)
-			InitSlope(&ColorSlopes[i][comp], v0->color[i][comp], v1->color[i][comp], v2->color[i][comp], fltdx31, fltdx12, fltdy12, fltdy31);
-	}
-
-	for (unsigned int i = 0; i < bpmem.genMode.numtexgens; i++)
-	{
-		for (int comp = 0; comp < 3; comp++)
-			InitSlope(&TexSlopes[i][comp], v0->texCoords[i][comp] * w[0], v1->texCoords[i][comp] * w[1], v2->texCoords[i][comp] * w[2], fltdx31, fltdx12, fltdy12, fltdy31);
-	}
-
-	// Start in corner of 8x8 block
-	minx &= ~(BLOCK_SIZE - 1);
-	miny &= ~(BLOCK_SIZE - 1);
-
 	// Half-edge constants
 	s32 C1 = DY12 * X1 - DX12 * Y1;
 	s32 C2 = DY23 * X2 - DX23 * Y2;
@@ -410,6 +489,11 @@ void DrawTriangleFrontFace(OutputVertexData *v0, OutputVertexData *v1, OutputVer
 	if (DY23 < 0 || (DY23 == 0 && DX23 > 0)) C2++;
 	if (DY31 < 0 || (DY31 == 0 && DX31 > 0)) C3++;
 
+	const s32 minx = max(tri.minx, left);
+	const s32 maxx = min(tri.maxx, right);
+	const s32 miny = max(tri.miny, top);
+	const s32 maxy = min(tri.maxy, bottom);
+
 	// Loop through blocks
 	for (s32 y = miny; y < maxy; y += BLOCK_SIZE)
 	{
@@ -444,7 +528,7 @@ void DrawTriangleFrontFace(OutputVertexData *v0, OutputVertexData *v1, OutputVer
 			if (a == 0x0 || b == 0x0 || c == 0x0)
 				continue;
 
-			BuildBlock(x, y);
+			BuildBlock(tri, worker.rasterBlock, x, y);
 
 			// Accept whole block when totally covered
 			if (a == 0xF && b == 0xF && c == 0xF)
@@ -453,7 +537,7 @@ void DrawTriangleFrontFace(OutputVertexData *v0, OutputVertexData *v1, OutputVer
 				{
 					for (s32 ix = 0; ix < BLOCK_SIZE; ix++)
 					{
-						Draw(x + ix, y + iy, ix, iy);
+						Draw(tri, worker, x + ix, y + iy, ix, iy);
 					}
 				}
 			}
@@ -473,7 +557,7 @@ void DrawTriangleFrontFace(OutputVertexData *v0, OutputVertexData *v1, OutputVer
 					{
 						if (CX1 > 0 && CX2 > 0 && CX3 > 0)
 						{
-							Draw(x + ix, y + iy, ix, iy);
+							Draw(tri, worker, x + ix, y + iy, ix, iy);
 						}
 
 						CX1 -= FDY12;
@@ -490,5 +574,164 @@ void DrawTriangleFrontFace(OutputVertexData *v0, OutputVertexData *v1, OutputVer
 	}
 }
 
+static u32 GetNumThreads()
+{
+	// The debug dumps draw into shared buffers, and object dumps need each
+	// object drawn when it ends.
+	if (g_SWVideoConfig.bDumpTevStages || g_SWVideoConfig.bDumpTevTextureFetches || g_SWVideoConfig.bDumpObjects)
+		return 1;
+
+	return g_SWVideoConfig.rasterizerThreads ? g_SWVideoConfig.rasterizerThreads : Common::GetNumWorkerThreads();
+}
+
+// Only call with an empty queue.
+static void SetNumThreads(u32 num_threads)
+{
+	if (s_workers.size() == num_threads)
+		return;
+
+	s_pool.reset();
+	if (num_threads > 1)
+		s_pool.reset(new Common::WorkerPool(num_threads));
+
+	s_workers.resize(1);
+	while (s_workers.size() < num_threads)
+	{
+		Worker *worker = new Worker();
+		worker->tev.Init();
+		worker->tev.CopyState(s_workers[0]->tev);
+		s_workers.emplace_back(worker);
+	}
+}
+
+void DrawTriangleFrontFace(OutputVertexData *v0, OutputVertexData *v1, OutputVertexData *v2)
+{
+	INCSTAT(swstats.thisFrame.numTrianglesDrawn);
+
+	if (g_SWVideoConfig.bHwRasterizer)
+	{
+		HwRasterizer::DrawTriangleFrontFace(v0, v1, v2);
+		return;
+	}
+
+	Triangle &tri = s_setup;
+
+	// adapted from http://www.devmaster.net/forums/showthread.php?t=1884
+
+	// 28.4 fixed-pou32 coordinates. rounded to nearest and adjusted to match hardware output
+	// could also take floor and adjust -8
+	const s32 Y1 = tri.Y1 = iround(16.0f * v0->screenPosition[1]) - 9;
+	const s32 Y2 = tri.Y2 = iround(16.0f * v1->screenPosition[1]) - 9;
+	const s32 Y3 = tri.Y3 = iround(16.0f * v2->screenPosition[1]) - 9;
+
+	const s32 X1 = tri.X1 = iround(16.0f * v0->screenPosition[0]) - 9;
+	const s32 X2 = tri.X2 = iround(16.0f * v1->screenPosition[0]) - 9;
+	const s32 X3 = tri.X3 = iround(16.0f * v2->screenPosition[0]) - 9;
+
+	// Bounding rectangle
+	s32 minx = (min(min(X1, X2), X3) + 0xF) >> 4;
+	s32 maxx = (max(max(X1, X2), X3) + 0xF) >> 4;
+	s32 miny = (min(min(Y1, Y2), Y3) + 0xF) >> 4;
+	s32 maxy = (max(max(Y1, Y2), Y3) + 0xF) >> 4;
+
+	// scissor
+	minx = max(minx, scissorLeft);
+	maxx = min(maxx, scissorRight);
+	miny = max(miny, scissorTop);
+	maxy = min(maxy, scissorBottom);
+
+	if (minx >= maxx || miny >= maxy)
+		return;
+
+	// Setup slopes
+	float fltx1 = v0->screenPosition.x;
+	float flty1 = v0->screenPosition.y;
+	float fltdx31 = v2->screenPosition.x - fltx1;
+	float fltdx12 = fltx1 - v1->screenPosition.x;
+	float fltdy12 = flty1 - v1->screenPosition.y;
+	float fltdy31 = v2->screenPosition.y - flty1;
+
+	InitTriangle(&tri, fltx1, flty1, (X1 + 0xF) >> 4, (Y1 + 0xF) >> 4);
+
+	float w[3] = { 1.0f / v0->projectedPosition.w, 1.0f / v1->projectedPosition.w, 1.0f / v2->projectedPosition.w };
+	InitSlope(&tri.WSlope, w[0], w[1], w[2], fltdx31, fltdx12, fltdy12, fltdy31);
+
+	// TODO: The zfreeze emulation is not quite correct, yet!
+	// Many things might prevent us from reaching this line (culling, clipping, scissoring).
+	// However, the zslope is always guaranteed to be calculated unless all vertices are trivially rejected during clipping!
+	// We're currently sloppy at this since we abort early if any of the culling/clipping/scissoring tests fail.
+	if (!bpmem.genMode.zfreeze || !g_SWVideoConfig.bZFreeze)
+		InitSlope(&tri.ZSlope, v0->screenPosition[2], v1->screenPosition[2], v2->screenPosition[2], fltdx31, fltdx12, fltdy12, fltdy31);
+
+	for (unsigned int i = 0; i < bpmem.genMode.numcolchans; i++)
+	{
+		for (int comp = 0; comp < 4; comp++)
+		{
+			Slope &slope = tri.ColorSlopes[i][comp];
+			InitSlope(&slope, v0->color[i][comp], v1->color[i][comp], v2->color[i][comp], fltdx31, fltdx12, fltdy12, fltdy31);
+			tri.ColorF0[i][comp] = slope.f0;
+			tri.ColorDfdx[i][comp] = slope.dfdx;
+			tri.ColorDfdy[i][comp] = slope.dfdy;
+		}
+	}
+
+	for (unsigned int i = 0; i < bpmem.genMode.numtexgens; i++)
+	{
+		for (int comp = 0; comp < 3; comp++)
+			InitSlope(&tri.TexSlopes[i][comp], v0->texCoords[i][comp] * w[0], v1->texCoords[i][comp] * w[1], v2->texCoords[i][comp] * w[2], fltdx31, fltdx12, fltdy12, fltdy31);
+	}
+
+	// Start in corner of 8x8 block
+	tri.minx = minx & ~(BLOCK_SIZE - 1);
+	tri.miny = miny & ~(BLOCK_SIZE - 1);
+	tri.maxx = maxx;
+	tri.maxy = maxy;
+
+	if (s_queue.empty())
+		SetNumThreads(GetNumThreads());
+
+	if (s_workers.size() == 1)
+	{
+		DrawTriangle(tri, *s_workers[0], 0, 0, EFB_WIDTH, EFB_HEIGHT);
+		s_workers[0]->tev.ApplyCounts();
+		return;
+	}
+
+	// Queue the triangle in every tile its blocks start in. Blocks don't
+	// cross tiles, so they are the same as if the triangle was drawn at once.
+	const u32 index = (u32)s_queue.size();
+	s_queue.push_back(tri);
+	for (s32 ty = tri.miny / TILE_SIZE; ty <= (tri.maxy - 1) / TILE_SIZE; ty++)
+	{
+		for (s32 tx = tri.minx / TILE_SIZE; tx <= (tri.maxx - 1) / TILE_SIZE; tx++)
+			s_tile_triangles[ty * TILES_X + tx].push_back(index);
+	}
+
+	if (s_queue.size() >= MAX_QUEUED_TRIANGLES)
+		Flush();
+}
+
+void Flush()
+{
+	if (s_queue.empty())
+		return;
+
+	// Each tile is drawn by one thread, with its triangles in the order they
+	// came in, so every pixel sees the same sequence of writes as when
+	// drawing them one by one.
+	s_pool->ParallelFor(TILES_X * TILES_Y, [](u32 tile, u32 worker) {
+		const s32 left = (tile % TILES_X) * TILE_SIZE;
+		const s32 top = (tile / TILES_X) * TILE_SIZE;
+		for (u32 index : s_tile_triangles[tile])
+			DrawTriangle(s_queue[index], *s_workers[worker], left, top, left + TILE_SIZE, top + TILE_SIZE);
+	});
+
+	for (auto& worker : s_workers)
+		worker->tev.ApplyCounts();
+
+	s_queue.clear();
+	for (auto& tile : s_tile_triangles)
+		tile.clear();
+}
 
 }
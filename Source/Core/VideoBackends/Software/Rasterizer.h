@@ -10,8 +10,13 @@
 namespace Rasterizer
 {
 	void Init();
+	void Shutdown();
 
+	// With more than one thread, triangles are queued and drawn later by all
+	// of them at once. Flush draws the queued ones; Pipeline::Flush calls it
+	// once the triangles still on their way here are queued too.
 	void DrawTriangleFrontFace(OutputVertexData *v0, OutputVertexData *v1, OutputVertexData *v2);
+	void Flush();
 
 	void SetScissor();
 
@@ -23,7 +28,7 @@ namespace Rasterizer
 		float dfdy;
 		float f0;
 
-		float GetValue(float dx, float dy) { return f0 + (dfdx * dx) + (dfdy * dy); }
+		float GetValue(float dx, float dy) const { return f0 + (dfdx * dx) + (dfdy * dy); }
 		void DoState(PointerWrap &p)
 		{
 			p.Do(dfdx);
@@ -17,6 +17,7 @@
 #include "Core/HW/ProcessorInterface.h"
 
 #include "VideoBackends/Software/OpcodeDecoder.h"
+#include "VideoBackends/Software/Pipeline.h"
 #include "VideoBackends/Software/SWCommandProcessor.h"
 #include "VideoBackends/Software/VideoBackend.h"
 
@@ -329,6 +330,9 @@ bool RunBuffer()
 		availableBytes = writePos - readPos;
 	}
 
+	// Everything sent so far is drawn when the GPU goes idle.
+	Pipeline::Flush();
+
 	cpreg.status.CommandIdle = 1;
 
 	bool ranDecoder = false;
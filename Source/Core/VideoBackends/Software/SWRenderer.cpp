@@ -143,6 +143,18 @@ void SWRenderer::DrawDebugText()
 		p+=sprintf(p,"Rasterized Pix:   %i\n",swstats.thisFrame.rasterizedPixels);
 		p+=sprintf(p,"TEV Pix In:   %i\n",swstats.thisFrame.tevPixelsIn);
 		p+=sprintf(p,"TEV Pix Out:   %i\n",swstats.thisFrame.tevPixelsOut);
+
+		p+=sprintf(p,"Texture Cache Hits:   %i\n",swstats.thisFrame.textureCacheHits);
+		p+=sprintf(p,"Texture Cache Misses:   %i\n",swstats.thisFrame.textureCacheMisses);
+
+		if (swstats.thisFrame.pipelineBatches)
+		{
+			p+=sprintf(p,"Pipeline Batches:   %i\n",swstats.thisFrame.pipelineBatches);
+			p+=sprintf(p,"Transform Busy:   %i us, %i stalls\n",swstats.thisFrame.transformBusyUs,swstats.thisFrame.transformStalls);
+			p+=sprintf(p,"Setup Busy:   %i us, %i stalls\n",swstats.thisFrame.setupBusyUs,swstats.thisFrame.setupStalls);
+			p+=sprintf(p,"Loader Stalls:   %i\n",swstats.thisFrame.loaderStalls);
+			p+=sprintf(p,"Flush Wait:   %i us\n",swstats.thisFrame.flushWaitUs);
+		}
 	}
 
 	// Render a shadow, and then the text.
@@ -25,6 +25,19 @@ struct SWStatistics
 		u32 rasterizedPixels;
 		u32 tevPixelsIn;
 		u32 tevPixelsOut;
+
+		u32 textureCacheHits;
+		u32 textureCacheMisses;
+
+		// Threaded pipeline: time each stage spent working and waiting, and
+		// how often a stage found nothing to do.
+		u32 pipelineBatches;
+		u32 transformBusyUs;
+		u32 setupBusyUs;
+		u32 flushWaitUs;
+		u32 loaderStalls;
+		u32 transformStalls;
+		u32 setupStalls;
 	};
 
 	u32 frameCount;
@@ -5,10 +5,9 @@
 #include "Common/Common.h"
 
 #include "VideoBackends/Software/CPMemLoader.h"
-#include "VideoBackends/Software/SetupUnit.h"
+#include "VideoBackends/Software/Pipeline.h"
 #include "VideoBackends/Software/SWStatistics.h"
 #include "VideoBackends/Software/SWVertexLoader.h"
-#include "VideoBackends/Software/TransformUnit.h"
 #include "VideoBackends/Software/XFMemLoader.h"
 
 #include "VideoCommon/DataReader.h"
@@ -33,14 +32,10 @@ SWVertexLoader::SWVertexLoader() :
 	VertexLoader_Normal::Init();
 	VertexLoader_Position::Init();
 	VertexLoader_TextCoord::Init();
-
-	m_SetupUnit = new SetupUnit;
  }
 
 SWVertexLoader::~SWVertexLoader()
 {
-	delete m_SetupUnit;
-	m_SetupUnit = nullptr;
 }
 
 void SWVertexLoader::SetFormat(u8 attributeIndex, u8 primitiveType)
@@ -244,7 +239,7 @@ void SWVertexLoader::SetFormat(u8 attributeIndex, u8 primitiveType)
 		(g_VtxDesc.Tex0Coord != NOT_PRESENT) &&
 		(swxfregs.texMtxInfo[0].projection == XF_TEXPROJ_ST);
 
-	m_SetupUnit->Init(primitiveType);
+	Pipeline::BeginPrimitive(primitiveType, m_CurrentVat->g0.NormalElements, g_VtxDesc.Normal != NOT_PRESENT, m_TexGenSpecialCase);
 }
 
 
@@ -253,21 +248,7 @@ void SWVertexLoader::LoadVertex()
 	for (int i = 0; i < m_NumAttributeLoaders; i++)
 		m_AttributeLoaders[i].loader(this, &m_Vertex, m_AttributeLoaders[i].index);
 
-	OutputVertexData* outVertex = m_SetupUnit->GetVertex();
-
-	// transform input data
-	TransformUnit::TransformPosition(&m_Vertex, outVertex);
-
-	if (g_VtxDesc.Normal != NOT_PRESENT)
-	{
-		TransformUnit::TransformNormal(&m_Vertex, m_CurrentVat->g0.NormalElements, outVertex);
-	}
-
-	TransformUnit::TransformColor(&m_Vertex, outVertex);
-
-	TransformUnit::TransformTexCoord(&m_Vertex, outVertex, m_TexGenSpecialCase);
-
-	m_SetupUnit->SetupVertex();
+	Pipeline::SubmitVertex(&m_Vertex);
 
 	INCSTAT(swstats.thisFrame.numVerticesLoaded)
 }
@@ -328,6 +309,6 @@ void SWVertexLoader::DoState(PointerWrap &p)
 	p.Do(m_normalLoader);
 	p.DoArray(m_colorLoader, sizeof m_colorLoader);
 	p.Do(m_NumAttributeLoaders);
-	m_SetupUnit->DoState(p);
+	Pipeline::DoState(p);
 	p.Do(m_TexGenSpecialCase);
 }
@@ -10,8 +10,6 @@
 #include "VideoBackends/Software/CPMemLoader.h"
 #include "VideoBackends/Software/NativeVertexFormat.h"
 
-class SetupUnit;
-
 class SWVertexLoader
 {
 	u32 m_VertexSize;
@@ -43,8 +41,6 @@ class SWVertexLoader
 	static void LoadColor(SWVertexLoader *vertexLoader, InputVertexData *vertex, u8 index);
 	static void LoadTexCoord(SWVertexLoader *vertexLoader, InputVertexData *vertex, u8 index);
 
-	SetupUnit *m_SetupUnit;
-
 	bool m_TexGenSpecialCase;
 
 public:
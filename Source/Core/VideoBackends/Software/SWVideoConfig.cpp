@@ -16,6 +16,10 @@ SWVideoConfig::SWVideoConfig()
 
 	bHwRasterizer = false;
 	bBypassXFB = false;
+	rasterizerThreads = 0;
+	textureCacheSize = 64;
+	bTevJit = true;
+	bThreadedPipeline = true;
 
 	bShowStats = false;
 
@@ -43,6 +47,10 @@ void SWVideoConfig::Load(const char* ini_file)
 
 	iniFile.Get("Rendering", "HwRasterizer", &bHwRasterizer, false);
 	iniFile.Get("Rendering", "BypassXFB", &bBypassXFB, false);
+	iniFile.Get("Rendering", "RasterizerThreads", &rasterizerThreads, 0);
+	iniFile.Get("Rendering", "TextureCacheSize", &textureCacheSize, 64);
+	iniFile.Get("Rendering", "TevJit", &bTevJit, true);
+	iniFile.Get("Rendering", "ThreadedPipeline", &bThreadedPipeline, true);
 	iniFile.Get("Rendering", "ZComploc", &bZComploc, true);
 	iniFile.Get("Rendering", "ZFreeze", &bZFreeze, true);
 
@@ -68,6 +76,10 @@ void SWVideoConfig::Save(const char* ini_file)
 
 	iniFile.Set("Rendering", "HwRasterizer", bHwRasterizer);
 	iniFile.Set("Rendering", "BypassXFB", bBypassXFB);
+	iniFile.Set("Rendering", "RasterizerThreads", rasterizerThreads);
+	iniFile.Set("Rendering", "TextureCacheSize", textureCacheSize);
+	iniFile.Set("Rendering", "TevJit", bTevJit);
+	iniFile.Set("Rendering", "ThreadedPipeline", bThreadedPipeline);
 	iniFile.Set("Rendering", "ZComploc", bZComploc);
 	iniFile.Set("Rendering", "ZFreeze", bZFreeze);
 
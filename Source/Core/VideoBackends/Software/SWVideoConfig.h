@@ -22,6 +22,14 @@ struct SWVideoConfig : NonCopyable
 
 	bool bHwRasterizer;
 	bool bBypassXFB;
+	// 0 uses all cores.
+	u32 rasterizerThreads;
+	// Decoded texture cache size in MB, 0 turns the cache off.
+	u32 textureCacheSize;
+	// Compile the TEV stages to machine code instead of interpreting them.
+	bool bTevJit;
+	// Transform and set up vertices on threads of their own.
+	bool bThreadedPipeline;
 
 	// Emulation features
 	bool bZComploc;
@@ -22,6 +22,7 @@
 #include "VideoBackends/Software/EfbInterface.h"
 #include "VideoBackends/Software/HwRasterizer.h"
 #include "VideoBackends/Software/OpcodeDecoder.h"
+#include "VideoBackends/Software/Pipeline.h"
 #include "VideoBackends/Software/Rasterizer.h"
 #include "VideoBackends/Software/SWCommandProcessor.h"
 #include "VideoBackends/Software/SWPixelEngine.h"
@@ -29,6 +30,8 @@
 #include "VideoBackends/Software/SWStatistics.h"
 #include "VideoBackends/Software/SWVertexLoader.h"
 #include "VideoBackends/Software/SWVideoConfig.h"
+#include "VideoBackends/Software/TevJit.h"
+#include "VideoBackends/Software/TextureSampler.h"
 #include "VideoBackends/Software/VideoBackend.h"
 #include "VideoBackends/Software/XFMemLoader.h"
 
@@ -93,6 +96,7 @@ bool VideoSoftware::Initialize(void *&window_handle)
 	OpcodeDecoder::Init();
 	Clipper::Init();
 	Rasterizer::Init();
+	Pipeline::Init();
 	HwRasterizer::Init();
 	SWRenderer::Init();
 	DebugUtil::Init();
@@ -108,6 +112,9 @@ void VideoSoftware::DoState(PointerWrap& p)
 		// change mode to abort load of incompatible save state.
 		p.SetMode(PointerWrap::MODE_VERIFY);
 
+	// Nothing may be drawing while the state changes.
+	Pipeline::Flush();
+
 	// TODO: incomplete?
 	SWCommandProcessor::DoState(p);
 	SWPixelEngine::DoState(p);
@@ -127,6 +134,12 @@ void VideoSoftware::DoState(PointerWrap& p)
 	p.DoArray(g_VtxAttr, 8);
 	p.DoMarker("CP Memory");
 
+	// Main memory and bpmem were replaced.
+	if (p.GetMode() == PointerWrap::MODE_READ)
+	{
+		TextureSampler::Invalidate();
+		TevJit::Invalidate();
+	}
 }
 
 void VideoSoftware::CheckInvalidState()
@@ -164,6 +177,10 @@ void VideoSoftware::EmuStateChange(EMUSTATE_CHANGE newState)
 void VideoSoftware::Shutdown()
 {
 	// TODO: should be in Video_Cleanup
+	Pipeline::Shutdown();
+	Rasterizer::Shutdown();
+	TextureSampler::Shutdown();
+	TevJit::Shutdown();
 	HwRasterizer::Shutdown();
 	SWRenderer::Shutdown();
 
@@ -2,9 +2,11 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <cmath>
 
 #include "Common/Common.h"
+#include "Common/CPUDetect.h"
 
 #include "VideoBackends/Software/DebugUtil.h"
 #include "VideoBackends/Software/EfbInterface.h"
@@ -12,6 +14,7 @@
 #include "VideoBackends/Software/SWStatistics.h"
 #include "VideoBackends/Software/SWVideoConfig.h"
 #include "VideoBackends/Software/Tev.h"
+#include "VideoBackends/Software/TevJit.h"
 #include "VideoBackends/Software/TextureSampler.h"
 #include "VideoBackends/Software/XFMemLoader.h"
 
@@ -112,6 +115,31 @@ void Tev::Init()
 	m_ScaleRShiftLUT[1] = 0;
 	m_ScaleRShiftLUT[2] = 0;
 	m_ScaleRShiftLUT[3] = 1;
+
+#if _M_SSE >= 0x401
+	for (int comp = 0; comp < 4; comp++)
+	{
+		One16[comp] = FixedConstants[8];
+		Half16[comp] = FixedConstants[4];
+	}
+
+	for (int i = 0; i < 4; i++)
+	{
+		m_ColorInputVectorLUT[i * 2] = Reg[i];
+		m_ColorInputVectorLUT[i * 2 + 1] = Reg[i];
+	}
+	m_ColorInputVectorLUT[8] = m_ColorInputVectorLUT[9] = TexColor;
+	m_ColorInputVectorLUT[10] = m_ColorInputVectorLUT[11] = RasColor;
+	m_ColorInputVectorLUT[12] = One16;
+	m_ColorInputVectorLUT[13] = Half16;
+	m_ColorInputVectorLUT[14] = StageKonst;
+	m_ColorInputVectorLUT[15] = Zero16;
+
+	for (StageParamsSSE4& params : m_StageParams)
+		params.valid = false;
+#endif
+
+	ResetCounts();
 }
 
 inline s16 Clamp255(s16 in)
@@ -324,6 +352,74 @@ void Tev::DrawAlphaCompare(TevStageCombiner::AlphaCombiner& ac, const InputRegTy
 	}
 }
 
+#if _M_SSE >= 0x401
+// Does the same as building the inputs, DrawColorRegular, DrawAlphaRegular
+// and the clamping in Draw, with a component in each lane. The alpha lane
+// uses the alpha combiner's settings.
+void Tev::DrawStageSSE4(unsigned int stageNum, TevStageCombiner::ColorCombiner &cc, TevStageCombiner::AlphaCombiner &ac)
+{
+	StageParamsSSE4 &params = m_StageParams[stageNum];
+	if (!params.valid || params.colorHex != cc.hex || params.alphaHex != ac.hex)
+	{
+		const s32 cscale = 1 << m_ScaleLShiftLUT[cc.shift];
+		const s32 ascale = 1 << m_ScaleLShiftLUT[ac.shift];
+		const s32 cround = (cc.shift != 3) ? 0 : (cc.op == 1) ? 127 : 128;
+		const s32 around = (ac.shift != 3) ? 0 : (ac.op == 1) ? 127 : 128;
+		const s32 cnegate = cc.op ? -1 : 0;
+		const s32 anegate = ac.op ? -1 : 0;
+		const s32 cdivide = m_ScaleRShiftLUT[cc.shift] ? -1 : 0;
+		const s32 adivide = m_ScaleRShiftLUT[ac.shift] ? -1 : 0;
+
+		params.scale = _mm_setr_epi32(ascale, cscale, cscale, cscale);
+		params.round = _mm_setr_epi32(around, cround, cround, cround);
+		params.negate = _mm_setr_epi32(anegate, cnegate, cnegate, cnegate);
+		params.bias = _mm_setr_epi32(m_BiasLUT[ac.bias], m_BiasLUT[cc.bias], m_BiasLUT[cc.bias], m_BiasLUT[cc.bias]);
+		params.divide = _mm_setr_epi32(adivide, cdivide, cdivide, cdivide);
+		params.min = _mm_setr_epi32(ac.clamp ? 0 : -1024, cc.clamp ? 0 : -1024, cc.clamp ? 0 : -1024, cc.clamp ? 0 : -1024);
+		params.max = _mm_setr_epi32(ac.clamp ? 255 : 1023, cc.clamp ? 255 : 1023, cc.clamp ? 255 : 1023, cc.clamp ? 255 : 1023);
+		params.colorHex = cc.hex;
+		params.alphaHex = ac.hex;
+		params.valid = true;
+	}
+
+	// The inputs, in 16 bit lanes. Lane 0 comes from the alpha inputs.
+	const u32 colorSel[4] = { cc.a, cc.b, cc.c, cc.d };
+	const u32 alphaSel[4] = { ac.a, ac.b, ac.c, ac.d };
+	__m128i inputs[4];
+	for (int i = 0; i < 4; i++)
+	{
+		__m128i color = _mm_loadl_epi64((const __m128i *)m_ColorInputVectorLUT[colorSel[i]]);
+		if (colorSel[i] & 1)
+			color = _mm_shufflelo_epi16(color, 0);
+		const __m128i alpha = _mm_loadl_epi64((const __m128i *)m_AlphaInputLUT[alphaSel[i]]);
+		inputs[i] = _mm_blend_epi16(color, alpha, 1);
+	}
+
+	// a, b and c are 8 bit, d is signed 11 bit.
+	const __m128i low8 = _mm_set1_epi16(0xff);
+	const __m128i a = _mm_and_si128(inputs[0], low8);
+	const __m128i b = _mm_and_si128(inputs[1], low8);
+	__m128i c = _mm_and_si128(inputs[2], low8);
+	c = _mm_add_epi16(c, _mm_srli_epi16(c, 7));
+	const __m128i d = _mm_cvtepi16_epi32(_mm_srai_epi16(_mm_slli_epi16(inputs[3], 5), 5));
+
+	// a * (256 - c) + b * c
+	__m128i temp = _mm_madd_epi16(_mm_unpacklo_epi16(a, b), _mm_unpacklo_epi16(_mm_sub_epi16(_mm_set1_epi16(256), c), c));
+	temp = _mm_mullo_epi32(temp, params.scale);
+	temp = _mm_add_epi32(temp, params.round);
+	temp = _mm_blendv_epi8(_mm_srai_epi32(temp, 8), _mm_srai_epi32(_mm_sub_epi32(_mm_setzero_si128(), temp), 8), params.negate);
+
+	__m128i result = _mm_add_epi32(_mm_mullo_epi32(_mm_add_epi32(d, params.bias), params.scale), temp);
+	result = _mm_blendv_epi8(result, _mm_srai_epi32(result, 1), params.divide);
+	result = _mm_min_epi32(_mm_max_epi32(result, params.min), params.max);
+
+	Reg[ac.dest][ALP_C] = _mm_extract_epi32(result, ALP_C);
+	Reg[cc.dest][BLU_C] = _mm_extract_epi32(result, BLU_C);
+	Reg[cc.dest][GRN_C] = _mm_extract_epi32(result, GRN_C);
+	Reg[cc.dest][RED_C] = _mm_extract_epi32(result, RED_C);
+}
+#endif
+
 static bool AlphaCompare(int alpha, int ref, AlphaTest::CompareMode comp)
 {
 	switch (comp) {
@@ -491,12 +587,53 @@ void Tev::Indirect(unsigned int stageNum, s32 s, s32 t)
 	}
 }
 
+void Tev::FetchTexture(unsigned int stageNum)
+{
+	int stageOdd = stageNum&1;
+	TwoTevStageOrders &order = bpmem.tevorders[stageNum >> 1];
+	TevStageCombiner::AlphaCombiner &ac = bpmem.combiners[stageNum].alphaC;
+
+	int texcoordSel = order.getTexCoord(stageOdd);
+	int texmap = order.getTexMap(stageOdd);
+
+	Indirect(stageNum, Uv[texcoordSel].s, Uv[texcoordSel].t);
+
+	// sample texture
+	if (order.getEnable(stageOdd))
+	{
+		// RGBA
+		u8 texel[4];
+
+		TextureSampler::Sample(TexCoord.s, TexCoord.t, TextureLod[stageNum], TextureLinear[stageNum], texmap, texel);
+
+#if ALLOW_TEV_DUMPS
+		if (g_SWVideoConfig.bDumpTevTextureFetches)
+			DebugUtil::DrawTempBuffer(texel, DIRECT_TFETCH + stageNum);
+#endif
+
+		int swaptable = ac.tswap * 2;
+
+		TexColor[RED_C] = texel[bpmem.tevksel[swaptable].swap1];
+		TexColor[GRN_C] = texel[bpmem.tevksel[swaptable].swap2];
+		swaptable++;
+		TexColor[BLU_C] = texel[bpmem.tevksel[swaptable].swap1];
+		TexColor[ALP_C] = texel[bpmem.tevksel[swaptable].swap2];
+	}
+}
+
 void Tev::Draw()
 {
 	_assert_(Position[0] >= 0 && Position[0] < EFB_WIDTH);
 	_assert_(Position[1] >= 0 && Position[1] < EFB_HEIGHT);
 
-	INCSTAT(swstats.thisFrame.tevPixelsIn);
+	Counts.tevIn++;
+
+	// Nothing the stages of one pixel leave behind is seen by the next, like
+	// on hardware. That's also what lets pixels be drawn on any thread.
+	memcpy(Reg, InitialReg, sizeof(Reg));
+	memset(TexColor, 0, sizeof(TexColor));
+	memset(IndirectTex, 0, sizeof(IndirectTex));
+	TexCoord.s = TexCoord.t = 0;
 
 	for (unsigned int stageNum = 0; stageNum < bpmem.genMode.numindstages; stageNum++)
 	{
@@ -527,116 +664,118 @@ void Tev::Draw()
 #endif
 	}
 
-	for (unsigned int stageNum = 0; stageNum <= bpmem.genMode.numtevstages; stageNum++)
-	{
-		int stageNum2 = stageNum >> 1;
-		int stageOdd = stageNum&1;
-		TwoTevStageOrders &order = bpmem.tevorders[stageNum2];
-		TevKSel &kSel = bpmem.tevksel[stageNum2];
-
-		// stage combiners
-		TevStageCombiner::ColorCombiner &cc = bpmem.combiners[stageNum].colorC;
-		TevStageCombiner::AlphaCombiner &ac = bpmem.combiners[stageNum].alphaC;
-
-		int texcoordSel = order.getTexCoord(stageOdd);
-		int texmap = order.getTexMap(stageOdd);
-
-		Indirect(stageNum, Uv[texcoordSel].s, Uv[texcoordSel].t);
+	// The stages and the alpha test, compiled for the current TEV setup or
+	// interpreted. The dumps are only done by the interpreter.
+	TevJit::PixelFunction jitFunction = nullptr;
+	if (g_SWVideoConfig.bTevJit && !(ALLOW_TEV_DUMPS && (g_SWVideoConfig.bDumpTevStages || g_SWVideoConfig.bDumpTevTextureFetches)))
+		jitFunction = TevJit::GetFunction(*this);
 
-		// sample texture
-		if (order.getEnable(stageOdd))
+	u8 output[4];
+	if (jitFunction)
+	{
+		if (!jitFunction(this, output))
+			return;
+	}
+	else
+	{
+		for (unsigned int stageNum = 0; stageNum <= bpmem.genMode.numtevstages; stageNum++)
 		{
-			// RGBA
-			u8 texel[4];
-
-			TextureSampler::Sample(TexCoord.s, TexCoord.t, TextureLod[stageNum], TextureLinear[stageNum], texmap, texel);
+			int stageNum2 = stageNum >> 1;
+			int stageOdd = stageNum&1;
+			TwoTevStageOrders &order = bpmem.tevorders[stageNum2];
+			TevKSel &kSel = bpmem.tevksel[stageNum2];
+
+			// stage combiners
+			TevStageCombiner::ColorCombiner &cc = bpmem.combiners[stageNum].colorC;
+			TevStageCombiner::AlphaCombiner &ac = bpmem.combiners[stageNum].alphaC;
+
+			FetchTexture(stageNum);
+
+			// set konst for this stage
+			int kc = kSel.getKC(stageOdd);
+			int ka = kSel.getKA(stageOdd);
+			StageKonst[RED_C] = *(m_KonstLUT[kc][RED_C]);
+			StageKonst[GRN_C] = *(m_KonstLUT[kc][GRN_C]);
+			StageKonst[BLU_C] = *(m_KonstLUT[kc][BLU_C]);
+			StageKonst[ALP_C] = *(m_KonstLUT[ka][ALP_C]);
+
+			// set color
+			SetRasColor(order.getColorChan(stageOdd), ac.rswap * 2);
+
+#if _M_SSE >= 0x401
+			if (cpu_info.bSSE4_1 && cc.bias != 3 && ac.bias != 3)
+			{
+				DrawStageSSE4(stageNum, cc, ac);
+			}
+			else
+#endif
+			{
+				// combine inputs
+				InputRegType inputs[4];
+				for (int i = 0; i < 3; i++)
+				{
+					inputs[BLU_C + i].a = *m_ColorInputLUT[cc.a][i];
+					inputs[BLU_C + i].b = *m_ColorInputLUT[cc.b][i];
+					inputs[BLU_C + i].c = *m_ColorInputLUT[cc.c][i];
+					inputs[BLU_C + i].d = *m_ColorInputLUT[cc.d][i];
+				}
+				inputs[ALP_C].a = *m_AlphaInputLUT[ac.a];
+				inputs[ALP_C].b = *m_AlphaInputLUT[ac.b];
+				inputs[ALP_C].c = *m_AlphaInputLUT[ac.c];
+				inputs[ALP_C].d = *m_AlphaInputLUT[ac.d];
+
+				if (cc.bias != 3)
+					DrawColorRegular(cc, inputs);
+				else
+					DrawColorCompare(cc, inputs);
+
+				if (cc.clamp)
+				{
+					Reg[cc.dest][RED_C] = Clamp255(Reg[cc.dest][RED_C]);
+					Reg[cc.dest][GRN_C] = Clamp255(Reg[cc.dest][GRN_C]);
+					Reg[cc.dest][BLU_C] = Clamp255(Reg[cc.dest][BLU_C]);
+				}
+				else
+				{
+					Reg[cc.dest][RED_C] = Clamp1024(Reg[cc.dest][RED_C]);
+					Reg[cc.dest][GRN_C] = Clamp1024(Reg[cc.dest][GRN_C]);
+					Reg[cc.dest][BLU_C] = Clamp1024(Reg[cc.dest][BLU_C]);
+				}
+
+				if (ac.bias != 3)
+					DrawAlphaRegular(ac, inputs);
+				else
+					DrawAlphaCompare(ac, inputs);
+
+				if (ac.clamp)
+					Reg[ac.dest][ALP_C] = Clamp255(Reg[ac.dest][ALP_C]);
+				else
+					Reg[ac.dest][ALP_C] = Clamp1024(Reg[ac.dest][ALP_C]);
+			}
 
 #if ALLOW_TEV_DUMPS
-			if (g_SWVideoConfig.bDumpTevTextureFetches)
-				DebugUtil::DrawTempBuffer(texel, DIRECT_TFETCH + stageNum);
+			if (g_SWVideoConfig.bDumpTevStages)
+			{
+				u8 stage[4] = {(u8)Reg[0][RED_C], (u8)Reg[0][GRN_C], (u8)Reg[0][BLU_C], (u8)Reg[0][ALP_C]};
+				DebugUtil::DrawTempBuffer(stage, DIRECT + stageNum);
+			}
 #endif
-
-			int swaptable = ac.tswap * 2;
-
-			TexColor[RED_C] = texel[bpmem.tevksel[swaptable].swap1];
-			TexColor[GRN_C] = texel[bpmem.tevksel[swaptable].swap2];
-			swaptable++;
-			TexColor[BLU_C] = texel[bpmem.tevksel[swaptable].swap1];
-			TexColor[ALP_C] = texel[bpmem.tevksel[swaptable].swap2];
 		}
 
-		// set konst for this stage
-		int kc = kSel.getKC(stageOdd);
-		int ka = kSel.getKA(stageOdd);
-		StageKonst[RED_C] = *(m_KonstLUT[kc][RED_C]);
-		StageKonst[GRN_C] = *(m_KonstLUT[kc][GRN_C]);
-		StageKonst[BLU_C] = *(m_KonstLUT[kc][BLU_C]);
-		StageKonst[ALP_C] = *(m_KonstLUT[ka][ALP_C]);
-
-		// set color
-		SetRasColor(order.getColorChan(stageOdd), ac.rswap * 2);
-
-		// combine inputs
-		InputRegType inputs[4];
-		for (int i = 0; i < 3; i++)
-		{
-			inputs[BLU_C + i].a = *m_ColorInputLUT[cc.a][i];
-			inputs[BLU_C + i].b = *m_ColorInputLUT[cc.b][i];
-			inputs[BLU_C + i].c = *m_ColorInputLUT[cc.c][i];
-			inputs[BLU_C + i].d = *m_ColorInputLUT[cc.d][i];
-		}
-		inputs[ALP_C].a = *m_AlphaInputLUT[ac.a];
-		inputs[ALP_C].b = *m_AlphaInputLUT[ac.b];
-		inputs[ALP_C].c = *m_AlphaInputLUT[ac.c];
-		inputs[ALP_C].d = *m_AlphaInputLUT[ac.d];
-
-		if (cc.bias != 3)
-			DrawColorRegular(cc, inputs);
-		else
-			DrawColorCompare(cc, inputs);
-
-		if (cc.clamp)
-		{
-			Reg[cc.dest][RED_C] = Clamp255(Reg[cc.dest][RED_C]);
-			Reg[cc.dest][GRN_C] = Clamp255(Reg[cc.dest][GRN_C]);
-			Reg[cc.dest][BLU_C] = Clamp255(Reg[cc.dest][BLU_C]);
-		}
-		else
-		{
-			Reg[cc.dest][RED_C] = Clamp1024(Reg[cc.dest][RED_C]);
-			Reg[cc.dest][GRN_C] = Clamp1024(Reg[cc.dest][GRN_C]);
-			Reg[cc.dest][BLU_C] = Clamp1024(Reg[cc.dest][BLU_C]);
-		}
-
-		if (ac.bias != 3)
-			DrawAlphaRegular(ac, inputs);
-		else
-			DrawAlphaCompare(ac, inputs);
-
-		if (ac.clamp)
-			Reg[ac.dest][ALP_C] = Clamp255(Reg[ac.dest][ALP_C]);
-		else
-			Reg[ac.dest][ALP_C] = Clamp1024(Reg[ac.dest][ALP_C]);
-
-#if ALLOW_TEV_DUMPS
-		if (g_SWVideoConfig.bDumpTevStages)
-		{
-			u8 stage[4] = {(u8)Reg[0][RED_C], (u8)Reg[0][GRN_C], (u8)Reg[0][BLU_C], (u8)Reg[0][ALP_C]};
-			DebugUtil::DrawTempBuffer(stage, DIRECT + stageNum);
-		}
-#endif
+		// convert to 8 bits per component
+		// the results of the last tev stage are put onto the screen,
+		// regardless of the used destination register - TODO: Verify!
+		u32 color_index = bpmem.combiners[bpmem.genMode.numtevstages].colorC.dest;
+		u32 alpha_index = bpmem.combiners[bpmem.genMode.numtevstages].alphaC.dest;
+		output[ALP_C] = (u8)Reg[alpha_index][ALP_C];
+		output[BLU_C] = (u8)Reg[color_index][BLU_C];
+		output[GRN_C] = (u8)Reg[color_index][GRN_C];
+		output[RED_C] = (u8)Reg[color_index][RED_C];
+
+		if (!TevAlphaTest(output[ALP_C]))
+			return;
 	}
 
-	// convert to 8 bits per component
-	// the results of the last tev stage are put onto the screen,
-	// regardless of the used destination register - TODO: Verify!
-	u32 color_index = bpmem.combiners[bpmem.genMode.numtevstages].colorC.dest;
-	u32 alpha_index = bpmem.combiners[bpmem.genMode.numtevstages].alphaC.dest;
-	u8 output[4] = {(u8)Reg[alpha_index][ALP_C], (u8)Reg[color_index][BLU_C], (u8)Reg[color_index][GRN_C], (u8)Reg[color_index][RED_C]};
-
-	if (!TevAlphaTest(output[ALP_C]))
-		return;
-
 	// z texture
 	if (bpmem.ztex2.op)
 	{
@@ -745,12 +884,12 @@ void Tev::Draw()
 	if (late_ztest && bpmem.zmode.testenable)
 	{
 		// TODO: Check against hw if these values get incremented even if depth testing is disabled
-		SWPixelEngine::pereg.IncZInputQuadCount(false);
+		Counts.zInput[0]++;
 
 		if (!EfbInterface::ZCompare(Position[0], Position[1], Position[2]))
 			return;
 
-		SWPixelEngine::pereg.IncZOutputQuadCount(false);
+		Counts.zOutput[0]++;
 	}
 
 #if ALLOW_TEV_DUMPS
@@ -773,10 +912,14 @@ void Tev::Draw()
 	}
 #endif
 
-	INCSTAT(swstats.thisFrame.tevPixelsOut);
-	SWPixelEngine::pereg.IncBlendInputQuadCount();
+	Counts.tevOut++;
 
 	EfbInterface::BlendTev(Position[0], Position[1], output);
+
+	Counts.boxLeft = std::min<u16>(Counts.boxLeft, Position[0]);
+	Counts.boxRight = std::max<u16>(Counts.boxRight, Position[0]);
+	Counts.boxTop = std::min<u16>(Counts.boxTop, Position[1]);
+	Counts.boxBottom = std::max<u16>(Counts.boxBottom, Position[1]);
 }
 
 void Tev::SetRegColor(int reg, int comp, bool konst, s16 color)
@@ -787,13 +930,61 @@ void Tev::SetRegColor(int reg, int comp, bool konst, s16 color)
 	}
 	else
 	{
-		Reg[reg][comp] = color;
+		InitialReg[reg][comp] = color;
+	}
+}
+
+void Tev::CopyState(const Tev &other)
+{
+	memcpy(Reg, other.Reg, sizeof(Reg));
+	memcpy(InitialReg, other.InitialReg, sizeof(InitialReg));
+	memcpy(KonstantColors, other.KonstantColors, sizeof(KonstantColors));
+	memcpy(TexColor, other.TexColor, sizeof(TexColor));
+	memcpy(RasColor, other.RasColor, sizeof(RasColor));
+	memcpy(StageKonst, other.StageKonst, sizeof(StageKonst));
+	AlphaBump = other.AlphaBump;
+	memcpy(IndirectTex, other.IndirectTex, sizeof(IndirectTex));
+	TexCoord = other.TexCoord;
+}
+
+void Tev::ResetCounts()
+{
+	memset(&Counts, 0, sizeof(Counts));
+	Counts.boxLeft = Counts.boxTop = 0xffff;
+}
+
+void Tev::ApplyCounts()
+{
+	ADDSTAT(swstats.thisFrame.rasterizedPixels, Counts.rasterized);
+	ADDSTAT(swstats.thisFrame.tevPixelsIn, Counts.tevIn);
+	ADDSTAT(swstats.thisFrame.tevPixelsOut, Counts.tevOut);
+
+	// The counters only go up every few pixels, so they have to see each one.
+	for (int early = 1; early >= 0; early--)
+	{
+		for (u32 i = 0; i < Counts.zInput[early]; i++)
+			SWPixelEngine::pereg.IncZInputQuadCount(early != 0);
+		for (u32 i = 0; i < Counts.zOutput[early]; i++)
+			SWPixelEngine::pereg.IncZOutputQuadCount(early != 0);
+	}
+	for (u32 i = 0; i < Counts.tevOut; i++)
+		SWPixelEngine::pereg.IncBlendInputQuadCount();
+
+	if (Counts.tevOut)
+	{
+		SWPixelEngine::PEReg &pereg = SWPixelEngine::pereg;
+		pereg.boxLeft = std::min(pereg.boxLeft, Counts.boxLeft);
+		pereg.boxRight = std::max(pereg.boxRight, Counts.boxRight);
+		pereg.boxTop = std::min(pereg.boxTop, Counts.boxTop);
+		pereg.boxBottom = std::max(pereg.boxBottom, Counts.boxBottom);
 	}
+
+	ResetCounts();
 }
 
 void Tev::DoState(PointerWrap &p)
 {
-	p.DoArray(Reg, sizeof(Reg));
+	p.DoArray(InitialReg, sizeof(InitialReg));
 
 	p.DoArray(KonstantColors, sizeof(KonstantColors));
 	p.DoArray(TexColor,4);
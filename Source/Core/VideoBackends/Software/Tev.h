@@ -7,8 +7,15 @@
 #include "Common/ChunkFile.h"
 #include "VideoBackends/Software/BPMemLoader.h"
 
+#if _M_SSE >= 0x401
+#include <smmintrin.h>
+#endif
+
 class Tev
 {
+	// Compiles the stages and the alpha test, and works on the registers directly.
+	friend class TevJitCompiler;
+
 	struct InputRegType
 	{
 		unsigned a : 8;
@@ -25,6 +32,8 @@ class Tev
 
 	// color order: ABGR
 	s16 Reg[4][4];
+	// The registers as set through BP, which every pixel starts out with.
+	s16 InitialReg[4][4];
 	s16 KonstantColors[4][4];
 	s16 TexColor[4];
 	s16 RasColor[4];
@@ -43,6 +52,32 @@ class Tev
 	u8 m_ScaleLShiftLUT[4];
 	u8 m_ScaleRShiftLUT[4];
 
+#if _M_SSE >= 0x401
+	s16 One16[4];
+	s16 Half16[4];
+
+	// The registers DrawStageSSE4 loads the color inputs from, as a whole.
+	// The odd inputs use only their alpha.
+	s16 *m_ColorInputVectorLUT[16];
+
+	// The settings of a stage's combiners, spread over the component lanes,
+	// and the combiners they were worked out for.
+	struct StageParamsSSE4
+	{
+		u32 colorHex;
+		u32 alphaHex;
+		bool valid;
+		__m128i scale;
+		__m128i round;
+		__m128i negate;
+		__m128i bias;
+		__m128i divide;
+		__m128i min;
+		__m128i max;
+	};
+	StageParamsSSE4 m_StageParams[16];
+#endif
+
 	// enumeration for color input LUT
 	enum
 	{
@@ -64,8 +99,15 @@ class Tev
 	void DrawColorCompare(TevStageCombiner::ColorCombiner& cc, const InputRegType inputs[4]);
 	void DrawAlphaRegular(TevStageCombiner::AlphaCombiner& ac, const InputRegType inputs[4]);
 	void DrawAlphaCompare(TevStageCombiner::AlphaCombiner& ac, const InputRegType inputs[4]);
+#if _M_SSE >= 0x401
+	// Both combiners of a stage at once, including the clamping. Only for
+	// the regular, non-compare modes.
+	void DrawStageSSE4(unsigned int stageNum, TevStageCombiner::ColorCombiner& cc, TevStageCombiner::AlphaCombiner& ac);
+#endif
 
 	void Indirect(unsigned int stageNum, s32 s, s32 t);
+	// The indirect stage and the texture lookup of a TEV stage, into TexCoord and TexColor.
+	void FetchTexture(unsigned int stageNum);
 
 public:
 	s32 Position[3];
@@ -76,12 +118,35 @@ public:
 	s32 TextureLod[16];
 	bool TextureLinear[16];
 
+	// What drawing pixels adds to the statistics and to the pixel engine's
+	// performance counters and bounding box. Each Tev keeps its own, so that
+	// several can draw at once; ApplyCounts adds them up.
+	struct PixelCounts
+	{
+		u32 rasterized;
+		u32 tevIn;
+		u32 tevOut;
+		// Indexed by early_ztest.
+		u32 zInput[2];
+		u32 zOutput[2];
+		u16 boxLeft, boxRight, boxTop, boxBottom;
+	};
+	PixelCounts Counts;
+
 	void Init();
 
 	void Draw();
 
 	void SetRegColor(int reg, int comp, bool konst, s16 color);
 
+	// Copies the registers of another Tev, but not its lookup tables, which
+	// point into the Tev they belong to.
+	void CopyState(const Tev &other);
+
+	void ResetCounts();
+	// Adds Counts to swstats and SWPixelEngine::pereg and resets them.
+	void ApplyCounts();
+
 	enum { ALP_C, BLU_C, GRN_C, RED_C };
 
 	void DoState(PointerWrap &p);
@@ -0,0 +1,702 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <atomic>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <utility>
+
+#include "Common/x64ABI.h"
+#include "Common/x64Emitter.h"
+#include "VideoBackends/Software/BPMemLoader.h"
+#include "VideoBackends/Software/Tev.h"
+#include "VideoBackends/Software/TevJit.h"
+#include "VideoCommon/ShaderGenCommon.h"
+
+#if _M_X86_64
+
+using namespace Gen;
+
+namespace
+{
+
+enum
+{
+	CODE_SIZE = 1024 * 1024,
+	// Sixteen stages with the most expensive inputs, plus their constants,
+	// take less than this.
+	MAX_FUNCTION_SIZE = 32 * 1024,
+};
+
+#pragma pack(1)
+// Everything in bpmem the code of a TEV setup depends on.
+struct tev_jit_uid_data
+{
+	u32 NumValues() const { return sizeof(tev_jit_uid_data) - (16 - numStages) * sizeof(stages[0]); }
+
+	u32 numStages : 5;
+	u32 alphaComp0 : 3;
+	u32 alphaComp1 : 3;
+	u32 alphaLogic : 2;
+	u32 alphaRef0 : 8;
+	u32 alphaRef1 : 8;
+	u32 pad0 : 3;
+
+	// swap1 and swap2 of the eight halves of the swap tables, 4 bits each.
+	u32 swapTables;
+
+	struct
+	{
+		u32 colorCombiner;
+		u32 alphaCombiner;
+		u32 colorChan : 3;
+		u32 kcSel : 5;
+		u32 kaSel : 5;
+		u32 texCoord : 3;
+		// The stage samples a texture or has an indirect stage, which goes
+		// through Tev::FetchTexture. Otherwise only the texture coordinate
+		// is passed on.
+		u32 fetchTexture : 1;
+		u32 pad1 : 15;
+	} stages[16];
+};
+#pragma pack()
+
+typedef ShaderUid<tev_jit_uid_data> TevJitUid;
+
+// Fills in uid for the setup in bpmem, or returns false if the JIT can't do it.
+bool GetUid(TevJitUid &uid)
+{
+	tev_jit_uid_data &data = uid.GetUidData<tev_jit_uid_data>();
+
+	data.numStages = bpmem.genMode.numtevstages + 1;
+	data.alphaComp0 = bpmem.alpha_test.comp0;
+	data.alphaComp1 = bpmem.alpha_test.comp1;
+	data.alphaLogic = bpmem.alpha_test.logic;
+	data.alphaRef0 = bpmem.alpha_test.ref0;
+	data.alphaRef1 = bpmem.alpha_test.ref1;
+
+	for (int i = 0; i < 8; i++)
+		data.swapTables |= (bpmem.tevksel[i].swap1 | (bpmem.tevksel[i].swap2 << 2)) << (i * 4);
+
+	for (u32 stageNum = 0; stageNum < data.numStages; stageNum++)
+	{
+		const int stageOdd = stageNum & 1;
+		TwoTevStageOrders &order = bpmem.tevorders[stageNum >> 1];
+		TevKSel &kSel = bpmem.tevksel[stageNum >> 1];
+		const TevStageCombiner &combiner = bpmem.combiners[stageNum];
+
+		// The compare modes are left to the interpreter, as are the konstant
+		// selections 8 to 11, which aren't valid.
+		if (combiner.colorC.bias == 3 || combiner.alphaC.bias == 3)
+			return false;
+		const int kc = kSel.getKC(stageOdd);
+		const int ka = kSel.getKA(stageOdd);
+		if ((kc & ~3) == 8 || (ka & ~3) == 8)
+			return false;
+
+		auto &stage = data.stages[stageNum];
+		stage.colorCombiner = combiner.colorC.hex & 0xFFFFFF;
+		stage.alphaCombiner = combiner.alphaC.hex & 0xFFFFFF;
+		stage.colorChan = order.getColorChan(stageOdd);
+		stage.kcSel = kc;
+		stage.kaSel = ka;
+		stage.texCoord = order.getTexCoord(stageOdd);
+		stage.fetchTexture = order.getEnable(stageOdd) || bpmem.tevind[stageNum].hex != 0;
+	}
+
+	return true;
+}
+
+}
+
+// Compiles each TEV setup into a function of SSE2 code. Like DrawStageSSE4,
+// each of the four 16 bit lanes of an XMM register holds one component, in
+// ABGR order, so the color and alpha combiners of a stage run together.
+//
+// Register use: RBX points to the Tev and R12 to the output. XMM0 to XMM3
+// hold the inputs a to d, XMM4 and XMM5 are temporaries. Constants are put
+// at the end of the code space, where each function can reach them.
+class TevJitCompiler : public XCodeBlock
+{
+public:
+	void Init()
+	{
+		AllocCodeSpace(CODE_SIZE);
+		ClearCache();
+	}
+
+	void Shutdown()
+	{
+		FreeCodeSpace();
+		m_constants.clear();
+	}
+
+	void ClearCache()
+	{
+		ClearCodeSpace();
+		m_constantsStart = region + region_size;
+		m_constants.clear();
+	}
+
+	bool IsInitialized() const
+	{
+		return region != nullptr;
+	}
+
+	bool IsFull() const
+	{
+		return m_constantsStart - GetCodePtr() < MAX_FUNCTION_SIZE;
+	}
+
+	TevJit::PixelFunction Compile(const tev_jit_uid_data &uid, const Tev &tev);
+
+private:
+	static void FetchTexture(Tev *tev, u32 stageNum)
+	{
+		tev->FetchTexture(stageNum);
+	}
+
+	// The offset of something in m_tev, for addressing it from RBX.
+	int Offset(const void *ptr) const
+	{
+		return (int)((const u8 *)ptr - (const u8 *)m_tev);
+	}
+
+	OpArg TevArg(const void *ptr) const
+	{
+		return MDisp(RBX, Offset(ptr));
+	}
+
+	OpArg Constant(u64 low, u64 high);
+	OpArg Constant16(s16 alpha, s16 color);
+	OpArg Constant32(s32 alpha, s32 color);
+
+	void CompileStage(const tev_jit_uid_data &uid, u32 stageNum);
+	void LoadInput(X64Reg dest, u32 colorSel, u32 alphaSel, const tev_jit_uid_data &uid, u32 stageNum);
+	void LoadRasColor(X64Reg dest, const tev_jit_uid_data &uid, u32 stageNum);
+	void LoadRasAlpha(X64Reg dest, const tev_jit_uid_data &uid, u32 stageNum);
+	void LoadAlphaBump(X64Reg dest, bool normalized);
+	void CompileAlphaCompare(X64Reg dest, u32 comp, u32 ref);
+	void CompileOutput(const tev_jit_uid_data &uid);
+
+	const Tev *m_tev;
+
+	// Constants grow down from the end of the code space.
+	u8 *m_constantsStart;
+	std::map<std::pair<u64, u64>, const u8 *> m_constants;
+};
+
+OpArg TevJitCompiler::Constant(u64 low, u64 high)
+{
+	auto it = m_constants.find(std::make_pair(low, high));
+	if (it != m_constants.end())
+		return M(it->second);
+
+	m_constantsStart -= 16;
+	memcpy(m_constantsStart, &low, 8);
+	memcpy(m_constantsStart + 8, &high, 8);
+	m_constants[std::make_pair(low, high)] = m_constantsStart;
+	return M(m_constantsStart);
+}
+
+// The value for the alpha lane and the three color lanes, twice.
+OpArg TevJitCompiler::Constant16(s16 alpha, s16 color)
+{
+	u64 value = (u16)alpha | ((u64)(u16)color << 16) | ((u64)(u16)color << 32) | ((u64)(u16)color << 48);
+	return Constant(value, value);
+}
+
+OpArg TevJitCompiler::Constant32(s32 alpha, s32 color)
+{
+	return Constant((u32)alpha | ((u64)(u32)color << 32), (u32)color | ((u64)(u32)color << 32));
+}
+
+TevJit::PixelFunction TevJitCompiler::Compile(const tev_jit_uid_data &uid, const Tev &tev)
+{
+	m_tev = &tev;
+
+	const u8 *start = AlignCode16();
+	const u32 savedRegisters = (1 << RBX) | (1 << R12);
+	ABI_PushRegistersAndAdjustStack(savedRegisters, true);
+	MOV(64, R(RBX), R(ABI_PARAM1));
+	MOV(64, R(R12), R(ABI_PARAM2));
+
+	for (u32 stageNum = 0; stageNum < uid.numStages; stageNum++)
+		CompileStage(uid, stageNum);
+
+	CompileOutput(uid);
+
+	ABI_PopRegistersAndAdjustStack(savedRegisters, true);
+	RET();
+
+	return (TevJit::PixelFunction)start;
+}
+
+void TevJitCompiler::CompileStage(const tev_jit_uid_data &uid, u32 stageNum)
+{
+	const auto &stage = uid.stages[stageNum];
+	TevStageCombiner::ColorCombiner cc;
+	TevStageCombiner::AlphaCombiner ac;
+	cc.hex = stage.colorCombiner;
+	ac.hex = stage.alphaCombiner;
+
+	if (stage.fetchTexture)
+	{
+		MOV(64, R(ABI_PARAM1), R(RBX));
+		MOV(32, R(ABI_PARAM2), Imm32(stageNum));
+		ABI_CallFunction((void *)&FetchTexture);
+	}
+	else
+	{
+		// What Tev::Indirect does without an indirect stage.
+		MOV(64, R(RAX), TevArg(&m_tev->Uv[stage.texCoord]));
+		MOV(64, TevArg(&m_tev->TexCoord), R(RAX));
+		MOV(8, TevArg(&m_tev->AlphaBump), Imm8(0));
+	}
+
+	LoadInput(XMM0, cc.a, ac.a, uid, stageNum);
+	LoadInput(XMM1, cc.b, ac.b, uid, stageNum);
+	LoadInput(XMM2, cc.c, ac.c, uid, stageNum);
+	LoadInput(XMM3, cc.d, ac.d, uid, stageNum);
+
+	const s16 ascale = 1 << m_tev->m_ScaleLShiftLUT[ac.shift];
+	const s16 cscale = 1 << m_tev->m_ScaleLShiftLUT[cc.shift];
+	const s32 around = (ac.shift != 3) ? 0 : (ac.op == 1) ? 127 : 128;
+	const s32 cround = (cc.shift != 3) ? 0 : (cc.op == 1) ? 127 : 128;
+	const s16 abias = m_tev->m_BiasLUT[ac.bias];
+	const s16 cbias = m_tev->m_BiasLUT[cc.bias];
+	const bool adivide = m_tev->m_ScaleRShiftLUT[ac.shift] != 0;
+	const bool cdivide = m_tev->m_ScaleRShiftLUT[cc.shift] != 0;
+	const OpArg scale = Constant16(ascale, cscale);
+
+	// a, b and c are 8 bit, d is signed 11 bit.
+	const OpArg low8 = Constant16(0xFF, 0xFF);
+	PAND(XMM0, low8);
+	PAND(XMM1, low8);
+	PAND(XMM2, low8);
+	PSLLW(XMM3, 5);
+	PSRAW(XMM3, 5);
+
+	// c += c >> 7
+	MOVAPD(XMM5, R(XMM2));
+	PSRLW(XMM5, 7);
+	PADDW(XMM2, R(XMM5));
+
+	// (a * (256 - c) + b * c) << shift, with the shift folded into the weights.
+	MOVQ_xmm(XMM4, Constant16(256, 256));
+	PSUBW(XMM4, R(XMM2));
+	if (ascale != 1 || cscale != 1)
+	{
+		PMULLW(XMM4, scale);
+		PMULLW(XMM2, scale);
+	}
+	PUNPCKLWD(XMM4, R(XMM2));
+	PUNPCKLWD(XMM0, R(XMM1));
+	PMADDWD(XMM0, R(XMM4));
+
+	if (around || cround)
+		PADDD(XMM0, Constant32(around, cround));
+	if (ac.op || cc.op)
+	{
+		// Negates the lanes that are all ones in the mask.
+		const OpArg negate = Constant32(ac.op ? -1 : 0, cc.op ? -1 : 0);
+		PXOR(XMM0, negate);
+		PSUBD(XMM0, negate);
+	}
+	PSRAD(XMM0, 8);
+
+	// + ((d + bias) << shift), which stays within 16 bits.
+	if (abias || cbias)
+		PADDW(XMM3, Constant16(abias, cbias));
+	if (ascale != 1 || cscale != 1)
+		PMULLW(XMM3, scale);
+	PUNPCKLWD(XMM3, R(XMM3));
+	PSRAD(XMM3, 16);
+	PADDD(XMM0, R(XMM3));
+
+	if (adivide && cdivide)
+	{
+		PSRAD(XMM0, 1);
+	}
+	else if (adivide || cdivide)
+	{
+		MOVAPD(XMM5, R(XMM0));
+		PSRAD(XMM5, 1);
+		PAND(XMM5, Constant32(adivide ? -1 : 0, cdivide ? -1 : 0));
+		PAND(XMM0, Constant32(adivide ? 0 : -1, cdivide ? 0 : -1));
+		POR(XMM0, R(XMM5));
+	}
+
+	PACKSSDW(XMM0, R(XMM0));
+	PMAXSW(XMM0, Constant16(ac.clamp ? 0 : -1024, cc.clamp ? 0 : -1024));
+	PMINSW(XMM0, Constant16(ac.clamp ? 255 : 1023, cc.clamp ? 255 : 1023));
+
+	if (ac.dest == cc.dest)
+	{
+		MOVQ_xmm(TevArg(m_tev->Reg[cc.dest]), XMM0);
+	}
+	else
+	{
+		PEXTRW(EAX, R(XMM0), Tev::ALP_C);
+		MOV(16, TevArg(&m_tev->Reg[ac.dest][Tev::ALP_C]), R(EAX));
+		for (int comp = Tev::BLU_C; comp <= Tev::RED_C; comp++)
+		{
+			PEXTRW(EAX, R(XMM0), comp);
+			MOV(16, TevArg(&m_tev->Reg[cc.dest][comp]), R(EAX));
+		}
+	}
+}
+
+// Puts the four lanes of an input into dest: the color lanes from the color
+// input, and the alpha lane from the alpha input.
+void TevJitCompiler::LoadInput(X64Reg dest, u32 colorSel, u32 alphaSel, const tev_jit_uid_data &uid, u32 stageNum)
+{
+	const auto &stage = uid.stages[stageNum];
+
+	// Color inputs that take all four lanes from the same place as the
+	// alpha input don't need the alpha lane replaced.
+	enum { FROM_TEX = 4, FROM_RAS, FROM_ZERO, FROM_ELSEWHERE };
+	int colorSource = FROM_ELSEWHERE;
+	if (colorSel < 8 && !(colorSel & 1))
+		colorSource = colorSel >> 1;
+	else if (colorSel == TEVCOLORARG_TEXC)
+		colorSource = FROM_TEX;
+	else if (colorSel == TEVCOLORARG_RASC)
+		colorSource = FROM_RAS;
+	else if (colorSel == TEVCOLORARG_ZERO)
+		colorSource = FROM_ZERO;
+	int alphaSource = FROM_ELSEWHERE;
+	if (alphaSel < 4)
+		alphaSource = alphaSel;
+	else if (alphaSel == TEVALPHAARG_TEXA)
+		alphaSource = FROM_TEX;
+	else if (alphaSel == TEVALPHAARG_RASA)
+		alphaSource = FROM_RAS;
+	else if (alphaSel == TEVALPHAARG_ZERO)
+		alphaSource = FROM_ZERO;
+
+	switch (colorSel)
+	{
+	case TEVCOLORARG_CPREV:
+	case TEVCOLORARG_APREV:
+	case TEVCOLORARG_C0:
+	case TEVCOLORARG_A0:
+	case TEVCOLORARG_C1:
+	case TEVCOLORARG_A1:
+	case TEVCOLORARG_C2:
+	case TEVCOLORARG_A2:
+		MOVQ_xmm(dest, TevArg(m_tev->Reg[colorSel >> 1]));
+		break;
+	case TEVCOLORARG_TEXC:
+	case TEVCOLORARG_TEXA:
+		MOVQ_xmm(dest, TevArg(m_tev->TexColor));
+		break;
+	case TEVCOLORARG_RASC:
+	case TEVCOLORARG_RASA:
+		LoadRasColor(dest, uid, stageNum);
+		break;
+	case TEVCOLORARG_ONE:
+		MOVQ_xmm(dest, Constant16(255, 255));
+		break;
+	case TEVCOLORARG_HALF:
+		MOVQ_xmm(dest, Constant16(127, 127));
+		break;
+	case TEVCOLORARG_KONST:
+		if (stage.kcSel < 8)
+		{
+			const s16 konst = m_tev->FixedConstants[8 - stage.kcSel];
+			MOVQ_xmm(dest, Constant16(konst, konst));
+		}
+		else if (stage.kcSel < 16)
+		{
+			MOVQ_xmm(dest, TevArg(m_tev->KonstantColors[stage.kcSel & 3]));
+		}
+		else
+		{
+			// One component of a konstant color, R, G, B or A.
+			const int comp = Tev::RED_C - ((stage.kcSel - 16) >> 2);
+			MOVQ_xmm(dest, TevArg(m_tev->KonstantColors[stage.kcSel & 3]));
+			PSHUFLW(dest, R(dest), comp * 0x55);
+		}
+		break;
+	case TEVCOLORARG_ZERO:
+		PXOR(dest, R(dest));
+		break;
+	}
+
+	// The .aaa inputs.
+	if (colorSel < TEVCOLORARG_ONE && (colorSel & 1))
+		PSHUFLW(dest, R(dest), 0);
+
+	if (colorSource == alphaSource && colorSource != FROM_ELSEWHERE)
+		return;
+
+	switch (alphaSel)
+	{
+	case TEVALPHAARG_APREV:
+	case TEVALPHAARG_A0:
+	case TEVALPHAARG_A1:
+	case TEVALPHAARG_A2:
+		PINSRW(dest, TevArg(&m_tev->Reg[alphaSel][Tev::ALP_C]), Tev::ALP_C);
+		break;
+	case TEVALPHAARG_TEXA:
+		PINSRW(dest, TevArg(&m_tev->TexColor[Tev::ALP_C]), Tev::ALP_C);
+		break;
+	case TEVALPHAARG_RASA:
+		LoadRasAlpha(EAX, uid, stageNum);
+		PINSRW(dest, R(EAX), Tev::ALP_C);
+		break;
+	case TEVALPHAARG_KONST:
+		if (stage.kaSel < 8)
+		{
+			MOV(32, R(EAX), Imm32(m_tev->FixedConstants[8 - stage.kaSel]));
+			PINSRW(dest, R(EAX), Tev::ALP_C);
+		}
+		else if (stage.kaSel < 16)
+		{
+			PINSRW(dest, TevArg(&m_tev->KonstantColors[stage.kaSel & 3][Tev::ALP_C]), Tev::ALP_C);
+		}
+		else
+		{
+			const int comp = Tev::RED_C - ((stage.kaSel - 16) >> 2);
+			PINSRW(dest, TevArg(&m_tev->KonstantColors[stage.kaSel & 3][comp]), Tev::ALP_C);
+		}
+		break;
+	case TEVALPHAARG_ZERO:
+		XOR(32, R(EAX), R(EAX));
+		PINSRW(dest, R(EAX), Tev::ALP_C);
+		break;
+	}
+}
+
+// What Tev::SetRasColor puts into RasColor.
+void TevJitCompiler::LoadRasColor(X64Reg dest, const tev_jit_uid_data &uid, u32 stageNum)
+{
+	const auto &stage = uid.stages[stageNum];
+	TevStageCombiner::AlphaCombiner ac;
+	ac.hex = stage.alphaCombiner;
+
+	switch (stage.colorChan)
+	{
+	case 0: // Color0
+	case 1: // Color1
+		{
+			// The swap table picks a byte of the RGBA color for each lane.
+			const u32 swap = uid.swapTables >> (ac.rswap * 8);
+			const u8 shuffle = (((swap >> 6) & 3) << (Tev::ALP_C * 2)) |
+			                   (((swap >> 4) & 3) << (Tev::BLU_C * 2)) |
+			                   (((swap >> 2) & 3) << (Tev::GRN_C * 2)) |
+			                   ((swap & 3) << (Tev::RED_C * 2));
+			MOVD_xmm(dest, TevArg(m_tev->Color[stage.colorChan]));
+			PXOR(XMM5, R(XMM5));
+			PUNPCKLBW(dest, R(XMM5));
+			PSHUFLW(dest, R(dest), shuffle);
+		}
+		break;
+	case 5: // alpha bump
+	case 6: // alpha bump normalized
+		if (stage.fetchTexture)
+		{
+			LoadAlphaBump(EAX, stage.colorChan == 6);
+			MOVD_xmm(dest, R(EAX));
+			PSHUFLW(dest, R(dest), 0);
+		}
+		else
+		{
+			PXOR(dest, R(dest));
+		}
+		break;
+	default: // zero
+		PXOR(dest, R(dest));
+		break;
+	}
+}
+
+void TevJitCompiler::LoadRasAlpha(X64Reg dest, const tev_jit_uid_data &uid, u32 stageNum)
+{
+	const auto &stage = uid.stages[stageNum];
+	TevStageCombiner::AlphaCombiner ac;
+	ac.hex = stage.alphaCombiner;
+
+	switch (stage.colorChan)
+	{
+	case 0: // Color0
+	case 1: // Color1
+		MOVZX(32, 8, dest, TevArg(&m_tev->Color[stage.colorChan][(uid.swapTables >> (ac.rswap * 8 + 6)) & 3]));
+		break;
+	case 5: // alpha bump
+	case 6: // alpha bump normalized
+		if (stage.fetchTexture)
+			LoadAlphaBump(dest, stage.colorChan == 6);
+		else
+			XOR(32, R(dest), R(dest));
+		break;
+	default: // zero
+		XOR(32, R(dest), R(dest));
+		break;
+	}
+}
+
+void TevJitCompiler::LoadAlphaBump(X64Reg dest, bool normalized)
+{
+	MOVZX(32, 8, dest, TevArg(&m_tev->AlphaBump));
+	if (normalized)
+	{
+		MOV(32, R(ECX), R(dest));
+		SHR(32, R(ECX), Imm8(5));
+		OR(32, R(dest), R(ECX));
+	}
+}
+
+// Compares the alpha in ECX with ref, and sets dest to 1 if it passes.
+void TevJitCompiler::CompileAlphaCompare(X64Reg dest, u32 comp, u32 ref)
+{
+	CCFlags flag;
+	switch (comp)
+	{
+	case AlphaTest::NEVER:
+		XOR(32, R(dest), R(dest));
+		return;
+	case AlphaTest::ALWAYS:
+		MOV(32, R(dest), Imm32(1));
+		return;
+	case AlphaTest::LESS:    flag = CC_L;  break;
+	case AlphaTest::EQUAL:   flag = CC_E;  break;
+	case AlphaTest::LEQUAL:  flag = CC_LE; break;
+	case AlphaTest::GREATER: flag = CC_G;  break;
+	case AlphaTest::NEQUAL:  flag = CC_NE; break;
+	default:                 flag = CC_GE; break;
+	}
+
+	XOR(32, R(dest), R(dest));
+	CMP(32, R(ECX), Imm32(ref));
+	SETcc(flag, R(dest));
+}
+
+// The output color of the last stage, and the alpha test.
+void TevJitCompiler::CompileOutput(const tev_jit_uid_data &uid)
+{
+	TevStageCombiner::ColorCombiner cc;
+	TevStageCombiner::AlphaCombiner ac;
+	cc.hex = uid.stages[uid.numStages - 1].colorCombiner;
+	ac.hex = uid.stages[uid.numStages - 1].alphaCombiner;
+
+	MOVQ_xmm(XMM0, TevArg(m_tev->Reg[cc.dest]));
+	if (ac.dest != cc.dest)
+		PINSRW(XMM0, TevArg(&m_tev->Reg[ac.dest][Tev::ALP_C]), Tev::ALP_C);
+	PAND(XMM0, Constant16(0xFF, 0xFF));
+	PACKUSWB(XMM0, R(XMM0));
+	MOVD_xmm(R(EAX), XMM0);
+	MOV(32, MatR(R12), R(EAX));
+
+	MOVZX(32, 8, ECX, R(EAX));
+	CompileAlphaCompare(EDX, uid.alphaComp0, uid.alphaRef0);
+	CompileAlphaCompare(EAX, uid.alphaComp1, uid.alphaRef1);
+	switch (uid.alphaLogic)
+	{
+	case AlphaTest::AND:
+		AND(32, R(EAX), R(EDX));
+		break;
+	case AlphaTest::OR:
+		OR(32, R(EAX), R(EDX));
+		break;
+	case AlphaTest::XOR:
+		XOR(32, R(EAX), R(EDX));
+		break;
+	case AlphaTest::XNOR:
+		XOR(32, R(EAX), R(EDX));
+		XOR(32, R(EAX), Imm8(1));
+		break;
+	}
+}
+
+namespace TevJit
+{
+
+static TevJitCompiler s_compiler;
+static std::mutex s_mutex;
+static std::map<TevJitUid, PixelFunction> s_functions;
+// Whether s_function is the function for the current setup. Set after it.
+static std::atomic<bool> s_valid;
+static PixelFunction s_function;
+
+PixelFunction GetFunction(const Tev &tev)
+{
+	if (s_valid.load(std::memory_order_acquire))
+		return s_function;
+
+	std::lock_guard<std::mutex> lk(s_mutex);
+	if (s_valid.load(std::memory_order_relaxed))
+		return s_function;
+
+	TevJitUid uid;
+	PixelFunction function = nullptr;
+	if (GetUid(uid))
+	{
+		auto it = s_functions.find(uid);
+		if (it != s_functions.end())
+		{
+			function = it->second;
+		}
+		else
+		{
+			if (!s_compiler.IsInitialized())
+			{
+				s_compiler.Init();
+			}
+			else if (s_compiler.IsFull())
+			{
+				// Nothing runs the old functions while their setup isn't current.
+				s_compiler.ClearCache();
+				s_functions.clear();
+			}
+
+			function = s_compiler.Compile(uid.GetUidData(), tev);
+			s_functions[uid] = function;
+		}
+	}
+
+	s_function = function;
+	s_valid.store(true, std::memory_order_release);
+	return function;
+}
+
+void Invalidate()
+{
+	s_valid.store(false, std::memory_order_relaxed);
+}
+
+void Shutdown()
+{
+	Invalidate();
+	if (s_compiler.IsInitialized())
+		s_compiler.Shutdown();
+	s_functions.clear();
+}
+
+}
+
+#else
+
+namespace TevJit
+{
+
+PixelFunction GetFunction(const Tev &tev)
+{
+	return nullptr;
+}
+
+void Invalidate()
+{
+}
+
+void Shutdown()
+{
+}
+
+}
+
+#endif
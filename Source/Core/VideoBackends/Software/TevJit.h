@@ -0,0 +1,28 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include "Common/Common.h"
+
+class Tev;
+
+namespace TevJit
+{
+	// Runs the TEV stages of one pixel on tev's registers, and puts the color
+	// of the last stage into output, in ABGR order. Returns whether the pixel
+	// passes the alpha test.
+	typedef u32 (*PixelFunction)(Tev *tev, u8 *output);
+
+	// The code for the TEV stages and alpha test in bpmem, compiled the first
+	// time a setup is used and kept for later ones. Returns nullptr for setups
+	// only the interpreter handles, which are those with compare modes, and
+	// on hosts other than x86-64.
+	PixelFunction GetFunction(const Tev &tev);
+
+	// Call this when bpmem may have changed, while nothing is being drawn.
+	void Invalidate();
+
+	void Shutdown();
+}
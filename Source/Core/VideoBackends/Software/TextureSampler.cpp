@@ -2,10 +2,20 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <atomic>
 #include <cmath>
+#include <list>
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <vector>
 
+#include "Common/Hash.h"
 #include "Core/HW/Memmap.h"
 #include "VideoBackends/Software/BPMemLoader.h"
+#include "VideoBackends/Software/SWStatistics.h"
+#include "VideoBackends/Software/SWVideoConfig.h"
 #include "VideoBackends/Software/TextureSampler.h"
 #include "VideoCommon/TextureDecoder.h"
 
@@ -14,6 +24,61 @@
 namespace TextureSampler
 {
 
+enum
+{
+	// Down to 1x1 from 1024x1024, the largest texture size.
+	MAX_MIP_LEVELS = 11,
+};
+
+// Everything decoding a mip level depends on, apart from the memory contents.
+struct CacheKey
+{
+	bool tmem;
+	// Main memory address, or TMEM offset of preloaded textures.
+	u32 address;
+	// TMEM offset of the GB tiles of preloaded RGBA8 textures.
+	u32 oddAddress;
+	int format;
+	int tlutAddress;
+	int tlutFormat;
+	// Largest s and t coordinates.
+	int width;
+	int height;
+
+	bool operator<(const CacheKey& other) const
+	{
+		return std::tie(tmem, address, oddAddress, format, tlutAddress, tlutFormat, width, height) <
+		       std::tie(other.tmem, other.address, other.oddAddress, other.format, other.tlutAddress, other.tlutFormat, other.width, other.height);
+	}
+};
+
+struct MipLevel
+{
+	CacheKey key;
+	const u8 *src;
+	const u8 *srcOdd;
+};
+
+struct CacheEntry
+{
+	CacheKey key;
+	// Of the encoded texels and the palette, to notice when they change.
+	u64 hash;
+	// Sampled by a texmap, so it can't be evicted.
+	bool bound;
+	// RGBA, row by row.
+	std::vector<u8> texels;
+};
+
+// Most recently used first.
+static std::list<CacheEntry> s_cache;
+static std::map<CacheKey, std::list<CacheEntry>::iterator> s_cacheMap;
+static size_t s_cacheSize;
+// The rasterizer threads look up textures while drawing.
+static std::mutex s_cacheMutex;
+// The entry each texmap and mip level samples, looked up on first use.
+static std::atomic<const CacheEntry*> s_bound[8][MAX_MIP_LEVELS];
+
 inline void WrapCoord(int &coord, int wrapMode, int imageSize)
 {
 	switch (wrapMode)
@@ -37,7 +102,7 @@ inline void WrapCoord(int &coord, int wrapMode, int imageSize)
 	}
 }
 
-inline void SetTexel(u8 *inTexel, u32 *outTexel, u32 fract)
+inline void SetTexel(const u8 *inTexel, u32 *outTexel, u32 fract)
 {
 	outTexel[0] = inTexel[0] * fract;
 	outTexel[1] = inTexel[1] * fract;
@@ -45,7 +110,7 @@ inline void SetTexel(u8 *inTexel, u32 *outTexel, u32 fract)
 	outTexel[3] = inTexel[3] * fract;
 }
 
-inline void AddTexel(u8 *inTexel, u32 *outTexel, u32 fract)
+inline void AddTexel(const u8 *inTexel, u32 *outTexel, u32 fract)
 {
 	outTexel[0] += inTexel[0] * fract;
 	outTexel[1] += inTexel[1] * fract;
@@ -53,6 +118,216 @@ inline void AddTexel(u8 *inTexel, u32 *outTexel, u32 fract)
 	outTexel[3] += inTexel[3] * fract;
 }
 
+static bool IsPaletteFormat(int format)
+{
+	return format == GX_TF_C4 || format == GX_TF_C8 || format == GX_TF_C14X2;
+}
+
+static void GetMipLevel(u8 texmap, s32 mip, MipLevel &level)
+{
+	FourTexUnits& texUnit = bpmem.tex[(texmap >> 2) & 1];
+	u8 subTexmap = texmap & 3;
+
+	TexImage0& ti0 = texUnit.texImage0[subTexmap];
+	TexTLUT& texTlut = texUnit.texTlut[subTexmap];
+
+	CacheKey& key = level.key;
+	key.tmem = texUnit.texImage1[subTexmap].image_type != 0;
+	key.format = ti0.format;
+	// Other formats don't look at the TLUT.
+	key.tlutAddress = IsPaletteFormat(ti0.format) ? texTlut.tmem_offset << 9 : 0;
+	key.tlutFormat = IsPaletteFormat(ti0.format) ? texTlut.tlut_format : 0;
+	key.width = ti0.width >> mip;
+	key.height = ti0.height >> mip;
+
+	level.srcOdd = nullptr;
+	key.oddAddress = 0;
+	if (key.tmem)
+	{
+		key.address = texUnit.texImage1[subTexmap].tmem_even * TMEM_LINE_SIZE;
+		level.src = &texMem[key.address];
+		if (ti0.format == GX_TF_RGBA8)
+		{
+			key.oddAddress = texUnit.texImage2[subTexmap].tmem_odd * TMEM_LINE_SIZE;
+			level.srcOdd = &texMem[key.oddAddress];
+		}
+	}
+	else
+	{
+		key.address = texUnit.texImage3[subTexmap].image_base << 5;
+		level.src = Memory::GetPointer(key.address);
+	}
+
+	// move texture pointer to mip location
+	if (mip)
+	{
+		int mipWidth = ti0.width + 1;
+		int mipHeight = ti0.height + 1;
+
+		int fmtWidth = TexDecoder_GetBlockWidthInTexels(ti0.format);
+		int fmtHeight = TexDecoder_GetBlockHeightInTexels(ti0.format);
+		int fmtDepth = TexDecoder_GetTexelSizeInNibbles(ti0.format);
+
+		u32 offset = 0;
+		while (mip)
+		{
+			mipWidth = max(mipWidth, fmtWidth);
+			mipHeight = max(mipHeight, fmtHeight);
+			offset += (mipWidth * mipHeight * fmtDepth) >> 1;
+
+			mipWidth >>= 1;
+			mipHeight >>= 1;
+			mip--;
+		}
+
+		key.address += offset;
+		if (level.src)
+			level.src += offset;
+	}
+}
+
+static inline void DecodeTexel(u8 *dst, const MipLevel& level, int s, int t)
+{
+	const CacheKey& key = level.key;
+	if (level.srcOdd)
+		TexDecoder_DecodeTexelRGBA8FromTmem(dst, level.src, level.srcOdd, s, t, key.width);
+	else
+		TexDecoder_DecodeTexel(dst, level.src, s, t, key.width, key.format, key.tlutAddress, key.tlutFormat);
+}
+
+// Only a texture in TMEM can end too close to its end for the whole texture.
+static u64 HashTmem(const u8 *src, int size)
+{
+	return GetHash64(src, std::min(size, (int)(texMem + TMEM_SIZE - src)), 0);
+}
+
+static u64 HashMipLevel(const MipLevel& level)
+{
+	const CacheKey& key = level.key;
+	int size = TexDecoder_GetTextureSizeInBytes(key.width + 1, key.height + 1, key.format);
+
+	u64 hash;
+	if (level.srcOdd)
+		hash = HashTmem(level.src, size / 2) * 31 + HashTmem(level.srcOdd, size / 2);
+	else if (key.tmem)
+		hash = HashTmem(level.src, size);
+	else
+		hash = GetHash64(level.src, size, 0);
+
+	if (IsPaletteFormat(key.format))
+	{
+		int entries = key.format == GX_TF_C4 ? 16 : key.format == GX_TF_C8 ? 256 : 16384;
+		hash = hash * 31 + HashTmem(texMem + key.tlutAddress, entries * 2);
+	}
+	return hash;
+}
+
+// Finds the mip level in the cache, and checks that its texels didn't change
+// since they were decoded. Decodes them if they did, or if it isn't cached.
+static const CacheEntry *Bind(u8 texmap, s32 mip, const MipLevel& level)
+{
+	const size_t maxSize = (size_t)g_SWVideoConfig.textureCacheSize << 20;
+	if (maxSize == 0 || !level.src)
+		return nullptr;
+
+	std::lock_guard<std::mutex> lk(s_cacheMutex);
+
+	// Another thread might have got here first.
+	const CacheEntry *bound = s_bound[texmap][mip].load(std::memory_order_relaxed);
+	if (bound)
+		return bound;
+
+	bool decode = false;
+	auto iter = s_cacheMap.find(level.key);
+	if (iter != s_cacheMap.end())
+	{
+		s_cache.splice(s_cache.begin(), s_cache, iter->second);
+	}
+	else
+	{
+		s_cache.emplace_front();
+		s_cache.front().key = level.key;
+		s_cache.front().bound = false;
+		s_cache.front().texels.resize((level.key.width + 1) * (level.key.height + 1) * 4);
+		s_cacheSize += s_cache.front().texels.size();
+		s_cacheMap[level.key] = s_cache.begin();
+		decode = true;
+	}
+	CacheEntry& entry = s_cache.front();
+
+	// Texture memory doesn't change while entries are bound.
+	if (!entry.bound)
+	{
+		u64 hash = HashMipLevel(level);
+		decode = decode || hash != entry.hash;
+		entry.hash = hash;
+		entry.bound = true;
+	}
+
+	if (decode)
+	{
+		u8 *dst = &entry.texels[0];
+		for (int t = 0; t <= level.key.height; t++)
+		{
+			for (int s = 0; s <= level.key.width; s++)
+			{
+				DecodeTexel(dst, level, s, t);
+				dst += 4;
+			}
+		}
+		INCSTAT(swstats.thisFrame.textureCacheMisses);
+	}
+	else
+	{
+		INCSTAT(swstats.thisFrame.textureCacheHits);
+	}
+
+	// Evict the least recently used entries that aren't bound.
+	for (auto it = s_cache.end(); s_cacheSize > maxSize && it != s_cache.begin();)
+	{
+		--it;
+		if (!it->bound)
+		{
+			s_cacheSize -= it->texels.size();
+			s_cacheMap.erase(it->key);
+			it = s_cache.erase(it);
+		}
+	}
+
+	s_bound[texmap][mip].store(&entry, std::memory_order_release);
+	return &entry;
+}
+
+// The texel at s, t, either from the cache or decoded into buffer.
+static inline const u8 *GetTexel(const CacheEntry *entry, const MipLevel& level, int s, int t, u8 *buffer)
+{
+	if (entry)
+		return &entry->texels[(t * (entry->key.width + 1) + s) * 4];
+
+	DecodeTexel(buffer, level, s, t);
+	return buffer;
+}
+
+void Invalidate()
+{
+	for (auto& texmap : s_bound)
+	{
+		for (auto& bound : texmap)
+			bound.store(nullptr, std::memory_order_relaxed);
+	}
+
+	for (CacheEntry& entry : s_cache)
+		entry.bound = false;
+}
+
+void Shutdown()
+{
+	Invalidate();
+	s_cacheMap.clear();
+	s_cache.clear();
+	s_cacheSize = 0;
+}
+
 void Sample(s32 s, s32 t, s32 lod, bool linear, u8 texmap, u8 *sample)
 {
 	int baseMip = 0;
@@ -100,58 +375,27 @@ void Sample(s32 s, s32 t, s32 lod, bool linear, u8 texmap, u8 *sample)
 void SampleMip(s32 s, s32 t, s32 mip, bool linear, u8 texmap, u8 *sample)
 {
 	FourTexUnits& texUnit = bpmem.tex[(texmap >> 2) & 1];
-	u8 subTexmap = texmap & 3;
+	TexMode0& tm0 = texUnit.texMode0[texmap & 3];
 
-	TexMode0& tm0 = texUnit.texMode0[subTexmap];
-	TexImage0& ti0 = texUnit.texImage0[subTexmap];
-	TexTLUT& texTlut = texUnit.texTlut[subTexmap];
+	const CacheEntry *entry = nullptr;
+	if (mip < MAX_MIP_LEVELS)
+		entry = s_bound[texmap][mip].load(std::memory_order_acquire);
 
-	u8 *imageSrc, *imageSrcOdd = nullptr;
-	if (texUnit.texImage1[subTexmap].image_type)
+	MipLevel level;
+	if (!entry)
 	{
-		imageSrc = &texMem[texUnit.texImage1[subTexmap].tmem_even * TMEM_LINE_SIZE];
-		if (ti0.format == GX_TF_RGBA8)
-			imageSrcOdd = &texMem[texUnit.texImage2[subTexmap].tmem_odd * TMEM_LINE_SIZE];
+		GetMipLevel(texmap, mip, level);
+		if (mip < MAX_MIP_LEVELS)
+			entry = Bind(texmap, mip, level);
 	}
-	else
-	{
-		u32 imageBase = texUnit.texImage3[subTexmap].image_base << 5;
-		imageSrc = Memory::GetPointer(imageBase);
-	}
-
-	int imageWidth = ti0.width;
-	int imageHeight = ti0.height;
-
-	int tlutAddress = texTlut.tmem_offset << 9;
-
-	// reduce sample location and texture size to mip level
-	// move texture pointer to mip location
-	if (mip)
-	{
-		int mipWidth = imageWidth + 1;
-		int mipHeight = imageHeight + 1;
 
-		int fmtWidth = TexDecoder_GetBlockWidthInTexels(ti0.format);
-		int fmtHeight = TexDecoder_GetBlockHeightInTexels(ti0.format);
-		int fmtDepth = TexDecoder_GetTexelSizeInNibbles(ti0.format);
-
-		imageWidth >>= mip;
-		imageHeight >>= mip;
-		s >>= mip;
-		t >>= mip;
-
-		while (mip)
-		{
-			mipWidth = max(mipWidth, fmtWidth);
-			mipHeight = max(mipHeight, fmtHeight);
-			u32 size = (mipWidth * mipHeight * fmtDepth) >> 1;
+	const CacheKey& key = entry ? entry->key : level.key;
+	int imageWidth = key.width;
+	int imageHeight = key.height;
 
-			imageSrc += size;
-			mipWidth >>= 1;
-			mipHeight >>= 1;
-			mip--;
-		}
-	}
+	// reduce sample location to mip level
+	s >>= mip;
+	t >>= mip;
 
 	if (linear)
 	{
@@ -178,34 +422,10 @@ void SampleMip(s32 s, s32 t, s32 mip, bool linear, u8 texmap, u8 *sample)
 		WrapCoord(imageSPlus1, tm0.wrap_s, imageWidth);
 		WrapCoord(imageTPlus1, tm0.wrap_t, imageHeight);
 
-		if (!(ti0.format == GX_TF_RGBA8 && texUnit.texImage1[subTexmap].image_type))
-		{
-			TexDecoder_DecodeTexel(sampledTex, imageSrc, imageS, imageT, imageWidth, ti0.format, tlutAddress, texTlut.tlut_format);
-			SetTexel(sampledTex, texel, (128 - fractS) * (128 - fractT));
-
-			TexDecoder_DecodeTexel(sampledTex, imageSrc, imageSPlus1, imageT, imageWidth, ti0.format, tlutAddress, texTlut.tlut_format);
-			AddTexel(sampledTex, texel, (fractS) * (128 - fractT));
-
-			TexDecoder_DecodeTexel(sampledTex, imageSrc, imageS, imageTPlus1, imageWidth, ti0.format, tlutAddress, texTlut.tlut_format);
-			AddTexel(sampledTex, texel, (128 - fractS) * (fractT));
-
-			TexDecoder_DecodeTexel(sampledTex, imageSrc, imageSPlus1, imageTPlus1, imageWidth, ti0.format, tlutAddress, texTlut.tlut_format);
-			AddTexel(sampledTex, texel, (fractS) * (fractT));
-		}
-		else
-		{
-			TexDecoder_DecodeTexelRGBA8FromTmem(sampledTex, imageSrc, imageSrcOdd, imageS, imageT, imageWidth);
-			SetTexel(sampledTex, texel, (128 - fractS) * (128 - fractT));
-
-			TexDecoder_DecodeTexelRGBA8FromTmem(sampledTex, imageSrc, imageSrcOdd, imageSPlus1, imageT, imageWidth);
-			AddTexel(sampledTex, texel, (fractS) * (128 - fractT));
-
-			TexDecoder_DecodeTexelRGBA8FromTmem(sampledTex, imageSrc, imageSrcOdd, imageS, imageTPlus1, imageWidth);
-			AddTexel(sampledTex, texel, (128 - fractS) * (fractT));
-
-			TexDecoder_DecodeTexelRGBA8FromTmem(sampledTex, imageSrc, imageSrcOdd, imageSPlus1, imageTPlus1, imageWidth);
-			AddTexel(sampledTex, texel, (fractS) * (fractT));
-		}
+		SetTexel(GetTexel(entry, level, imageS, imageT, sampledTex), texel, (128 - fractS) * (128 - fractT));
+		AddTexel(GetTexel(entry, level, imageSPlus1, imageT, sampledTex), texel, (fractS) * (128 - fractT));
+		AddTexel(GetTexel(entry, level, imageS, imageTPlus1, sampledTex), texel, (128 - fractS) * (fractT));
+		AddTexel(GetTexel(entry, level, imageSPlus1, imageTPlus1, sampledTex), texel, (fractS) * (fractT));
 
 		sample[0] = (u8)(texel[0] >> 14);
 		sample[1] = (u8)(texel[1] >> 14);
@@ -222,10 +442,9 @@ void SampleMip(s32 s, s32 t, s32 mip, bool linear, u8 texmap, u8 *sample)
 		WrapCoord(imageS, tm0.wrap_s, imageWidth);
 		WrapCoord(imageT, tm0.wrap_t, imageHeight);
 
-		if (!(ti0.format == GX_TF_RGBA8 && texUnit.texImage1[subTexmap].image_type))
-			TexDecoder_DecodeTexel(sample, imageSrc, imageS, imageT, imageWidth, ti0.format, tlutAddress, texTlut.tlut_format);
-		else
-			TexDecoder_DecodeTexelRGBA8FromTmem(sample, imageSrc, imageSrcOdd, imageS, imageT, imageWidth);
+		const u8 *texel = GetTexel(entry, level, imageS, imageT, sample);
+		if (texel != sample)
+			memcpy(sample, texel, 4);
 	}
 }
 
@@ -12,5 +12,13 @@ namespace TextureSampler
 
 	void SampleMip(s32 s, s32 t, s32 mip, bool linear, u8 texmap, u8 *sample);
 
+	// Sampled textures are decoded once and kept in a cache, up to
+	// g_SWVideoConfig.textureCacheSize. Call this when texture registers or
+	// texture memory may have changed, while nothing is being drawn: the next
+	// sample of each texture checks its texels and palette for changes.
+	void Invalidate();
+
+	void Shutdown();
+
 	enum { RED_SMP, GRN_SMP, BLU_SMP, ALP_SMP };
 }
@@ -3,6 +3,9 @@
 // Refer to the license.txt file included.
 
 #include <cmath>
+#if _M_X86
+#include <emmintrin.h>
+#endif
 
 #include "Common/Common.h"
 #include "VideoBackends/Software/BPMemLoader.h"
@@ -508,4 +511,627 @@ void TransformTexCoord(const InputVertexData *src, OutputVertexData *dst, bool s
 	}
 }
 
+#if _M_X86
+
+// Four vertices at a time, one in each SSE lane. Every operation is done in
+// the same order as in the functions above, so the results are the same to
+// the bit.
+//
+// SSE2 is always there, so this needs no cpu_info check. An AVX version
+// could be picked at runtime like the SSE4.1 paths of Tev and Rasterizer,
+// but it isn't worth it: a run is one primitive, often only a few vertices
+// long, so eight lanes would be full less often than four, and what's left
+// over goes through the scalar functions.
+
+struct Vec3x4
+{
+	__m128 x, y, z;
+};
+
+static inline Vec3x4 Broadcast(const Vec3 &v)
+{
+	Vec3x4 result = { _mm_set1_ps(v.x), _mm_set1_ps(v.y), _mm_set1_ps(v.z) };
+	return result;
+}
+
+static inline Vec3x4 Sub(const Vec3x4 &a, const Vec3x4 &b)
+{
+	Vec3x4 result = { _mm_sub_ps(a.x, b.x), _mm_sub_ps(a.y, b.y), _mm_sub_ps(a.z, b.z) };
+	return result;
+}
+
+static inline Vec3x4 Scale(const Vec3x4 &v, __m128 f)
+{
+	Vec3x4 result = { _mm_mul_ps(v.x, f), _mm_mul_ps(v.y, f), _mm_mul_ps(v.z, f) };
+	return result;
+}
+
+static inline __m128 Dot(const Vec3x4 &a, const Vec3x4 &b)
+{
+	return _mm_add_ps(_mm_add_ps(_mm_mul_ps(a.x, b.x), _mm_mul_ps(a.y, b.y)), _mm_mul_ps(a.z, b.z));
+}
+
+// Vec3::operator/ multiplies by the reciprocal.
+static inline Vec3x4 Divide(const Vec3x4 &v, __m128 f)
+{
+	return Scale(v, _mm_div_ps(_mm_set1_ps(1.0f), f));
+}
+
+static inline Vec3x4 Normalized(const Vec3x4 &v)
+{
+	return Divide(v, _mm_sqrt_ps(Dot(v, v)));
+}
+
+// max(0.0f, v) and Clamp(v, 0.0f, 1.0f), NaNs included.
+static inline __m128 MaxZero(__m128 v)
+{
+	return _mm_max_ps(_mm_setzero_ps(), v);
+}
+
+static inline __m128 ClampUnit(__m128 v)
+{
+	return MaxZero(_mm_min_ps(_mm_set1_ps(1.0f), v));
+}
+
+static inline __m128 SafeDivide(__m128 n, __m128 d)
+{
+	const __m128 zero_d = _mm_cmpeq_ps(d, _mm_setzero_ps());
+	const __m128 special = _mm_and_ps(_mm_cmpgt_ps(n, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+	return _mm_or_ps(_mm_and_ps(zero_d, special), _mm_andnot_ps(zero_d, _mm_div_ps(n, d)));
+}
+
+static inline __m128 GatherFloat(const float *const p[4], int i)
+{
+	return _mm_setr_ps(p[0][i], p[1][i], p[2][i], p[3][i]);
+}
+
+static inline Vec3x4 Gather(const float *const p[4])
+{
+	Vec3x4 result = { GatherFloat(p, 0), GatherFloat(p, 1), GatherFloat(p, 2) };
+	return result;
+}
+
+static inline void Scatter(const Vec3x4 &v, float *const p[4])
+{
+	float x[4], y[4], z[4];
+	_mm_storeu_ps(x, v.x);
+	_mm_storeu_ps(y, v.y);
+	_mm_storeu_ps(z, v.z);
+	for (int i = 0; i < 4; ++i)
+	{
+		p[i][0] = x[i];
+		p[i][1] = y[i];
+		p[i][2] = z[i];
+	}
+}
+
+// Element i of the four matrices goes to m[i]. Vertices mostly share their
+// matrix, which saves the gathering.
+static inline void LoadMatrices(__m128 *m, int count, const float *const mat[4])
+{
+	if (mat[0] == mat[1] && mat[0] == mat[2] && mat[0] == mat[3])
+	{
+		for (int i = 0; i < count; ++i)
+			m[i] = _mm_set1_ps(mat[0][i]);
+	}
+	else
+	{
+		for (int i = 0; i < count; ++i)
+			m[i] = GatherFloat(mat, i);
+	}
+}
+
+static inline __m128 Row3(const __m128 *row, const Vec3x4 &v)
+{
+	return _mm_add_ps(_mm_add_ps(_mm_mul_ps(row[0], v.x), _mm_mul_ps(row[1], v.y)), _mm_mul_ps(row[2], v.z));
+}
+
+static inline __m128 Row3Offset(const __m128 *row, const Vec3x4 &v)
+{
+	return _mm_add_ps(Row3(row, v), row[3]);
+}
+
+static inline __m128 Row2Offset(const __m128 *row, const Vec3x4 &v)
+{
+	return _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(row[0], v.x), _mm_mul_ps(row[1], v.y)), row[2]), row[3]);
+}
+
+static inline void AddScaledColor(const u8 *color, __m128 scale, Vec3x4 &lightCol)
+{
+	lightCol.x = _mm_add_ps(lightCol.x, _mm_mul_ps(_mm_set1_ps(color[1]), scale));
+	lightCol.y = _mm_add_ps(lightCol.y, _mm_mul_ps(_mm_set1_ps(color[2]), scale));
+	lightCol.z = _mm_add_ps(lightCol.z, _mm_mul_ps(_mm_set1_ps(color[3]), scale));
+}
+
+// The specular test compares a float with the double -655.36, which is the
+// same as comparing with the first float above it.
+static float GetSpecularThreshold()
+{
+	float threshold = (float)-655.36;
+	if (threshold <= -655.36)
+		threshold = nextafterf(threshold, 0.0f);
+	return threshold;
+}
+
+static const float s_specularThreshold = GetSpecularThreshold();
+
+// The attenuation of a spot or specular light, and the direction used for
+// its diffuse part.
+static inline __m128 Attenuation(const LightPointer *light, const Vec3x4 &pos, const Vec3x4 &normal, u32 attnfunc, Vec3x4 &ldir)
+{
+	ldir = Sub(Broadcast(light->pos), pos);
+
+	if (attnfunc == 3) // spot
+	{
+		const __m128 dist2 = Dot(ldir, ldir);
+		const __m128 dist = _mm_sqrt_ps(dist2);
+		ldir = Divide(ldir, dist);
+		const __m128 attn = MaxZero(Dot(ldir, Broadcast(light->dir)));
+
+		const __m128 cosAtt = _mm_add_ps(_mm_add_ps(_mm_set1_ps(light->cosatt.x), _mm_mul_ps(_mm_set1_ps(light->cosatt.y), attn)),
+			_mm_mul_ps(_mm_mul_ps(_mm_set1_ps(light->cosatt.z), attn), attn));
+		const __m128 distAtt = _mm_add_ps(_mm_add_ps(_mm_set1_ps(light->distatt.x), _mm_mul_ps(_mm_set1_ps(light->distatt.y), dist)),
+			_mm_mul_ps(_mm_set1_ps(light->distatt.z), dist2));
+		return SafeDivide(MaxZero(cosAtt), distAtt);
+	}
+	else // specular
+	{
+		const __m128 facing = _mm_cmpge_ps(Dot(Broadcast(light->pos), normal), _mm_set1_ps(s_specularThreshold));
+		const __m128 attn = _mm_and_ps(facing, MaxZero(Dot(Broadcast(light->dir), normal)));
+		ldir.x = _mm_set1_ps(1.0f);
+		ldir.y = attn;
+		ldir.z = _mm_mul_ps(attn, attn);
+
+		const __m128 cosAtt = Dot(Broadcast(light->cosatt), ldir);
+		const __m128 distAtt = Dot(Broadcast(light->distatt), ldir);
+		return SafeDivide(MaxZero(cosAtt), distAtt);
+	}
+}
+
+static void LightColor4(const Vec3x4 &pos, const Vec3x4 &normal, u8 lightNum, const LitChannel &chan, Vec3x4 &lightCol)
+{
+	const LightPointer *light = (const LightPointer*)&swxfregs.lights[0x10*lightNum];
+
+	if (!(chan.attnfunc & 1))
+	{
+		// atten disabled
+		switch (chan.diffusefunc)
+		{
+			case LIGHTDIF_NONE:
+				AddScaledColor(light->color, _mm_set1_ps(1.0f), lightCol);
+				break;
+			case LIGHTDIF_SIGN:
+				AddScaledColor(light->color, Dot(Normalized(Sub(Broadcast(light->pos), pos)), normal), lightCol);
+				break;
+			case LIGHTDIF_CLAMP:
+				AddScaledColor(light->color, MaxZero(Dot(Normalized(Sub(Broadcast(light->pos), pos)), normal)), lightCol);
+				break;
+			default: _assert_(0);
+		}
+	}
+	else // spec and spot
+	{
+		if (chan.attnfunc != 3 && chan.attnfunc != 1)
+		{
+			PanicAlert("LightColor");
+			return;
+		}
+
+		Vec3x4 ldir;
+		const __m128 attn = Attenuation(light, pos, normal, chan.attnfunc, ldir);
+
+		switch (chan.diffusefunc)
+		{
+			case LIGHTDIF_NONE:
+				AddScaledColor(light->color, attn, lightCol);
+				break;
+			case LIGHTDIF_SIGN:
+				AddScaledColor(light->color, _mm_mul_ps(attn, Dot(ldir, normal)), lightCol);
+				break;
+			case LIGHTDIF_CLAMP:
+				AddScaledColor(light->color, _mm_mul_ps(attn, MaxZero(Dot(ldir, normal))), lightCol);
+				break;
+			default: _assert_(0);
+		}
+	}
+}
+
+static void LightAlpha4(const Vec3x4 &pos, const Vec3x4 &normal, u8 lightNum, const LitChannel &chan, __m128 &lightCol)
+{
+	const LightPointer *light = (const LightPointer*)&swxfregs.lights[0x10*lightNum];
+	const __m128 color = _mm_set1_ps(light->color[0]);
+
+	if (!(chan.attnfunc & 1))
+	{
+		// atten disabled
+		switch (chan.diffusefunc)
+		{
+			case LIGHTDIF_NONE:
+				lightCol = _mm_add_ps(lightCol, color);
+				break;
+			case LIGHTDIF_SIGN:
+				lightCol = _mm_add_ps(lightCol, _mm_mul_ps(color, Dot(Normalized(Sub(Broadcast(light->pos), pos)), normal)));
+				break;
+			case LIGHTDIF_CLAMP:
+				lightCol = _mm_add_ps(lightCol, _mm_mul_ps(color, MaxZero(Dot(Normalized(Sub(Broadcast(light->pos), pos)), normal))));
+				break;
+			default: _assert_(0);
+		}
+	}
+	else // spec and spot
+	{
+		Vec3x4 ldir;
+		const __m128 attn = Attenuation(light, pos, normal, chan.attnfunc == 3 ? 3 : 1, ldir);
+
+		switch (chan.diffusefunc)
+		{
+			case LIGHTDIF_NONE:
+				lightCol = _mm_add_ps(lightCol, _mm_mul_ps(color, attn));
+				break;
+			case LIGHTDIF_SIGN:
+				lightCol = _mm_add_ps(lightCol, _mm_mul_ps(_mm_mul_ps(color, attn), Dot(ldir, normal)));
+				break;
+			case LIGHTDIF_CLAMP:
+				lightCol = _mm_add_ps(lightCol, _mm_mul_ps(_mm_mul_ps(color, attn), MaxZero(Dot(ldir, normal))));
+				break;
+			default: _assert_(0);
+		}
+	}
+}
+
+// One byte of each vertex's color, as floats.
+static inline __m128 ColorComponent(const u8 *const color[4], int comp)
+{
+	return _mm_setr_ps(color[0][comp], color[1][comp], color[2][comp], color[3][comp]);
+}
+
+static void TransformColor4(const Vec3x4 &pos, const Vec3x4 &normal, const InputVertexData *src, OutputVertexData *dst)
+{
+	for (u32 chan = 0; chan < swxfregs.nNumChans; chan++)
+	{
+		// abgr
+		u8 matcolor[4][4];
+		u8 chancolor[4][4];
+		const u8 *vertexColor[4];
+		for (int i = 0; i < 4; ++i)
+			vertexColor[i] = src[i].color[chan];
+
+		// color
+		const LitChannel &colorchan = swxfregs.color[chan];
+		for (int i = 0; i < 4; ++i)
+		{
+			if (colorchan.matsource)
+				memcpy(matcolor[i], vertexColor[i], 4);
+			else
+				memcpy(matcolor[i], &swxfregs.matColor[chan], 4);
+		}
+
+		if (colorchan.enablelighting)
+		{
+			Vec3x4 lightCol;
+			if (colorchan.ambsource)
+			{
+				lightCol.x = ColorComponent(vertexColor, 1);
+				lightCol.y = ColorComponent(vertexColor, 2);
+				lightCol.z = ColorComponent(vertexColor, 3);
+			}
+			else
+			{
+				const u8 *ambColor = (const u8*)&swxfregs.ambColor[chan];
+				lightCol.x = _mm_set1_ps(ambColor[1]);
+				lightCol.y = _mm_set1_ps(ambColor[2]);
+				lightCol.z = _mm_set1_ps(ambColor[3]);
+			}
+
+			const u8 mask = colorchan.GetFullLightMask();
+			for (int i = 0; i < 8; ++i)
+			{
+				if (mask&(1<<i))
+					LightColor4(pos, normal, i, colorchan, lightCol);
+			}
+
+			const u8 *mat[4] = { matcolor[0], matcolor[1], matcolor[2], matcolor[3] };
+			const __m128 inv = _mm_set1_ps(1.0f / 255.0f);
+			s32 result[3][4];
+			_mm_storeu_si128((__m128i*)result[0], _mm_cvttps_epi32(_mm_mul_ps(ColorComponent(mat, 1), ClampUnit(_mm_mul_ps(lightCol.x, inv)))));
+			_mm_storeu_si128((__m128i*)result[1], _mm_cvttps_epi32(_mm_mul_ps(ColorComponent(mat, 2), ClampUnit(_mm_mul_ps(lightCol.y, inv)))));
+			_mm_storeu_si128((__m128i*)result[2], _mm_cvttps_epi32(_mm_mul_ps(ColorComponent(mat, 3), ClampUnit(_mm_mul_ps(lightCol.z, inv)))));
+			for (int i = 0; i < 4; ++i)
+			{
+				chancolor[i][1] = (u8)result[0][i];
+				chancolor[i][2] = (u8)result[1][i];
+				chancolor[i][3] = (u8)result[2][i];
+			}
+		}
+		else
+		{
+			for (int i = 0; i < 4; ++i)
+				memcpy(chancolor[i], matcolor[i], 4);
+		}
+
+		// alpha
+		const LitChannel &alphachan = swxfregs.alpha[chan];
+		for (int i = 0; i < 4; ++i)
+		{
+			if (alphachan.matsource)
+				matcolor[i][0] = vertexColor[i][0];
+			else
+				matcolor[i][0] = swxfregs.matColor[chan] & 0xff;
+		}
+
+		if (alphachan.enablelighting)
+		{
+			__m128 lightCol;
+			if (alphachan.ambsource)
+				lightCol = ColorComponent(vertexColor, 0);
+			else
+				lightCol = _mm_set1_ps((float)(swxfregs.ambColor[chan] & 0xff));
+
+			const u8 mask = alphachan.GetFullLightMask();
+			for (int i = 0; i < 8; ++i)
+			{
+				if (mask&(1<<i))
+					LightAlpha4(pos, normal, i, alphachan, lightCol);
+			}
+
+			const u8 *mat[4] = { matcolor[0], matcolor[1], matcolor[2], matcolor[3] };
+			s32 result[4];
+			_mm_storeu_si128((__m128i*)result, _mm_cvttps_epi32(_mm_mul_ps(ColorComponent(mat, 0), ClampUnit(_mm_div_ps(lightCol, _mm_set1_ps(255.0f))))));
+			for (int i = 0; i < 4; ++i)
+				chancolor[i][0] = (u8)result[i];
+		}
+		else
+		{
+			for (int i = 0; i < 4; ++i)
+				chancolor[i][0] = matcolor[i][0];
+		}
+
+		// abgr -> rgba
+		for (int i = 0; i < 4; ++i)
+			*(u32*)dst[i].color[chan] = Common::swap32(*(u32*)chancolor[i]);
+	}
+}
+
+static void TransformTexCoord4(const Vec3x4 &position, const InputVertexData *src, OutputVertexData *dst, bool specialCase)
+{
+	Vec3x4 texCoords[8];
+	bool done[8] = {};
+	float *dstCoord[8][4];
+	for (int coordNum = 0; coordNum < 8; ++coordNum)
+	{
+		for (int i = 0; i < 4; ++i)
+			dstCoord[coordNum][i] = &dst[i].texCoords[coordNum].x;
+	}
+
+	for (u32 coordNum = 0; coordNum < swxfregs.numTexGens; coordNum++)
+	{
+		const TexMtxInfo &texinfo = swxfregs.texMtxInfo[coordNum];
+		Vec3x4 &coord = texCoords[coordNum];
+
+		switch (texinfo.texgentype)
+		{
+		case XF_TEXGEN_REGULAR:
+			{
+				Vec3x4 source;
+				const float *sourceRow[4];
+				for (int i = 0; i < 4; ++i)
+				{
+					switch (texinfo.sourcerow)
+					{
+						case XF_SRCGEOM_INROW:       sourceRow[i] = &src[i].position.x; break;
+						case XF_SRCNORMAL_INROW:     sourceRow[i] = &src[i].normal[0].x; break;
+						case XF_SRCBINORMAL_T_INROW: sourceRow[i] = &src[i].normal[1].x; break;
+						case XF_SRCBINORMAL_B_INROW: sourceRow[i] = &src[i].normal[2].x; break;
+						default:
+							_assert_(texinfo.sourcerow >= XF_SRCTEX0_INROW && texinfo.sourcerow <= XF_SRCTEX7_INROW);
+							sourceRow[i] = src[i].texCoords[texinfo.sourcerow - XF_SRCTEX0_INROW];
+							break;
+					}
+				}
+				source = texinfo.sourcerow == XF_SRCGEOM_INROW ? position : Gather(sourceRow);
+
+				const float *mat[4];
+				for (int i = 0; i < 4; ++i)
+					mat[i] = (const float*)&swxfregs.posMatrices[src[i].texMtx[coordNum] * 4];
+				__m128 m[12];
+				const bool stq = texinfo.projection == XF_TEXPROJ_STQ;
+				LoadMatrices(m, stq ? 12 : 8, mat);
+
+				const bool ab11 = texinfo.inputform == XF_TEXINPUT_AB11 || (!stq && specialCase);
+				coord.x = ab11 ? Row2Offset(&m[0], source) : Row3Offset(&m[0], source);
+				coord.y = ab11 ? Row2Offset(&m[4], source) : Row3Offset(&m[4], source);
+				if (stq)
+					coord.z = ab11 ? Row2Offset(&m[8], source) : Row3Offset(&m[8], source);
+				else
+					coord.z = _mm_set1_ps(1.0f);
+
+				if (swxfregs.dualTexTrans)
+				{
+					const PostMtxInfo &postInfo = swxfregs.postMtxInfo[coordNum];
+					const float *postMat = (const float*)&swxfregs.postMatrices[postInfo.index * 4];
+					__m128 p[12];
+					for (int i = 0; i < 12; ++i)
+						p[i] = _mm_set1_ps(postMat[i]);
+
+					if (specialCase)
+					{
+						// no normalization
+						// q of input is 1
+						// q of output is unknown
+						const Vec3x4 tempCoord = coord;
+						coord.x = Row2Offset(&p[0], tempCoord);
+						coord.y = Row2Offset(&p[4], tempCoord);
+						coord.z = _mm_set1_ps(1.0f);
+					}
+					else
+					{
+						const Vec3x4 tempCoord = postInfo.normalize ? Normalized(coord) : coord;
+						coord.x = Row3Offset(&p[0], tempCoord);
+						coord.y = Row3Offset(&p[4], tempCoord);
+						coord.z = Row3Offset(&p[8], tempCoord);
+					}
+				}
+				done[coordNum] = true;
+			}
+			break;
+		case XF_TEXGEN_EMBOSS_MAP:
+			{
+				const LightPointer *light = (const LightPointer*)&swxfregs.lights[0x10*texinfo.embosslightshift];
+
+				const float *mvPosition[4], *normal1[4], *normal2[4];
+				for (int i = 0; i < 4; ++i)
+				{
+					mvPosition[i] = &dst[i].mvPosition.x;
+					normal1[i] = &dst[i].normal[1].x;
+					normal2[i] = &dst[i].normal[2].x;
+				}
+				const Vec3x4 ldir = Normalized(Sub(Broadcast(light->pos), Gather(mvPosition)));
+				const __m128 d1 = Dot(ldir, Gather(normal1));
+				const __m128 d2 = Dot(ldir, Gather(normal2));
+
+				const u32 source = texinfo.embosssourceshift;
+				const Vec3x4 sourceCoord = done[source] ? texCoords[source] : Gather(dstCoord[source]);
+				coord.x = _mm_add_ps(sourceCoord.x, d1);
+				coord.y = _mm_add_ps(sourceCoord.y, d2);
+				coord.z = sourceCoord.z;
+				done[coordNum] = true;
+			}
+			break;
+		case XF_TEXGEN_COLOR_STRGBC0:
+		case XF_TEXGEN_COLOR_STRGBC1:
+			{
+				_assert_(texinfo.sourcerow == XF_SRCCOLORS_INROW);
+				_assert_(texinfo.inputform == XF_TEXINPUT_AB11);
+				const int chan = texinfo.texgentype - XF_TEXGEN_COLOR_STRGBC0;
+				const u8 *color[4];
+				for (int i = 0; i < 4; ++i)
+					color[i] = dst[i].color[chan];
+				coord.x = _mm_div_ps(ColorComponent(color, 0), _mm_set1_ps(255.0f));
+				coord.y = _mm_div_ps(ColorComponent(color, 1), _mm_set1_ps(255.0f));
+				coord.z = _mm_set1_ps(1.0f);
+				done[coordNum] = true;
+			}
+			break;
+		default:
+			ERROR_LOG(VIDEO, "Bad tex gen type %i", texinfo.texgentype);
+		}
+	}
+
+	for (u32 coordNum = 0; coordNum < swxfregs.numTexGens; coordNum++)
+	{
+		Vec3x4 coord = done[coordNum] ? texCoords[coordNum] : Gather(dstCoord[coordNum]);
+		coord.x = _mm_mul_ps(coord.x, _mm_set1_ps((float)(bpmem.texcoords[coordNum].s.scale_minus_1 + 1)));
+		coord.y = _mm_mul_ps(coord.y, _mm_set1_ps((float)(bpmem.texcoords[coordNum].t.scale_minus_1 + 1)));
+		Scatter(coord, dstCoord[coordNum]);
+	}
+}
+
+static void TransformFour(const InputVertexData *src, OutputVertexData *dst, bool hasNormal, bool nbt, bool texGenSpecialCase)
+{
+	// position
+	const float *position[4];
+	const float *mat[4];
+	float *mvPosition[4];
+	for (int i = 0; i < 4; ++i)
+	{
+		position[i] = &src[i].position.x;
+		mat[i] = (const float*)&swxfregs.posMatrices[src[i].posMtx * 4];
+		mvPosition[i] = &dst[i].mvPosition.x;
+	}
+	__m128 m[12];
+	LoadMatrices(m, 12, mat);
+
+	const Vec3x4 inPosition = Gather(position);
+	Vec3x4 mv;
+	mv.x = Row3Offset(&m[0], inPosition);
+	mv.y = Row3Offset(&m[4], inPosition);
+	mv.z = Row3Offset(&m[8], inPosition);
+	Scatter(mv, mvPosition);
+
+	const float *proj = swxfregs.projection.rawProjection;
+	__m128 projected[4];
+	if (swxfregs.projection.type == GX_PERSPECTIVE)
+	{
+		projected[0] = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(proj[0]), mv.x), _mm_mul_ps(_mm_set1_ps(proj[1]), mv.z));
+		projected[1] = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(proj[2]), mv.y), _mm_mul_ps(_mm_set1_ps(proj[3]), mv.z));
+		projected[2] = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(proj[4]), mv.z), _mm_set1_ps(proj[5])), _mm_set1_ps(1.0f - (float)1e-7));
+		projected[3] = _mm_xor_ps(mv.z, _mm_set1_ps(-0.0f));
+	}
+	else
+	{
+		projected[0] = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(proj[0]), mv.x), _mm_set1_ps(proj[1]));
+		projected[1] = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(proj[2]), mv.y), _mm_set1_ps(proj[3]));
+		projected[2] = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(proj[4]), mv.z), _mm_set1_ps(proj[5]));
+		projected[3] = _mm_set1_ps(1.0f);
+	}
+	_MM_TRANSPOSE4_PS(projected[0], projected[1], projected[2], projected[3]);
+	for (int i = 0; i < 4; ++i)
+		_mm_storeu_ps(&dst[i].projectedPosition.x, projected[i]);
+
+	// normal
+	Vec3x4 normal;
+	float *outNormal[3][4];
+	for (int n = 0; n < 3; ++n)
+	{
+		for (int i = 0; i < 4; ++i)
+			outNormal[n][i] = &dst[i].normal[n].x;
+	}
+	if (hasNormal)
+	{
+		const float *inNormal[3][4];
+		for (int i = 0; i < 4; ++i)
+		{
+			mat[i] = (const float*)&swxfregs.normalMatrices[(src[i].posMtx & 31) * 3];
+			for (int n = 0; n < 3; ++n)
+				inNormal[n][i] = &src[i].normal[n].x;
+		}
+		LoadMatrices(m, 9, mat);
+
+		for (int n = 0; n < (nbt ? 3 : 1); ++n)
+		{
+			const Vec3x4 in = Gather(inNormal[n]);
+			Vec3x4 out;
+			out.x = Row3(&m[0], in);
+			out.y = Row3(&m[3], in);
+			out.z = Row3(&m[6], in);
+			if (n == 0)
+			{
+				out = Normalized(out);
+				normal = out;
+			}
+			Scatter(out, outNormal[n]);
+		}
+	}
+	else
+	{
+		// Lighting goes on with the normal from the last vertex in these.
+		normal = Gather(outNormal[0]);
+	}
+
+	TransformColor4(mv, normal, src, dst);
+
+	TransformTexCoord4(inPosition, src, dst, texGenSpecialCase);
+}
+
+#endif
+
+void TransformVertices(const InputVertexData *src, OutputVertexData *dst, u32 count, bool hasNormal, bool nbt, bool texGenSpecialCase)
+{
+	u32 i = 0;
+
+#if _M_X86
+	for (; i + 4 <= count; i += 4)
+		TransformFour(src + i, dst + i, hasNormal, nbt, texGenSpecialCase);
+#endif
+
+	for (; i < count; ++i)
+	{
+		TransformPosition(&src[i], &dst[i]);
+		if (hasNormal)
+			TransformNormal(&src[i], nbt, &dst[i]);
+		TransformColor(&src[i], &dst[i]);
+		TransformTexCoord(&src[i], &dst[i], texGenSpecialCase);
+	}
+}
+
 }
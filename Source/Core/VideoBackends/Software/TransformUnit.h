@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include "Common/CommonTypes.h"
+
 struct InputVertexData;
 struct OutputVertexData;
 
@@ -18,4 +20,8 @@ namespace TransformUnit
 	void TransformNormal(const InputVertexData *src, bool nbt, OutputVertexData *dst);
 	void TransformColor(const InputVertexData *src, OutputVertexData *dst);
 	void TransformTexCoord(const InputVertexData *src, OutputVertexData *dst, bool specialCase);
+
+	// All of the above for count vertices of one primitive, several at a time
+	// where the CPU allows, with the same results as one at a time.
+	void TransformVertices(const InputVertexData *src, OutputVertexData *dst, u32 count, bool hasNormal, bool nbt, bool texGenSpecialCase);
 }
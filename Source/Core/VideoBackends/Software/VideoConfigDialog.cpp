@@ -70,6 +70,18 @@ VideoConfigDialog::VideoConfigDialog(wxWindow* parent, const std::string& title,
 
 	// xfb
 	szr_rendering->Add(new SettingCheckBox(page_general, wxT("Bypass XFB"), wxT(""), vconfig.bBypassXFB));
+
+	// threads
+	szr_rendering->Add(new wxStaticText(page_general, wxID_ANY, wxT("Rasterizer threads (0 = all cores):")), 1, wxALIGN_CENTER_VERTICAL, 5);
+	szr_rendering->Add(new U32Setting(page_general, wxT(""), vconfig.rasterizerThreads, 0, 64));
+
+	// texture cache
+	szr_rendering->Add(new wxStaticText(page_general, wxID_ANY, wxT("Texture cache size in MB (0 = off):")), 1, wxALIGN_CENTER_VERTICAL, 5);
+	szr_rendering->Add(new U32Setting(page_general, wxT(""), vconfig.textureCacheSize, 0, 1024));
+
+	// tev
+	szr_rendering->Add(new SettingCheckBox(page_general, wxT("Compile TEV stages (JIT)"), wxT(""), vconfig.bTevJit));
+	szr_rendering->Add(new SettingCheckBox(page_general, wxT("Transform and set up on separate threads"), wxT(""), vconfig.bThreadedPipeline));
 	}
 
 	// - info
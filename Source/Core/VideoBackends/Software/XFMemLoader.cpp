@@ -5,6 +5,7 @@
 #include "Core/HW/Memmap.h"
 #include "VideoBackends/Software/Clipper.h"
 #include "VideoBackends/Software/CPMemLoader.h"
+#include "VideoBackends/Software/Pipeline.h"
 #include "VideoBackends/Software/XFMemLoader.h"
 #include "VideoCommon/VideoCommon.h"
 
@@ -49,6 +50,8 @@ void XFWritten(u32 transferSize, u32 baseAddress)
 
 void SWLoadXFReg(u32 transferSize, u32 baseAddress, u32 *pData)
 {
+	Pipeline::Flush();
+
 	u32 size = transferSize;
 
 	// do not allow writes past registers
@@ -71,6 +74,8 @@ void SWLoadXFReg(u32 transferSize, u32 baseAddress, u32 *pData)
 
 void SWLoadIndexedXF(u32 val, int array)
 {
+	Pipeline::Flush();
+
 	int index = val >> 16;
 	int address = val & 0xFFF; //check mask
 	int size = ((val >> 12) & 0xF) + 1;
@@ -204,10 +204,16 @@ bool AVIDump::SetVideoFormat()
 
 #else
 
+#include <cinttypes>
+#include <memory>
+
 #include "Common/FileUtil.h"
 #include "Common/Log.h"
 #include "Common/StringUtil.h"
 
+#include "VideoCommon/FrameDumpPipeline.h"
+#include "VideoCommon/OnScreenDisplay.h"
+
 extern "C" {
 #include <libavcodec/avcodec.h>
 #include <libavformat/avformat.h>
@@ -215,15 +221,24 @@ extern "C" {
 #include <libavutil/mathematics.h>
 }
 
+// Frames that can be on their way through the pipeline at once, before
+// AddFrame has to wait for the encoder.
+static const u32 FRAME_BUFFERS = 6;
+
 AVFormatContext *s_FormatContext = nullptr;
 AVStream *s_Stream = nullptr;
-AVFrame *s_BGRFrame = nullptr, *s_YUVFrame = nullptr;
-uint8_t *s_YUVBuffer = nullptr;
+AVFrame *s_YUVFrame = nullptr;
 uint8_t *s_OutBuffer = nullptr;
 int s_width;
 int s_height;
 int s_size;
 
+// Only used on the conversion thread, and kept from frame to frame.
+struct SwsContext *s_SwsContext = nullptr;
+
+static std::unique_ptr<FrameDumpPipeline> s_pipeline;
+static u64 s_reported_stalls;
+
 static void InitAVCodec()
 {
 	static bool first_run = true;
@@ -234,6 +249,49 @@ static void InitAVCodec()
 	}
 }
 
+// Convert image from BGR24 to desired pixel format, and scale to initial
+// width and height. The scaler is only set up again if the size changes.
+static void ConvertFrame(FrameDumpPipeline::Frame& frame)
+{
+	AVPicture bgr, yuv;
+	avpicture_fill(&bgr, frame.data.data(), PIX_FMT_BGR24, frame.width, frame.height);
+	frame.converted.resize(s_size);
+	avpicture_fill(&yuv, frame.converted.data(), s_Stream->codec->pix_fmt, s_width, s_height);
+
+	s_SwsContext = sws_getCachedContext(s_SwsContext, frame.width, frame.height, PIX_FMT_BGR24,
+			s_width, s_height, s_Stream->codec->pix_fmt, SWS_BICUBIC, nullptr, nullptr, nullptr);
+	if (s_SwsContext)
+		sws_scale(s_SwsContext, bgr.data, bgr.linesize, 0, frame.height, yuv.data, yuv.linesize);
+}
+
+// Encode and write the image
+static void EncodeFrame(FrameDumpPipeline::Frame& frame)
+{
+	avpicture_fill((AVPicture *)s_YUVFrame, frame.converted.data(), s_Stream->codec->pix_fmt, s_width, s_height);
+
+	int outsize = avcodec_encode_video(s_Stream->codec, s_OutBuffer, s_size, s_YUVFrame);
+	while (outsize > 0)
+	{
+		AVPacket pkt;
+		av_init_packet(&pkt);
+
+		if (s_Stream->codec->coded_frame->pts != (unsigned int)AV_NOPTS_VALUE)
+			pkt.pts = av_rescale_q(s_Stream->codec->coded_frame->pts,
+					s_Stream->codec->time_base, s_Stream->time_base);
+		if (s_Stream->codec->coded_frame->key_frame)
+			pkt.flags |= AV_PKT_FLAG_KEY;
+		pkt.stream_index = s_Stream->index;
+		pkt.data = s_OutBuffer;
+		pkt.size = outsize;
+
+		// Write the compressed frame in the media file
+		av_interleaved_write_frame(s_FormatContext, &pkt);
+
+		// Encode delayed frames
+		outsize = avcodec_encode_video(s_Stream->codec, s_OutBuffer, s_size, nullptr);
+	}
+}
+
 bool AVIDump::Start(int w, int h)
 {
 	s_width = w;
@@ -276,14 +334,10 @@ bool AVIDump::CreateFile()
 		return false;
 	}
 
-	s_BGRFrame = avcodec_alloc_frame();
 	s_YUVFrame = avcodec_alloc_frame();
 
 	s_size = avpicture_get_size(s_Stream->codec->pix_fmt, s_width, s_height);
 
-	s_YUVBuffer = new uint8_t[s_size];
-	avpicture_fill((AVPicture *)s_YUVFrame, s_YUVBuffer, s_Stream->codec->pix_fmt, s_width, s_height);
-
 	s_OutBuffer = new uint8_t[s_size];
 
 	NOTICE_LOG(VIDEO, "Opening file %s for dumping", s_FormatContext->filename);
@@ -296,50 +350,39 @@ bool AVIDump::CreateFile()
 
 	avformat_write_header(s_FormatContext, nullptr);
 
+	s_pipeline.reset(new FrameDumpPipeline(FRAME_BUFFERS, ConvertFrame, EncodeFrame));
+	s_reported_stalls = 0;
+
 	return true;
 }
 
 void AVIDump::AddFrame(const u8* data, int width, int height)
 {
-	avpicture_fill((AVPicture *)s_BGRFrame, const_cast<u8*>(data), PIX_FMT_BGR24, width, height);
+	s_pipeline->AddFrame(data, width * height * 3, width, height);
 
-	// Convert image from BGR24 to desired pixel format, and scale to initial
-	// width and height
-	struct SwsContext *s_SwsContext;
-	if ((s_SwsContext = sws_getContext(width, height, PIX_FMT_BGR24, s_width, s_height,
-					s_Stream->codec->pix_fmt, SWS_BICUBIC, nullptr, nullptr, nullptr)))
-	{
-		sws_scale(s_SwsContext, s_BGRFrame->data, s_BGRFrame->linesize, 0,
-				height, s_YUVFrame->data, s_YUVFrame->linesize);
-		sws_freeContext(s_SwsContext);
-	}
+	FrameDumpPipeline::Stats stats = s_pipeline->GetStats();
+	if (stats.stalls && !s_reported_stalls)
+		WARN_LOG(VIDEO, "Frame dump: the encoder is falling behind, rendering waits for it");
+	s_reported_stalls = stats.stalls;
+}
 
-	// Encode and write the image
-	int outsize = avcodec_encode_video(s_Stream->codec, s_OutBuffer, s_size, s_YUVFrame);
-	while (outsize > 0)
+void AVIDump::Stop()
+{
+	// Let the frames still on their way through be written first.
+	if (s_pipeline)
 	{
-		AVPacket pkt;
-		av_init_packet(&pkt);
-
-		if (s_Stream->codec->coded_frame->pts != (unsigned int)AV_NOPTS_VALUE)
-			pkt.pts = av_rescale_q(s_Stream->codec->coded_frame->pts,
-					s_Stream->codec->time_base, s_Stream->time_base);
-		if (s_Stream->codec->coded_frame->key_frame)
-			pkt.flags |= AV_PKT_FLAG_KEY;
-		pkt.stream_index = s_Stream->index;
-		pkt.data = s_OutBuffer;
-		pkt.size = outsize;
+		FrameDumpPipeline::Stats stats = s_pipeline->GetStats();
+		s_pipeline.reset();
 
-		// Write the compressed frame in the media file
-		av_interleaved_write_frame(s_FormatContext, &pkt);
-
-		// Encode delayed frames
-		outsize = avcodec_encode_video(s_Stream->codec, s_OutBuffer, s_size, nullptr);
+		NOTICE_LOG(VIDEO, "Frame dump: %" PRIu64 " frames, rendering waited for the encoder on %" PRIu64
+		           " of them, %" PRIu64 " ms in all", stats.frames_added, stats.stalls, stats.stall_us / 1000);
+		if (stats.stalls)
+		{
+			OSD::AddMessage(StringFromFormat("Frame dump: rendering waited for the encoder on %" PRIu64 " of %" PRIu64 " frames",
+			                                 stats.stalls, stats.frames_added), 5000);
+		}
 	}
-}
 
-void AVIDump::Stop()
-{
 	av_write_trailer(s_FormatContext);
 	CloseFile();
 	NOTICE_LOG(VIDEO, "Stopping frame dump");
@@ -355,22 +398,18 @@ void AVIDump::CloseFile()
 		s_Stream = nullptr;
 	}
 
-	if (s_YUVBuffer)
-		delete[] s_YUVBuffer;
-	s_YUVBuffer = nullptr;
-
 	if (s_OutBuffer)
 		delete[] s_OutBuffer;
 	s_OutBuffer = nullptr;
 
-	if (s_BGRFrame)
-		av_free(s_BGRFrame);
-	s_BGRFrame = nullptr;
-
 	if (s_YUVFrame)
 		av_free(s_YUVFrame);
 	s_YUVFrame = nullptr;
 
+	if (s_SwsContext)
+		sws_freeContext(s_SwsContext);
+	s_SwsContext = nullptr;
+
 	if (s_FormatContext)
 	{
 		if (s_FormatContext->pb)
@@ -0,0 +1,116 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cstring>
+
+#include "Common/Timer.h"
+#include "VideoCommon/FrameDumpPipeline.h"
+
+FrameDumpPipeline::FrameDumpPipeline(u32 num_buffers, const Stage& convert, const Stage& encode)
+	: m_convert(convert), m_encode(encode), m_frames(std::max(1u, num_buffers)), m_stop(false)
+{
+	memset(&m_stats, 0, sizeof(m_stats));
+	for (u32 i = 0; i < m_frames.size(); ++i)
+		m_free.push_back(i);
+
+	m_convert_thread = std::thread(&FrameDumpPipeline::ConvertThread, this);
+	m_encode_thread = std::thread(&FrameDumpPipeline::EncodeThread, this);
+}
+
+FrameDumpPipeline::~FrameDumpPipeline()
+{
+	Flush();
+	{
+		std::lock_guard<std::mutex> lk(m_lock);
+		m_stop = true;
+	}
+	m_cv.notify_all();
+	m_convert_thread.join();
+	m_encode_thread.join();
+}
+
+void FrameDumpPipeline::AddFrame(const u8* data, size_t size, int width, int height)
+{
+	std::unique_lock<std::mutex> lk(m_lock);
+	if (m_free.empty())
+	{
+		const u64 start = Common::Timer::GetTimeUs();
+		m_cv.wait(lk, [&] { return !m_free.empty(); });
+		m_stats.stalls++;
+		m_stats.stall_us += Common::Timer::GetTimeUs() - start;
+	}
+	const u32 index = m_free.front();
+	m_free.pop_front();
+	const u64 number = m_stats.frames_added++;
+	lk.unlock();
+
+	Frame& frame = m_frames[index];
+	frame.data.assign(data, data + size);
+	frame.width = width;
+	frame.height = height;
+	frame.number = number;
+
+	lk.lock();
+	m_to_convert.push_back(index);
+	lk.unlock();
+	m_cv.notify_all();
+}
+
+void FrameDumpPipeline::Flush()
+{
+	std::unique_lock<std::mutex> lk(m_lock);
+	m_cv.wait(lk, [&] { return m_free.size() == m_frames.size(); });
+}
+
+FrameDumpPipeline::Stats FrameDumpPipeline::GetStats() const
+{
+	std::lock_guard<std::mutex> lk(m_lock);
+	return m_stats;
+}
+
+void FrameDumpPipeline::ConvertThread()
+{
+	Common::SetCurrentThreadName("Frame dump conversion");
+
+	std::unique_lock<std::mutex> lk(m_lock);
+	while (true)
+	{
+		m_cv.wait(lk, [&] { return m_stop || !m_to_convert.empty(); });
+		if (m_to_convert.empty())
+			return;
+		const u32 index = m_to_convert.front();
+		m_to_convert.pop_front();
+
+		lk.unlock();
+		m_convert(m_frames[index]);
+		lk.lock();
+
+		m_to_encode.push_back(index);
+		m_cv.notify_all();
+	}
+}
+
+void FrameDumpPipeline::EncodeThread()
+{
+	Common::SetCurrentThreadName("Frame dump encoder");
+
+	std::unique_lock<std::mutex> lk(m_lock);
+	while (true)
+	{
+		m_cv.wait(lk, [&] { return m_stop || !m_to_encode.empty(); });
+		if (m_to_encode.empty())
+			return;
+		const u32 index = m_to_encode.front();
+		m_to_encode.pop_front();
+
+		lk.unlock();
+		m_encode(m_frames[index]);
+		lk.lock();
+
+		m_free.push_back(index);
+		m_stats.frames_encoded++;
+		m_cv.notify_all();
+	}
+}
@@ -0,0 +1,78 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <deque>
+#include <functional>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/Thread.h"
+
+// Takes dumped frames off the thread that renders them. Each frame is copied
+// into one of a fixed pool of buffers, then converted on one thread and
+// encoded on another, in the order they were added. When every buffer is in
+// use, AddFrame waits for the encoder to catch up rather than drop the frame,
+// and counts how often and how long it did.
+class FrameDumpPipeline
+{
+public:
+	struct Frame
+	{
+		// As added.
+		std::vector<u8> data;
+		int width;
+		int height;
+		u64 number;
+
+		// Whatever the conversion makes of it for the encoder.
+		std::vector<u8> converted;
+	};
+
+	// Called on the pipeline's threads with one frame at a time. The buffers
+	// are reused, so they keep their capacity from frame to frame.
+	typedef std::function<void(Frame&)> Stage;
+
+	struct Stats
+	{
+		u64 frames_added;
+		u64 frames_encoded;
+		// Frames that had to wait for a free buffer, and the total wait.
+		u64 stalls;
+		u64 stall_us;
+	};
+
+	FrameDumpPipeline(u32 num_buffers, const Stage& convert, const Stage& encode);
+	// Finishes the frames still on their way through.
+	~FrameDumpPipeline();
+
+	void AddFrame(const u8* data, size_t size, int width, int height);
+
+	// Waits until every frame added so far has been encoded.
+	void Flush();
+
+	Stats GetStats() const;
+
+private:
+	void ConvertThread();
+	void EncodeThread();
+
+	Stage m_convert;
+	Stage m_encode;
+	std::vector<Frame> m_frames;
+
+	// Indices into m_frames, for each step they're waiting on.
+	std::deque<u32> m_free;
+	std::deque<u32> m_to_convert;
+	std::deque<u32> m_to_encode;
+
+	mutable std::mutex m_lock;
+	std::condition_variable m_cv;
+	bool m_stop;
+	Stats m_stats;
+
+	std::thread m_convert_thread;
+	std::thread m_encode_thread;
+};
@@ -61,6 +61,9 @@ struct Statistics
 
 		int numDListsCalled;
 
+		int numTexturesHashed;
+		int numTextureHashesSkipped;
+
 		int bytesVertexStreamed;
 		int bytesIndexStreamed;
 		int bytesUniformStreamed;
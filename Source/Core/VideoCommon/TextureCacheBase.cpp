@@ -2,11 +2,16 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <vector>
+
 #include "Common/FileUtil.h"
 #include "Common/MemoryUtil.h"
+#include "Common/ParallelFor.h"
 
 #include "Core/ConfigManager.h"
 #include "Core/HW/Memmap.h"
+#include "Core/HW/WriteTracker.h"
 
 #include "VideoCommon/Debugger.h"
 #include "VideoCommon/HiresTextures.h"
@@ -21,6 +26,8 @@ extern int frameCount;
 enum
 {
 	TEXTURE_KILL_THRESHOLD = 200,
+	// Stop watching a texture's data after it was found changed this many loads in a row.
+	TEXTURE_REWRITE_THRESHOLD = 3,
 };
 
 TextureCache *g_texture_cache;
@@ -34,10 +41,21 @@ TextureCache::BackupConfig TextureCache::backup_config;
 
 bool invalidate_texture_cache_requested;
 
+TextureCache::TCacheEntryBase::TCacheEntryBase()
+	: ram_hash(TEXHASH_INVALID), ram_write_count(WriteTracker::UNWATCHED), ram_rewrites(0)
+{
+}
+
 TextureCache::TCacheEntryBase::~TCacheEntryBase()
 {
 }
 
+static int GetNumDecoderThreads(const VideoConfig& config)
+{
+	// Don't take too many cores away from the CPU and GPU threads.
+	return config.bOMPDecoder ? std::max(1, (int)(Common::GetNumWorkerThreads() + 2) / 3) : 1;
+}
+
 TextureCache::TextureCache()
 {
 	temp_size = 2048 * 2048 * 4;
@@ -45,6 +63,7 @@ TextureCache::TextureCache()
 		temp = (u8*)AllocateAlignedMemory(temp_size, 16);
 
 	TexDecoder_SetTexFmtOverlayOptions(g_ActiveConfig.bTexFmtOverlayEnable, g_ActiveConfig.bTexFmtOverlayCenter);
+	TexDecoder_SetNumThreads(GetNumDecoderThreads(g_ActiveConfig));
 
 	if (g_ActiveConfig.bHiresTextures && !g_ActiveConfig.bDumpTextures)
 		HiresTextures::Init(SConfig::GetInstance().m_LocalCoreStartupParameter.m_strUniqueID);
@@ -73,12 +92,16 @@ TextureCache::~TextureCache()
 	Invalidate();
 	FreeAlignedMemory(temp);
 	temp = nullptr;
+
+	TexDecoder_SetNumThreads(1);
 }
 
 void TextureCache::OnConfigChanged(VideoConfig& config)
 {
 	if (g_texture_cache)
 	{
+		TexDecoder_SetNumThreads(GetNumDecoderThreads(config));
+
 		// TODO: Invalidating texcache is really stupid in some of these cases
 		if (config.iSafeTextureCache_ColorSamples != backup_config.s_colorsamples ||
 			config.bTexFmtOverlayEnable != backup_config.s_texfmt_overlay ||
@@ -364,8 +387,6 @@ TextureCache::TCacheEntryBase* TextureCache::Load(unsigned int const stage,
 	else
 		src_data = Memory::GetPointer(address);
 
-	// TODO: This doesn't hash GB tiles for preloaded RGBA8 textures (instead, it's hashing more data from the low tmem bank than it should)
-	tex_hash = GetHash64(src_data, texture_size, g_ActiveConfig.iSafeTextureCache_ColorSamples);
 	if (isPaletteTexture)
 	{
 		const u32 palette_size = TexDecoder_GetPaletteSize(texformat);
@@ -381,7 +402,6 @@ TextureCache::TCacheEntryBase* TextureCache::Load(unsigned int const stage,
 		//
 		// TODO: Because texID isn't always the same as the address now, CopyRenderTargetToTexture might be broken now
 		texID ^= ((u32)tlut_hash) ^(u32)(tlut_hash >> 32);
-		tex_hash ^= tlut_hash;
 	}
 
 	// D3D doesn't like when the specified mipmap count would require more than one 1x1-sized LOD in the mipmap chain
@@ -390,6 +410,48 @@ TextureCache::TCacheEntryBase* TextureCache::Load(unsigned int const stage,
 		--maxlevel;
 
 	TCacheEntryBase *entry = textures[texID];
+
+	// Texture data in RAM that nothing wrote to since the entry hashed it doesn't
+	// need hashing again. Data that keeps changing isn't watched, so that writes
+	// to it don't keep faulting.
+	const bool track_writes = !from_tmem && g_ActiveConfig.bTextureWriteTracking && WriteTracker::IsEnabled();
+	const bool same_range = entry && entry->type == TCET_NORMAL &&
+		entry->addr == address && entry->size_in_bytes == texture_size;
+	u64 ram_hash;
+	u64 ram_write_count = WriteTracker::UNWATCHED;
+	u32 ram_rewrites = 0;
+	if (track_writes && same_range && entry->ram_write_count != WriteTracker::UNWATCHED &&
+	    entry->ram_write_count == WriteTracker::GetWriteCount(address, texture_size))
+	{
+		ram_hash = entry->ram_hash;
+		ram_write_count = entry->ram_write_count;
+		INCSTAT(stats.thisFrame.numTextureHashesSkipped);
+	}
+	else
+	{
+		if (track_writes && !(same_range && entry->ram_rewrites >= TEXTURE_REWRITE_THRESHOLD))
+		{
+			WriteTracker::Watch(address, texture_size);
+			ram_write_count = WriteTracker::GetWriteCount(address, texture_size);
+		}
+
+		// TODO: This doesn't hash GB tiles for preloaded RGBA8 textures (instead, it's hashing more data from the low tmem bank than it should)
+		ram_hash = GetHash64(src_data, texture_size, g_ActiveConfig.iSafeTextureCache_ColorSamples);
+		INCSTAT(stats.thisFrame.numTexturesHashed);
+
+		// The CPU thread may have written to it while we were hashing.
+		if (ram_write_count != WriteTracker::UNWATCHED &&
+		    ram_write_count != WriteTracker::GetWriteCount(address, texture_size))
+			ram_write_count = WriteTracker::UNWATCHED;
+
+		if (same_range && ram_hash != entry->ram_hash)
+			ram_rewrites = entry->ram_rewrites + 1;
+	}
+
+	tex_hash = ram_hash;
+	if (isPaletteTexture)
+		tex_hash ^= tlut_hash;
+
 	if (entry)
 	{
 		// 1. Calculate reference hash:
@@ -412,6 +474,9 @@ TextureCache::TCacheEntryBase* TextureCache::Load(unsigned int const stage,
 		if (address == entry->addr && tex_hash == entry->hash && full_format == entry->format &&
 			entry->num_mipmaps > maxlevel && entry->native_width == nativeW && entry->native_height == nativeH)
 		{
+			entry->ram_hash = ram_hash;
+			entry->ram_write_count = ram_write_count;
+			entry->ram_rewrites = ram_rewrites;
 			return ReturnEntry(stage, entry);
 		}
 
@@ -509,6 +574,9 @@ TextureCache::TCacheEntryBase* TextureCache::Load(unsigned int const stage,
 	entry->SetGeneralParameters(address, texture_size, full_format, entry->num_mipmaps);
 	entry->SetDimensions(nativeW, nativeH, width, height);
 	entry->hash = tex_hash;
+	entry->ram_hash = ram_hash;
+	entry->ram_write_count = ram_write_count;
+	entry->ram_rewrites = ram_rewrites;
 
 	if (entry->IsEfbCopy() && !g_ActiveConfig.bCopyEFBToTexture)
 		entry->type = TCET_EC_DYNAMIC;
@@ -534,20 +602,44 @@ TextureCache::TCacheEntryBase* TextureCache::Load(unsigned int const stage,
 				ptr_odd = &texMem[bpmem.tex[stage/4].texImage2[stage%4].tmem_odd * TMEM_LINE_SIZE];
 			}
 
-			for (; level != texLevels; ++level)
+			// Decode all levels at once, one after another in temp, so they share
+			// a single trip to the decoder threads; most levels are too small to
+			// be worth splitting up on their own. Each one is then moved to the
+			// start of temp for Load, over the levels that were already loaded.
+			std::vector<TexDecoderLevel> mips;
+			u32 decoded_size = 0;
+			for (u32 mip_level = level; mip_level != texLevels; ++mip_level)
 			{
-				const u32 mip_width = CalculateLevelSize(width, level);
-				const u32 mip_height = CalculateLevelSize(height, level);
+				const u32 mip_width = CalculateLevelSize(width, mip_level);
+				const u32 mip_height = CalculateLevelSize(height, mip_level);
 				const u32 expanded_mip_width = (mip_width + bsw) & (~bsw);
 				const u32 expanded_mip_height = (mip_height + bsh) & (~bsh);
 
 				const u8*& mip_src_data = from_tmem
-					? ((level % 2) ? ptr_odd : ptr_even)
+					? ((mip_level % 2) ? ptr_odd : ptr_even)
 					: src_data;
-				TexDecoder_Decode(temp, mip_src_data, expanded_mip_width, expanded_mip_height, texformat, tlutaddr, tlutfmt, g_ActiveConfig.backend_info.bUseRGBATextures);
+				TexDecoderLevel mip = { temp + decoded_size, mip_src_data, (int)expanded_mip_width, (int)expanded_mip_height };
+				mips.push_back(mip);
 				mip_src_data += TexDecoder_GetTextureSizeInBytes(expanded_mip_width, expanded_mip_height, texformat);
+				decoded_size += expanded_mip_width * expanded_mip_height * 4;
+			}
+
+			const bool decoded_at_once = decoded_size <= temp_size;
+			if (decoded_at_once && !mips.empty())
+				TexDecoder_DecodeLevels(&mips[0], (int)mips.size(), texformat, tlutaddr, tlutfmt, g_ActiveConfig.backend_info.bUseRGBATextures);
+
+			for (; level != texLevels; ++level)
+			{
+				const TexDecoderLevel& mip = mips[level - 1];
+				const u32 mip_width = CalculateLevelSize(width, level);
+				const u32 mip_height = CalculateLevelSize(height, level);
+
+				if (decoded_at_once)
+					memmove(temp, mip.dst, mip.width * mip.height * 4);
+				else
+					TexDecoder_Decode(temp, mip.src, mip.width, mip.height, texformat, tlutaddr, tlutfmt, g_ActiveConfig.backend_info.bUseRGBATextures);
 
-				entry->Load(mip_width, mip_height, expanded_mip_width, level);
+				entry->Load(mip_width, mip_height, mip.width, level);
 
 				if (g_ActiveConfig.bDumpTextures)
 					DumpTexture(entry, level);
@@ -45,6 +45,14 @@ public:
 		// used to delete textures which haven't been used for TEXTURE_KILL_THRESHOLD frames
 		int frameCount;
 
+		// Hash of the texture data in RAM, without the palette, and the write
+		// count of its range when it was taken. While the count stays the same,
+		// the data doesn't need hashing again.
+		u64 ram_hash;
+		u64 ram_write_count;
+		// How many loads in a row found the data changed.
+		u32 ram_rewrites;
+
 
 		void SetGeneralParameters(u32 _addr, u32 _size, u32 _format, unsigned int _num_mipmaps)
 		{
@@ -69,6 +77,7 @@ public:
 		}
 
 
+		TCacheEntryBase();
 		virtual ~TCacheEntryBase();
 
 		virtual void Bind(unsigned int stage) = 0;
@@ -0,0 +1,220 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "Common/Common.h"
+#include "Common/ParallelFor.h"
+#include "VideoCommon/TextureDecoder.h"
+
+enum
+{
+	// Below this many texels, waking up the other threads costs more than
+	// it saves.
+	MIN_THREADED_TEXELS = 256 * 256,
+	// Hand out a few bands per thread, so a thread that wakes up late doesn't
+	// hold up the others.
+	BANDS_PER_THREAD = 4,
+};
+
+bool TexFmt_Overlay_Enable=false;
+bool TexFmt_Overlay_Center=false;
+
+extern const char* texfmt[];
+extern const unsigned char sfont_map[];
+extern const unsigned char sfont_raw[][9*10];
+
+// Only used from the video thread.
+static std::unique_ptr<Common::WorkerPool> s_pool;
+
+struct DecodeBand
+{
+	int level;
+	int first_row;
+	int num_rows;
+	PC_TexFormat result;
+};
+static std::vector<DecodeBand> s_bands;
+
+// Bytes per texel TexDecoder_DecodeRows writes, or 0 if it doesn't decode the format.
+static int GetDecodedTexelSize(int texformat, int tlutfmt, bool rgbaOnly)
+{
+	switch (texformat)
+	{
+	case GX_TF_I4:
+	case GX_TF_I8:
+		return rgbaOnly ? 4 : 1;
+	case GX_TF_IA4:
+	case GX_TF_IA8:
+	case GX_TF_RGB565:
+		return rgbaOnly ? 4 : 2;
+	case GX_TF_RGB5A3:
+	case GX_TF_RGBA8:
+	case GX_TF_CMPR:
+		return 4;
+	case GX_TF_C4:
+	case GX_TF_C8:
+	case GX_TF_C14X2:
+		return (rgbaOnly || tlutfmt == 2) ? 4 : 2;
+	default:
+		return 0;
+	}
+}
+
+static void DrawOverlay(u8 *dst, int width, int height, int texformat, PC_TexFormat pcfmt)
+{
+	int w = std::min(width, 40);
+	int h = std::min(height, 10);
+
+	int xoff = (width - w) >> 1;
+	int yoff = (height - h) >> 1;
+
+	if (!TexFmt_Overlay_Center)
+	{
+		xoff=0;
+		yoff=0;
+	}
+
+	const char* fmt = texfmt[texformat&15];
+	while (*fmt)
+	{
+		int xcnt = 0;
+		int nchar = sfont_map[(int)*fmt];
+
+		const unsigned char *ptr = sfont_raw[nchar]; // each char is up to 9x10
+
+		for (int x = 0; x < 9;x++)
+		{
+			if (ptr[x] == 0x78)
+				break;
+			xcnt++;
+		}
+
+		for (int y=0; y < 10; y++)
+		{
+			for (int x=0; x < xcnt; x++)
+			{
+				switch (pcfmt)
+				{
+				case PC_TEX_FMT_I8:
+					{
+						// TODO: Is this an acceptable way to draw in I8?
+						u8  *dtp = (u8*)dst;
+						dtp[(y + yoff) * width + x + xoff] = ptr[x] ? 0xFF : 0x88;
+						break;
+					}
+				case PC_TEX_FMT_IA8:
+				case PC_TEX_FMT_IA4_AS_IA8:
+					{
+						u16  *dtp = (u16*)dst;
+						dtp[(y + yoff) * width + x + xoff] = ptr[x] ? 0xFFFF : 0xFF00;
+						break;
+					}
+				case PC_TEX_FMT_RGB565:
+					{
+						u16  *dtp = (u16*)dst;
+						dtp[(y + yoff)*width + x + xoff] = ptr[x] ? 0xFFFF : 0x0000;
+						break;
+					}
+				default:
+				case PC_TEX_FMT_BGRA32:
+					{
+						int  *dtp = (int*)dst;
+						dtp[(y + yoff) * width + x + xoff] = ptr[x] ? 0xFFFFFFFF : 0xFF000000;
+						break;
+					}
+				}
+			}
+			ptr += 9;
+		}
+		xoff += xcnt;
+		fmt++;
+	}
+}
+
+void TexDecoder_SetTexFmtOverlayOptions(bool enable, bool center)
+{
+	TexFmt_Overlay_Enable = enable;
+	TexFmt_Overlay_Center = center;
+}
+
+void TexDecoder_SetNumThreads(int num_threads)
+{
+	u32 current = s_pool ? s_pool->GetNumWorkers() : 1;
+	u32 wanted = (u32)std::max(1, num_threads);
+	if (current == wanted)
+		return;
+
+	s_pool.reset();
+	if (wanted > 1)
+		s_pool.reset(new Common::WorkerPool(wanted));
+}
+
+PC_TexFormat TexDecoder_DecodeLevels(const TexDecoderLevel *levels, int num_levels, int texformat, int tlutaddr, int tlutfmt, bool rgbaOnly)
+{
+	PC_TexFormat retval = PC_TEX_FMT_NONE;
+	if (num_levels <= 0)
+		return retval;
+
+	int total_texels = 0;
+	for (int i = 0; i < num_levels; ++i)
+		total_texels += levels[i].width * levels[i].height;
+
+	const int texel_size = GetDecodedTexelSize(texformat, tlutfmt, rgbaOnly);
+	if (!s_pool || texel_size == 0 || total_texels < MIN_THREADED_TEXELS)
+	{
+		for (int i = 0; i < num_levels; ++i)
+		{
+			const TexDecoderLevel& level = levels[i];
+			retval = TexDecoder_DecodeRows(level.dst, level.src, level.width, level.height, texformat, tlutaddr, tlutfmt, rgbaOnly);
+		}
+	}
+	else
+	{
+		// Split every level into bands of whole tile rows of roughly equal size.
+		// The source of a band starts right after the tile rows above it, and
+		// its output right after their decoded texels.
+		const int block_height = TexDecoder_GetBlockHeightInTexels(texformat);
+		const int texels_per_band = std::max(1, total_texels / (int)(s_pool->GetNumWorkers() * BANDS_PER_THREAD));
+
+		s_bands.clear();
+		for (int i = 0; i < num_levels; ++i)
+		{
+			const TexDecoderLevel& level = levels[i];
+			int rows = std::max(1, texels_per_band / std::max(1, level.width));
+			rows = (rows + block_height - 1) / block_height * block_height;
+			for (int y = 0; y < level.height; y += rows)
+			{
+				DecodeBand band = { i, y, std::min(rows, level.height - y), PC_TEX_FMT_NONE };
+				s_bands.push_back(band);
+			}
+		}
+
+		s_pool->ParallelFor((u32)s_bands.size(), [&](u32 index, u32) {
+			DecodeBand& band = s_bands[index];
+			const TexDecoderLevel& level = levels[band.level];
+			band.result = TexDecoder_DecodeRows(
+				level.dst + (size_t)band.first_row * level.width * texel_size,
+				level.src + TexDecoder_GetTextureSizeInBytes(level.width, band.first_row, texformat),
+				level.width, band.num_rows, texformat, tlutaddr, tlutfmt, rgbaOnly);
+		});
+		retval = s_bands.empty() ? PC_TEX_FMT_NONE : s_bands.back().result;
+	}
+
+	if ((!TexFmt_Overlay_Enable) || (retval == PC_TEX_FMT_NONE))
+		return retval;
+
+	for (int i = 0; i < num_levels; ++i)
+		DrawOverlay(levels[i].dst, levels[i].width, levels[i].height, texformat, retval);
+
+	return retval;
+}
+
+PC_TexFormat TexDecoder_Decode(u8 *dst, const u8 *src, int width, int height, int texformat, int tlutaddr, int tlutfmt, bool rgbaOnly)
+{
+	TexDecoderLevel level = { dst, src, width, height };
+	return TexDecoder_DecodeLevels(&level, 1, texformat, tlutaddr, tlutfmt, rgbaOnly);
+}
@@ -72,6 +72,29 @@ enum PC_TexFormat
 };
 
 PC_TexFormat TexDecoder_Decode(u8 *dst, const u8 *src, int width, int height, int texformat, int tlutaddr, int tlutfmt,bool rgbaOnly = false);
+
+// One image for TexDecoder_DecodeLevels, e.g. a level of a mip chain.
+struct TexDecoderLevel
+{
+	u8 *dst;
+	const u8 *src;
+	int width;
+	int height;
+};
+
+// Decodes several images of the same format with one round trip to the
+// decoder threads. Every level gets the same treatment as TexDecoder_Decode.
+PC_TexFormat TexDecoder_DecodeLevels(const TexDecoderLevel *levels, int num_levels, int texformat, int tlutaddr, int tlutfmt, bool rgbaOnly = false);
+
+// Number of threads large textures are split across, including the calling
+// thread. With 1, everything is decoded on the calling thread.
+void TexDecoder_SetNumThreads(int num_threads);
+
+// Decodes on the calling thread only, without the overlay. Tile rows are
+// independent, so any band of them starting on a tile row can be decoded on
+// its own.
+PC_TexFormat TexDecoder_DecodeRows(u8 *dst, const u8 *src, int width, int height, int texformat, int tlutaddr, int tlutfmt, bool rgbaOnly);
+
 PC_TexFormat GetPC_TexFormat(int texformat, int tlutfmt);
 void TexDecoder_DecodeTexel(u8 *dst, const u8 *src, int s, int t, int imageWidth, int texformat, int tlutaddr, int tlutfmt);
 void TexDecoder_DecodeTexelRGBA8FromTmem(u8 *dst, const u8 *src_ar, const u8* src_gb, int s, int t, int imageWidth);
@@ -24,9 +24,6 @@
 //#include "VideoCommon/VideoCommon.h" // to get debug logs
 #include "VideoCommon/VideoConfig.h"
 
-bool TexFmt_Overlay_Enable=false;
-bool TexFmt_Overlay_Center=false;
-
 extern const char* texfmt[];
 extern const unsigned char sfont_map[];
 extern const unsigned char sfont_raw[][9*10];
@@ -1039,91 +1036,12 @@ PC_TexFormat TexDecoder_Decode_RGBA(u32 * dst, const u8 * src, int width, int he
 
 
 
-void TexDecoder_SetTexFmtOverlayOptions(bool enable, bool center)
+PC_TexFormat TexDecoder_DecodeRows(u8 *dst, const u8 *src, int width, int height, int texformat, int tlutaddr, int tlutfmt, bool rgbaOnly)
 {
-	TexFmt_Overlay_Enable = enable;
-	TexFmt_Overlay_Center = center;
-}
-
-PC_TexFormat TexDecoder_Decode(u8 *dst, const u8 *src, int width, int height, int texformat, int tlutaddr, int tlutfmt,bool rgbaOnly)
-{
-	PC_TexFormat retval = rgbaOnly ? TexDecoder_Decode_RGBA((u32*)dst, src,
+	return rgbaOnly ? TexDecoder_Decode_RGBA((u32*)dst, src,
 			width, height, texformat, tlutaddr, tlutfmt)
 		: TexDecoder_Decode_real(dst, src,
 			width, height, texformat, tlutaddr, tlutfmt);
-
-	if ((!TexFmt_Overlay_Enable) || (retval == PC_TEX_FMT_NONE))
-		return retval;
-
-	int w = min(width, 40);
-	int h = min(height, 10);
-
-	int xoff = (width - w) >> 1;
-	int yoff = (height - h) >> 1;
-
-	if (!TexFmt_Overlay_Center)
-	{
-		xoff=0;
-		yoff=0;
-	}
-
-	const char* fmt = texfmt[texformat&15];
-	while (*fmt)
-	{
-		int xcnt = 0;
-		int nchar = sfont_map[(int)*fmt];
-
-		const unsigned char *ptr = sfont_raw[nchar]; // each char is up to 9x10
-
-		for (int x = 0; x < 9;x++)
-		{
-			if (ptr[x] == 0x78)
-				break;
-			xcnt++;
-		}
-
-		for (int y=0; y < 10; y++)
-		{
-			for (int x=0; x < xcnt; x++)
-			{
-				switch (retval)
-				{
-				case PC_TEX_FMT_I8:
-					{
-						// TODO: Is this an acceptable way to draw in I8?
-						u8  *dtp = (u8*)dst;
-						dtp[(y + yoff) * width + x + xoff] = ptr[x] ? 0xFF : 0x88;
-						break;
-					}
-				case PC_TEX_FMT_IA8:
-				case PC_TEX_FMT_IA4_AS_IA8:
-					{
-						u16  *dtp = (u16*)dst;
-						dtp[(y + yoff) * width + x + xoff] = ptr[x] ? 0xFFFF : 0xFF00;
-						break;
-					}
-				case PC_TEX_FMT_RGB565:
-					{
-						u16  *dtp = (u16*)dst;
-						dtp[(y + yoff)*width + x + xoff] = ptr[x] ? 0xFFFF : 0x0000;
-						break;
-					}
-				default:
-				case PC_TEX_FMT_BGRA32:
-					{
-						int  *dtp = (int*)dst;
-						dtp[(y + yoff) * width + x + xoff] = ptr[x] ? 0xFFFFFFFF : 0xFF000000;
-						break;
-					}
-				}
-			}
-			ptr += 9;
-		}
-		xoff += xcnt;
-		fmt++;
-	}
-
-	return retval;
 }
 
 
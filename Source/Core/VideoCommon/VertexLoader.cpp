@@ -3,6 +3,7 @@
 // Refer to the license.txt file included.
 
 #include "Common/Common.h"
+#include "Common/CPUDetect.h"
 #include "Common/MemoryUtil.h"
 #include "Common/StringUtil.h"
 #include "Common/x64ABI.h"
@@ -476,6 +477,18 @@ VertexLoader::VertexLoader(const TVtxDesc &vtx_desc, const VAT &vtx_attr)
 	m_VtxDesc = vtx_desc;
 	SetVAT(vtx_attr.g0.Hex, vtx_attr.g1.Hex, vtx_attr.g2.Hex);
 
+	m_inline = false;
+#if defined(USE_VERTEX_LOADER_JIT) && _M_X86_64
+	// The generated code byte swaps with PSHUFB.
+	m_inline = g_ActiveConfig.bInlineVertexLoaders && cpu_info.bSSSE3;
+#endif
+	m_srcOffset = 0;
+	m_dstOffset = 0;
+	m_registersValid = false;
+	m_globalsValid = true;
+	m_texMtxRead = 0;
+	m_texMtxWrite = 0;
+
 	#ifdef USE_VERTEX_LOADER_JIT
 	AllocCodeSpace(COMPILED_CODE_SIZE);
 	CompileVertexTranslator();
@@ -507,24 +520,37 @@ void VertexLoader::CompileVertexTranslator()
 	m_compiledCode = GetCodePtr();
 	ABI_PushAllCalleeSavedRegsAndAdjustStack();
 
+#if _M_X86_64
+	if (m_inline)
+	{
+		MOV(64, R(RAX), Imm64((u64)&loop_counter));
+		MOV(32, R(EBX), MatR(RAX));
+		UseRegisters();
+	}
+#endif
+
 	// Start loop here
 	const u8 *loop_start = GetCodePtr();
 
-	// Reset component counters if present in vertex format only.
-	if (m_VtxDesc.Tex0Coord || m_VtxDesc.Tex1Coord || m_VtxDesc.Tex2Coord || m_VtxDesc.Tex3Coord ||
-		m_VtxDesc.Tex4Coord || m_VtxDesc.Tex5Coord || m_VtxDesc.Tex6Coord || m_VtxDesc.Tex7Coord)
-	{
-		WriteSetVariable(32, &tcIndex, Imm32(0));
-	}
-	if (m_VtxDesc.Color0 || m_VtxDesc.Color1)
-	{
-		WriteSetVariable(32, &colIndex, Imm32(0));
-	}
-	if (m_VtxDesc.Tex0MatIdx || m_VtxDesc.Tex1MatIdx || m_VtxDesc.Tex2MatIdx || m_VtxDesc.Tex3MatIdx ||
-		m_VtxDesc.Tex4MatIdx || m_VtxDesc.Tex5MatIdx || m_VtxDesc.Tex6MatIdx || m_VtxDesc.Tex7MatIdx)
+	// Reset component counters if present in vertex format only. The code
+	// generated in line knows them when compiling.
+	if (!m_inline)
 	{
-		WriteSetVariable(32, &s_texmtxwrite, Imm32(0));
-		WriteSetVariable(32, &s_texmtxread, Imm32(0));
+		if (m_VtxDesc.Tex0Coord || m_VtxDesc.Tex1Coord || m_VtxDesc.Tex2Coord || m_VtxDesc.Tex3Coord ||
+			m_VtxDesc.Tex4Coord || m_VtxDesc.Tex5Coord || m_VtxDesc.Tex6Coord || m_VtxDesc.Tex7Coord)
+		{
+			WriteSetVariable(32, &tcIndex, Imm32(0));
+		}
+		if (m_VtxDesc.Color0 || m_VtxDesc.Color1)
+		{
+			WriteSetVariable(32, &colIndex, Imm32(0));
+		}
+		if (m_VtxDesc.Tex0MatIdx || m_VtxDesc.Tex1MatIdx || m_VtxDesc.Tex2MatIdx || m_VtxDesc.Tex3MatIdx ||
+			m_VtxDesc.Tex4MatIdx || m_VtxDesc.Tex5MatIdx || m_VtxDesc.Tex6MatIdx || m_VtxDesc.Tex7MatIdx)
+		{
+			WriteSetVariable(32, &s_texmtxwrite, Imm32(0));
+			WriteSetVariable(32, &s_texmtxread, Imm32(0));
+		}
 	}
 #else
 	// Reset pipeline
@@ -552,19 +578,20 @@ void VertexLoader::CompileVertexTranslator()
 	// Position Matrix Index
 	if (m_VtxDesc.PosMatIdx)
 	{
-		WriteCall(PosMtx_ReadDirect_UByte);
+		if (!EmitPosMtxRead())
+			WriteCall(PosMtx_ReadDirect_UByte);
 		components |= VB_HAS_POSMTXIDX;
 		m_VertexSize += 1;
 	}
 
-	if (m_VtxDesc.Tex0MatIdx) {m_VertexSize += 1; components |= VB_HAS_TEXMTXIDX0; WriteCall(TexMtx_ReadDirect_UByte); }
-	if (m_VtxDesc.Tex1MatIdx) {m_VertexSize += 1; components |= VB_HAS_TEXMTXIDX1; WriteCall(TexMtx_ReadDirect_UByte); }
-	if (m_VtxDesc.Tex2MatIdx) {m_VertexSize += 1; components |= VB_HAS_TEXMTXIDX2; WriteCall(TexMtx_ReadDirect_UByte); }
-	if (m_VtxDesc.Tex3MatIdx) {m_VertexSize += 1; components |= VB_HAS_TEXMTXIDX3; WriteCall(TexMtx_ReadDirect_UByte); }
-	if (m_VtxDesc.Tex4MatIdx) {m_VertexSize += 1; components |= VB_HAS_TEXMTXIDX4; WriteCall(TexMtx_ReadDirect_UByte); }
-	if (m_VtxDesc.Tex5MatIdx) {m_VertexSize += 1; components |= VB_HAS_TEXMTXIDX5; WriteCall(TexMtx_ReadDirect_UByte); }
-	if (m_VtxDesc.Tex6MatIdx) {m_VertexSize += 1; components |= VB_HAS_TEXMTXIDX6; WriteCall(TexMtx_ReadDirect_UByte); }
-	if (m_VtxDesc.Tex7MatIdx) {m_VertexSize += 1; components |= VB_HAS_TEXMTXIDX7; WriteCall(TexMtx_ReadDirect_UByte); }
+	if (m_VtxDesc.Tex0MatIdx) {m_VertexSize += 1; components |= VB_HAS_TEXMTXIDX0; if (!EmitTexMtxRead()) WriteCall(TexMtx_ReadDirect_UByte); }
+	if (m_VtxDesc.Tex1MatIdx) {m_VertexSize += 1; components |= VB_HAS_TEXMTXIDX1; if (!EmitTexMtxRead()) WriteCall(TexMtx_ReadDirect_UByte); }
+	if (m_VtxDesc.Tex2MatIdx) {m_VertexSize += 1; components |= VB_HAS_TEXMTXIDX2; if (!EmitTexMtxRead()) WriteCall(TexMtx_ReadDirect_UByte); }
+	if (m_VtxDesc.Tex3MatIdx) {m_VertexSize += 1; components |= VB_HAS_TEXMTXIDX3; if (!EmitTexMtxRead()) WriteCall(TexMtx_ReadDirect_UByte); }
+	if (m_VtxDesc.Tex4MatIdx) {m_VertexSize += 1; components |= VB_HAS_TEXMTXIDX4; if (!EmitTexMtxRead()) WriteCall(TexMtx_ReadDirect_UByte); }
+	if (m_VtxDesc.Tex5MatIdx) {m_VertexSize += 1; components |= VB_HAS_TEXMTXIDX5; if (!EmitTexMtxRead()) WriteCall(TexMtx_ReadDirect_UByte); }
+	if (m_VtxDesc.Tex6MatIdx) {m_VertexSize += 1; components |= VB_HAS_TEXMTXIDX6; if (!EmitTexMtxRead()) WriteCall(TexMtx_ReadDirect_UByte); }
+	if (m_VtxDesc.Tex7MatIdx) {m_VertexSize += 1; components |= VB_HAS_TEXMTXIDX7; if (!EmitTexMtxRead()) WriteCall(TexMtx_ReadDirect_UByte); }
 
 	// Write vertex position loader
 	if (g_ActiveConfig.bUseBBox)
@@ -573,7 +600,7 @@ void VertexLoader::CompileVertexTranslator()
 		WriteCall(VertexLoader_Position::GetFunction(m_VtxDesc.Position, m_VtxAttr.PosFormat, m_VtxAttr.PosElements));
 		WriteCall(UpdateBoundingBox);
 	}
-	else
+	else if (!EmitPosition())
 	{
 		WriteCall(VertexLoader_Position::GetFunction(m_VtxDesc.Position, m_VtxAttr.PosFormat, m_VtxAttr.PosElements));
 	}
@@ -601,7 +628,8 @@ void VertexLoader::CompileVertexTranslator()
 				m_VtxDesc.Normal, m_VtxAttr.NormalFormat, 
 				m_VtxAttr.NormalElements, m_VtxAttr.NormalIndex3).c_str());
 		}
-		WriteCall(pFunc);
+		if (!EmitNormal())
+			WriteCall(pFunc);
 
 		for (int i = 0; i < (vtx_attr.NormalElements ? 3 : 1); i++)
 		{
@@ -625,6 +653,7 @@ void VertexLoader::CompileVertexTranslator()
 		vtx_decl.colors[i].components = 4;
 		vtx_decl.colors[i].type = VAR_UNSIGNED_BYTE;
 		vtx_decl.colors[i].integer = false;
+		TPipelineFunction pFunc = nullptr;
 		switch (col[i])
 		{
 		case NOT_PRESENT:
@@ -632,12 +661,12 @@ void VertexLoader::CompileVertexTranslator()
 		case DIRECT:
 			switch (m_VtxAttr.color[i].Comp)
 			{
-			case FORMAT_16B_565:  m_VertexSize += 2; WriteCall(Color_ReadDirect_16b_565); break;
-			case FORMAT_24B_888:  m_VertexSize += 3; WriteCall(Color_ReadDirect_24b_888); break;
-			case FORMAT_32B_888x: m_VertexSize += 4; WriteCall(Color_ReadDirect_32b_888x); break;
-			case FORMAT_16B_4444: m_VertexSize += 2; WriteCall(Color_ReadDirect_16b_4444); break;
-			case FORMAT_24B_6666: m_VertexSize += 3; WriteCall(Color_ReadDirect_24b_6666); break;
-			case FORMAT_32B_8888: m_VertexSize += 4; WriteCall(Color_ReadDirect_32b_8888); break;
+			case FORMAT_16B_565:  m_VertexSize += 2; pFunc = Color_ReadDirect_16b_565; break;
+			case FORMAT_24B_888:  m_VertexSize += 3; pFunc = Color_ReadDirect_24b_888; break;
+			case FORMAT_32B_888x: m_VertexSize += 4; pFunc = Color_ReadDirect_32b_888x; break;
+			case FORMAT_16B_4444: m_VertexSize += 2; pFunc = Color_ReadDirect_16b_4444; break;
+			case FORMAT_24B_6666: m_VertexSize += 3; pFunc = Color_ReadDirect_24b_6666; break;
+			case FORMAT_32B_8888: m_VertexSize += 4; pFunc = Color_ReadDirect_32b_8888; break;
 			default: _assert_(0); break;
 			}
 			break;
@@ -645,12 +674,12 @@ void VertexLoader::CompileVertexTranslator()
 			m_VertexSize += 1;
 			switch (m_VtxAttr.color[i].Comp)
 			{
-			case FORMAT_16B_565:  WriteCall(Color_ReadIndex8_16b_565); break;
-			case FORMAT_24B_888:  WriteCall(Color_ReadIndex8_24b_888); break;
-			case FORMAT_32B_888x: WriteCall(Color_ReadIndex8_32b_888x); break;
-			case FORMAT_16B_4444: WriteCall(Color_ReadIndex8_16b_4444); break;
-			case FORMAT_24B_6666: WriteCall(Color_ReadIndex8_24b_6666); break;
-			case FORMAT_32B_8888: WriteCall(Color_ReadIndex8_32b_8888); break;
+			case FORMAT_16B_565:  pFunc = Color_ReadIndex8_16b_565; break;
+			case FORMAT_24B_888:  pFunc = Color_ReadIndex8_24b_888; break;
+			case FORMAT_32B_888x: pFunc = Color_ReadIndex8_32b_888x; break;
+			case FORMAT_16B_4444: pFunc = Color_ReadIndex8_16b_4444; break;
+			case FORMAT_24B_6666: pFunc = Color_ReadIndex8_24b_6666; break;
+			case FORMAT_32B_8888: pFunc = Color_ReadIndex8_32b_8888; break;
 			default: _assert_(0); break;
 			}
 			break;
@@ -658,16 +687,19 @@ void VertexLoader::CompileVertexTranslator()
 			m_VertexSize += 2;
 			switch (m_VtxAttr.color[i].Comp)
 			{
-			case FORMAT_16B_565:  WriteCall(Color_ReadIndex16_16b_565); break;
-			case FORMAT_24B_888:  WriteCall(Color_ReadIndex16_24b_888); break;
-			case FORMAT_32B_888x: WriteCall(Color_ReadIndex16_32b_888x); break;
-			case FORMAT_16B_4444: WriteCall(Color_ReadIndex16_16b_4444); break;
-			case FORMAT_24B_6666: WriteCall(Color_ReadIndex16_24b_6666); break;
-			case FORMAT_32B_8888: WriteCall(Color_ReadIndex16_32b_8888); break;
+			case FORMAT_16B_565:  pFunc = Color_ReadIndex16_16b_565; break;
+			case FORMAT_24B_888:  pFunc = Color_ReadIndex16_24b_888; break;
+			case FORMAT_32B_888x: pFunc = Color_ReadIndex16_32b_888x; break;
+			case FORMAT_16B_4444: pFunc = Color_ReadIndex16_16b_4444; break;
+			case FORMAT_24B_6666: pFunc = Color_ReadIndex16_24b_6666; break;
+			case FORMAT_32B_8888: pFunc = Color_ReadIndex16_32b_8888; break;
 			default: _assert_(0); break;
 			}
 			break;
 		}
+		if (col[i] != NOT_PRESENT && !EmitColor(i, col[i]))
+			WriteCall(pFunc);
+
 		// Common for the three bottom cases
 		if (col[i] != NOT_PRESENT)
 		{
@@ -699,7 +731,8 @@ void VertexLoader::CompileVertexTranslator()
 			_assert_msg_(VIDEO, 0 <= elements && elements <= 1, "Invalid number of texture coordinates elements!\n(elements = %d)", elements);
 
 			components |= VB_HAS_UV0 << i;
-			WriteCall(VertexLoader_TextCoord::GetFunction(tc[i], format, elements));
+			if (!EmitTexCoord(i, tc[i]))
+				WriteCall(VertexLoader_TextCoord::GetFunction(tc[i], format, elements));
 			m_VertexSize += VertexLoader_TextCoord::GetSize(tc[i], format, elements);
 		}
 
@@ -711,14 +744,16 @@ void VertexLoader::CompileVertexTranslator()
 				// if texmtx is included, texcoord will always be 3 floats, z will be the texmtx index
 				vtx_decl.texcoords[i].components = 3;
 				nat_offset += 12;
-				WriteCall(m_VtxAttr.texCoord[i].Elements ? TexMtx_Write_Float : TexMtx_Write_Float2);
+				if (!EmitTexMtxWrite(m_VtxAttr.texCoord[i].Elements ? 1 : 2))
+					WriteCall(m_VtxAttr.texCoord[i].Elements ? TexMtx_Write_Float : TexMtx_Write_Float2);
 			}
 			else
 			{
 				components |= VB_HAS_UV0 << i; // have to include since using now
 				vtx_decl.texcoords[i].components = 4;
 				nat_offset += 16; // still include the texture coordinate, but this time as 6 + 2 bytes
-				WriteCall(TexMtx_Write_Float4);
+				if (!EmitTexMtxWrite(4))
+					WriteCall(TexMtx_Write_Float4);
 			}
 		}
 		else
@@ -739,7 +774,8 @@ void VertexLoader::CompileVertexTranslator()
 			{
 				if (tc[j] != NOT_PRESENT)
 				{
-					WriteCall(VertexLoader_TextCoord::GetDummyFunction()); // important to get indices right!
+					if (!m_inline)
+						WriteCall(VertexLoader_TextCoord::GetDummyFunction()); // important to get indices right!
 					break;
 				}
 			}
@@ -754,7 +790,8 @@ void VertexLoader::CompileVertexTranslator()
 
 	if (m_VtxDesc.PosMatIdx)
 	{
-		WriteCall(PosMtx_Write);
+		if (!EmitPosMtxWrite())
+			WriteCall(PosMtx_Write);
 		vtx_decl.posmtx.components = 4;
 		vtx_decl.posmtx.enable = true;
 		vtx_decl.posmtx.offset = nat_offset;
@@ -769,13 +806,25 @@ void VertexLoader::CompileVertexTranslator()
 #ifdef USE_VERTEX_LOADER_JIT
 	// End loop here
 #if _M_X86_64
-	MOV(64, R(RAX), Imm64((u64)&loop_counter));
-	SUB(32, MatR(RAX), Imm8(1));
+	if (m_inline)
+	{
+		UseRegisters();
+		AdvancePointers();
+		SUB(32, R(EBX), Imm8(1));
+		J_CC(CC_NZ, loop_start, true);
+		UseGlobals();
+	}
+	else
+	{
+		MOV(64, R(RAX), Imm64((u64)&loop_counter));
+		SUB(32, MatR(RAX), Imm8(1));
+		J_CC(CC_NZ, loop_start, true);
+	}
 #else
 	SUB(32, M(&loop_counter), Imm8(1));
+	J_CC(CC_NZ, loop_start, true);
 #endif
 
-	J_CC(CC_NZ, loop_start, true);
 	ABI_PopAllCalleeSavedRegsAndAdjustStack();
 	RET();
 #endif
@@ -788,8 +837,12 @@ void VertexLoader::WriteCall(TPipelineFunction func)
 {
 #ifdef USE_VERTEX_LOADER_JIT
 #if _M_X86_64
+	// The C loaders go by the globals.
+	if (m_inline)
+		UseGlobals();
 	MOV(64, R(RAX), Imm64((u64)func));
 	CALLptr(R(RAX));
+	m_registersValid = false;
 #else
 	CALL((void*)func);
 #endif
@@ -824,6 +877,362 @@ void VertexLoader::WriteSetVariable(int bits, void *address, OpArg value)
 }
 #endif
 
+#if defined(USE_VERTEX_LOADER_JIT) && _M_X86_64
+
+// The attribute loaders generated in line keep g_pVideoData in RSI and
+// VertexManager::s_pCurBufferPointer in RDI, with the offsets into the vertex
+// known at compile time, and only write the pointers back for the C loaders
+// the rarer formats still call. RAX, RCX, RDX, XMM0 and XMM1 are scratch, and
+// EBX counts the vertices.
+
+// PSHUFB masks by format and element count, that byte swap big endian
+// elements into the top of a 32 bit lane each, or in place for floats, and
+// clear the lanes past the count.
+static struct ShuffleMasks
+{
+	GC_ALIGNED16(u8 masks[5][4][16]);
+
+	ShuffleMasks()
+	{
+		static const int sizes[5] = { 1, 1, 2, 2, 4 };
+		memset(masks, 0x80, sizeof(masks));
+		for (int format = 0; format < 5; ++format)
+		{
+			const int size = sizes[format];
+			for (int count = 1; count < 4; ++count)
+			{
+				for (int lane = 0; lane < count; ++lane)
+				{
+					for (int byte = 0; byte < size; ++byte)
+						masks[format][count][lane * 4 + 3 - byte] = lane * size + byte;
+				}
+			}
+		}
+	}
+} s_shuffleMasks;
+
+// What VertexLoader_Normal divides each format by.
+static const float s_normalScales[5] = {
+	1.0f / (1 << 7), 1.0f / (1 << 6), 1.0f / (1 << 15), 1.0f / (1 << 14), 1.0f,
+};
+
+static int GetElementSize(int format)
+{
+	static const int sizes[5] = { 1, 1, 2, 2, 4 };
+	return sizes[format];
+}
+
+void VertexLoader::UseRegisters()
+{
+	if (!m_registersValid)
+	{
+		MOV(64, R(RAX), ImmPtr(&g_pVideoData));
+		MOV(64, R(RSI), MatR(RAX));
+		MOV(64, R(RAX), ImmPtr(&VertexManager::s_pCurBufferPointer));
+		MOV(64, R(RDI), MatR(RAX));
+		m_srcOffset = 0;
+		m_dstOffset = 0;
+		m_registersValid = true;
+	}
+	m_globalsValid = false;
+}
+
+void VertexLoader::UseGlobals()
+{
+	if (!m_globalsValid)
+	{
+		AdvancePointers();
+		MOV(64, R(RAX), ImmPtr(&g_pVideoData));
+		MOV(64, MatR(RAX), R(RSI));
+		MOV(64, R(RAX), ImmPtr(&VertexManager::s_pCurBufferPointer));
+		MOV(64, MatR(RAX), R(RDI));
+		m_globalsValid = true;
+	}
+}
+
+void VertexLoader::AdvancePointers()
+{
+	if (m_srcOffset)
+		ADD(64, R(RSI), Imm32(m_srcOffset));
+	if (m_dstOffset)
+		ADD(64, R(RDI), Imm32(m_dstOffset));
+	m_srcOffset = 0;
+	m_dstOffset = 0;
+}
+
+// Reads an index from the vertex, and leaves the address of the element it
+// picks from the array in RAX.
+void VertexLoader::EmitArrayAddress(int array, int index_type, int offset)
+{
+	if (index_type == INDEX8)
+	{
+		MOVZX(32, 8, EAX, MDisp(RSI, m_srcOffset + offset));
+	}
+	else
+	{
+		MOVZX(32, 16, EAX, MDisp(RSI, m_srcOffset + offset));
+		ROL(16, R(EAX), Imm8(8));
+	}
+	MOV(64, R(RCX), ImmPtr(&arraystrides[array]));
+	IMUL(32, EAX, MatR(RCX));
+	MOV(64, R(RCX), ImmPtr(&cached_arraybases[array]));
+	ADD(64, R(RAX), MatR(RCX));
+}
+
+// Loads count big endian elements of format from src, turns them into floats
+// multiplied by *scale, and stores out_count of them, zeroes past count.
+void VertexLoader::EmitVector(OpArg src, int format, int count, int out_count, const float *scale)
+{
+	const int size = count * GetElementSize(format);
+	if (size <= 4)
+		MOVD_xmm(XMM0, src);
+	else if (size <= 8)
+		MOVQ_xmm(XMM0, src);
+	else
+		MOVUPS(XMM0, src);
+
+	MOV(64, R(RDX), ImmPtr(s_shuffleMasks.masks[format][count]));
+	PSHUFB(XMM0, MatR(RDX));
+
+	if (format != FORMAT_FLOAT)
+	{
+		const int shift = GetElementSize(format) == 1 ? 24 : 16;
+		if (format == FORMAT_BYTE || format == FORMAT_SHORT)
+			PSRAD(XMM0, shift);
+		else
+			PSRLD(XMM0, shift);
+		CVTDQ2PS(XMM0, R(XMM0));
+
+		MOV(64, R(RDX), ImmPtr(scale));
+		MOVSS(XMM1, MatR(RDX));
+		SHUFPS(XMM1, R(XMM1), 0);
+		MULPS(XMM0, R(XMM1));
+	}
+
+	switch (out_count)
+	{
+	case 1:
+		MOVSS(MDisp(RDI, m_dstOffset), XMM0);
+		break;
+	case 2:
+		MOVQ_xmm(MDisp(RDI, m_dstOffset), XMM0);
+		break;
+	case 3:
+		MOVQ_xmm(MDisp(RDI, m_dstOffset), XMM0);
+		SHUFPS(XMM0, R(XMM0), 2);
+		MOVSS(MDisp(RDI, m_dstOffset + 8), XMM0);
+		break;
+	}
+	m_dstOffset += out_count * sizeof(float);
+}
+
+bool VertexLoader::EmitPosMtxRead()
+{
+	if (!m_inline)
+		return false;
+
+	UseRegisters();
+	MOVZX(32, 8, EAX, MDisp(RSI, m_srcOffset));
+	AND(32, R(EAX), Imm8(0x3f));
+	MOV(64, R(RCX), ImmPtr(&s_curposmtx));
+	MOV(8, MatR(RCX), R(AL));
+	m_srcOffset += 1;
+	return true;
+}
+
+bool VertexLoader::EmitTexMtxRead()
+{
+	if (!m_inline)
+		return false;
+
+	UseRegisters();
+	MOVZX(32, 8, EAX, MDisp(RSI, m_srcOffset));
+	AND(32, R(EAX), Imm8(0x3f));
+	MOV(64, R(RCX), ImmPtr(&s_curtexmtx[m_texMtxRead++]));
+	MOV(8, MatR(RCX), R(AL));
+	m_srcOffset += 1;
+	return true;
+}
+
+bool VertexLoader::EmitPosMtxWrite()
+{
+	if (!m_inline)
+		return false;
+
+	UseRegisters();
+	MOV(64, R(RCX), ImmPtr(&s_curposmtx));
+	MOVZX(32, 8, EAX, MatR(RCX));
+	MOV(32, MDisp(RDI, m_dstOffset), R(EAX));
+	m_dstOffset += 4;
+
+	// Back to the default, for the bounding box.
+	MOV(64, R(RDX), ImmPtr(&MatrixIndexA));
+	MOV(32, R(EAX), MatR(RDX));
+	AND(32, R(EAX), Imm8(0x3f));
+	MOV(8, MatR(RCX), R(AL));
+	return true;
+}
+
+// The matrix index as the last float but one of floats, zeroes around it.
+bool VertexLoader::EmitTexMtxWrite(int floats)
+{
+	if (!m_inline)
+		return false;
+
+	UseRegisters();
+	MOV(64, R(RCX), ImmPtr(&s_curtexmtx[m_texMtxWrite++]));
+	MOVZX(32, 8, EAX, MatR(RCX));
+	MOVD_xmm(XMM0, R(EAX));
+	CVTDQ2PS(XMM0, R(XMM0));
+
+	const int index = floats == 4 ? 2 : floats - 1;
+	for (int i = 0; i < floats; ++i)
+	{
+		if (i == index)
+			MOVSS(MDisp(RDI, m_dstOffset + i * 4), XMM0);
+		else
+			MOV(32, MDisp(RDI, m_dstOffset + i * 4), Imm32(0));
+	}
+	m_dstOffset += floats * 4;
+	return true;
+}
+
+bool VertexLoader::EmitPosition()
+{
+	const int format = m_VtxAttr.PosFormat;
+	if (!m_inline || format > FORMAT_FLOAT)
+		return false;
+
+	UseRegisters();
+	const int count = m_VtxAttr.PosElements ? 3 : 2;
+	if (m_VtxDesc.Position == DIRECT)
+	{
+		EmitVector(MDisp(RSI, m_srcOffset), format, count, 3, &posScale);
+		m_srcOffset += count * GetElementSize(format);
+	}
+	else
+	{
+		EmitArrayAddress(ARRAY_POSITION, m_VtxDesc.Position, 0);
+		EmitVector(MatR(RAX), format, count, 3, &posScale);
+		m_srcOffset += m_VtxDesc.Position == INDEX8 ? 1 : 2;
+	}
+	return true;
+}
+
+bool VertexLoader::EmitNormal()
+{
+	const int format = m_VtxAttr.NormalFormat;
+	if (!m_inline || format > FORMAT_FLOAT)
+		return false;
+
+	UseRegisters();
+	const int normals = m_VtxAttr.NormalElements ? 3 : 1;
+	const int size = 3 * GetElementSize(format);
+	const float *scale = &s_normalScales[format];
+	if (m_VtxDesc.Normal == DIRECT)
+	{
+		for (int i = 0; i < normals; ++i)
+		{
+			EmitVector(MDisp(RSI, m_srcOffset), format, 3, 3, scale);
+			m_srcOffset += size;
+		}
+	}
+	else
+	{
+		const int index_size = m_VtxDesc.Normal == INDEX8 ? 1 : 2;
+		// With three indices, each normal has its own.
+		const bool index3 = normals == 3 && m_VtxAttr.NormalIndex3;
+		for (int i = 0; i < normals; ++i)
+		{
+			if (i == 0 || index3)
+				EmitArrayAddress(ARRAY_NORMAL, m_VtxDesc.Normal, index3 ? i * index_size : 0);
+			EmitVector(MDisp(RAX, i * size), format, 3, 3, scale);
+		}
+		m_srcOffset += index3 ? 3 * index_size : index_size;
+	}
+	return true;
+}
+
+bool VertexLoader::EmitColor(int index, u32 mode)
+{
+	const int format = m_VtxAttr.color[index].Comp;
+	if (!m_inline)
+		return false;
+
+	// The C loaders go by colIndex, which counts the colors before this one,
+	// for the array and the elements. A second color without a first ends up
+	// with those of the first.
+	const int slot = index && m_VtxDesc.Color0 != NOT_PRESENT ? 1 : 0;
+	if (format != FORMAT_24B_888 && format != FORMAT_32B_888x && format != FORMAT_32B_8888)
+	{
+		// Which isn't kept up by the code here.
+		WriteSetVariable(32, &colIndex, Imm32(slot));
+		return false;
+	}
+
+	UseRegisters();
+	if (mode == DIRECT)
+	{
+		MOV(32, R(EAX), MDisp(RSI, m_srcOffset));
+		m_srcOffset += format == FORMAT_24B_888 ? 3 : 4;
+	}
+	else
+	{
+		EmitArrayAddress(ARRAY_COLOR + slot, mode, 0);
+		MOV(32, R(EAX), MatR(RAX));
+		m_srcOffset += mode == INDEX8 ? 1 : 2;
+	}
+
+	// Only direct 8888 colors keep their alpha, and only with the elements
+	// saying they have one.
+	if (format != FORMAT_32B_8888 || (mode == DIRECT && !m_VtxAttr.color[slot].Elements))
+		OR(32, R(EAX), Imm32(0xFF000000));
+
+	MOV(32, MDisp(RDI, m_dstOffset), R(EAX));
+	m_dstOffset += 4;
+	return true;
+}
+
+bool VertexLoader::EmitTexCoord(int index, u32 mode)
+{
+	const int format = m_VtxAttr.texCoord[index].Format;
+	if (!m_inline)
+		return false;
+	if (format > FORMAT_FLOAT)
+	{
+		WriteSetVariable(32, &tcIndex, Imm32(index));
+		return false;
+	}
+
+	UseRegisters();
+	const int count = m_VtxAttr.texCoord[index].Elements ? 2 : 1;
+	if (mode == DIRECT)
+	{
+		EmitVector(MDisp(RSI, m_srcOffset), format, count, count, &tcScale[index]);
+		m_srcOffset += count * GetElementSize(format);
+	}
+	else
+	{
+		EmitArrayAddress(ARRAY_TEXCOORD0 + index, mode, 0);
+		EmitVector(MatR(RAX), format, count, count, &tcScale[index]);
+		m_srcOffset += mode == INDEX8 ? 1 : 2;
+	}
+	return true;
+}
+
+#else
+
+bool VertexLoader::EmitPosMtxRead() { return false; }
+bool VertexLoader::EmitTexMtxRead() { return false; }
+bool VertexLoader::EmitPosMtxWrite() { return false; }
+bool VertexLoader::EmitTexMtxWrite(int floats) { return false; }
+bool VertexLoader::EmitPosition() { return false; }
+bool VertexLoader::EmitNormal() { return false; }
+bool VertexLoader::EmitColor(int index, u32 mode) { return false; }
+bool VertexLoader::EmitTexCoord(int index, u32 mode) { return false; }
+
+#endif
+
 void VertexLoader::SetupRunVertices(int vtx_attr_group, int primitive, int const count)
 {
 	m_numLoadedVertices += count;
@@ -102,6 +102,10 @@ public:
 	void SetupRunVertices(int vtx_attr_group, int primitive, int const count);
 	void RunVertices(int vtx_attr_group, int primitive, int count);
 
+	// Converts count vertices from g_pVideoData to VertexManager::s_pCurBufferPointer,
+	// once SetupRunVertices has been called.
+	void ConvertVertices(int count);
+
 	// For debugging / profiling
 	void AppendToString(std::string *dest) const;
 	int GetNumLoadedVerts() const { return m_numLoadedVertices; }
@@ -132,17 +136,45 @@ private:
 
 	const u8 *m_compiledCode;
 
+	// Whether the attributes are loaded by code generated in line, rather
+	// than by calls to the C loaders. See VertexLoader.cpp.
+	bool m_inline;
+	// How far the generated code has read and written past the pointers it
+	// keeps in registers, and whether those or the globals are up to date.
+	int m_srcOffset;
+	int m_dstOffset;
+	bool m_registersValid;
+	bool m_globalsValid;
+	int m_texMtxRead;
+	int m_texMtxWrite;
+
 	int m_numLoadedVertices;
 
 	void SetVAT(u32 _group0, u32 _group1, u32 _group2);
 
 	void CompileVertexTranslator();
-	void ConvertVertices(int count);
 
 	void WriteCall(TPipelineFunction);
 
+	// These generate the loader of one attribute in line, and return false
+	// for the formats left to WriteCall.
+	bool EmitPosMtxRead();
+	bool EmitTexMtxRead();
+	bool EmitPosMtxWrite();
+	bool EmitTexMtxWrite(int floats);
+	bool EmitPosition();
+	bool EmitNormal();
+	bool EmitColor(int index, u32 mode);
+	bool EmitTexCoord(int index, u32 mode);
+
 #ifndef _M_GENERIC
 	void WriteGetVariable(int bits, Gen::OpArg dest, void *address);
 	void WriteSetVariable(int bits, void *address, Gen::OpArg dest);
+
+	void UseRegisters();
+	void UseGlobals();
+	void AdvancePointers();
+	void EmitArrayAddress(int array, int index_type, int offset);
+	void EmitVector(Gen::OpArg src, int format, int count, int out_count, const float *scale);
 #endif
 };
@@ -51,6 +51,7 @@ void VideoConfig::Load(const std::string& ini_file)
 	iniFile.Get("Settings", "UseXFB", &bUseXFB, 0);
 	iniFile.Get("Settings", "UseRealXFB", &bUseRealXFB, 0);
 	iniFile.Get("Settings", "SafeTextureCacheColorSamples", &iSafeTextureCache_ColorSamples,128);
+	iniFile.Get("Settings", "TextureWriteTracking", &bTextureWriteTracking, true);
 	iniFile.Get("Settings", "ShowFPS", &bShowFPS, false); // Settings
 	iniFile.Get("Settings", "LogFPSToFile", &bLogFPSToFile, false);
 	iniFile.Get("Settings", "ShowInputDisplay", &bShowInputDisplay, false);
@@ -83,6 +84,7 @@ void VideoConfig::Load(const std::string& ini_file)
 	iniFile.Get("Settings", "OMPDecoder", &bOMPDecoder, false);
 
 	iniFile.Get("Settings", "EnableShaderDebugging", &bEnableShaderDebugging, false);
+	iniFile.Get("Settings", "InlineVertexLoaders", &bInlineVertexLoaders, true);
 
 	iniFile.Get("Enhancements", "ForceFiltering", &bForceFiltering, 0);
 	iniFile.Get("Enhancements", "MaxAnisotropy", &iMaxAnisotropy, 0);  // NOTE - this is x in (1 << x)
@@ -143,6 +145,7 @@ void VideoConfig::GameIniLoad()
 	CHECK_SETTING("Video_Settings", "UseXFB", bUseXFB);
 	CHECK_SETTING("Video_Settings", "UseRealXFB", bUseRealXFB);
 	CHECK_SETTING("Video_Settings", "SafeTextureCacheColorSamples", iSafeTextureCache_ColorSamples);
+	CHECK_SETTING("Video_Settings", "TextureWriteTracking", bTextureWriteTracking);
 	CHECK_SETTING("Video_Settings", "DLOptimize", iCompileDLsLevel);
 	CHECK_SETTING("Video_Settings", "HiresTextures", bHiresTextures);
 	CHECK_SETTING("Video_Settings", "AnaglyphStereo", bAnaglyphStereo);
@@ -227,6 +230,7 @@ void VideoConfig::Save(const std::string& ini_file)
 	iniFile.Set("Settings", "UseXFB", bUseXFB);
 	iniFile.Set("Settings", "UseRealXFB", bUseRealXFB);
 	iniFile.Set("Settings", "SafeTextureCacheColorSamples", iSafeTextureCache_ColorSamples);
+	iniFile.Set("Settings", "TextureWriteTracking", bTextureWriteTracking);
 	iniFile.Set("Settings", "ShowFPS", bShowFPS);
 	iniFile.Set("Settings", "LogFPSToFile", bLogFPSToFile);
 	iniFile.Set("Settings", "ShowInputDisplay", bShowInputDisplay);
@@ -258,6 +262,7 @@ void VideoConfig::Save(const std::string& ini_file)
 	iniFile.Set("Settings", "OMPDecoder", bOMPDecoder);
 
 	iniFile.Set("Settings", "EnableShaderDebugging", bEnableShaderDebugging);
+	iniFile.Set("Settings", "InlineVertexLoaders", bInlineVertexLoaders);
 
 	iniFile.Set("Enhancements", "ForceFiltering", bForceFiltering);
 	iniFile.Set("Enhancements", "MaxAnisotropy", iMaxAnisotropy);
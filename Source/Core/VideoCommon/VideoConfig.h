@@ -67,7 +67,7 @@ struct VideoConfig final
 	bool bUseXFB;
 	bool bUseRealXFB;
 
-	// OpenMP
+	// Decode large textures on several threads
 	bool bOMPDecoder;
 
 	// Enhancements
@@ -114,6 +114,7 @@ struct VideoConfig final
 	bool bCopyEFBToTexture;
 	bool bCopyEFBScaled;
 	int iSafeTextureCache_ColorSamples;
+	bool bTextureWriteTracking;
 	int iPhackvalue[3];
 	std::string sPhackvalue[2];
 	float fAspectRatioHackW, fAspectRatioHackH;
@@ -131,6 +132,7 @@ struct VideoConfig final
 
 	// Debugging
 	bool bEnableShaderDebugging;
+	bool bInlineVertexLoaders;
 
 	// Static config per API
 	// TODO: Move this out of VideoConfig
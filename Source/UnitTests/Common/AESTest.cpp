@@ -0,0 +1,56 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <random>
+#include <vector>
+#include <gtest/gtest.h>
+#include <polarssl/aes.h>
+
+#include "Common/CommonTypes.h"
+#include "Common/CPUDetect.h"
+#include "Common/Crypto/aes.h"
+
+TEST(AES, DecryptCBCMatchesPolarSSL)
+{
+	std::mt19937 rng(1234);
+	auto fill = [&](u8* data, size_t size) {
+		for (size_t i = 0; i < size; ++i)
+			data[i] = (u8)rng();
+	};
+
+	u8 key[16];
+	fill(key, sizeof(key));
+	aes_context ctx;
+	aes_setkey_dec(&ctx, key, 128);
+
+	// Check both paths when the CPU allows it.
+	const bool has_aes = cpu_info.bAES;
+	for (int use_aesni = 0; use_aesni <= (int)has_aes; ++use_aesni)
+	{
+		cpu_info.bAES = use_aesni != 0;
+		for (size_t size : { 16, 48, 64, 80, 0x400, 0x7C00 })
+		{
+			std::vector<u8> src(size), expected(size), actual(size);
+			fill(&src[0], size);
+			u8 iv[16], expected_iv[16];
+			fill(iv, sizeof(iv));
+			memcpy(expected_iv, iv, sizeof(iv));
+
+			aes_crypt_cbc(&ctx, AES_DECRYPT, size, expected_iv, &src[0], &expected[0]);
+
+			u8 actual_iv[16];
+			memcpy(actual_iv, iv, sizeof(iv));
+			AES::DecryptCBC(&ctx, actual_iv, &src[0], &actual[0], size);
+			EXPECT_EQ(expected, actual) << "size " << size << ", AES-NI " << use_aesni;
+			EXPECT_EQ(0, memcmp(expected_iv, actual_iv, sizeof(iv)));
+
+			// In place.
+			memcpy(actual_iv, iv, sizeof(iv));
+			AES::DecryptCBC(&ctx, actual_iv, &src[0], &src[0], size);
+			EXPECT_EQ(expected, src);
+		}
+	}
+	cpu_info.bAES = has_aes;
+}
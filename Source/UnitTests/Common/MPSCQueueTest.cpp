@@ -0,0 +1,74 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+#include "Common/MPSCQueue.h"
+
+TEST(MPSCQueue, Simple)
+{
+	Common::MPSCQueue<u32> q;
+
+	EXPECT_TRUE(q.Empty());
+	u32 v;
+	EXPECT_FALSE(q.Pop(v));
+
+	q.Push(1);
+	EXPECT_FALSE(q.Empty());
+	EXPECT_TRUE(q.Pop(v));
+	EXPECT_EQ(1u, v);
+	EXPECT_TRUE(q.Empty());
+
+	for (u32 i = 0; i < 1000; ++i)
+		q.Push(i);
+	for (u32 i = 0; i < 1000; ++i)
+	{
+		EXPECT_TRUE(q.Pop(v));
+		EXPECT_EQ(i, v);
+	}
+	EXPECT_TRUE(q.Empty());
+
+	for (u32 i = 0; i < 1000; ++i)
+		q.Push(i);
+	q.Clear();
+	EXPECT_TRUE(q.Empty());
+}
+
+TEST(MPSCQueue, MultipleWriters)
+{
+	static const u32 NUM_WRITERS = 4;
+	static const u32 NUM_ITEMS = 100000;
+	Common::MPSCQueue<u32> q;
+
+	auto inserter = [&q](u32 writer) {
+		for (u32 i = 0; i < NUM_ITEMS; ++i)
+			q.Push(writer * NUM_ITEMS + i);
+	};
+
+	// Every item must arrive exactly once, and each writer's items in order.
+	auto popper = [&q]() {
+		std::vector<u32> next(NUM_WRITERS, 0);
+		for (u32 i = 0; i < NUM_WRITERS * NUM_ITEMS; ++i)
+		{
+			u32 v;
+			while (!q.Pop(v));
+			u32 writer = v / NUM_ITEMS;
+			ASSERT_LT(writer, NUM_WRITERS);
+			EXPECT_EQ(next[writer], v % NUM_ITEMS);
+			next[writer]++;
+		}
+		EXPECT_TRUE(q.Empty());
+	};
+
+	std::thread popper_thread(popper);
+	std::vector<std::thread> inserter_threads;
+	for (u32 i = 0; i < NUM_WRITERS; ++i)
+		inserter_threads.emplace_back(inserter, i);
+
+	for (auto& t : inserter_threads)
+		t.join();
+	popper_thread.join();
+}
@@ -0,0 +1,67 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <gtest/gtest.h>
+#include <vector>
+
+#include "Common/ParallelFor.h"
+
+TEST(ParallelFor, EveryIndexOnce)
+{
+	static const u32 COUNT = 10000;
+	static const u32 WORKERS = 4;
+	std::vector<u32> calls(COUNT, 0);
+	std::vector<u32> worker_of(COUNT, WORKERS);
+
+	Common::ParallelFor(COUNT, WORKERS, [&](u32 i, u32 worker) {
+		calls[i]++;
+		worker_of[i] = worker;
+	});
+
+	for (u32 i = 0; i < COUNT; ++i)
+	{
+		EXPECT_EQ(1u, calls[i]);
+		EXPECT_LT(worker_of[i], WORKERS);
+	}
+}
+
+TEST(ParallelFor, Empty)
+{
+	bool called = false;
+	Common::ParallelFor(0, 4, [&](u32, u32) { called = true; });
+	EXPECT_FALSE(called);
+}
+
+TEST(WorkerPool, EveryIndexOnceRepeatedly)
+{
+	static const u32 WORKERS = 4;
+	Common::WorkerPool pool(WORKERS);
+	EXPECT_EQ(WORKERS, pool.GetNumWorkers());
+
+	for (u32 count : { 0u, 1u, 3u, 100u, 5000u })
+	{
+		for (int run = 0; run < 50; ++run)
+		{
+			std::vector<u32> calls(count, 0);
+			bool bad_worker = false;
+			pool.ParallelFor(count, [&](u32 i, u32 worker) {
+				calls[i]++;
+				if (worker >= WORKERS)
+					bad_worker = true;
+			});
+
+			for (u32 i = 0; i < count; ++i)
+				ASSERT_EQ(1u, calls[i]);
+			EXPECT_FALSE(bad_worker);
+		}
+	}
+}
+
+TEST(WorkerPool, SingleWorker)
+{
+	Common::WorkerPool pool(1);
+	u32 sum = 0;
+	pool.ParallelFor(10, [&](u32 i, u32 worker) { sum += i + worker; });
+	EXPECT_EQ(45u, sum);
+}
@@ -0,0 +1,83 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <gtest/gtest.h>
+#include <thread>
+
+#include "Common/SPSCQueue.h"
+
+TEST(SPSCQueue, Simple)
+{
+	Common::SPSCQueue<u32, 8> q;
+
+	EXPECT_TRUE(q.Empty());
+	u32 v;
+	EXPECT_FALSE(q.Pop(v));
+
+	EXPECT_TRUE(q.TryPush(1));
+	EXPECT_FALSE(q.Empty());
+	EXPECT_TRUE(q.Pop(v));
+	EXPECT_EQ(1u, v);
+	EXPECT_TRUE(q.Empty());
+
+	// Wraps around the ring a few times, and refuses to go past its size.
+	for (u32 round = 0; round < 3; ++round)
+	{
+		for (u32 i = 0; i < 8; ++i)
+			EXPECT_TRUE(q.TryPush(i));
+		EXPECT_FALSE(q.TryPush(8));
+		EXPECT_EQ(8u, q.Size());
+		for (u32 i = 0; i < 8; ++i)
+		{
+			EXPECT_TRUE(q.Pop(v));
+			EXPECT_EQ(i, v);
+		}
+		EXPECT_TRUE(q.Empty());
+	}
+}
+
+TEST(SPSCQueue, ReaderAndWriter)
+{
+	static const u32 NUM_ITEMS = 100000;
+	Common::SPSCQueue<u32, 64> q;
+
+	std::thread writer([&q]() {
+		for (u32 i = 0; i < NUM_ITEMS; ++i)
+			while (!q.TryPush(i))
+				std::this_thread::yield();
+	});
+
+	// Every item must arrive exactly once, in order.
+	for (u32 i = 0; i < NUM_ITEMS; ++i)
+	{
+		u32 v;
+		while (!q.Pop(v))
+			std::this_thread::yield();
+		ASSERT_EQ(i, v);
+	}
+
+	writer.join();
+	EXPECT_TRUE(q.Empty());
+}
+
+TEST(SPSCQueue, Many)
+{
+	Common::SPSCQueue<u32, 8> q;
+	const u32 items[] = { 0, 1, 2, 3, 4, 5, 6, 7 };
+	u32 out[8];
+
+	// Runs over the end of the ring and back to the start.
+	EXPECT_TRUE(q.TryPushMany(items, 5));
+	EXPECT_EQ(5u, q.PopMany(out, 8));
+	EXPECT_TRUE(q.TryPushMany(items, 6));
+	EXPECT_FALSE(q.TryPushMany(items, 3));
+	EXPECT_EQ(6u, q.Size());
+	EXPECT_EQ(4u, q.PopMany(out, 4));
+	for (u32 i = 0; i < 4; ++i)
+		EXPECT_EQ(i, out[i]);
+	EXPECT_EQ(2u, q.PopMany(out, 8));
+	EXPECT_EQ(4u, out[0]);
+	EXPECT_EQ(5u, out[1]);
+	EXPECT_EQ(0u, q.PopMany(out, 8));
+}
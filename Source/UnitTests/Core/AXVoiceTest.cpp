@@ -0,0 +1,249 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "Common/CommonTypes.h"
+#include "Common/ParallelFor.h"
+#include "Core/HW/DSP.h"
+
+#define AX_GC
+#include "Core/HW/DSPHLE/UCodes/UCode_AX_Voice.h"
+
+namespace
+{
+
+const u32 SPMS = 32;
+
+// Each buffer of AXBuffers, for the 5 ms of a frame.
+struct Output
+{
+	Output() : samples(sizeof(AXBuffers::ptrs) / sizeof(int*) * 5 * SPMS) {}
+
+	AXBuffers Buffers(u32 ms)
+	{
+		AXBuffers buffers;
+		for (u32 i = 0; i < sizeof(buffers.ptrs) / sizeof(int*); ++i)
+			buffers.ptrs[i] = &samples[(i * 5 + ms) * SPMS];
+		return buffers;
+	}
+
+	std::vector<int> samples;
+};
+
+void Hash(u64& hash, const void* data, size_t size)
+{
+	// FNV-1a
+	for (size_t i = 0; i < size; ++i)
+		hash = (hash ^ ((const u8*)data)[i]) * 1099511628211ULL;
+}
+
+// A voice at random, playing close enough to its end address to loop or stop
+// within a frame or two.
+AXPB MakeVoice(std::mt19937& rng)
+{
+	auto random = [&rng](u32 n) { return (u32)(rng() % n); };
+
+	AXPB pb;
+	u16* raw = (u16*)&pb;
+	for (size_t i = 0; i < sizeof(pb) / sizeof(u16); ++i)
+		raw[i] = (u16)rng();
+
+	static const u16 formats[] = { AUDIOFORMAT_ADPCM, AUDIOFORMAT_PCM8, AUDIOFORMAT_PCM16 };
+	pb.running = 1;
+	pb.is_stream = random(2);
+	pb.src_type = random(3);
+	pb.coef_select = 0;
+	pb.lpf.enabled = 0;
+	pb.initial_time_delay.on = 0;
+	pb.vol_env.cur_volume_delta = (s16)(random(512) - 256);
+	pb.audio_addr.looping = random(2);
+	pb.audio_addr.sample_format = formats[random(3)];
+
+	const u32 cur = 0x1000 + random(0x100000);
+	const u32 end = cur + 16 + random(400);
+	const u32 loop = cur - random(0x800);
+	pb.audio_addr.cur_addr_hi = (u16)(cur >> 16);
+	pb.audio_addr.cur_addr_lo = (u16)cur;
+	pb.audio_addr.end_addr_hi = (u16)(end >> 16);
+	pb.audio_addr.end_addr_lo = (u16)end;
+	pb.audio_addr.loop_addr_hi = (u16)(loop >> 16);
+	pb.audio_addr.loop_addr_lo = (u16)loop;
+
+	for (s16& coef : pb.adpcm.coefs)
+		coef = (s16)(random(0x2000) - 0x1000);
+	pb.adpcm.pred_scale &= 0x7F;
+	pb.adpcm_loop_info.pred_scale &= 0x7F;
+
+	const u32 ratio = 0x2000 + random(0x30000);
+	pb.src.ratio_hi = (u16)(ratio >> 16);
+	pb.src.ratio_lo = (u16)ratio;
+
+	// Every other one without ramps, and many not sent anywhere.
+	if (random(2))
+	{
+		pb.mixer.left_delta = pb.mixer.right_delta = pb.mixer.surround_delta = 0;
+		pb.mixer.auxA_left_delta = pb.mixer.auxA_right_delta = pb.mixer.auxA_surround_delta = 0;
+		pb.mixer.auxB_left_delta = pb.mixer.auxB_right_delta = pb.mixer.auxB_surround_delta = 0;
+	}
+
+	return pb;
+}
+
+// Plays a frame of voices over random ARAM and hashes what it mixed and what
+// it left in the PBs.
+u64 PlayFrame(u32 seed, u32 num_voices)
+{
+	std::mt19937 rng(seed);
+	u8* aram = DSP::GetARAMPtr();
+	for (u32 i = 0; i < 0x200000; i += 4)
+	{
+		const u32 word = rng();
+		memcpy(&aram[i], &word, sizeof(word));
+	}
+
+	Output output;
+	u64 hash = 14695981039346656037ULL;
+	for (u32 v = 0; v < num_voices; ++v)
+	{
+		AXPB pb = MakeVoice(rng);
+		const AXMixControl mctrl = (AXMixControl)(rng() & 0x3FFFF);
+		for (u32 ms = 0; ms < 5; ++ms)
+			ProcessVoice(pb, output.Buffers(ms), SPMS, mctrl, nullptr);
+		Hash(hash, &pb, sizeof(pb));
+	}
+	Hash(hash, output.samples.data(), output.samples.size() * sizeof(int));
+	return hash;
+}
+
+class AXVoiceTest : public testing::Test
+{
+protected:
+	virtual void SetUp() { DSP::Init(true); }
+	virtual void TearDown() { DSP::Shutdown(); }
+};
+
+}
+
+// Frames of voices at random, mixed as they were before the voice engine
+// worked a block at a time, down to the bit.
+TEST_F(AXVoiceTest, MatchesRecorded)
+{
+	static const u64 recorded[] = {
+		15528057750611580160ULL,
+		1456292452311746753ULL,
+		10161223537706040019ULL,
+		6218997175519240852ULL,
+	};
+	for (u32 seed = 0; seed < sizeof(recorded) / sizeof(recorded[0]); ++seed)
+		EXPECT_EQ(recorded[seed], PlayFrame(seed, 64)) << "seed " << seed;
+}
+
+// Voices mixed in shares on a worker pool come out the same as mixed one
+// after another, for any number of workers.
+TEST_F(AXVoiceTest, MixVoices)
+{
+	std::mt19937 rng(42);
+	u8* aram = DSP::GetARAMPtr();
+	for (u32 i = 0; i < 0x200000; ++i)
+		aram[i] = (u8)rng();
+
+	std::vector<AXPB> voices;
+	for (u32 v = 0; v < 40; ++v)
+		voices.push_back(MakeVoice(rng));
+	auto process = [](AXPB& pb, const AXBuffers& buffers) {
+		AXBuffers ms_buffers = buffers;
+		for (u32 ms = 0; ms < 5; ++ms)
+		{
+			ProcessVoice(pb, ms_buffers, SPMS, (AXMixControl)0x3FFFF, nullptr);
+			for (int*& ptr : ms_buffers.ptrs)
+				ptr += SPMS;
+		}
+	};
+
+	Output expected;
+	std::vector<AXPB> expected_pbs = voices;
+	MixVoices(nullptr, expected_pbs, expected.Buffers(0), process);
+
+	for (u32 workers = 2; workers <= 5; ++workers)
+	{
+		Common::WorkerPool pool(workers);
+		Output output;
+		std::vector<AXPB> pbs = voices;
+		MixVoices(&pool, pbs, output.Buffers(0), process);
+		EXPECT_EQ(expected.samples, output.samples) << workers << " workers";
+		EXPECT_EQ(0, memcmp(expected_pbs.data(), pbs.data(), pbs.size() * sizeof(AXPB))) << workers << " workers";
+	}
+}
+
+// Mixing adds the voice at its volume to what's there, whatever the count.
+TEST_F(AXVoiceTest, MixAdd)
+{
+	for (u32 count = 1; count <= 20; ++count)
+	{
+		s16 input[20];
+		int out[20], expected[20];
+		for (u32 i = 0; i < count; ++i)
+		{
+			input[i] = (s16)(i * 3001 - 30000);
+			out[i] = expected[i] = (int)i * 7;
+		}
+
+		u16 volume = 0x7000;
+		const u16 delta = 0x0F00;
+		for (u32 i = 0; i < count; ++i)
+		{
+			expected[i] += (s16)(((s32)input[i] * volume) >> 15);
+			volume += delta;
+		}
+
+		u16 pvol[2] = { 0x7000, delta };
+		s16 dpop = 0;
+		MixAdd(out, input, count, pvol, &dpop, true);
+		EXPECT_EQ(volume, pvol[0]);
+		EXPECT_EQ(0, memcmp(out, expected, count * sizeof(int)));
+		EXPECT_EQ((s16)(expected[count - 1] - (int)(count - 1) * 7), dpop);
+	}
+}
+
+// 64 voices looping through long samples for a second, as a busy game has
+// them. Run with --gtest_also_run_disabled_tests.
+TEST_F(AXVoiceTest, DISABLED_Benchmark)
+{
+	static const u16 formats[] = { AUDIOFORMAT_ADPCM, AUDIOFORMAT_PCM8, AUDIOFORMAT_PCM16 };
+	for (u16 format : formats)
+	{
+		std::mt19937 rng(0);
+		std::vector<AXPB> voices;
+		for (u32 v = 0; v < 64; ++v)
+		{
+			AXPB pb = MakeVoice(rng);
+			const u32 end = HILO_TO_32(pb.audio_addr.cur_addr) + 0x100000;
+			pb.audio_addr.end_addr_hi = (u16)(end >> 16);
+			pb.audio_addr.end_addr_lo = (u16)end;
+			pb.audio_addr.sample_format = format;
+			pb.src_type = SRCTYPE_LINEAR;
+			voices.push_back(pb);
+		}
+
+		Output output;
+		const AXMixControl mctrl = (AXMixControl)(MIX_L | MIX_L_RAMP | MIX_R | MIX_R_RAMP | MIX_AUXA_L | MIX_AUXA_R);
+		const auto start = std::chrono::high_resolution_clock::now();
+		for (u32 frame = 0; frame < 200; ++frame)
+		{
+			for (AXPB& pb : voices)
+			{
+				for (u32 ms = 0; ms < 5; ++ms)
+					ProcessVoice(pb, output.Buffers(ms), SPMS, mctrl, nullptr);
+			}
+		}
+		const double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		printf("64 voices of format %02x: %.1f ms for a second of audio\n", format, ms);
+	}
+}
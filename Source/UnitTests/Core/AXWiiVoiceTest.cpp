@@ -0,0 +1,145 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <random>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "Common/CommonTypes.h"
+#include "Common/ParallelFor.h"
+#include "Core/HW/DSP.h"
+
+#define AX_WII
+#include "Core/HW/DSPHLE/UCodes/UCode_AX_Voice.h"
+
+namespace
+{
+
+const u32 NUM_BUFFERS = sizeof(AXBuffers::ptrs) / sizeof(int*);
+// Past the last buffer, to catch mixing that runs off its end.
+const u32 GUARD_SIZE = 32 * 3;
+const int GUARD_VALUE = 0x5A5A5A5A;
+
+// The buffers of a frame one after another, as CUCode_AXWii has them.
+struct Output
+{
+	Output()
+	{
+		u32 size = GUARD_SIZE;
+		for (u32 i = 0; i < NUM_BUFFERS; ++i)
+			size += GetBufferSize(i);
+		samples.resize(size);
+		std::fill(samples.end() - GUARD_SIZE, samples.end(), GUARD_VALUE);
+	}
+
+	AXBuffers Buffers()
+	{
+		AXBuffers buffers;
+		int* ptr = samples.data();
+		for (u32 i = 0; i < NUM_BUFFERS; ++i)
+		{
+			buffers.ptrs[i] = ptr;
+			ptr += GetBufferSize(i);
+		}
+		return buffers;
+	}
+
+	bool GuardIntact() const
+	{
+		for (auto it = samples.end() - GUARD_SIZE; it != samples.end(); ++it)
+		{
+			if (*it != GUARD_VALUE)
+				return false;
+		}
+		return true;
+	}
+
+	std::vector<int> samples;
+};
+
+// A looping voice at random, sent to the Wii remote as well.
+AXPBWii MakeVoice(std::mt19937& rng)
+{
+	auto random = [&rng](u32 n) { return (u32)(rng() % n); };
+
+	AXPBWii pb;
+	u16* raw = (u16*)&pb;
+	for (size_t i = 0; i < sizeof(pb) / sizeof(u16); ++i)
+		raw[i] = (u16)rng();
+
+	pb.running = 1;
+	pb.is_stream = 0;
+	pb.src_type = SRCTYPE_LINEAR;
+	pb.coef_select = 0;
+	pb.lpf.enabled = 0;
+	pb.initial_time_delay.on = 0;
+	pb.audio_addr.looping = 1;
+	pb.audio_addr.sample_format = AUDIOFORMAT_PCM16;
+
+	const u32 cur = 0x1000 + random(0x80000);
+	const u32 end = cur + 0x1000;
+	pb.audio_addr.cur_addr_hi = (u16)(cur >> 16);
+	pb.audio_addr.cur_addr_lo = (u16)cur;
+	pb.audio_addr.end_addr_hi = (u16)(end >> 16);
+	pb.audio_addr.end_addr_lo = (u16)end;
+	pb.audio_addr.loop_addr_hi = (u16)(cur >> 16);
+	pb.audio_addr.loop_addr_lo = (u16)cur;
+
+	const u32 ratio = 0x8000 + random(0x10000);
+	pb.src.ratio_hi = (u16)(ratio >> 16);
+	pb.src.ratio_lo = (u16)ratio;
+
+	pb.remote = 1;
+	pb.remote_mixer_control = 0xFFFF;
+
+	return pb;
+}
+
+class AXWiiVoiceTest : public testing::Test
+{
+protected:
+	virtual void SetUp() { DSP::Init(true); }
+	virtual void TearDown() { DSP::Shutdown(); }
+};
+
+}
+
+// Old AXWii, with updates, mixes ms per ms. Mixed in shares on a worker pool,
+// its voices come out the same as mixed one after another, and neither way
+// mixes past the end of the Wii remote buffers.
+TEST_F(AXWiiVoiceTest, OldAXWiiMixVoices)
+{
+	std::mt19937 rng(7);
+	u8* aram = DSP::GetARAMPtr();
+	for (u32 i = 0; i < 0x200000; ++i)
+		aram[i] = (u8)rng();
+
+	std::vector<AXPBWii> voices;
+	for (u32 v = 0; v < 40; ++v)
+		voices.push_back(MakeVoice(rng));
+	auto process = [](AXPBWii& pb, const AXBuffers& frame_buffers) {
+		AXBuffers buffers = frame_buffers;
+		for (u32 ms = 0; ms < 3; ++ms)
+		{
+			ProcessVoice(pb, buffers, 32, (AXMixControl)0xFFFFFFFF, nullptr);
+			ForwardBuffersOneMs(buffers);
+		}
+	};
+
+	Output expected;
+	std::vector<AXPBWii> expected_pbs = voices;
+	MixVoices(nullptr, expected_pbs, expected.Buffers(), process);
+	EXPECT_TRUE(expected.GuardIntact());
+
+	for (u32 workers = 2; workers <= 5; ++workers)
+	{
+		Common::WorkerPool pool(workers);
+		Output output;
+		std::vector<AXPBWii> pbs = voices;
+		MixVoices(&pool, pbs, output.Buffers(), process);
+		EXPECT_EQ(expected.samples, output.samples) << workers << " workers";
+		EXPECT_EQ(0, memcmp(expected_pbs.data(), pbs.data(), pbs.size() * sizeof(AXPBWii))) << workers << " workers";
+	}
+}
@@ -0,0 +1,258 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Core/CoreTiming.h"
+#include "Core/HW/Memmap.h"
+#include "Core/PowerPC/CachedInterpreter.h"
+#include "Core/PowerPC/PowerPC.h"
+#include "Core/PowerPC/PPCTables.h"
+#include "Core/PowerPC/Interpreter/Interpreter.h"
+
+// After the Dolphin headers, since the x64 emitter has a TEST method.
+#include <gtest/gtest.h>
+
+namespace
+{
+
+const u32 CODE = 0x80003000;
+const u32 DATA = 0x80100000;
+const u32 MSR_FP = 0x2000;
+
+// Just enough of an assembler for the test programs.
+u32 D(u32 op, u32 d, u32 a, u32 imm) { return (op << 26) | (d << 21) | (a << 16) | (imm & 0xFFFF); }
+u32 X(u32 d, u32 a, u32 b, u32 xo) { return (31 << 26) | (d << 21) | (a << 16) | (b << 11) | (xo << 1); }
+u32 SPR(u32 spr) { return ((spr & 0x1F) << 5) | (spr >> 5); }
+u32 ADDI(u32 d, u32 a, s32 imm) { return D(14, d, a, imm); }
+u32 LI(u32 d, s32 imm) { return ADDI(d, 0, imm); }
+u32 ORI(u32 a, u32 s, u32 imm) { return D(24, s, a, imm); }
+u32 CMPWI(u32 a, s32 imm) { return D(11, 0, a, imm); }
+u32 LWZ(u32 d, s32 offset, u32 a) { return D(32, d, a, offset); }
+u32 STWU(u32 s, s32 offset, u32 a) { return D(37, s, a, offset); }
+u32 ADD(u32 d, u32 a, u32 b) { return X(d, a, b, 266); }
+u32 MULLW(u32 d, u32 a, u32 b) { return X(d, a, b, 235); }
+u32 XOR(u32 a, u32 s, u32 b) { return X(s, a, b, 316); }
+u32 RLWINM(u32 a, u32 s, u32 sh, u32 mb, u32 me) { return (21 << 26) | (s << 21) | (a << 16) | (sh << 11) | (mb << 6) | (me << 1); }
+u32 MTSPR(u32 spr, u32 s) { return X(s, 0, 0, 467) | (SPR(spr) << 11); }
+u32 FADDS(u32 d, u32 a, u32 b) { return (59 << 26) | (d << 21) | (a << 16) | (b << 11) | (21 << 1); }
+u32 B(s32 offset) { return (18 << 26) | (offset & 0x3FFFFFC); }
+u32 BL(s32 offset) { return B(offset) | 1; }
+u32 BDNZ(s32 offset) { return (16 << 26) | (16 << 21) | (offset & 0xFFFC); }
+const u32 BLR = 0x4E800020;
+
+u8 *RAMPointer(u32 address)
+{
+	return Memory::GetMainRAMPtr() + (address & Memory::RAM_MASK);
+}
+
+void Assemble(u32 address, const std::vector<u32>& code)
+{
+	for (u32 inst : code)
+	{
+		Memory::Write_U32(inst, address);
+		address += 4;
+	}
+}
+
+// A loop with loads and stores, calls and a floating point instruction.
+// Exceptions are left out: taking one updates the EXI interrupt state, which
+// would need most of the emulated hardware.
+void AssembleLoop(u32 iterations)
+{
+	Assemble(CODE, {
+		LI(3, 0),                      // 0x00
+		ORI(4, 4, iterations & 0xFFFF),
+		MTSPR(SPR_CTR, 4),
+		D(15, 5, 0, DATA >> 16),       // lis r5, DATA
+		ADDI(3, 3, 3),                 // 0x10 loop:
+		MULLW(6, 3, 3),
+		XOR(7, 6, 3),
+		STWU(7, 4, 5),
+		LWZ(8, 0, 5),                  // 0x20
+		ADD(3, 3, 8),
+		RLWINM(3, 3, 1, 0, 31),
+		CMPWI(3, 0),
+		BL(0x0C),                      // 0x30
+		BDNZ(-0x24),
+		B(0),
+		ADDI(9, 9, 1),                 // 0x3C func:
+		FADDS(1, 1, 2),                // 0x40
+		BLR,
+	});
+}
+
+void ResetCPU()
+{
+	memset(&PowerPC::ppcState.gpr, 0, sizeof(PowerPC::ppcState.gpr));
+	memset(&PowerPC::ppcState.ps, 0, sizeof(PowerPC::ppcState.ps));
+	memset(&PowerPC::ppcState.spr, 0, sizeof(PowerPC::ppcState.spr));
+	PowerPC::ppcState.cr = 0;
+	memset(PowerPC::ppcState.cr_fast, 0, sizeof(PowerPC::ppcState.cr_fast));
+	PowerPC::ppcState.Exceptions = 0;
+	rPS0(2) = 1.0;
+	MSR = MSR_FP;
+	PC = NPC = CODE;
+	Interpreter::m_EndBlock = false;
+}
+
+// Runs the interpreter's fast loop, which the cached interpreter has to match.
+void RunInterpreter(int cycles)
+{
+	CoreTiming::downcount = cycles;
+	while (CoreTiming::downcount > 0)
+	{
+		Interpreter::m_EndBlock = false;
+		int block_cycles = 0;
+		while (!Interpreter::m_EndBlock)
+			block_cycles += Interpreter::getInstance()->SingleStepInner();
+		CoreTiming::downcount -= block_cycles;
+	}
+}
+
+struct CPUState
+{
+	u32 gpr[32];
+	u64 ps[32][2];
+	u32 cr;
+	u8 cr_fast[8];
+	u32 ctr, lr;
+	u32 msr, pc;
+	int downcount;
+	std::vector<u8> data;
+
+	CPUState()
+	{
+		memcpy(gpr, PowerPC::ppcState.gpr, sizeof(gpr));
+		memcpy(ps, PowerPC::ppcState.ps, sizeof(ps));
+		cr = PowerPC::ppcState.cr;
+		memcpy(cr_fast, PowerPC::ppcState.cr_fast, sizeof(cr_fast));
+		ctr = CTR;
+		lr = LR;
+		msr = MSR;
+		pc = PC;
+		downcount = CoreTiming::downcount;
+		data.assign(RAMPointer(DATA), RAMPointer(DATA) + 0x1000);
+	}
+
+	bool operator==(const CPUState& o) const
+	{
+		return !memcmp(gpr, o.gpr, sizeof(gpr)) && !memcmp(ps, o.ps, sizeof(ps)) && cr == o.cr &&
+		       !memcmp(cr_fast, o.cr_fast, sizeof(cr_fast)) &&
+		       ctr == o.ctr && lr == o.lr && msr == o.msr &&
+		       pc == o.pc && downcount == o.downcount && data == o.data;
+	}
+};
+
+class CachedInterpreterTest : public testing::Test
+{
+protected:
+	virtual void SetUp()
+	{
+		// Plain RAM accesses only need the RAM buffer.
+		m_ram.assign(Memory::RAM_SIZE, 0);
+		Memory::m_pRAM = &m_ram[0];
+		PPCTables::InitTables(0);
+
+		jit = &m_core;
+		m_core.Init();
+		ResetCPU();
+	}
+
+	virtual void TearDown()
+	{
+		m_core.Shutdown();
+		jit = nullptr;
+		Memory::m_pRAM = nullptr;
+	}
+
+	void RunCached(int cycles)
+	{
+		CoreTiming::downcount = cycles;
+		m_core.RunSlice();
+	}
+
+	std::vector<u8> m_ram;
+	CachedInterpreter m_core;
+};
+
+}
+
+TEST_F(CachedInterpreterTest, MatchesInterpreter)
+{
+	AssembleLoop(100);
+
+	// Stop in the middle of the loop as well as well after it has finished.
+	const int budgets[] = { 1, 57, 1000, 100000 };
+	for (int cycles : budgets)
+	{
+		memset(RAMPointer(DATA), 0, 0x1000);
+		ResetCPU();
+		RunInterpreter(cycles);
+		CPUState expected;
+
+		memset(RAMPointer(DATA), 0, 0x1000);
+		ResetCPU();
+		RunCached(cycles);
+		CPUState actual;
+
+		EXPECT_TRUE(expected == actual) << cycles << " cycles";
+	}
+
+	// The loop ran to the end.
+	EXPECT_EQ(CODE + 0x38, PC);
+	EXPECT_EQ(100u, PowerPC::ppcState.gpr[9]);
+	EXPECT_EQ(100.0, rPS0(1));
+}
+
+TEST_F(CachedInterpreterTest, InvalidatesChangedCode)
+{
+	Assemble(CODE, { LI(3, 1), B(0) });
+	RunCached(10);
+	EXPECT_EQ(1u, PowerPC::ppcState.gpr[3]);
+
+	// Without invalidation the old block keeps running.
+	Memory::Write_U32(LI(3, 2), CODE);
+	PC = CODE;
+	RunCached(10);
+	EXPECT_EQ(1u, PowerPC::ppcState.gpr[3]);
+
+	m_core.GetBlockCache()->InvalidateICache(CODE, 4);
+	PC = CODE;
+	RunCached(10);
+	EXPECT_EQ(2u, PowerPC::ppcState.gpr[3]);
+}
+
+// Speed of both cores on the loop above.
+// Run with --gtest_also_run_disabled_tests.
+TEST_F(CachedInterpreterTest, DISABLED_Benchmark)
+{
+	// Stays inside the loop.
+	const int cycles = 500000;
+	const int repeats = 100;
+	AssembleLoop(0xFFFF);
+
+	long long us[2];
+	for (int pass = 0; pass < 2; ++pass)
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < repeats; ++i)
+		{
+			ResetCPU();
+			if (pass)
+				RunCached(cycles);
+			else
+				RunInterpreter(cycles);
+		}
+		auto end = std::chrono::high_resolution_clock::now();
+		us[pass] = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+	}
+
+	printf("interpreter %lld us, cached interpreter %lld us (%.2fx)\n",
+	       us[0], us[1], (double)us[0] / us[1]);
+}
@@ -0,0 +1,165 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <cstdio>
+#include <utility>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "Common/CommonTypes.h"
+#include "Core/CoreTiming.h"
+
+namespace
+{
+
+// (type index, userdata) of every callback, in the order they ran.
+std::vector<std::pair<int, u64>> s_fired;
+
+template <int N>
+void RecordCallback(u64 userdata, int cyclesLate)
+{
+	s_fired.push_back(std::make_pair(N, userdata));
+}
+
+void AdvanceBy(int cycles)
+{
+	CoreTiming::downcount -= cycles;
+	CoreTiming::Advance();
+}
+
+class CoreTimingTest : public testing::Test
+{
+protected:
+	void SetUp() override
+	{
+		s_fired.clear();
+		CoreTiming::Init();
+		m_types[0] = CoreTiming::RegisterEvent("test_a", RecordCallback<0>);
+		m_types[1] = CoreTiming::RegisterEvent("test_b", RecordCallback<1>);
+		m_types[2] = CoreTiming::RegisterEvent("test_c", RecordCallback<2>);
+		// Start the first slice from a known state.
+		CoreTiming::slicelength = CoreTiming::downcount = 0;
+	}
+
+	void TearDown() override
+	{
+		CoreTiming::Shutdown();
+	}
+
+	int m_types[3];
+};
+
+}
+
+TEST_F(CoreTimingTest, Ordering)
+{
+	CoreTiming::ScheduleEvent(300, m_types[0], 3);
+	CoreTiming::ScheduleEvent(100, m_types[1], 1);
+	CoreTiming::ScheduleEvent(200, m_types[2], 2);
+	// Events due at the same time run in the order they were scheduled.
+	CoreTiming::ScheduleEvent(200, m_types[0], 4);
+	CoreTiming::ScheduleEvent(200, m_types[1], 5);
+
+	AdvanceBy(0);
+	EXPECT_TRUE(s_fired.empty());
+	EXPECT_EQ(100, CoreTiming::downcount);
+
+	AdvanceBy(100);
+	ASSERT_EQ(1u, s_fired.size());
+	EXPECT_EQ(std::make_pair(1, (u64)1), s_fired[0]);
+
+	AdvanceBy(CoreTiming::downcount);
+	ASSERT_EQ(4u, s_fired.size());
+	EXPECT_EQ(std::make_pair(2, (u64)2), s_fired[1]);
+	EXPECT_EQ(std::make_pair(0, (u64)4), s_fired[2]);
+	EXPECT_EQ(std::make_pair(1, (u64)5), s_fired[3]);
+
+	AdvanceBy(CoreTiming::downcount);
+	ASSERT_EQ(5u, s_fired.size());
+	EXPECT_EQ(std::make_pair(0, (u64)3), s_fired[4]);
+}
+
+TEST_F(CoreTimingTest, RemoveEvent)
+{
+	for (int i = 0; i < 50; ++i)
+	{
+		CoreTiming::ScheduleEvent(1000 - i * 10, m_types[i % 3], i);
+		CoreTiming::ScheduleEvent_Threadsafe(i * 10 + 5, m_types[i % 3], i + 100);
+	}
+	EXPECT_TRUE(CoreTiming::IsScheduled(m_types[1]));
+
+	CoreTiming::RemoveAllEvents(m_types[1]);
+	EXPECT_FALSE(CoreTiming::IsScheduled(m_types[1]));
+	EXPECT_TRUE(CoreTiming::IsScheduled(m_types[0]));
+	EXPECT_TRUE(CoreTiming::IsScheduled(m_types[2]));
+
+	AdvanceBy(0);
+	while (CoreTiming::IsScheduled(m_types[0]) || CoreTiming::IsScheduled(m_types[2]))
+		AdvanceBy(CoreTiming::downcount);
+
+	// The remaining events still ran in time order.
+	ASSERT_EQ(66u, s_fired.size());
+	u64 last_time = 0;
+	for (const auto& fired : s_fired)
+	{
+		EXPECT_NE(1, fired.first);
+		u64 time = fired.second >= 100 ? (fired.second - 100) * 10 + 5 : 1000 - fired.second * 10;
+		EXPECT_LE(last_time, time);
+		last_time = time;
+	}
+}
+
+TEST_F(CoreTimingTest, DoState)
+{
+	for (int i = 0; i < 20; ++i)
+		CoreTiming::ScheduleEvent((i * 7919) % 1000, m_types[i % 3], i);
+
+	u8* ptr = nullptr;
+	PointerWrap p_measure(&ptr, PointerWrap::MODE_MEASURE);
+	CoreTiming::DoState(p_measure);
+	std::vector<u8> buffer((size_t)ptr);
+
+	ptr = &buffer[0];
+	PointerWrap p_write(&ptr, PointerWrap::MODE_WRITE);
+	CoreTiming::DoState(p_write);
+	const std::string before = CoreTiming::GetScheduledEventsSummary();
+
+	CoreTiming::ClearPendingEvents();
+	CoreTiming::ScheduleEvent(5, m_types[0], 1234);
+
+	ptr = &buffer[0];
+	PointerWrap p_read(&ptr, PointerWrap::MODE_READ);
+	CoreTiming::DoState(p_read);
+	EXPECT_EQ(PointerWrap::MODE_READ, p_read.GetMode());
+	EXPECT_EQ(before, CoreTiming::GetScheduledEventsSummary());
+}
+
+// Micro-benchmark of Advance() with a few dozen periodic events pending, as
+// during normal emulation. Run with --gtest_also_run_disabled_tests.
+TEST_F(CoreTimingTest, DISABLED_Benchmark)
+{
+	static const int NUM_EVENTS = 48;
+	static const int NUM_ADVANCES = 2000000;
+
+	static int s_periodic_type;
+	s_periodic_type = CoreTiming::RegisterEvent("periodic", [](u64 userdata, int cyclesLate) {
+		CoreTiming::ScheduleEvent((int)userdata - cyclesLate, s_periodic_type, userdata);
+	});
+	for (int i = 0; i < NUM_EVENTS; ++i)
+		CoreTiming::ScheduleEvent(i * 37, s_periodic_type, 500 + i * 131);
+
+	AdvanceBy(0);
+	auto t0 = std::chrono::high_resolution_clock::now();
+	for (int i = 0; i < NUM_ADVANCES; ++i)
+		AdvanceBy(CoreTiming::downcount);
+	auto t1 = std::chrono::high_resolution_clock::now();
+
+	using std::chrono::duration_cast;
+	using std::chrono::nanoseconds;
+	printf("%d events: %.1f ns per Advance\n", NUM_EVENTS,
+	       (double)duration_cast<nanoseconds>(t1 - t0).count() / NUM_ADVANCES);
+
+	CoreTiming::ClearPendingEvents();
+}
@@ -0,0 +1,281 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <random>
+#include <utility>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "Common/CommonTypes.h"
+#include "Core/PowerPC/JitCommon/JitBlockIndex.h"
+
+namespace
+{
+
+// The std::map/std::multimap bookkeeping JitBaseBlockCache used before the
+// flat indices, kept here as a reference and as the benchmark baseline.
+class TreeBlockIndex
+{
+public:
+	void Insert(u32 start, u32 end, int block_num)
+	{
+		block_map[std::make_pair(end, start)] = block_num;
+	}
+
+	void Extract(u32 start, u32 length, std::vector<int>* out)
+	{
+		auto it1 = block_map.lower_bound(std::make_pair(start, 0u)), it2 = it1;
+		while (it2 != block_map.end() && it2->first.second < start + length)
+		{
+			out->push_back(it2->second);
+			++it2;
+		}
+		block_map.erase(it1, it2);
+	}
+
+	void InsertLink(u32 exit_address, int source_block)
+	{
+		links_to.insert(std::make_pair(exit_address, source_block));
+	}
+
+	template <typename Func>
+	void ForEachSource(u32 exit_address, Func func) const
+	{
+		auto range = links_to.equal_range(exit_address);
+		for (auto it = range.first; it != range.second; ++it)
+			func(it->second);
+	}
+
+	void EraseLinks(u32 exit_address)
+	{
+		links_to.erase(exit_address);
+	}
+
+private:
+	std::map<std::pair<u32, u32>, int> block_map;
+	std::multimap<u32, int> links_to;
+};
+
+// Both flat indices behind the same interface as TreeBlockIndex.
+struct FlatBlockIndex
+{
+	JitBlockRangeIndex ranges;
+	JitBlockLinkIndex links;
+
+	void Insert(u32 start, u32 end, int block_num) { ranges.Insert(start, end, block_num); }
+	void Extract(u32 start, u32 length, std::vector<int>* out) { ranges.Extract(start, length, out); }
+	void InsertLink(u32 exit_address, int source_block) { links.Insert(exit_address, source_block); }
+	void EraseLinks(u32 exit_address) { links.Erase(exit_address); }
+
+	template <typename Func>
+	void ForEachSource(u32 exit_address, Func func) const
+	{
+		links.ForEachSource(exit_address, func);
+	}
+};
+
+enum TraceOpType
+{
+	OP_COMPILE,
+	OP_INVALIDATE,
+};
+
+struct TraceOp
+{
+	TraceOpType type;
+	u32 address;
+	u32 size; // block size in bytes, or invalidated length
+	u32 exits[2];
+};
+
+// Blocks are laid out on 0x100 byte slots so no two live blocks overlap,
+// which the tree index requires to give exact answers.
+std::vector<TraceOp> GenerateTrace(size_t count, u32 seed)
+{
+	std::mt19937 rng(seed);
+	std::uniform_int_distribution<u32> slot(0, 0x8000 - 1);
+	std::uniform_int_distribution<u32> length(1, 0x40);
+	std::uniform_int_distribution<u32> percent(0, 99);
+
+	std::vector<TraceOp> trace;
+	for (size_t i = 0; i < count; ++i)
+	{
+		TraceOp op;
+		op.address = 0x80000000 | (slot(rng) * 0x100);
+		if (percent(rng) < 70)
+		{
+			op.type = OP_COMPILE;
+			op.size = length(rng) * 4;
+			op.exits[0] = 0x80000000 | (slot(rng) * 0x100);
+			op.exits[1] = op.address + op.size;
+		}
+		else
+		{
+			op.type = OP_INVALIDATE;
+			op.size = percent(rng) < 90 ? 32 : 0x1000;
+			op.address &= ~0x1f;
+		}
+		trace.push_back(op);
+	}
+	return trace;
+}
+
+// Replays the trace the way JitBaseBlockCache drives its indices and returns
+// every block reported by an invalidation, in a canonical order.
+template <typename Index>
+std::vector<std::vector<int>> Replay(Index& index, const std::vector<TraceOp>& trace)
+{
+	std::vector<std::vector<int>> results;
+	std::vector<int> out;
+	int next_block = 0;
+	int link_visits = 0;
+	for (const TraceOp& op : trace)
+	{
+		u32 paddr = op.address & 0x1FFFFFFF;
+		if (op.type == OP_COMPILE)
+		{
+			int block_num = next_block++;
+			index.Insert(paddr, paddr + op.size - 1, block_num);
+			index.InsertLink(op.exits[0], block_num);
+			index.InsertLink(op.exits[1], block_num);
+			index.ForEachSource(op.address, [&](int) { link_visits++; });
+		}
+		else
+		{
+			out.clear();
+			index.Extract(paddr, op.size, &out);
+			std::sort(out.begin(), out.end());
+			results.push_back(out);
+			index.EraseLinks(op.address);
+		}
+	}
+	results.push_back(std::vector<int>(1, link_visits));
+	return results;
+}
+
+}
+
+TEST(JitBlockIndex, ExtractOverlapping)
+{
+	JitBlockRangeIndex index;
+	index.Init();
+
+	// A block straddling a page boundary must be reported once.
+	index.Insert(0x0FF0, 0x100F, 1);
+	index.Insert(0x2000, 0x201F, 2);
+	index.Insert(0x2010, 0x201F, 3);
+
+	std::vector<int> out;
+	index.Extract(0x0FE0, 0x40, &out);
+	EXPECT_EQ(std::vector<int>(1, 1), out);
+
+	out.clear();
+	index.Extract(0x1000, 0x20, &out);
+	EXPECT_TRUE(out.empty());
+
+	out.clear();
+	index.Extract(0x2018, 4, &out);
+	std::sort(out.begin(), out.end());
+	ASSERT_EQ(2u, out.size());
+	EXPECT_EQ(2, out[0]);
+	EXPECT_EQ(3, out[1]);
+	EXPECT_TRUE(index.IsEmpty());
+
+	index.Shutdown();
+}
+
+TEST(JitBlockIndex, ReinsertReplaces)
+{
+	JitBlockRangeIndex index;
+	index.Init();
+
+	index.Insert(0x100, 0x11F, 1);
+	index.Insert(0x100, 0x11F, 2);
+
+	std::vector<int> out;
+	index.Extract(0x100, 0x20, &out);
+	EXPECT_EQ(std::vector<int>(1, 2), out);
+
+	index.Insert(0x100, 0x11F, 3);
+	index.Clear();
+	out.clear();
+	index.Extract(0, 0x1000, &out);
+	EXPECT_TRUE(out.empty());
+
+	index.Shutdown();
+}
+
+TEST(JitBlockIndex, Links)
+{
+	JitBlockLinkIndex links;
+	links.Init();
+
+	links.Insert(0x80003000, 1);
+	links.Insert(0x80003000, 2);
+	links.Insert(0x80003004, 3);
+
+	std::vector<int> sources;
+	links.ForEachSource(0x80003000, [&](int block) { sources.push_back(block); });
+	std::sort(sources.begin(), sources.end());
+	ASSERT_EQ(2u, sources.size());
+	EXPECT_EQ(1, sources[0]);
+	EXPECT_EQ(2, sources[1]);
+
+	links.Erase(0x80003000);
+	sources.clear();
+	links.ForEachSource(0x80003000, [&](int block) { sources.push_back(block); });
+	links.ForEachSource(0x80003004, [&](int block) { sources.push_back(block); });
+	EXPECT_EQ(std::vector<int>(1, 3), sources);
+
+	links.Shutdown();
+}
+
+// Flat indices and the old tree bookkeeping must agree on a random trace.
+TEST(JitBlockIndex, MatchesTreeIndex)
+{
+	std::vector<TraceOp> trace = GenerateTrace(50000, 1234);
+
+	FlatBlockIndex flat;
+	flat.ranges.Init();
+	flat.links.Init();
+	TreeBlockIndex tree;
+
+	auto flat_results = Replay(flat, trace);
+	auto tree_results = Replay(tree, trace);
+	EXPECT_EQ(tree_results, flat_results);
+
+	flat.ranges.Shutdown();
+	flat.links.Shutdown();
+}
+
+// Micro-benchmark replaying an icbi/link trace through both implementations.
+// Run with --gtest_also_run_disabled_tests.
+TEST(JitBlockIndex, DISABLED_Benchmark)
+{
+	std::vector<TraceOp> trace = GenerateTrace(2000000, 42);
+
+	FlatBlockIndex flat;
+	flat.ranges.Init();
+	flat.links.Init();
+	TreeBlockIndex tree;
+
+	auto t0 = std::chrono::high_resolution_clock::now();
+	Replay(flat, trace);
+	auto t1 = std::chrono::high_resolution_clock::now();
+	Replay(tree, trace);
+	auto t2 = std::chrono::high_resolution_clock::now();
+
+	using std::chrono::duration_cast;
+	using std::chrono::microseconds;
+	printf("%u ops: flat %lld us, tree %lld us\n", (u32)trace.size(),
+	       (long long)duration_cast<microseconds>(t1 - t0).count(),
+	       (long long)duration_cast<microseconds>(t2 - t1).count());
+
+	flat.ranges.Shutdown();
+	flat.links.Shutdown();
+}
@@ -0,0 +1,139 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "Common/CommonTypes.h"
+#include "Common/FileUtil.h"
+#include "Core/PowerPC/JitCommon/JitBlockProfile.h"
+
+namespace
+{
+
+// The on disk format, as documented in JitBlockProfile.cpp.
+struct FileHeader
+{
+	u32 magic;
+	u32 version;
+	u32 entry_size;
+	u32 num_entries;
+};
+
+struct FileEntry
+{
+	u32 address;
+	u32 num_instructions;
+	u64 code_hash;
+	u32 compile_count;
+	u32 reserved;
+};
+
+std::vector<u8> ReadFile(const std::string& filename)
+{
+	std::vector<u8> data((size_t)File::GetSize(filename));
+	File::IOFile file(filename, "rb");
+	file.ReadBytes(data.data(), data.size());
+	return data;
+}
+
+void WriteProfile(const std::string& filename, FileHeader header, const std::vector<FileEntry>& entries)
+{
+	File::IOFile file(filename, "wb");
+	file.WriteArray(&header, 1);
+	file.WriteArray(entries.data(), entries.size());
+}
+
+// Hottest first, then by address: the order Save writes them in.
+std::vector<FileEntry> SortedEntries()
+{
+	std::vector<FileEntry> entries;
+	const FileEntry e[] = {
+		{ 0x80004000, 12, 0x0123456789ABCDEFULL, 9, 0 },
+		{ 0x80003000, 1, 0xFFFFFFFF00000001ULL, 3, 0 },
+		{ 0x80005000, 40, 0x1ULL, 3, 0 },
+		{ 0x81200000, 7, 0x8000000000000000ULL, 1, 0 },
+	};
+	entries.assign(e, e + sizeof(e) / sizeof(e[0]));
+	return entries;
+}
+
+const FileHeader GOOD_HEADER = { 0x4650424A, 1, sizeof(FileEntry), 4 };
+
+class JitBlockProfileTest : public testing::Test
+{
+protected:
+	JitBlockProfileTest()
+		: m_in("JitBlockProfileTest.in"), m_out("JitBlockProfileTest.out")
+	{
+	}
+
+	virtual void SetUp()
+	{
+		TearDown();
+	}
+
+	virtual void TearDown()
+	{
+		File::Delete(m_in);
+		File::Delete(m_out);
+	}
+
+	std::string m_in;
+	std::string m_out;
+};
+
+}
+
+// Loading and saving a profile gives back the same bytes, so nothing
+// uninitialized makes it to disk.
+TEST_F(JitBlockProfileTest, LoadSaveRoundTrip)
+{
+	WriteProfile(m_in, GOOD_HEADER, SortedEntries());
+
+	JitBlockProfile profile;
+	ASSERT_TRUE(profile.Load(m_in));
+	EXPECT_TRUE(profile.HasPendingBlocks());
+	ASSERT_TRUE(profile.Save(m_out));
+	EXPECT_TRUE(ReadFile(m_out) == ReadFile(m_in));
+
+	JitBlockProfile reloaded;
+	ASSERT_TRUE(reloaded.Load(m_out));
+	ASSERT_TRUE(reloaded.Save(m_in));
+	EXPECT_TRUE(ReadFile(m_in) == ReadFile(m_out));
+}
+
+TEST_F(JitBlockProfileTest, EmptyRoundTrip)
+{
+	JitBlockProfile profile;
+	ASSERT_TRUE(profile.Save(m_out));
+	EXPECT_EQ(sizeof(FileHeader), File::GetSize(m_out));
+
+	ASSERT_TRUE(profile.Load(m_out));
+	EXPECT_FALSE(profile.HasPendingBlocks());
+}
+
+TEST_F(JitBlockProfileTest, RejectsOtherFormats)
+{
+	JitBlockProfile profile;
+	EXPECT_FALSE(profile.Load(m_in));
+
+	FileHeader header = GOOD_HEADER;
+	header.version = 2;
+	WriteProfile(m_in, header, SortedEntries());
+	EXPECT_FALSE(profile.Load(m_in));
+
+	header = GOOD_HEADER;
+	header.entry_size = 20;
+	WriteProfile(m_in, header, SortedEntries());
+	EXPECT_FALSE(profile.Load(m_in));
+	EXPECT_FALSE(profile.HasPendingBlocks());
+
+	// Fewer entries than the header says.
+	std::vector<FileEntry> entries = SortedEntries();
+	entries.pop_back();
+	WriteProfile(m_in, GOOD_HEADER, entries);
+	EXPECT_FALSE(profile.Load(m_in));
+}
@@ -0,0 +1,36 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <string>
+
+// The emitter has a TEST of its own.
+#define GTEST_DONT_DEFINE_TEST 1
+#include <gtest/gtest.h>
+
+#include "Common/CommonTypes.h"
+#include "Core/PowerPC/Jit64/Jit.h"
+
+GTEST_TEST(JitTieringStatsTest, Summary)
+{
+	Jit64::TieringStats stats;
+	stats.blocks_interpreted = 5000000000ULL;
+	stats.cold_blocks = 1500;
+	stats.blocks_compiled = 1000;
+	stats.compile_time_us = 250000;
+
+	EXPECT_EQ("Tiering (threshold 2): 1000 blocks compiled in 250 ms, "
+	          "5000000000 interpreted runs, ~500 compiles skipped (~125 ms saved), "
+	          "code cache 1000 blocks / 32767 KiB used",
+	          stats.Summary(2, 1000, 32 * 1024 * 1024 - 1024));
+}
+
+GTEST_TEST(JitTieringStatsTest, SummaryWithNothingCompiled)
+{
+	Jit64::TieringStats stats = {};
+
+	EXPECT_EQ("Tiering (threshold 100): 0 blocks compiled in 0 ms, "
+	          "0 interpreted runs, ~0 compiles skipped (~0 ms saved), "
+	          "code cache 0 blocks / 0 KiB used",
+	          stats.Summary(100, 0, 0));
+}
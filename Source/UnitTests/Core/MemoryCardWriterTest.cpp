@@ -0,0 +1,284 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "Common/CommonTypes.h"
+#include "Common/FileUtil.h"
+#include "Core/HW/MemoryCardWriter.h"
+
+namespace
+{
+
+const u32 CARD_SIZE = 0x40000;
+const u32 NUM_BLOCKS = CARD_SIZE / MemoryCardWriter::BLOCK_SIZE;
+
+std::vector<u8> ReadCard(const std::string& filename)
+{
+	std::vector<u8> data((size_t)File::GetSize(filename));
+	File::IOFile file(filename, "rb");
+	file.ReadBytes(data.data(), data.size());
+	return data;
+}
+
+void WriteCard(const std::string& filename, const std::vector<u8>& data)
+{
+	File::IOFile file(filename, "wb");
+	file.WriteBytes(data.data(), data.size());
+}
+
+std::vector<u8> RandomCard(std::mt19937& rng)
+{
+	std::vector<u8> data(CARD_SIZE);
+	for (u8& b : data)
+		b = (u8)rng();
+	return data;
+}
+
+class MemoryCardWriterTest : public testing::Test
+{
+protected:
+	MemoryCardWriterTest()
+		: m_filename("MemoryCardWriterTest.raw")
+	{
+	}
+
+	virtual void SetUp()
+	{
+		TearDown();
+	}
+
+	virtual void TearDown()
+	{
+		File::Delete(m_filename);
+		File::Delete(MemoryCardWriter::GetJournalPath(m_filename));
+		File::Delete(MemoryCardWriter::GetJournalPath(m_filename) + ".tmp");
+		File::DeleteDir(MemoryCardWriter::GetJournalPath(m_filename) + ".tmp");
+	}
+
+	std::string m_filename;
+};
+
+}
+
+// Only the blocks marked dirty are written, and nothing is left behind.
+TEST_F(MemoryCardWriterTest, WritesDirtyBlocks)
+{
+	std::mt19937 rng(0);
+	std::vector<u8> content = RandomCard(rng);
+	const std::vector<u8> on_disk = RandomCard(rng);
+	WriteCard(m_filename, on_disk);
+
+	MemoryCardWriter writer(m_filename, CARD_SIZE);
+	std::vector<u8> expected = on_disk;
+	for (u32 offset : { 0x0u, 0x2100u, 0x9ff0u, CARD_SIZE - 0x200 })
+	{
+		const u32 length = offset == 0x9ff0 ? 0x20 : 0x200;
+		for (u32 i = offset; i < offset + length; ++i)
+			content[i] ^= 0x5A;
+		writer.MarkDirty(offset, length);
+
+		// Whole blocks of the content make it to the file.
+		const u32 first = offset / MemoryCardWriter::BLOCK_SIZE * MemoryCardWriter::BLOCK_SIZE;
+		const u32 end = (offset + length + MemoryCardWriter::BLOCK_SIZE - 1) / MemoryCardWriter::BLOCK_SIZE * MemoryCardWriter::BLOCK_SIZE;
+		std::copy(content.begin() + first, content.begin() + end, expected.begin() + first);
+	}
+	EXPECT_TRUE(writer.IsDirty());
+
+	writer.Flush(content.data());
+	EXPECT_FALSE(writer.IsDirty());
+	writer.Wait();
+
+	EXPECT_TRUE(expected == ReadCard(m_filename));
+	EXPECT_FALSE(File::Exists(MemoryCardWriter::GetJournalPath(m_filename)));
+}
+
+// Flushes queued faster than they're written are all written in the end.
+TEST_F(MemoryCardWriterTest, QueuedFlushes)
+{
+	std::mt19937 rng(1);
+	std::vector<u8> content = RandomCard(rng);
+
+	MemoryCardWriter writer(m_filename, CARD_SIZE);
+	writer.MarkAllDirty();
+	writer.Flush(content.data());
+
+	for (int i = 0; i < 200; ++i)
+	{
+		const u32 offset = rng() % CARD_SIZE & ~0x1FF;
+		for (u32 j = offset; j < offset + 0x200; ++j)
+			content[j] = (u8)rng();
+		writer.MarkDirty(offset, 0x200);
+		writer.Flush(content.data());
+	}
+	writer.Wait();
+
+	EXPECT_TRUE(content == ReadCard(m_filename));
+}
+
+// A card that isn't there is only made from a flush of all of it, which
+// the next flush is once it's found missing.
+TEST_F(MemoryCardWriterTest, RewritesMissingCard)
+{
+	std::mt19937 rng(2);
+	std::vector<u8> content = RandomCard(rng);
+
+	MemoryCardWriter writer(m_filename, CARD_SIZE);
+	writer.MarkDirty(0x4000, 1);
+	writer.Flush(content.data());
+	writer.Wait();
+	EXPECT_FALSE(File::Exists(m_filename));
+
+	writer.Flush(content.data());
+	writer.Wait();
+	EXPECT_TRUE(content == ReadCard(m_filename));
+}
+
+// A flush whose journal can't be written leaves the writer dirty, and the
+// next flush writes the blocks it lost along with its own.
+TEST_F(MemoryCardWriterTest, RetriesFailedJournal)
+{
+	std::mt19937 rng(4);
+	std::vector<u8> content = RandomCard(rng);
+	WriteCard(m_filename, RandomCard(rng));
+	const std::string temp_journal = MemoryCardWriter::GetJournalPath(m_filename) + ".tmp";
+
+	MemoryCardWriter writer(m_filename, CARD_SIZE);
+	writer.MarkAllDirty();
+	writer.Flush(content.data());
+	writer.Wait();
+
+	// The journal is written under this name first, which a directory
+	// won't let it.
+	ASSERT_TRUE(File::CreateDir(temp_journal));
+	for (u32 i = 0x6000; i < 0x6200; ++i)
+		content[i] ^= 0xA5;
+	writer.MarkDirty(0x6000, 0x200);
+	writer.Flush(content.data());
+	writer.Wait();
+	EXPECT_TRUE(writer.IsDirty());
+	EXPECT_FALSE(content == ReadCard(m_filename));
+	ASSERT_TRUE(File::DeleteDir(temp_journal));
+
+	for (u32 i = 0x20000; i < 0x20200; ++i)
+		content[i] ^= 0xA5;
+	writer.MarkDirty(0x20000, 0x200);
+	writer.Flush(content.data());
+	writer.Wait();
+	EXPECT_FALSE(writer.IsDirty());
+	EXPECT_TRUE(content == ReadCard(m_filename));
+	EXPECT_FALSE(File::Exists(MemoryCardWriter::GetJournalPath(m_filename)));
+}
+
+// The journal of a flush whose card write failed is finished before the
+// next flush writes a journal of its own.
+TEST_F(MemoryCardWriterTest, FinishesJournalLeftBehind)
+{
+	std::mt19937 rng(5);
+	const std::vector<u8> on_disk = RandomCard(rng);
+	std::vector<u8> content = RandomCard(rng);
+	WriteCard(m_filename, on_disk);
+
+	// As a flush that wrote its journal and then failed to write the card
+	// leaves things.
+	MemoryCardWriter::Blocks blocks;
+	for (u32 block : { 3u, 4u })
+	{
+		const u32 offset = block * MemoryCardWriter::BLOCK_SIZE;
+		blocks[block].assign(content.begin() + offset, content.begin() + offset + MemoryCardWriter::BLOCK_SIZE);
+	}
+	ASSERT_TRUE(MemoryCardWriter::WriteJournal(m_filename, CARD_SIZE, blocks));
+
+	std::vector<u8> expected = on_disk;
+	std::copy(content.begin() + 3 * MemoryCardWriter::BLOCK_SIZE, content.begin() + 5 * MemoryCardWriter::BLOCK_SIZE,
+	          expected.begin() + 3 * MemoryCardWriter::BLOCK_SIZE);
+	std::copy(content.begin() + 9 * MemoryCardWriter::BLOCK_SIZE, content.begin() + 10 * MemoryCardWriter::BLOCK_SIZE,
+	          expected.begin() + 9 * MemoryCardWriter::BLOCK_SIZE);
+
+	MemoryCardWriter writer(m_filename, CARD_SIZE);
+	writer.MarkDirty(9 * MemoryCardWriter::BLOCK_SIZE, 1);
+	writer.Flush(content.data());
+	writer.Wait();
+
+	EXPECT_TRUE(expected == ReadCard(m_filename));
+	EXPECT_FALSE(File::Exists(MemoryCardWriter::GetJournalPath(m_filename)));
+}
+
+// A complete journal is written to the card, an incomplete one dropped.
+TEST_F(MemoryCardWriterTest, Recover)
+{
+	std::mt19937 rng(3);
+	const std::vector<u8> on_disk = RandomCard(rng);
+	const std::vector<u8> content = RandomCard(rng);
+	const std::string journal = MemoryCardWriter::GetJournalPath(m_filename);
+
+	MemoryCardWriter::Blocks blocks;
+	std::vector<u8> expected = on_disk;
+	for (u32 block : { 1u, 2u, 7u, NUM_BLOCKS - 1 })
+	{
+		const u32 offset = block * MemoryCardWriter::BLOCK_SIZE;
+		blocks[block].assign(content.begin() + offset, content.begin() + offset + MemoryCardWriter::BLOCK_SIZE);
+		std::copy(content.begin() + offset, content.begin() + offset + MemoryCardWriter::BLOCK_SIZE, expected.begin() + offset);
+	}
+
+	WriteCard(m_filename, on_disk);
+	EXPECT_FALSE(MemoryCardWriter::Recover(m_filename));
+
+	ASSERT_TRUE(MemoryCardWriter::WriteJournal(m_filename, CARD_SIZE, blocks));
+	EXPECT_TRUE(MemoryCardWriter::Recover(m_filename));
+	EXPECT_TRUE(expected == ReadCard(m_filename));
+	EXPECT_FALSE(File::Exists(journal));
+
+	// Cut short, or with a bit flipped.
+	for (int damage = 0; damage < 2; ++damage)
+	{
+		WriteCard(m_filename, on_disk);
+		ASSERT_TRUE(MemoryCardWriter::WriteJournal(m_filename, CARD_SIZE, blocks));
+		std::vector<u8> data = ReadCard(journal);
+		if (damage)
+			data[100] ^= 1;
+		else
+			data.resize(data.size() - 1);
+		WriteCard(journal, data);
+
+		EXPECT_FALSE(MemoryCardWriter::Recover(m_filename));
+		EXPECT_TRUE(on_disk == ReadCard(m_filename));
+		EXPECT_FALSE(File::Exists(journal));
+	}
+}
+
+// Time to flush a few pages of a full size card, as a save does, rewriting
+// the whole card and only the dirty blocks. Run with
+// --gtest_also_run_disabled_tests.
+TEST_F(MemoryCardWriterTest, DISABLED_Benchmark)
+{
+	const u32 size = 0x1000000;
+	std::vector<u8> content(size, 0xFF);
+	WriteCard(m_filename, content);
+
+	long long us[2];
+	for (int dirty = 0; dirty < 2; ++dirty)
+	{
+		MemoryCardWriter writer(m_filename, size);
+		auto start = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < 20; ++i)
+		{
+			if (dirty)
+				writer.MarkDirty(0xA000 + i * 0x2000, 0x4000);
+			else
+				writer.MarkAllDirty();
+			writer.Flush(content.data());
+			writer.Wait();
+		}
+		auto end = std::chrono::high_resolution_clock::now();
+		us[dirty] = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+	}
+
+	printf("whole card %lld us, dirty blocks %lld us (%.2fx)\n", us[0], us[1], (double)us[0] / us[1]);
+}
@@ -0,0 +1,287 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cstdio>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "Common/CommonTypes.h"
+#include "Core/NetPlayInputChannel.h"
+
+namespace
+{
+
+typedef NetPlayInputChannel::Entry Entry;
+
+const u32 GAME = 1234;
+
+// Entry number n of a stream, as big as a wiimote report for the wiimotes.
+Entry MakeEntry(u8 stream, u32 n)
+{
+	Entry entry(stream < NetPlayInputChannel::FIRST_WIIMOTE_STREAM ? 8 : 21);
+	for (size_t i = 0; i < entry.size(); ++i)
+		entry[i] = (u8)(n >> (i % 4 * 8)) ^ stream;
+	return entry;
+}
+
+// One way of a link between two channels, in milliseconds of a made up
+// clock, losing and delaying datagrams at random. Enough delay reorders them.
+class Link
+{
+public:
+	Link(std::mt19937& rng, double loss, u32 latency_ms, u32 jitter_ms)
+		: m_rng(rng), m_loss(loss), m_latency_ms(latency_ms), m_jitter_ms(jitter_ms)
+	{
+	}
+
+	void Send(NetPlayInputChannel& from, u32 now_ms)
+	{
+		sf::Packet packet;
+		from.BuildDatagram(packet, now_ms);
+		if (std::uniform_real_distribution<double>()(m_rng) < m_loss)
+			return;
+
+		const u32 arrival = now_ms + m_latency_ms + m_rng() % (m_jitter_ms + 1);
+		m_in_flight.insert(std::make_pair(arrival, std::string(packet.GetData(), packet.GetDataSize())));
+	}
+
+	// Hands to channel what arrived by now_ms.
+	void Deliver(NetPlayInputChannel& to, u32 now_ms, const NetPlayInputChannel::EntryReceiver& receiver)
+	{
+		while (!m_in_flight.empty() && m_in_flight.begin()->first <= now_ms)
+		{
+			const std::string& datagram = m_in_flight.begin()->second;
+			sf::Packet packet;
+			packet.Append(datagram.data(), datagram.size());
+
+			u32 game;
+			PlayerId pid;
+			EXPECT_TRUE(NetPlayInputChannel::ReadHeader(packet, game, pid));
+			EXPECT_EQ(GAME, game);
+			EXPECT_TRUE(to.Receive(packet, receiver));
+			EXPECT_TRUE(packet.EndOfPacket());
+
+			m_in_flight.erase(m_in_flight.begin());
+		}
+	}
+
+private:
+	std::mt19937& m_rng;
+	double m_loss;
+	u32 m_latency_ms;
+	u32 m_jitter_ms;
+	std::multimap<u32, std::string> m_in_flight;
+};
+
+struct Latency
+{
+	double mean_ms;
+	u32 max_ms;
+	u32 p99_ms;
+};
+
+// Sorts latencies, for the 99th percentile.
+Latency Summarize(std::vector<u32>& latencies)
+{
+	Latency latency = {};
+	for (u32 ms : latencies)
+		latency.mean_ms += ms;
+	latency.mean_ms /= latencies.size();
+	std::sort(latencies.begin(), latencies.end());
+	latency.max_ms = latencies.back();
+	latency.p99_ms = latencies[latencies.size() * 99 / 100];
+	return latency;
+}
+
+// Plays frames of a game at 60 fps between a client with pads 0 and 1 and
+// the server with pad 2 over links as given, checking every entry arrives
+// once and in order, and returns the time from push to arrival.
+Latency Simulate(u32 seed, u32 frames, double loss, u32 latency_ms, u32 jitter_ms, u32 max_entries = NetPlayInputChannel::MAX_ENTRIES)
+{
+	std::mt19937 rng(seed);
+	NetPlayInputChannel client(GAME, 1, max_entries);
+	NetPlayInputChannel server(GAME, 0, max_entries);
+	Link up(rng, loss, latency_ms, jitter_ms);
+	Link down(rng, loss, latency_ms, jitter_ms);
+
+	std::vector<u32> pushed_ms;
+	std::vector<u32> latencies;
+	u32 received[NetPlayInputChannel::NUM_STREAMS] = {};
+	auto receiver = [&](u8 stream, const Entry& entry, u32 now_ms)
+	{
+		EXPECT_TRUE(MakeEntry(stream, received[stream]) == entry);
+		latencies.push_back(now_ms - pushed_ms[received[stream]]);
+		received[stream]++;
+	};
+
+	u32 now_ms = 0;
+	for (u32 frame = 0; received[0] < frames || received[1] < frames || received[2] < frames; ++now_ms)
+	{
+		using namespace std::placeholders;
+		up.Deliver(server, now_ms, std::bind(receiver, _1, _2, now_ms));
+		down.Deliver(client, now_ms, std::bind(receiver, _1, _2, now_ms));
+
+		// Both pads of a client go in the same datagram.
+		if (frame < frames && now_ms >= frame * 1000 / 60)
+		{
+			pushed_ms.push_back(now_ms);
+			client.Push(0, MakeEntry(0, frame));
+			client.Push(1, MakeEntry(1, frame));
+			up.Send(client, now_ms);
+			server.Push(2, MakeEntry(2, frame));
+			down.Send(server, now_ms);
+			frame++;
+		}
+
+		if (client.ShouldSend(now_ms))
+			up.Send(client, now_ms);
+		if (server.ShouldSend(now_ms))
+			down.Send(server, now_ms);
+
+		if (now_ms > frames * 1000)
+		{
+			ADD_FAILURE() << "stalled";
+			break;
+		}
+	}
+
+	EXPECT_EQ(frames, received[0]);
+	EXPECT_EQ(frames, received[1]);
+	EXPECT_EQ(frames, received[2]);
+
+	return Summarize(latencies);
+}
+
+// The same over TCP: each frame sent once, resent after the shortest timeout
+// Linux allows when lost, and held up by those before it.
+Latency SimulateTCP(u32 seed, u32 frames, double loss, u32 latency_ms, u32 jitter_ms)
+{
+	const u32 RTO_MS = 200;
+	std::mt19937 rng(seed);
+
+	std::vector<u32> latencies;
+	u32 last_delivered_ms = 0;
+	for (u32 frame = 0; frame < frames; ++frame)
+	{
+		const u32 pushed_ms = frame * 1000 / 60;
+		u32 sent_ms = pushed_ms;
+		while (std::uniform_real_distribution<double>()(rng) < loss)
+			sent_ms += RTO_MS;
+		last_delivered_ms = std::max<u32>(last_delivered_ms, sent_ms + latency_ms + rng() % (jitter_ms + 1));
+		latencies.push_back(last_delivered_ms - pushed_ms);
+	}
+
+	return Summarize(latencies);
+}
+
+}
+
+// The entries of several streams go in one datagram.
+TEST(NetPlayInputChannel, Coalesces)
+{
+	NetPlayInputChannel client(GAME, 1), server(GAME, 0);
+	for (u8 stream : { 0, 3, 5 })
+		client.Push(stream, MakeEntry(stream, 0));
+
+	sf::Packet packet;
+	client.BuildDatagram(packet, 0);
+	u32 game;
+	PlayerId pid;
+	ASSERT_TRUE(NetPlayInputChannel::ReadHeader(packet, game, pid));
+	EXPECT_EQ(GAME, game);
+	EXPECT_EQ(1, pid);
+
+	std::vector<u8> streams;
+	EXPECT_TRUE(server.Receive(packet, [&](u8 stream, const Entry& entry)
+	{
+		EXPECT_TRUE(MakeEntry(stream, 0) == entry);
+		streams.push_back(stream);
+	}));
+	EXPECT_EQ(std::vector<u8>({ 0, 3, 5 }), streams);
+}
+
+// A datagram carries what those lost before it did, and what was received
+// once isn't again.
+TEST(NetPlayInputChannel, Redundancy)
+{
+	NetPlayInputChannel client(GAME, 1), server(GAME, 0);
+	std::vector<sf::Packet> datagrams(4);
+	for (u32 n = 0; n < 3; ++n)
+	{
+		client.Push(0, MakeEntry(0, n));
+		client.BuildDatagram(datagrams[n], n);
+	}
+	client.BuildDatagram(datagrams[3], 3);
+
+	std::vector<u32> received;
+	auto receiver = [&](u8 stream, const Entry& entry)
+	{
+		EXPECT_TRUE(MakeEntry(0, (u32)received.size()) == entry);
+		received.push_back((u32)received.size());
+	};
+	for (int d : { 2, 1, 3 })
+	{
+		u32 game;
+		PlayerId pid;
+		ASSERT_TRUE(NetPlayInputChannel::ReadHeader(datagrams[d], game, pid));
+		EXPECT_TRUE(server.Receive(datagrams[d], receiver));
+	}
+	EXPECT_EQ(std::vector<u32>({ 0, 1, 2 }), received);
+}
+
+// Once acknowledged entries aren't sent again, and the link goes quiet but
+// for keeping it alive.
+TEST(NetPlayInputChannel, Acknowledgements)
+{
+	std::mt19937 rng(0);
+	NetPlayInputChannel client(GAME, 1), server(GAME, 0);
+	Link up(rng, 0, 10, 0), down(rng, 0, 10, 0);
+	auto ignore = [](u8, const Entry&) {};
+
+	client.Push(0, MakeEntry(0, 0));
+	up.Send(client, 0);
+	EXPECT_FALSE(client.ShouldSend(0));
+	EXPECT_TRUE(client.ShouldSend(NetPlayInputChannel::RESEND_INTERVAL_MS));
+
+	up.Deliver(server, 10, ignore);
+	EXPECT_TRUE(server.ShouldSend(NetPlayInputChannel::RESEND_INTERVAL_MS));
+	down.Send(server, 10);
+	down.Deliver(client, 20, ignore);
+
+	EXPECT_FALSE(client.ShouldSend(100));
+	EXPECT_FALSE(server.ShouldSend(100));
+	EXPECT_TRUE(client.ShouldSend(NetPlayInputChannel::KEEPALIVE_INTERVAL_MS));
+
+	// Acknowledged, the entry isn't there any more.
+	sf::Packet empty, acked;
+	NetPlayInputChannel(GAME, 1).BuildDatagram(empty, 0);
+	client.BuildDatagram(acked, 30);
+	EXPECT_EQ(empty.GetDataSize(), acked.GetDataSize());
+}
+
+// Whatever is lost or reordered, every entry arrives once and in order, even
+// with room for only one in a datagram.
+TEST(NetPlayInputChannel, LossyLink)
+{
+	Simulate(0, 600, 0.3, 30, 40);
+	Simulate(1, 600, 0.05, 5, 100, 1);
+}
+
+// Time from pushing input to it arriving on a link losing datagrams at
+// random, against the same over TCP. Run with
+// --gtest_also_run_disabled_tests.
+TEST(NetPlayInputChannel, DISABLED_Benchmark)
+{
+	for (double loss : { 0.0, 0.01, 0.02, 0.05, 0.1, 0.2 })
+	{
+		const Latency udp = Simulate(0, 36000, loss, 40, 10);
+		const Latency tcp = SimulateTCP(0, 36000, loss, 40, 10);
+		printf("%2.0f%% loss: UDP mean %.1f ms, 99%% %u ms, max %u ms; TCP mean %.1f ms, 99%% %u ms, max %u ms\n",
+			loss * 100, udp.mean_ms, udp.p99_ms, udp.max_ms, tcp.mean_ms, tcp.p99_ms, tcp.max_ms);
+	}
+}
@@ -0,0 +1,131 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <random>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "Common/CommonTypes.h"
+#include "Core/State.h"
+
+namespace
+{
+
+// Large enough for several pages and a short last one.
+const size_t STATE_SIZE = 37 * 4096 + 123;
+
+std::vector<u8> RandomState(std::mt19937& rng)
+{
+	std::vector<u8> state(STATE_SIZE);
+	for (u8& b : state)
+		b = (u8)rng();
+	return state;
+}
+
+// Touches a few bytes, the way a frame of emulation touches a few pages.
+void Modify(std::vector<u8>* state, std::mt19937& rng)
+{
+	for (int i = 0; i < 3; ++i)
+		(*state)[rng() % state->size()] ^= (u8)(1 + rng() % 255);
+}
+
+class RewindStateTest : public testing::Test
+{
+protected:
+	void SetUp() override { State::ClearRewindStates(); }
+	void TearDown() override { State::ClearRewindStates(); }
+
+	void Push(const std::vector<u8>& state)
+	{
+		std::vector<u8> copy = state;
+		State::PushRewindState(copy);
+	}
+};
+
+}  // namespace
+
+TEST_F(RewindStateTest, EmptyHasNothingToPop)
+{
+	std::vector<u8> out;
+	EXPECT_FALSE(State::PopRewindState(out));
+}
+
+TEST_F(RewindStateTest, SaveModifyRewind)
+{
+	std::mt19937 rng(1);
+	std::vector<std::vector<u8>> saved;
+	std::vector<u8> state = RandomState(rng);
+
+	// Enough saves to go through more than one keyframe.
+	for (int i = 0; i < 40; ++i)
+	{
+		Push(state);
+		saved.push_back(state);
+		Modify(&state, rng);
+	}
+
+	std::vector<u8> out;
+	while (!saved.empty())
+	{
+		ASSERT_TRUE(State::PopRewindState(out));
+		EXPECT_TRUE(out == saved.back()) << "state " << saved.size() - 1;
+		saved.pop_back();
+	}
+	EXPECT_FALSE(State::PopRewindState(out));
+}
+
+TEST_F(RewindStateTest, ChangedSizeAndLastPage)
+{
+	std::mt19937 rng(2);
+	std::vector<u8> a = RandomState(rng);
+	std::vector<u8> b = a;
+	b.back() ^= 0xFF;
+	std::vector<u8> c = a;
+	c.resize(a.size() + 4096, 0x55);
+
+	Push(a);
+	Push(b);
+	Push(c);
+
+	std::vector<u8> out;
+	ASSERT_TRUE(State::PopRewindState(out));
+	EXPECT_TRUE(out == c);
+	ASSERT_TRUE(State::PopRewindState(out));
+	EXPECT_TRUE(out == b);
+	ASSERT_TRUE(State::PopRewindState(out));
+	EXPECT_TRUE(out == a);
+}
+
+TEST_F(RewindStateTest, MostlyChangedStateStillRoundTrips)
+{
+	std::mt19937 rng(3);
+	std::vector<u8> a = RandomState(rng);
+	std::vector<u8> b = RandomState(rng);
+
+	Push(a);
+	Push(b);
+
+	std::vector<u8> out;
+	ASSERT_TRUE(State::PopRewindState(out));
+	EXPECT_TRUE(out == b);
+	ASSERT_TRUE(State::PopRewindState(out));
+	EXPECT_TRUE(out == a);
+}
+
+TEST_F(RewindStateTest, OldestStatesAreDropped)
+{
+	std::mt19937 rng(4);
+	std::vector<u8> state = RandomState(rng);
+	for (int i = 0; i < 100; ++i)
+	{
+		Push(state);
+		Modify(&state, rng);
+	}
+
+	std::vector<u8> out;
+	int count = 0;
+	while (State::PopRewindState(out))
+		++count;
+	EXPECT_EQ(64, count);
+}
@@ -0,0 +1,208 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <gtest/gtest.h>
+
+#ifndef _WIN32
+#include <signal.h>
+#endif
+
+#include "Common/CommonTypes.h"
+#include "Common/Hash.h"
+#include "Common/MemArena.h"
+#include "Core/HW/Memmap.h"
+#include "Core/HW/WriteTracker.h"
+
+namespace
+{
+
+u8* s_ram;
+u8* s_physical;
+u8* s_cached;
+u8* s_uncached;
+
+const MemoryView s_views[] =
+{
+	{&s_ram,  &s_physical, 0x00000000, Memory::RAM_SIZE, 0},
+	{nullptr, &s_cached,   0x80000000, Memory::RAM_SIZE, MV_MIRROR_PREVIOUS},
+	{nullptr, &s_uncached, 0xC0000000, Memory::RAM_SIZE, MV_MIRROR_PREVIOUS},
+};
+const int s_num_views = sizeof(s_views) / sizeof(MemoryView);
+
+#ifndef _WIN32
+int s_faults;
+struct sigaction s_old_segv, s_old_bus;
+
+void HandleSignal(int sig, siginfo_t* info, void*)
+{
+	if (WriteTracker::HandleFault((uintptr_t)info->si_addr))
+	{
+		s_faults++;
+		return;
+	}
+	// Not ours; let it crash the usual way when the store is retried.
+	sigaction(SIGSEGV, &s_old_segv, nullptr);
+	sigaction(SIGBUS, &s_old_bus, nullptr);
+}
+#endif
+
+// How the texture cache uses the tracker: the hash of a range is only taken
+// again after a write to it.
+struct CachedHash
+{
+	CachedHash(u32 address_, u32 size_)
+		: address(address_), size(size_), hash(0), count(WriteTracker::UNWATCHED), hashes(0) {}
+
+	u64 Get()
+	{
+		if (count != WriteTracker::UNWATCHED && count == WriteTracker::GetWriteCount(address, size))
+			return hash;
+
+		WriteTracker::Watch(address, size);
+		count = WriteTracker::GetWriteCount(address, size);
+		hash = GetHash64(s_physical + (address & 0x0FFFFFFF), size, 0);
+		hashes++;
+		if (count != WriteTracker::GetWriteCount(address, size))
+			count = WriteTracker::UNWATCHED;
+		return hash;
+	}
+
+	u32 address;
+	u32 size;
+	u64 hash;
+	u64 count;
+	int hashes;
+};
+
+class WriteTrackerTest : public testing::Test
+{
+protected:
+	virtual void SetUp()
+	{
+		m_base = MemoryMap_Setup(s_views, s_num_views, 0, &m_arena);
+		WriteTracker::Init(m_base, false);
+#ifndef _WIN32
+		s_faults = 0;
+		struct sigaction sa;
+		sa.sa_sigaction = HandleSignal;
+		sa.sa_flags = SA_SIGINFO;
+		sigemptyset(&sa.sa_mask);
+		sigaction(SIGSEGV, &sa, &s_old_segv);
+		sigaction(SIGBUS, &sa, &s_old_bus);
+#endif
+	}
+
+	virtual void TearDown()
+	{
+#ifndef _WIN32
+		sigaction(SIGSEGV, &s_old_segv, nullptr);
+		sigaction(SIGBUS, &s_old_bus, nullptr);
+#endif
+		WriteTracker::Shutdown();
+		MemoryMap_Shutdown(s_views, s_num_views, 0, &m_arena);
+	}
+
+	MemArena m_arena;
+	u8* m_base;
+};
+
+}
+
+TEST_F(WriteTrackerTest, Written)
+{
+	WriteTracker::Watch(0x80001000, 0x2000);
+	const u64 count = WriteTracker::GetWriteCount(0x80001000, 0x2000);
+	EXPECT_NE(WriteTracker::UNWATCHED, count);
+	// The other mirrors are the same memory.
+	EXPECT_EQ(count, WriteTracker::GetWriteCount(0x00001000, 0x2000));
+	EXPECT_EQ(count, WriteTracker::GetWriteCount(0xC0001000, 0x2000));
+	// Nothing written, nothing changes.
+	EXPECT_EQ(count, WriteTracker::GetWriteCount(0x80001000, 0x2000));
+
+	// A write to one page stops it from being watched...
+	WriteTracker::Written(0x00002ffe, 4);
+	EXPECT_EQ(WriteTracker::UNWATCHED, WriteTracker::GetWriteCount(0x80001000, 0x2000));
+	EXPECT_EQ(WriteTracker::UNWATCHED, WriteTracker::GetWriteCount(0x80003000, 4));
+
+	// ...and watching it again doesn't give the old count back.
+	WriteTracker::Watch(0x80001000, 0x2000);
+	const u64 new_count = WriteTracker::GetWriteCount(0x80001000, 0x2000);
+	EXPECT_NE(WriteTracker::UNWATCHED, new_count);
+	EXPECT_NE(count, new_count);
+
+	// Writes outside the range don't matter.
+	WriteTracker::Written(0x80000ffc, 4);
+	WriteTracker::Written(0x80003000, 0x100);
+	EXPECT_EQ(new_count, WriteTracker::GetWriteCount(0x80001000, 0x2000));
+}
+
+// Anything that writes through the physical view, like the FIFO player,
+// DMA or IOS, isn't caught by the protection, and has to call Written for
+// the range to be hashed again.
+TEST_F(WriteTrackerTest, PhysicalWriteForcesRehash)
+{
+	CachedHash texture(0x80010000, 0x2000);
+	const u64 hash = texture.Get();
+	EXPECT_EQ(hash, texture.Get());
+	EXPECT_EQ(1, texture.hashes);
+
+	memset(s_physical + 0x11000, 0xAB, 0x100);
+	WriteTracker::Written(0x00011000, 0x100);
+
+	EXPECT_NE(hash, texture.Get());
+	EXPECT_EQ(2, texture.hashes);
+	EXPECT_EQ(GetHash64(s_physical + 0x10000, 0x2000, 0), texture.Get());
+	EXPECT_EQ(2, texture.hashes);
+}
+
+TEST_F(WriteTrackerTest, OutOfRange)
+{
+	EXPECT_EQ(WriteTracker::UNWATCHED, WriteTracker::GetWriteCount(0x80001000, 4));
+	WriteTracker::Watch(0x81fff000, 0x2000);
+	EXPECT_EQ(WriteTracker::UNWATCHED, WriteTracker::GetWriteCount(0x81fff000, 0x2000));
+	// No EXRAM on the GameCube.
+	WriteTracker::Watch(0x90000000, 0x1000);
+	EXPECT_EQ(WriteTracker::UNWATCHED, WriteTracker::GetWriteCount(0x90000000, 0x1000));
+	EXPECT_EQ(WriteTracker::UNWATCHED, WriteTracker::GetWriteCount(0xCC000000, 4));
+}
+
+TEST_F(WriteTrackerTest, Reset)
+{
+	WriteTracker::Watch(0x80000000, 0x10000);
+	EXPECT_NE(WriteTracker::UNWATCHED, WriteTracker::GetWriteCount(0x80000000, 0x10000));
+	WriteTracker::Reset();
+	EXPECT_EQ(WriteTracker::UNWATCHED, WriteTracker::GetWriteCount(0x80000000, 0x10000));
+}
+
+#ifndef _WIN32
+// Stores through the mirrors the JIT uses fault once per watched page and are
+// counted. Other pages aren't protected.
+TEST_F(WriteTrackerTest, Fault)
+{
+	WriteTracker::Watch(0x80004000, 0x1000);
+	const u64 count = WriteTracker::GetWriteCount(0x80004000, 0x1000);
+
+	m_base[0x80003ffc] = 1;
+	m_base[0xC0005000] = 2;
+	EXPECT_EQ(0, s_faults);
+	EXPECT_EQ(count, WriteTracker::GetWriteCount(0x80004000, 0x1000));
+
+	m_base[0xC0004100] = 3;
+	m_base[0x80004101] = 4;
+	EXPECT_EQ(1, s_faults);
+	EXPECT_EQ(WriteTracker::UNWATCHED, WriteTracker::GetWriteCount(0x80004000, 0x1000));
+	EXPECT_EQ(3, s_physical[0x4100]);
+	EXPECT_EQ(4, s_physical[0x4101]);
+
+	WriteTracker::Watch(0x80004000, 0x1000);
+	EXPECT_NE(count, WriteTracker::GetWriteCount(0x80004000, 0x1000));
+	EXPECT_NE(WriteTracker::UNWATCHED, WriteTracker::GetWriteCount(0x80004000, 0x1000));
+	EXPECT_EQ(1, s_faults);
+
+	// Stores through the physical mirror aren't seen.
+	s_physical[0x4200] = 5;
+	EXPECT_EQ(1, s_faults);
+	EXPECT_NE(WriteTracker::UNWATCHED, WriteTracker::GetWriteCount(0x80004000, 0x1000));
+}
+#endif
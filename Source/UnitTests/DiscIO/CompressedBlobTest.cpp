@@ -0,0 +1,106 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "Common/CommonTypes.h"
+#include "Common/FileUtil.h"
+#include "DiscIO/Blob.h"
+
+namespace
+{
+
+const int BLOCK_SIZE = 0x4000;
+
+std::vector<u8> ReadFile(const std::string& filename)
+{
+	std::vector<u8> data((size_t)File::GetSize(filename));
+	File::IOFile file(filename, "rb");
+	file.ReadBytes(data.data(), data.size());
+	return data;
+}
+
+void WriteFile(const std::string& filename, const std::vector<u8>& data)
+{
+	File::IOFile file(filename, "wb");
+	file.WriteBytes(data.data(), data.size());
+}
+
+// Runs of noise, which is stored as-is, between runs that compress well, and
+// a short last block.
+std::vector<u8> MakeImage()
+{
+	std::mt19937 rng(0);
+	std::vector<u8> data(97 * BLOCK_SIZE + 1234);
+	for (size_t i = 0; i < data.size(); )
+	{
+		const size_t run = std::min<size_t>(1 + rng() % (3 * BLOCK_SIZE), data.size() - i);
+		const bool noise = rng() % 2 != 0;
+		const u8 fill = (u8)rng();
+		for (size_t j = 0; j < run; ++j, ++i)
+			data[i] = noise ? (u8)rng() : (u8)(fill + j / 64);
+	}
+	return data;
+}
+
+class CompressedBlobTest : public testing::Test
+{
+protected:
+	CompressedBlobTest()
+		: m_iso("CompressedBlobTest.iso"), m_gcz("CompressedBlobTest.gcz"), m_out("CompressedBlobTest.out")
+	{
+	}
+
+	virtual void SetUp()
+	{
+		TearDown();
+	}
+
+	virtual void TearDown()
+	{
+		File::Delete(m_iso);
+		File::Delete(m_gcz);
+		File::Delete(m_out);
+	}
+
+	std::string m_iso;
+	std::string m_gcz;
+	std::string m_out;
+};
+
+}
+
+// The blocks come out of the workers in any order; the file must not show it.
+TEST_F(CompressedBlobTest, ThreadedOutputMatchesSerial)
+{
+	const std::vector<u8> image = MakeImage();
+	WriteFile(m_iso, image);
+
+	ASSERT_TRUE(DiscIO::CompressFileToBlob(m_iso, m_gcz, 0, BLOCK_SIZE, nullptr, nullptr, 9, 1));
+	const std::vector<u8> serial = ReadFile(m_gcz);
+	ASSERT_LT(serial.size(), image.size());
+
+	for (u32 threads : {2u, 3u, 8u})
+	{
+		ASSERT_TRUE(DiscIO::CompressFileToBlob(m_iso, m_gcz, 0, BLOCK_SIZE, nullptr, nullptr, 9, threads));
+		EXPECT_TRUE(ReadFile(m_gcz) == serial) << threads << " threads";
+	}
+}
+
+TEST_F(CompressedBlobTest, DecompressRoundTrips)
+{
+	const std::vector<u8> image = MakeImage();
+	WriteFile(m_iso, image);
+	ASSERT_TRUE(DiscIO::CompressFileToBlob(m_iso, m_gcz, 0, BLOCK_SIZE, nullptr, nullptr, 9, 4));
+
+	for (u32 threads : {1u, 4u})
+	{
+		ASSERT_TRUE(DiscIO::DecompressBlobToFile(m_gcz, m_out, nullptr, nullptr, threads));
+		EXPECT_TRUE(ReadFile(m_out) == image) << threads << " threads";
+	}
+}
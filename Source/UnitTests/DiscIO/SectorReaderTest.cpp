@@ -0,0 +1,135 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <random>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "Common/CommonTypes.h"
+#include "DiscIO/Blob.h"
+
+namespace
+{
+
+const int BLOCK_SIZE = 0x800;
+
+// Serves blocks from memory and counts how often each is fetched.
+class TestSectorReader : public DiscIO::SectorReader
+{
+public:
+	TestSectorReader(const std::vector<u8>& data, u32 cache_size)
+		: m_data(data), m_fetches(data.size() / BLOCK_SIZE)
+	{
+		DiscIO::SetSectorCacheSize(cache_size);
+		SetSectorSize(BLOCK_SIZE);
+		DiscIO::SetSectorCacheSize(8 * 1024 * 1024);
+	}
+
+	~TestSectorReader()
+	{
+		StopReadAhead();
+	}
+
+	u64 GetRawSize() const override { return m_data.size(); }
+	u64 GetDataSize() const override { return m_data.size(); }
+
+	u32 Fetches(u64 block_num) const { return m_fetches[block_num].load(); }
+
+protected:
+	void GetBlock(u64 block_num, u8* out) override
+	{
+		m_fetches[block_num]++;
+		memcpy(out, &m_data[block_num * BLOCK_SIZE], BLOCK_SIZE);
+	}
+
+private:
+	const std::vector<u8>& m_data;
+	std::vector<std::atomic<u32>> m_fetches;
+};
+
+std::vector<u8> MakeReference(u32 num_blocks)
+{
+	std::mt19937 rng(num_blocks);
+	std::vector<u8> data((size_t)num_blocks * BLOCK_SIZE);
+	for (u8& b : data)
+		b = (u8)rng();
+	return data;
+}
+
+void ExpectRead(TestSectorReader* reader, const std::vector<u8>& reference, u64 offset, u64 size)
+{
+	std::vector<u8> out(size);
+	ASSERT_TRUE(reader->Read(offset, size, out.data()));
+	EXPECT_TRUE(std::equal(out.begin(), out.end(), reference.begin() + offset))
+		<< "offset " << offset << " size " << size;
+}
+
+}  // namespace
+
+TEST(SectorReaderTest, SequentialReadsMatchReference)
+{
+	const std::vector<u8> reference = MakeReference(512);
+	TestSectorReader reader(reference, 64 * BLOCK_SIZE);
+
+	// Odd sizes, so reads start and end inside blocks and cross block borders.
+	for (u64 offset = 0; offset < reference.size(); )
+	{
+		const u64 size = std::min<u64>(700, reference.size() - offset);
+		ExpectRead(&reader, reference, offset, size);
+		offset += size;
+	}
+
+	const DiscIO::SectorReader::CacheStats stats = reader.GetCacheStats();
+	EXPECT_GT(stats.read_ahead_blocks, 0u);
+}
+
+TEST(SectorReaderTest, RandomReadsMatchReference)
+{
+	const std::vector<u8> reference = MakeReference(512);
+	TestSectorReader reader(reference, 32 * BLOCK_SIZE);
+
+	std::mt19937 rng(1);
+	for (int i = 0; i < 2000; ++i)
+	{
+		const u64 offset = rng() % reference.size();
+		const u64 size = 1 + rng() % std::min<u64>(3 * BLOCK_SIZE, reference.size() - offset);
+		ExpectRead(&reader, reference, offset, size);
+	}
+
+	// Random reads interleaved with sequential runs start and drop read-ahead.
+	for (int i = 0; i < 50; ++i)
+	{
+		u64 offset = rng() % (reference.size() - 8 * BLOCK_SIZE);
+		for (int j = 0; j < 6; ++j)
+		{
+			ExpectRead(&reader, reference, offset, BLOCK_SIZE);
+			offset += BLOCK_SIZE;
+		}
+	}
+}
+
+TEST(SectorReaderTest, EvictsLeastRecentlyUsed)
+{
+	const std::vector<u8> reference = MakeReference(16);
+	// The smallest cache there is: four blocks.
+	TestSectorReader reader(reference, 0);
+
+	// None of these are sequential, so nothing is read ahead.
+	const u64 order[] = {0, 2, 4, 6, 0, 8, 0, 2};
+	for (u64 block : order)
+		ExpectRead(&reader, reference, block * BLOCK_SIZE, 1);
+
+	// 8 evicted 2, the least recently used, and kept 0.
+	EXPECT_EQ(1u, reader.Fetches(0));
+	EXPECT_EQ(2u, reader.Fetches(2));
+	EXPECT_EQ(1u, reader.Fetches(4));
+
+	const DiscIO::SectorReader::CacheStats stats = reader.GetCacheStats();
+	EXPECT_EQ(2u, stats.hits);
+	EXPECT_EQ(6u, stats.misses);
+	EXPECT_EQ(0u, stats.read_ahead_blocks);
+}
@@ -0,0 +1,221 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+#include <polarssl/aes.h>
+
+#include "Common/CommonTypes.h"
+#include "Common/CPUDetect.h"
+#include "DiscIO/Blob.h"
+#include "DiscIO/FileSystemGCWii.h"
+#include "DiscIO/VolumeWiiCrypted.h"
+
+namespace
+{
+
+const u32 CLUSTER_SIZE = 0x8000;
+const u32 CLUSTER_DATA_SIZE = 0x7C00;
+const u64 DATA_OFFSET = 0x20000;
+
+class MemoryBlobReader : public DiscIO::IBlobReader
+{
+public:
+	MemoryBlobReader(const std::vector<u8>& data) : m_data(data), m_reads(0) {}
+
+	u64 GetRawSize() const override { return m_data.size(); }
+	u64 GetDataSize() const override { return m_data.size(); }
+	bool Read(u64 offset, u64 size, u8* out_ptr) override
+	{
+		if (offset + size > m_data.size())
+			return false;
+		memcpy(out_ptr, &m_data[(size_t)offset], (size_t)size);
+		m_reads++;
+		return true;
+	}
+
+	u32 GetNumReads() const { return m_reads; }
+
+private:
+	std::vector<u8> m_data;
+	u32 m_reads;
+};
+
+void Write32(std::vector<u8>& data, u64 offset, u32 value)
+{
+	data[(size_t)offset + 0] = (u8)(value >> 24);
+	data[(size_t)offset + 1] = (u8)(value >> 16);
+	data[(size_t)offset + 2] = (u8)(value >> 8);
+	data[(size_t)offset + 3] = (u8)value;
+}
+
+// Decrypted contents of a partition with a Wii file system of num_dirs
+// directories of files_per_dir files each, and the encrypted partition.
+struct TestPartition
+{
+	std::vector<u8> plain;
+	std::vector<u8> encrypted;
+	u8 key[16];
+	u32 num_entries;
+};
+
+TestPartition BuildPartition(u32 num_dirs, u32 files_per_dir, u32 max_file_size, u32 seed)
+{
+	std::mt19937 rng(seed);
+	TestPartition p;
+	std::vector<u8>& plain = p.plain;
+
+	p.num_entries = 1 + num_dirs * (1 + files_per_dir);
+	const u64 fst_offset = 0x440;
+	std::string names;
+	std::vector<u8> fst(p.num_entries * 12);
+
+	u64 file_data = (fst_offset + fst.size() + 0x10000 + 0x7FFF) & ~0x7FFFULL;
+	plain.resize((size_t)file_data);
+	Write32(fst, 0, 0x01000000);
+	Write32(fst, 8, p.num_entries);
+	u32 entry = 1;
+	for (u32 d = 0; d < num_dirs; ++d)
+	{
+		const u32 dir_entry = entry++;
+		Write32(fst, dir_entry * 12 + 0, 0x01000000 | (u32)names.size());
+		Write32(fst, dir_entry * 12 + 8, dir_entry + 1 + files_per_dir);
+		names += "dir" + std::to_string(d) + '\0';
+
+		for (u32 f = 0; f < files_per_dir; ++f, ++entry)
+		{
+			u32 size = rng() % max_file_size + 1;
+			Write32(fst, entry * 12 + 0, (u32)names.size());
+			Write32(fst, entry * 12 + 4, (u32)(file_data >> 2));
+			Write32(fst, entry * 12 + 8, size);
+			names += "file" + std::to_string(f) + ".bin" + '\0';
+
+			plain.resize((size_t)(file_data + size));
+			for (u32 i = 0; i < size; ++i)
+				plain[(size_t)(file_data + i)] = (u8)rng();
+			file_data = (file_data + size + 3) & ~3ULL;
+		}
+	}
+
+	Write32(plain, 0x18, 0x5D1C9EA3);
+	Write32(plain, 0x424, (u32)(fst_offset >> 2));
+	memcpy(&plain[(size_t)fst_offset], &fst[0], fst.size());
+	memcpy(&plain[(size_t)(fst_offset + fst.size())], names.data(), names.size());
+
+	const u64 num_clusters = (plain.size() + CLUSTER_DATA_SIZE - 1) / CLUSTER_DATA_SIZE;
+	plain.resize((size_t)(num_clusters * CLUSTER_DATA_SIZE));
+
+	for (u8& b : p.key)
+		b = (u8)rng();
+	aes_context ctx;
+	aes_setkey_enc(&ctx, p.key, 128);
+
+	p.encrypted.resize((size_t)(DATA_OFFSET + num_clusters * CLUSTER_SIZE));
+	for (u64 c = 0; c < num_clusters; ++c)
+	{
+		u8* raw = &p.encrypted[(size_t)(DATA_OFFSET + c * CLUSTER_SIZE)];
+		for (u32 i = 0; i < 0x400; ++i)
+			raw[i] = (u8)rng();
+		u8 iv[16];
+		memcpy(iv, raw + 0x3D0, 16);
+		aes_crypt_cbc(&ctx, AES_ENCRYPT, CLUSTER_DATA_SIZE, iv, &plain[(size_t)(c * CLUSTER_DATA_SIZE)], raw + 0x400);
+	}
+	return p;
+}
+
+}
+
+TEST(VolumeWiiCrypted, ReadMatchesPlaintext)
+{
+	TestPartition p = BuildPartition(4, 16, 0x20000, 1);
+	MemoryBlobReader* reader = new MemoryBlobReader(p.encrypted);
+	DiscIO::CVolumeWiiCrypted volume(reader, 0, p.key);
+
+	std::mt19937 rng(2);
+	const u64 size = p.plain.size();
+	std::vector<u8> buffer;
+	for (int i = 0; i < 2000; ++i)
+	{
+		// Mostly small reads, some spanning many clusters.
+		u64 length = (rng() % 8 == 0) ? rng() % (CLUSTER_DATA_SIZE * 40) : rng() % 0x100;
+		u64 offset = rng() % (size - length);
+		if (rng() % 4 == 0)
+			offset -= offset % CLUSTER_DATA_SIZE;
+		length = std::max<u64>(length, 1);
+		buffer.assign((size_t)length, 0);
+		ASSERT_TRUE(volume.Read(offset, length, &buffer[0]));
+		ASSERT_EQ(0, memcmp(&buffer[0], &p.plain[(size_t)offset], (size_t)length))
+			<< "offset " << offset << ", length " << length;
+	}
+
+	buffer.resize(0x100);
+	EXPECT_FALSE(volume.Read(size, 0x100, &buffer[0]));
+}
+
+TEST(VolumeWiiCrypted, FileSystem)
+{
+	TestPartition p = BuildPartition(3, 5, 0x10000, 3);
+	MemoryBlobReader* reader = new MemoryBlobReader(p.encrypted);
+	DiscIO::CVolumeWiiCrypted volume(reader, 0, p.key);
+	DiscIO::CFileSystemGCWii fs(&volume);
+	ASSERT_TRUE(fs.IsValid());
+
+	std::vector<const DiscIO::SFileInfo*> files;
+	ASSERT_EQ(p.num_entries, fs.GetFileList(files));
+	EXPECT_EQ("dir0/", files[1]->m_FullPath);
+	EXPECT_EQ("dir0/file0.bin", files[2]->m_FullPath);
+	EXPECT_EQ("dir2/file4.bin", files.back()->m_FullPath);
+
+	const DiscIO::SFileInfo* file = files.back();
+	std::vector<u8> data((size_t)file->m_FileSize);
+	ASSERT_EQ(file->m_FileSize, fs.ReadFile(file->m_FullPath, &data[0], data.size()));
+	EXPECT_EQ(0, memcmp(&data[0], &p.plain[(size_t)file->m_Offset], data.size()));
+
+	// The FST walk stays within a few clusters, which are read once each.
+	EXPECT_LT(reader->GetNumReads(), 16u);
+}
+
+// Walks a file system of 10000 files and reads every file, with and without
+// AES-NI. Run with --gtest_also_run_disabled_tests.
+TEST(VolumeWiiCrypted, DISABLED_Benchmark)
+{
+	TestPartition p = BuildPartition(100, 100, 0x1000, 4);
+
+	const bool has_aes = cpu_info.bAES;
+	for (int use_aesni = 0; use_aesni <= (int)has_aes; ++use_aesni)
+	{
+		cpu_info.bAES = use_aesni != 0;
+		MemoryBlobReader* reader = new MemoryBlobReader(p.encrypted);
+		DiscIO::CVolumeWiiCrypted volume(reader, 0, p.key);
+
+		auto t0 = std::chrono::high_resolution_clock::now();
+		DiscIO::CFileSystemGCWii fs(&volume);
+		std::vector<const DiscIO::SFileInfo*> files;
+		fs.GetFileList(files);
+		auto t1 = std::chrono::high_resolution_clock::now();
+
+		std::vector<u8> data(0x1000);
+		for (const DiscIO::SFileInfo* file : files)
+		{
+			if (!file->IsDirectory())
+				volume.Read(file->m_Offset, file->m_FileSize, &data[0]);
+		}
+		auto t2 = std::chrono::high_resolution_clock::now();
+
+		using std::chrono::duration_cast;
+		using std::chrono::microseconds;
+		printf("AES-NI %s: %u entries, walk %lld us, read all %lld us, %u blob reads\n",
+		       use_aesni ? "on" : "off", (u32)files.size(),
+		       (long long)duration_cast<microseconds>(t1 - t0).count(),
+		       (long long)duration_cast<microseconds>(t2 - t1).count(),
+		       reader->GetNumReads());
+	}
+	cpu_info.bAES = has_aes;
+}
@@ -0,0 +1,273 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "Common/CommonTypes.h"
+#include "VideoBackends/Software/Clipper.h"
+#include "VideoBackends/Software/EfbInterface.h"
+#include "VideoBackends/Software/NativeVertexFormat.h"
+#include "VideoBackends/Software/Pipeline.h"
+#include "VideoBackends/Software/Rasterizer.h"
+#include "VideoBackends/Software/SWStatistics.h"
+#include "VideoBackends/Software/SWVideoConfig.h"
+#include "VideoBackends/Software/TevJit.h"
+#include "VideoBackends/Software/XFMemLoader.h"
+#include "VideoCommon/BPMemory.h"
+#include "VideoCommon/OpcodeDecoding.h"
+#include "VideoCommon/VideoCommon.h"
+
+#include "SoftwareTestUtil.h"
+
+extern u8 efb[EFB_WIDTH*EFB_HEIGHT*6];
+
+namespace
+{
+
+struct Primitive
+{
+	u8 type;
+	std::vector<InputVertexData> vertices;
+};
+
+// Primitives of every kind the setup unit handles, some long enough to span
+// several batches, with vertices a little past the edges to be clipped.
+std::vector<Primitive> RandomPrimitives(int count, u32 seed)
+{
+	const u8 types[] = {
+		GX_DRAW_QUADS, GX_DRAW_TRIANGLES, GX_DRAW_TRIANGLE_STRIP,
+		GX_DRAW_TRIANGLE_FAN, GX_DRAW_LINES, GX_DRAW_LINE_STRIP,
+	};
+
+	std::mt19937 rng(seed);
+	std::uniform_real_distribution<float> xy(-1.2f, 1.2f);
+	std::uniform_real_distribution<float> offset(-0.2f, 0.2f);
+	std::uniform_real_distribution<float> z(-1.0f, 0.0f);
+
+	std::vector<Primitive> primitives(count);
+	for (Primitive& primitive : primitives)
+	{
+		primitive.type = types[rng() % (sizeof(types) / sizeof(types[0]))];
+		primitive.vertices.resize(rng() % 8 ? 3 + rng() % 30 : 200 + rng() % 600);
+
+		const float cx = xy(rng), cy = xy(rng);
+		for (InputVertexData& v : primitive.vertices)
+		{
+			memset(&v, 0, sizeof(v));
+			v.position.x = cx + offset(rng);
+			v.position.y = cy + offset(rng);
+			v.position.z = z(rng);
+			for (u8& comp : v.color[0])
+				comp = (u8)rng();
+		}
+	}
+	return primitives;
+}
+
+// An identity position matrix and an orthographic projection onto the
+// whole EFB, with the vertex color passed through.
+void SetupXFMem()
+{
+	InitXFMemory();
+
+	float *position = (float*)swxfregs.posMatrices;
+	position[0] = position[5] = position[10] = 1.0f;
+
+	swxfregs.projection.type = GX_ORTHOGRAPHIC;
+	const float projection[] = { 1.0f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f };
+	memcpy(swxfregs.projection.rawProjection, projection, sizeof(projection));
+
+	swxfregs.viewport.wd = EFB_WIDTH / 2;
+	swxfregs.viewport.ht = -EFB_HEIGHT / 2;
+	swxfregs.viewport.xOrig = 342 + EFB_WIDTH / 2;
+	swxfregs.viewport.yOrig = 342 + EFB_HEIGHT / 2;
+	swxfregs.viewport.zRange = 16777215.0f;
+	swxfregs.viewport.farZ = 16777215.0f;
+	Clipper::SetViewOffset();
+
+	swxfregs.nNumChans = 1;
+	swxfregs.color[0].matsource = 1;
+	swxfregs.alpha[0].matsource = 1;
+}
+
+void Submit(const std::vector<Primitive>& primitives)
+{
+	for (const Primitive& primitive : primitives)
+	{
+		Pipeline::BeginPrimitive(primitive.type, 0, false, false);
+		for (const InputVertexData& vertex : primitive.vertices)
+			Pipeline::SubmitVertex(&vertex);
+	}
+}
+
+class SoftwarePipelineTest : public testing::Test
+{
+protected:
+	virtual void SetUp()
+	{
+		SetupXFMem();
+		SetupBPMem();
+		TevJit::Invalidate();
+		Rasterizer::Init();
+		Rasterizer::SetScissor();
+		Clipper::Init();
+		Pipeline::Init();
+		swstats.ResetFrame();
+	}
+
+	virtual void TearDown()
+	{
+		Pipeline::Shutdown();
+		Rasterizer::Shutdown();
+		TevJit::Shutdown();
+		g_SWVideoConfig.bThreadedPipeline = true;
+		g_SWVideoConfig.rasterizerThreads = 0;
+	}
+
+	// Switches the pipeline over, which happens on a flush.
+	void SetThreaded(bool threaded)
+	{
+		g_SWVideoConfig.bThreadedPipeline = threaded;
+		Pipeline::Flush();
+	}
+
+	std::vector<u8> Clear()
+	{
+		memset(efb, 0, EfbInterface::DEPTH_BUFFER_START);
+		memset(efb + EfbInterface::DEPTH_BUFFER_START, 0xFF, sizeof(efb) - EfbInterface::DEPTH_BUFFER_START);
+		return std::vector<u8>(efb, efb + sizeof(efb));
+	}
+
+	std::vector<u8> EFB() const
+	{
+		return std::vector<u8>(efb, efb + sizeof(efb));
+	}
+};
+
+}
+
+// Transforming and setting up on other threads must draw exactly what
+// doing it as the vertices come does, with any number of rasterizer threads.
+TEST_F(SoftwarePipelineTest, ThreadedMatchesSerial)
+{
+	const u32 thread_counts[] = { 1, 4 };
+
+	for (u32 seed = 0; seed < 4; ++seed)
+	{
+		std::vector<Primitive> primitives = RandomPrimitives(300, seed);
+
+		g_SWVideoConfig.rasterizerThreads = 1;
+		SetThreaded(false);
+		const std::vector<u8> cleared = Clear();
+		Submit(primitives);
+		Pipeline::Flush();
+		const std::vector<u8> expected = EFB();
+		EXPECT_TRUE(expected != cleared);
+
+		for (u32 threads : thread_counts)
+		{
+			g_SWVideoConfig.rasterizerThreads = threads;
+			SetThreaded(true);
+			swstats.ResetFrame();
+			Clear();
+			Submit(primitives);
+			Pipeline::Flush();
+			EXPECT_TRUE(expected == EFB()) << "seed " << seed << ", " << threads << " rasterizer threads";
+			EXPECT_LT(0u, swstats.thisFrame.pipelineBatches);
+		}
+	}
+}
+
+// Register writes wait for the vertices before them to be drawn, and apply
+// to all the ones after, even in the middle of a primitive.
+TEST_F(SoftwarePipelineTest, RegisterWritesStayInOrder)
+{
+	std::vector<Primitive> primitives = RandomPrimitives(100, 10);
+
+	std::vector<u8> results[2];
+	for (int threaded = 0; threaded < 2; ++threaded)
+	{
+		SetupXFMem();
+		SetThreaded(threaded != 0);
+		Clear();
+
+		for (size_t i = 0; i < primitives.size(); ++i)
+		{
+			const Primitive& primitive = primitives[i];
+			Pipeline::BeginPrimitive(primitive.type, 0, false, false);
+			for (size_t v = 0; v < primitive.vertices.size(); ++v)
+			{
+				if (v == primitive.vertices.size() / 2 && i % 10 == 0)
+				{
+					// Scale the position matrix down.
+					u32 scale[3];
+					const float value = 0.9f - i / 200.0f;
+					for (u32& s : scale)
+						memcpy(&s, &value, sizeof(s));
+					SWLoadXFReg(1, 0, &scale[0]);
+					SWLoadXFReg(1, 5, &scale[1]);
+					SWLoadXFReg(1, 10, &scale[2]);
+				}
+				Pipeline::SubmitVertex(&primitive.vertices[v]);
+			}
+		}
+		Pipeline::Flush();
+		results[threaded] = EFB();
+	}
+	EXPECT_TRUE(results[0] == results[1]);
+}
+
+// Time to transform, set up and draw small triangles, serially and on the
+// pipeline threads. Run with --gtest_also_run_disabled_tests.
+TEST_F(SoftwarePipelineTest, DISABLED_Benchmark)
+{
+	std::vector<Primitive> primitives(2000);
+	std::mt19937 rng(20);
+	std::uniform_real_distribution<float> xy(-1.0f, 1.0f);
+	std::uniform_real_distribution<float> offset(-0.02f, 0.02f);
+	for (Primitive& primitive : primitives)
+	{
+		primitive.type = GX_DRAW_TRIANGLE_STRIP;
+		primitive.vertices.resize(64);
+		const float cx = xy(rng), cy = xy(rng);
+		for (InputVertexData& v : primitive.vertices)
+		{
+			memset(&v, 0, sizeof(v));
+			v.position.x = cx + offset(rng);
+			v.position.y = cy + offset(rng);
+			v.position.z = -0.5f;
+			for (u8& comp : v.color[0])
+				comp = (u8)rng();
+		}
+	}
+
+	long long us[2];
+	for (int threaded = 0; threaded < 2; ++threaded)
+	{
+		SetThreaded(threaded != 0);
+		swstats.ResetFrame();
+		Clear();
+
+		auto start = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < 5; ++i)
+			Submit(primitives);
+		Pipeline::Flush();
+		auto end = std::chrono::high_resolution_clock::now();
+		us[threaded] = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+
+		if (threaded)
+		{
+			printf("transform busy %u us, setup busy %u us, loader stalls %u, flush wait %u us\n",
+				swstats.thisFrame.transformBusyUs, swstats.thisFrame.setupBusyUs,
+				swstats.thisFrame.loaderStalls, swstats.thisFrame.flushWaitUs);
+		}
+	}
+
+	printf("serial %lld us, threaded %lld us (%.2fx)\n", us[0], us[1], (double)us[0] / us[1]);
+}
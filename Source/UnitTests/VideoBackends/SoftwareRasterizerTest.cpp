@@ -0,0 +1,446 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "Common/CommonTypes.h"
+#include "Common/CPUDetect.h"
+#include "Common/ParallelFor.h"
+#include "VideoBackends/Software/EfbInterface.h"
+#include "VideoBackends/Software/NativeVertexFormat.h"
+#include "VideoBackends/Software/Rasterizer.h"
+#include "VideoBackends/Software/SWPixelEngine.h"
+#include "VideoBackends/Software/SWVideoConfig.h"
+#include "VideoBackends/Software/Tev.h"
+#include "VideoBackends/Software/TevJit.h"
+#include "VideoBackends/Software/TextureSampler.h"
+#include "VideoBackends/Software/XFMemLoader.h"
+#include "VideoCommon/BPMemory.h"
+#include "VideoCommon/TextureDecoder.h"
+#include "VideoCommon/VideoCommon.h"
+
+#include "SoftwareTestUtil.h"
+
+extern u8 efb[EFB_WIDTH*EFB_HEIGHT*6];
+extern u8 texMem[TMEM_SIZE];
+
+namespace
+{
+
+struct Vertices
+{
+	OutputVertexData v[3];
+};
+
+std::vector<Vertices> RandomTriangles(int count, float max_size, u32 seed)
+{
+	std::mt19937 rng(seed);
+	std::uniform_real_distribution<float> x(0.0f, (float)EFB_WIDTH);
+	std::uniform_real_distribution<float> y(0.0f, (float)EFB_HEIGHT);
+	std::uniform_real_distribution<float> offset(-max_size, max_size);
+	std::uniform_real_distribution<float> z(0.0f, (float)0xffffff);
+
+	std::vector<Vertices> triangles(count);
+	for (Vertices& triangle : triangles)
+	{
+		memset(&triangle, 0, sizeof(triangle));
+		const float cx = x(rng), cy = y(rng);
+		for (OutputVertexData& v : triangle.v)
+		{
+			v.screenPosition.x = cx + offset(rng);
+			v.screenPosition.y = cy + offset(rng);
+			v.screenPosition.z = z(rng);
+			v.projectedPosition.w = 1.0f;
+			for (u8& comp : v.color[0])
+				comp = (u8)rng();
+		}
+	}
+	return triangles;
+}
+
+// Random TEV stages with a texture in TMEM, perspective correct texture
+// coordinates and two color channels.
+void SetupRandomTev(std::vector<Vertices>& triangles, u32 seed)
+{
+	std::mt19937 rng(seed);
+
+	bpmem.genMode.numtevstages = rng() % 16;
+	bpmem.genMode.numcolchans = 2;
+	bpmem.genMode.numtexgens = 1;
+	for (auto& combiner : bpmem.combiners)
+	{
+		combiner.colorC.hex = rng();
+		combiner.alphaC.hex = rng();
+	}
+	for (auto& order : bpmem.tevorders)
+	{
+		order.hex = rng();
+		order.texmap0 = order.texmap1 = 0;
+		order.texcoord0 = order.texcoord1 = 0;
+	}
+	for (auto& ksel : bpmem.tevksel)
+	{
+		ksel.hex = rng();
+		// 8 to 11 aren't valid constants.
+		if ((ksel.kcsel0 & ~3) == 8) ksel.kcsel0 = 0;
+		if ((ksel.kcsel1 & ~3) == 8) ksel.kcsel1 = 0;
+		if ((ksel.kasel0 & ~3) == 8) ksel.kasel0 = 0;
+		if ((ksel.kasel1 & ~3) == 8) ksel.kasel1 = 0;
+	}
+	for (int reg = 0; reg < 4; reg++)
+	{
+		for (int comp = 0; comp < 4; comp++)
+		{
+			Rasterizer::SetTevReg(reg, comp, false, (s16)(rng() % 2048) - 1024);
+			Rasterizer::SetTevReg(reg, comp, true, (s16)(rng() % 256));
+		}
+	}
+
+	// A 64x64 I8 texture without mipmaps.
+	for (u8& texel : texMem)
+		texel = (u8)rng();
+	FourTexUnits& unit = bpmem.tex[0];
+	unit.texMode0[0].hex = rng();
+	unit.texMode0[0].wrap_s = rng() % 3;
+	unit.texMode0[0].wrap_t = rng() % 3;
+	unit.texMode0[0].min_filter &= 4;
+	unit.texMode1[0].hex = 0;
+	unit.texImage0[0].width = 63;
+	unit.texImage0[0].height = 63;
+	unit.texImage0[0].format = GX_TF_I8;
+	unit.texImage1[0].image_type = 1;
+	unit.texImage1[0].tmem_even = 0;
+	TextureSampler::Invalidate();
+	TevJit::Invalidate();
+	swxfregs.texMtxInfo[0].projection = rng() & 1;
+
+	std::uniform_real_distribution<float> uv(-100.0f, 100.0f);
+	std::uniform_real_distribution<float> w(0.5f, 2.0f);
+	for (Vertices& triangle : triangles)
+	{
+		for (OutputVertexData& v : triangle.v)
+		{
+			v.projectedPosition.w = w(rng);
+			v.texCoords[0].x = uv(rng);
+			v.texCoords[0].y = uv(rng);
+			v.texCoords[0].z = w(rng);
+			for (u8& comp : v.color[1])
+				comp = (u8)rng();
+		}
+	}
+}
+
+void Draw(std::vector<Vertices>& triangles, u32 num_threads)
+{
+	g_SWVideoConfig.rasterizerThreads = num_threads;
+	for (Vertices& triangle : triangles)
+	{
+		// Only one of the two windings covers any pixels.
+		Rasterizer::DrawTriangleFrontFace(&triangle.v[0], &triangle.v[1], &triangle.v[2]);
+		Rasterizer::DrawTriangleFrontFace(&triangle.v[0], &triangle.v[2], &triangle.v[1]);
+	}
+	Rasterizer::Flush();
+}
+
+// The performance counters keep a count of pixels between runs, so only
+// the bounding box is compared.
+struct Result
+{
+	std::vector<u8> efb;
+	u16 box[4];
+
+	Result() : efb(::efb, ::efb + sizeof(::efb))
+	{
+		const SWPixelEngine::PEReg& pereg = SWPixelEngine::pereg;
+		box[0] = pereg.boxLeft;
+		box[1] = pereg.boxRight;
+		box[2] = pereg.boxTop;
+		box[3] = pereg.boxBottom;
+	}
+
+	bool operator==(const Result& o) const
+	{
+		return efb == o.efb && !memcmp(box, o.box, sizeof(box));
+	}
+};
+
+class SoftwareRasterizerTest : public testing::Test
+{
+protected:
+	virtual void SetUp()
+	{
+		SetupBPMem();
+		TevJit::Invalidate();
+		Rasterizer::Init();
+		Rasterizer::SetScissor();
+	}
+
+	virtual void TearDown()
+	{
+		Rasterizer::Shutdown();
+		TevJit::Shutdown();
+		g_SWVideoConfig.rasterizerThreads = 0;
+		g_SWVideoConfig.bTevJit = true;
+	}
+
+	void Clear()
+	{
+		memset(efb, 0, EfbInterface::DEPTH_BUFFER_START);
+		memset(efb + EfbInterface::DEPTH_BUFFER_START, 0xFF, sizeof(efb) - EfbInterface::DEPTH_BUFFER_START);
+		memset(&SWPixelEngine::pereg, 0, sizeof(SWPixelEngine::pereg));
+	}
+};
+
+}
+
+// Drawing in tiles must give the same EFB and bounding box as
+// drawing one triangle after the other, for small and large triangles.
+TEST_F(SoftwareRasterizerTest, ThreadedMatchesSerial)
+{
+	const float sizes[] = { 8.0f, 60.0f, 300.0f };
+	const u32 thread_counts[] = { 2, 3, 8 };
+
+	for (float size : sizes)
+	{
+		std::vector<Vertices> triangles = RandomTriangles(1000, size, (u32)size);
+
+		Clear();
+		Draw(triangles, 1);
+		Result expected;
+		EXPECT_NE(0u, expected.box[1]);
+
+		for (u32 threads : thread_counts)
+		{
+			Clear();
+			Draw(triangles, threads);
+			EXPECT_TRUE(expected == Result()) << "size " << size << ", " << threads << " threads";
+		}
+	}
+}
+
+// The same with random TEV setups. Their stages read the registers, the
+// texture color and the indirect texture coordinates, which mustn't depend
+// on which pixels a thread drew before, with the JIT or without.
+TEST_F(SoftwareRasterizerTest, ThreadedMatchesSerialWithRandomTev)
+{
+	const u32 thread_counts[] = { 2, 3, 8 };
+
+	for (u32 seed = 0; seed < 12; ++seed)
+	{
+		std::vector<Vertices> triangles = RandomTriangles(300, 60.0f, seed);
+		SetupRandomTev(triangles, seed);
+		std::mt19937 rng(seed + 2000);
+		bpmem.genMode.numtevstages = 1 + rng() % 15;
+		for (int i = 0; i < 4; ++i)
+			bpmem.tevind[rng() % 16].hex = rng();
+		TevJit::Invalidate();
+		g_SWVideoConfig.bTevJit = (seed & 1) != 0;
+
+		Clear();
+		Draw(triangles, 1);
+		Result expected;
+
+		for (u32 threads : thread_counts)
+		{
+			Clear();
+			Draw(triangles, threads);
+			EXPECT_TRUE(expected == Result()) << "seed " << seed << ", " << threads << " threads";
+		}
+	}
+}
+
+// Triangles drawn with one thread after queued ones still go on top.
+TEST_F(SoftwareRasterizerTest, ChangingThreadCount)
+{
+	std::vector<Vertices> first = RandomTriangles(500, 100.0f, 1);
+	std::vector<Vertices> second = RandomTriangles(500, 100.0f, 2);
+
+	Clear();
+	Draw(first, 1);
+	Draw(second, 1);
+	Result expected;
+
+	Clear();
+	Draw(first, 4);
+	Draw(second, 1);
+	EXPECT_TRUE(expected == Result());
+}
+
+// The SSE4.1 paths must give exactly the same pixels as the plain C++ ones.
+TEST_F(SoftwareRasterizerTest, SSE4MatchesScalar)
+{
+	if (!cpu_info.bSSE4_1)
+		return;
+
+	g_SWVideoConfig.bTevJit = false;
+	for (u32 seed = 0; seed < 20; ++seed)
+	{
+		std::vector<Result> results;
+		for (int sse4 = 0; sse4 < 2; ++sse4)
+		{
+			Rasterizer::Init();
+			std::vector<Vertices> triangles = RandomTriangles(200, 60.0f, seed);
+			SetupRandomTev(triangles, seed);
+
+			cpu_info.bSSE4_1 = sse4 != 0;
+			Clear();
+			Draw(triangles, 1);
+			results.push_back(Result());
+		}
+		EXPECT_TRUE(results[0] == results[1]) << "seed " << seed;
+	}
+}
+
+// The compiled TEV stages must give exactly the same pixels as the
+// interpreter, with indirect stages and the alpha test as well.
+TEST_F(SoftwareRasterizerTest, TevJitMatchesInterpreter)
+{
+	for (u32 seed = 0; seed < 40; ++seed)
+	{
+		std::vector<Result> results;
+		for (int jit = 0; jit < 2; ++jit)
+		{
+			Rasterizer::Init();
+			std::vector<Vertices> triangles = RandomTriangles(200, 60.0f, seed);
+			SetupRandomTev(triangles, seed);
+
+			// Setups with compare modes stay with the interpreter, so most
+			// go without.
+			std::mt19937 rng(seed + 1000);
+			if (seed % 4)
+			{
+				for (auto& combiner : bpmem.combiners)
+				{
+					if (combiner.colorC.bias == 3) combiner.colorC.bias = 0;
+					if (combiner.alphaC.bias == 3) combiner.alphaC.bias = 0;
+				}
+			}
+			bpmem.alpha_test.hex = rng();
+			bpmem.tevind[rng() % 16].hex = rng();
+			TevJit::Invalidate();
+
+			g_SWVideoConfig.bTevJit = jit != 0;
+			Clear();
+			Draw(triangles, 1);
+			results.push_back(Result());
+		}
+		EXPECT_TRUE(results[0] == results[1]) << "seed " << seed;
+	}
+}
+
+TEST_F(SoftwareRasterizerTest, TevJitLeavesCompareModesToInterpreter)
+{
+	Tev tev;
+	tev.Init();
+
+	bpmem.genMode.numtevstages = 1;
+	EXPECT_TRUE(TevJit::GetFunction(tev) != nullptr);
+
+	// Only looked at again after an invalidation.
+	bpmem.combiners[1].alphaC.bias = 3;
+	EXPECT_TRUE(TevJit::GetFunction(tev) != nullptr);
+	TevJit::Invalidate();
+	EXPECT_TRUE(TevJit::GetFunction(tev) == nullptr);
+
+	// Unused stages don't matter.
+	bpmem.genMode.numtevstages = 0;
+	TevJit::Invalidate();
+	EXPECT_TRUE(TevJit::GetFunction(tev) != nullptr);
+}
+
+// Drawing speed on 1 to all threads.
+// Run with --gtest_also_run_disabled_tests.
+TEST_F(SoftwareRasterizerTest, DISABLED_Benchmark)
+{
+	const float sizes[] = { 8.0f, 40.0f, 200.0f };
+	const int repeats = 10;
+	const u32 all_threads = Common::GetNumWorkerThreads();
+
+	for (float size : sizes)
+	{
+		std::vector<Vertices> triangles = RandomTriangles(2000, size, 1);
+
+		long long serial_us = 0;
+		for (u32 threads = 1; threads <= all_threads; ++threads)
+		{
+			Clear();
+			auto start = std::chrono::high_resolution_clock::now();
+			for (int i = 0; i < repeats; ++i)
+				Draw(triangles, threads);
+			auto end = std::chrono::high_resolution_clock::now();
+			long long us = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / repeats;
+			if (threads == 1)
+				serial_us = us;
+
+			printf("size %3.0f: %2u threads %7lld us (%.2fx)\n", size, threads, us, (double)serial_us / us);
+		}
+	}
+}
+
+// Drawing speed with and without the SSE4.1 paths.
+// Run with --gtest_also_run_disabled_tests.
+TEST_F(SoftwareRasterizerTest, DISABLED_BenchmarkSSE4)
+{
+	if (!cpu_info.bSSE4_1)
+		return;
+
+	g_SWVideoConfig.bTevJit = false;
+	const int repeats = 10;
+	std::vector<Vertices> triangles = RandomTriangles(2000, 40.0f, 1);
+	SetupRandomTev(triangles, 1);
+	bpmem.genMode.numtevstages = 3;
+
+	long long us[2];
+	for (int pass = 0; pass < 2; ++pass)
+	{
+		cpu_info.bSSE4_1 = pass != 0;
+		Clear();
+		auto start = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < repeats; ++i)
+			Draw(triangles, 1);
+		auto end = std::chrono::high_resolution_clock::now();
+		us[pass] = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / repeats;
+	}
+
+	printf("scalar %lld us, SSE4.1 %lld us (%.2fx)\n", us[0], us[1], (double)us[0] / us[1]);
+}
+
+// Drawing speed with interpreted and compiled TEV stages.
+// Run with --gtest_also_run_disabled_tests.
+TEST_F(SoftwareRasterizerTest, DISABLED_BenchmarkTevJit)
+{
+	const int repeats = 10;
+	const u32 stage_counts[] = { 1, 4, 16 };
+
+	for (u32 stages : stage_counts)
+	{
+		std::vector<Vertices> triangles = RandomTriangles(2000, 40.0f, 1);
+		SetupRandomTev(triangles, 1);
+		bpmem.genMode.numtevstages = stages - 1;
+		for (auto& combiner : bpmem.combiners)
+		{
+			if (combiner.colorC.bias == 3) combiner.colorC.bias = 0;
+			if (combiner.alphaC.bias == 3) combiner.alphaC.bias = 0;
+		}
+
+		long long us[2];
+		for (int pass = 0; pass < 2; ++pass)
+		{
+			g_SWVideoConfig.bTevJit = pass != 0;
+			Clear();
+			auto start = std::chrono::high_resolution_clock::now();
+			for (int i = 0; i < repeats; ++i)
+				Draw(triangles, 1);
+			auto end = std::chrono::high_resolution_clock::now();
+			us[pass] = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / repeats;
+		}
+
+		printf("%2u stages: interpreter %lld us, JIT %lld us (%.2fx)\n", stages, us[0], us[1], (double)us[0] / us[1]);
+	}
+}
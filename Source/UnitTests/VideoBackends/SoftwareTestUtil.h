@@ -0,0 +1,55 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstring>
+
+#include "VideoCommon/BPMemory.h"
+#include "VideoCommon/VideoCommon.h"
+
+// One stage passing the rasterized color through, blended on top of what's
+// there, so that the order of the triangles matters.
+inline void SetupBPMem()
+{
+	memset(&bpmem, 0, sizeof(bpmem));
+
+	bpmem.genMode.numcolchans = 1;
+	bpmem.combiners[0].colorC.a = TEVCOLORARG_ZERO;
+	bpmem.combiners[0].colorC.b = TEVCOLORARG_ZERO;
+	bpmem.combiners[0].colorC.c = TEVCOLORARG_ZERO;
+	bpmem.combiners[0].colorC.d = TEVCOLORARG_RASC;
+	bpmem.combiners[0].colorC.clamp = 1;
+	bpmem.combiners[0].alphaC.a = TEVALPHAARG_ZERO;
+	bpmem.combiners[0].alphaC.b = TEVALPHAARG_ZERO;
+	bpmem.combiners[0].alphaC.c = TEVALPHAARG_ZERO;
+	bpmem.combiners[0].alphaC.d = TEVALPHAARG_RASA;
+	bpmem.combiners[0].alphaC.clamp = 1;
+	bpmem.tevksel[0].swap1 = 0;
+	bpmem.tevksel[0].swap2 = 1;
+	bpmem.tevksel[1].swap1 = 2;
+	bpmem.tevksel[1].swap2 = 3;
+
+	bpmem.alpha_test.comp0 = AlphaTest::ALWAYS;
+	bpmem.alpha_test.comp1 = AlphaTest::ALWAYS;
+
+	bpmem.zcontrol.pixel_format = PEControl::RGBA6_Z24;
+	bpmem.zmode.testenable = 1;
+	bpmem.zmode.func = ZMode::LEQUAL;
+	bpmem.zmode.updateenable = 1;
+
+	bpmem.blendmode.blendenable = 1;
+	bpmem.blendmode.colorupdate = 1;
+	bpmem.blendmode.alphaupdate = 1;
+	bpmem.blendmode.srcfactor = BlendMode::SRCALPHA;
+	bpmem.blendmode.dstfactor = BlendMode::INVSRCALPHA;
+
+	// The whole EFB.
+	bpmem.scissorOffset.x = 171;
+	bpmem.scissorOffset.y = 171;
+	bpmem.scissorTL.x = 342;
+	bpmem.scissorTL.y = 342;
+	bpmem.scissorBR.x = 342 + EFB_WIDTH - 1;
+	bpmem.scissorBR.y = 342 + EFB_HEIGHT - 1;
+}
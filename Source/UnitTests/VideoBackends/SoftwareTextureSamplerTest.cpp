@@ -0,0 +1,216 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "Common/CommonTypes.h"
+#include "Core/HW/Memmap.h"
+#include "VideoBackends/Software/SWStatistics.h"
+#include "VideoBackends/Software/SWVideoConfig.h"
+#include "VideoBackends/Software/TextureSampler.h"
+#include "VideoCommon/BPMemory.h"
+#include "VideoCommon/TextureDecoder.h"
+
+extern u8 texMem[TMEM_SIZE];
+
+namespace Memory
+{
+extern u8 *m_pPhysicalRAM;
+}
+
+namespace
+{
+
+const u32 TEXTURE_ADDRESS = 0x00100000;
+const u32 TLUT_OFFSET = 0x40000;
+
+void SetTexture(u8 texmap, u32 address, int width, int height, int format)
+{
+	FourTexUnits& unit = bpmem.tex[texmap >> 2];
+	int i = texmap & 3;
+	unit.texImage0[i].width = width - 1;
+	unit.texImage0[i].height = height - 1;
+	unit.texImage0[i].format = format;
+	unit.texImage1[i].image_type = 0;
+	unit.texImage3[i].image_base = address >> 5;
+	unit.texTlut[i].tmem_offset = TLUT_OFFSET >> 9;
+	unit.texTlut[i].tlut_format = 1;
+	// Wrap in one direction, mirror in the other, blend between mip levels.
+	unit.texMode0[i].wrap_s = 1;
+	unit.texMode0[i].wrap_t = 2;
+	unit.texMode0[i].min_filter = 2;
+}
+
+void FillRandom(u8 *dst, size_t size, std::mt19937& rng)
+{
+	for (size_t i = 0; i < size; ++i)
+		dst[i] = (u8)rng();
+}
+
+class SoftwareTextureSamplerTest : public testing::Test
+{
+protected:
+	virtual void SetUp()
+	{
+		m_ram.assign(Memory::RAM_SIZE, 0);
+		Memory::m_pPhysicalRAM = &m_ram[0];
+		memset(&bpmem, 0, sizeof(bpmem));
+		memset(texMem, 0, TMEM_SIZE);
+		g_SWVideoConfig.textureCacheSize = 64;
+		swstats.ResetFrame();
+	}
+
+	virtual void TearDown()
+	{
+		TextureSampler::Shutdown();
+		Memory::m_pPhysicalRAM = nullptr;
+	}
+
+	u32 Sample(s32 s, s32 t, s32 lod, bool linear, u8 texmap)
+	{
+		u8 sample[4];
+		TextureSampler::Sample(s, t, lod, linear, texmap, sample);
+		u32 result;
+		memcpy(&result, sample, 4);
+		return result;
+	}
+
+	std::vector<u8> m_ram;
+};
+
+}
+
+TEST_F(SoftwareTextureSamplerTest, CachedMatchesDecoded)
+{
+	const int formats[] = {
+		GX_TF_I4, GX_TF_I8, GX_TF_IA4, GX_TF_IA8, GX_TF_RGB565, GX_TF_RGB5A3,
+		GX_TF_RGBA8, GX_TF_C4, GX_TF_C8, GX_TF_C14X2, GX_TF_CMPR,
+	};
+	const int width = 64, height = 32;
+
+	std::mt19937 rng(1);
+	FillRandom(&m_ram[TEXTURE_ADDRESS], 0x10000, rng);
+	FillRandom(texMem, TMEM_SIZE, rng);
+
+	for (int format : formats)
+	{
+		// One texture in main memory, and one preloaded into TMEM.
+		SetTexture(1, TEXTURE_ADDRESS, width, height, format);
+		SetTexture(6, TEXTURE_ADDRESS, width, height, format);
+		bpmem.tex[1].texImage1[2].image_type = 1;
+		bpmem.tex[1].texImage1[2].tmem_even = 0x100;
+		bpmem.tex[1].texImage2[2].tmem_odd = 0x4000;
+
+		std::uniform_int_distribution<s32> coord(-4 * width * 128, 4 * width * 128);
+		std::uniform_int_distribution<s32> lod(0, 5 << 4);
+		for (int i = 0; i < 2000; ++i)
+		{
+			s32 s = coord(rng), t = coord(rng), l = lod(rng);
+			bool linear = (i & 1) != 0;
+			u8 texmap = (i & 2) ? 6 : 1;
+
+			g_SWVideoConfig.textureCacheSize = 0;
+			TextureSampler::Invalidate();
+			u32 expected = Sample(s, t, l, linear, texmap);
+
+			g_SWVideoConfig.textureCacheSize = 64;
+			TextureSampler::Invalidate();
+			EXPECT_EQ(expected, Sample(s, t, l, linear, texmap)) << "format " << format << ", sample " << i;
+		}
+	}
+	EXPECT_LT(0u, swstats.thisFrame.textureCacheHits);
+}
+
+TEST_F(SoftwareTextureSamplerTest, NoticesChanges)
+{
+	SetTexture(0, TEXTURE_ADDRESS, 8, 4, GX_TF_I8);
+	m_ram[TEXTURE_ADDRESS] = 0x10;
+	EXPECT_EQ(0x10101010u, Sample(0, 0, 0, false, 0));
+
+	// Nothing is checked again until the next invalidation.
+	m_ram[TEXTURE_ADDRESS] = 0x20;
+	EXPECT_EQ(0x10101010u, Sample(0, 0, 0, false, 0));
+	TextureSampler::Invalidate();
+	EXPECT_EQ(0x20202020u, Sample(0, 0, 0, false, 0));
+	TextureSampler::Invalidate();
+	EXPECT_EQ(0x20202020u, Sample(0, 0, 0, false, 0));
+
+	EXPECT_EQ(2u, swstats.thisFrame.textureCacheMisses);
+	EXPECT_EQ(1u, swstats.thisFrame.textureCacheHits);
+
+	// Changing the palette changes the texture as well.
+	SetTexture(0, TEXTURE_ADDRESS, 8, 4, GX_TF_C8);
+	TextureSampler::Invalidate();
+	m_ram[TEXTURE_ADDRESS] = 1;
+	texMem[TLUT_OFFSET + 2] = 0x00;
+	texMem[TLUT_OFFSET + 3] = 0x40;
+	u32 before = Sample(0, 0, 0, false, 0);
+	texMem[TLUT_OFFSET + 3] = 0x80;
+	TextureSampler::Invalidate();
+	EXPECT_NE(before, Sample(0, 0, 0, false, 0));
+}
+
+TEST_F(SoftwareTextureSamplerTest, EvictsLeastRecentlyUsed)
+{
+	// 256 kB, 512 kB and 512 kB decoded, one more than fits.
+	g_SWVideoConfig.textureCacheSize = 1;
+	const u32 addresses[] = { TEXTURE_ADDRESS, TEXTURE_ADDRESS + 0x20000, TEXTURE_ADDRESS + 0x40000 };
+	const int widths[] = { 256, 512, 512 };
+
+	std::mt19937 rng(2);
+	FillRandom(&m_ram[TEXTURE_ADDRESS], 0x60000, rng);
+
+	// Textures in use stay, even over the budget.
+	u32 expected[3];
+	for (int i = 0; i < 3; ++i)
+	{
+		SetTexture(i, addresses[i], widths[i], 256, GX_TF_I8);
+		expected[i] = Sample(100 << 7, 100 << 7, 0, false, i);
+	}
+	for (int i = 0; i < 3; ++i)
+		EXPECT_EQ(expected[i], Sample(100 << 7, 100 << 7, 0, false, i));
+	EXPECT_EQ(3u, swstats.thisFrame.textureCacheMisses);
+
+	// The first texture is the oldest once they aren't.
+	TextureSampler::Invalidate();
+	EXPECT_EQ(expected[2], Sample(100 << 7, 100 << 7, 0, false, 2));
+	EXPECT_EQ(expected[1], Sample(100 << 7, 100 << 7, 0, false, 1));
+	EXPECT_EQ(2u, swstats.thisFrame.textureCacheHits);
+	EXPECT_EQ(expected[0], Sample(100 << 7, 100 << 7, 0, false, 0));
+	EXPECT_EQ(4u, swstats.thisFrame.textureCacheMisses);
+}
+
+// Speed of bilinear sampling from a CMPR texture, with and without the cache.
+// Run with --gtest_also_run_disabled_tests.
+TEST_F(SoftwareTextureSamplerTest, DISABLED_Benchmark)
+{
+	const int size = 256;
+	const int samples = 4000000;
+
+	std::mt19937 rng(3);
+	FillRandom(&m_ram[TEXTURE_ADDRESS], size * size, rng);
+	SetTexture(0, TEXTURE_ADDRESS, size, size, GX_TF_CMPR);
+
+	long long us[2];
+	u32 sum[2] = {};
+	for (int pass = 0; pass < 2; ++pass)
+	{
+		g_SWVideoConfig.textureCacheSize = pass ? 64 : 0;
+		TextureSampler::Invalidate();
+
+		auto start = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < samples; ++i)
+			sum[pass] += Sample((i * 37) & 0x7FFFF, (i / 1024 * 91) & 0x7FFFF, 0, true, 0);
+		auto end = std::chrono::high_resolution_clock::now();
+		us[pass] = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+	}
+
+	EXPECT_EQ(sum[0], sum[1]);
+	printf("decoded %lld us, cached %lld us (%.2fx)\n", us[0], us[1], (double)us[0] / us[1]);
+}
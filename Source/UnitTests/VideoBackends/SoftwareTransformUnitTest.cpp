@@ -0,0 +1,217 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "Common/CommonTypes.h"
+#include "VideoBackends/Software/NativeVertexFormat.h"
+#include "VideoBackends/Software/TransformUnit.h"
+#include "VideoBackends/Software/XFMemLoader.h"
+#include "VideoCommon/BPMemory.h"
+
+namespace
+{
+
+void RandomFloats(u32 *dst, size_t count, std::mt19937 &rng)
+{
+	std::uniform_real_distribution<float> value(-2.0f, 2.0f);
+	for (size_t i = 0; i < count; ++i)
+	{
+		const float f = value(rng);
+		memcpy(&dst[i], &f, sizeof(f));
+	}
+}
+
+// Matrices, lights, channels and texgens set up at random, with every kind
+// of light and texgen the transform unit handles.
+void RandomXFMem(std::mt19937 &rng, bool specialCase)
+{
+	InitXFMemory();
+	memset(&bpmem, 0, sizeof(bpmem));
+
+	RandomFloats(swxfregs.posMatrices, 256, rng);
+	RandomFloats(swxfregs.normalMatrices, 96, rng);
+	RandomFloats(swxfregs.postMatrices, 256, rng);
+	RandomFloats(swxfregs.lights, 128, rng);
+	for (int i = 0; i < 8; ++i)
+		swxfregs.lights[0x10 * i + 3] = rng();
+
+	swxfregs.projection.type = rng() % 2 ? GX_PERSPECTIVE : GX_ORTHOGRAPHIC;
+	RandomFloats((u32*)swxfregs.projection.rawProjection, 6, rng);
+
+	swxfregs.nNumChans = rng() % 3;
+	for (int chan = 0; chan < 2; ++chan)
+	{
+		swxfregs.ambColor[chan] = rng();
+		swxfregs.matColor[chan] = rng();
+		for (LitChannel *channel : { &swxfregs.color[chan], &swxfregs.alpha[chan] })
+		{
+			channel->hex = rng();
+			channel->diffusefunc = rng() % 3;
+		}
+		// Only alpha lights treat the invalid attenuation as specular.
+		if (swxfregs.color[chan].attnfunc == 2)
+			swxfregs.color[chan].attnfunc = 3;
+	}
+
+	swxfregs.dualTexTrans = rng() % 2;
+	swxfregs.numTexGens = rng() % 9;
+	for (int i = 0; i < 8; ++i)
+	{
+		TexMtxInfo &texinfo = swxfregs.texMtxInfo[i];
+		texinfo.hex = rng();
+		texinfo.texgentype = rng() % 4;
+		texinfo.inputform = rng() % 2;
+		if (texinfo.texgentype == XF_TEXGEN_REGULAR)
+		{
+			const u32 rows[] = {
+				XF_SRCGEOM_INROW, XF_SRCNORMAL_INROW, XF_SRCBINORMAL_T_INROW, XF_SRCBINORMAL_B_INROW,
+				XF_SRCTEX0_INROW + (u32)(rng() % 8),
+			};
+			texinfo.sourcerow = rows[rng() % 5];
+			if (specialCase)
+				texinfo.projection = XF_TEXPROJ_ST;
+		}
+		else if (texinfo.texgentype != XF_TEXGEN_EMBOSS_MAP)
+		{
+			texinfo.sourcerow = XF_SRCCOLORS_INROW;
+			texinfo.inputform = XF_TEXINPUT_AB11;
+		}
+
+		swxfregs.postMtxInfo[i].hex = rng();
+		swxfregs.postMtxInfo[i].index = rng() % 62;
+
+		bpmem.texcoords[i].s.scale_minus_1 = rng();
+		bpmem.texcoords[i].t.scale_minus_1 = rng();
+	}
+}
+
+std::vector<InputVertexData> RandomVertices(u32 count, std::mt19937 &rng, bool sharedMatrix)
+{
+	std::uniform_real_distribution<float> value(-2.0f, 2.0f);
+	std::vector<InputVertexData> vertices(count);
+	const u8 posMtx = 3 * (rng() % 11);
+	for (InputVertexData &v : vertices)
+	{
+		v.posMtx = sharedMatrix ? posMtx : 3 * (rng() % 11);
+		for (u8 &texMtx : v.texMtx)
+			texMtx = sharedMatrix ? posMtx : 3 * (rng() % 20);
+		v.position = Vec3(value(rng), value(rng), value(rng));
+		for (Vec3 &normal : v.normal)
+			normal = Vec3(value(rng), value(rng), value(rng));
+		for (auto &color : v.color)
+			for (u8 &comp : color)
+				comp = (u8)rng();
+		for (auto &coord : v.texCoords)
+			for (float &comp : coord)
+				comp = value(rng);
+	}
+	return vertices;
+}
+
+// Whatever the last vertices left, which some texgens and unlit normals read.
+std::vector<OutputVertexData> RandomOutput(u32 count, std::mt19937 &rng)
+{
+	std::vector<u32> data(count * sizeof(OutputVertexData) / sizeof(u32));
+	RandomFloats(data.data(), data.size(), rng);
+	std::vector<OutputVertexData> output(count);
+	memcpy(output.data(), data.data(), count * sizeof(OutputVertexData));
+	return output;
+}
+
+void TransformOneAtATime(const InputVertexData *src, OutputVertexData *dst, u32 count, bool hasNormal, bool nbt, bool specialCase)
+{
+	for (u32 i = 0; i < count; ++i)
+	{
+		TransformUnit::TransformPosition(&src[i], &dst[i]);
+		if (hasNormal)
+			TransformUnit::TransformNormal(&src[i], nbt, &dst[i]);
+		TransformUnit::TransformColor(&src[i], &dst[i]);
+		TransformUnit::TransformTexCoord(&src[i], &dst[i], specialCase);
+	}
+}
+
+}
+
+// Batches must come out exactly as the vertices one at a time, whether or not
+// the vertices share their matrices, and with counts that leave some over.
+TEST(SoftwareTransformUnit, BatchMatchesOneAtATime)
+{
+	std::mt19937 rng(0);
+
+	for (int i = 0; i < 2000; ++i)
+	{
+		const bool specialCase = rng() % 4 == 0;
+		const bool hasNormal = rng() % 4 != 0;
+		const bool nbt = rng() % 2 != 0;
+		const bool sharedMatrix = rng() % 2 != 0;
+		const u32 count = rng() % 23;
+
+		RandomXFMem(rng, specialCase);
+		std::vector<InputVertexData> input = RandomVertices(count, rng, sharedMatrix);
+		std::vector<OutputVertexData> expected = RandomOutput(count, rng);
+		std::vector<OutputVertexData> output = expected;
+
+		TransformOneAtATime(input.data(), expected.data(), count, hasNormal, nbt, specialCase);
+		TransformUnit::TransformVertices(input.data(), output.data(), count, hasNormal, nbt, specialCase);
+
+		for (u32 v = 0; v < count; ++v)
+		{
+			ASSERT_EQ(0, memcmp(&expected[v], &output[v], sizeof(OutputVertexData)))
+				<< "case " << i << ", vertex " << v << " of " << count;
+		}
+	}
+}
+
+// Time to transform lit, textured vertices one at a time and in batches. Run
+// with --gtest_also_run_disabled_tests.
+TEST(SoftwareTransformUnit, DISABLED_Benchmark)
+{
+	std::mt19937 rng(1);
+	RandomXFMem(rng, false);
+	swxfregs.nNumChans = 2;
+	swxfregs.numTexGens = 2;
+	for (int chan = 0; chan < 2; ++chan)
+	{
+		for (LitChannel *channel : { &swxfregs.color[chan], &swxfregs.alpha[chan] })
+		{
+			channel->enablelighting = 1;
+			channel->lightMask0_3 = 0xf;
+			channel->lightMask4_7 = 0;
+			channel->attnfunc = 3;
+			channel->diffusefunc = LIGHTDIF_CLAMP;
+		}
+	}
+	for (int i = 0; i < 2; ++i)
+	{
+		swxfregs.texMtxInfo[i].texgentype = XF_TEXGEN_REGULAR;
+		swxfregs.texMtxInfo[i].sourcerow = XF_SRCTEX0_INROW + i;
+	}
+
+	const u32 count = 256;
+	std::vector<InputVertexData> input = RandomVertices(count, rng, true);
+	std::vector<OutputVertexData> output = RandomOutput(count, rng);
+
+	long long us[2];
+	for (int batched = 0; batched < 2; ++batched)
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < 2000; ++i)
+		{
+			if (batched)
+				TransformUnit::TransformVertices(input.data(), output.data(), count, true, false, false);
+			else
+				TransformOneAtATime(input.data(), output.data(), count, true, false, false);
+		}
+		auto end = std::chrono::high_resolution_clock::now();
+		us[batched] = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+	}
+
+	printf("one at a time %lld us, batched %lld us (%.2fx)\n", us[0], us[1], (double)us[0] / us[1]);
+}
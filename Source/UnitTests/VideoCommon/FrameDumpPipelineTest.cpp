@@ -0,0 +1,206 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <vector>
+#include <gtest/gtest.h>
+#include <zlib.h>
+
+#include "Common/CommonTypes.h"
+#include "Common/Thread.h"
+#include "VideoBackends/Software/EfbInterface.h"
+#include "VideoCommon/BPMemory.h"
+#include "VideoCommon/FrameDumpPipeline.h"
+#include "VideoCommon/VideoCommon.h"
+
+namespace
+{
+
+void NoConversion(FrameDumpPipeline::Frame& frame)
+{
+	frame.converted = frame.data;
+}
+
+// BGR24 to planar YUV 4:2:0, the way the FFmpeg dumper converts frames for
+// most codecs.
+void ConvertToYUV(FrameDumpPipeline::Frame& frame)
+{
+	const int w = frame.width, h = frame.height;
+	frame.converted.resize(w * h + 2 * (w / 2) * (h / 2));
+	u8* y_plane = &frame.converted[0];
+	u8* u_plane = y_plane + w * h;
+	u8* v_plane = u_plane + (w / 2) * (h / 2);
+	for (int y = 0; y < h; ++y)
+	{
+		const u8* bgr = &frame.data[y * w * 3];
+		for (int x = 0; x < w; ++x, bgr += 3)
+		{
+			y_plane[y * w + x] = (u8)((25 * bgr[0] + 129 * bgr[1] + 66 * bgr[2] + 128 + 16 * 256) >> 8);
+			if (!(x & 1) && !(y & 1) && x / 2 < w / 2 && y / 2 < h / 2)
+			{
+				u_plane[(y / 2) * (w / 2) + x / 2] = (u8)((112 * bgr[0] - 74 * bgr[1] - 38 * bgr[2] + 128 + 128 * 256) >> 8);
+				v_plane[(y / 2) * (w / 2) + x / 2] = (u8)((-18 * bgr[0] - 94 * bgr[1] + 112 * bgr[2] + 128 + 128 * 256) >> 8);
+			}
+		}
+	}
+}
+
+// zlib standing in for the video codec, which the tests don't link.
+struct Compressor
+{
+	Compressor() : total(0) {}
+
+	void operator()(FrameDumpPipeline::Frame& frame)
+	{
+		uLongf size = compressBound((uLong)frame.converted.size());
+		output.resize(size);
+		compress2(output.data(), &size, frame.converted.data(), (uLong)frame.converted.size(), 1);
+		total += size;
+	}
+
+	std::vector<u8> output;
+	u64 total;
+};
+
+}
+
+// Frames come out of both stages in the order they went in, each with what
+// it was added with, and all are finished before the pipeline goes away.
+TEST(FrameDumpPipeline, Order)
+{
+	std::vector<u64> numbers;
+	std::vector<u8> contents;
+	{
+		FrameDumpPipeline pipeline(3, NoConversion, [&](FrameDumpPipeline::Frame& frame) {
+			numbers.push_back(frame.number);
+			contents.push_back(frame.converted[0]);
+			EXPECT_EQ(frame.width * 2, (int)frame.converted.size());
+		});
+
+		for (int i = 0; i < 100; ++i)
+		{
+			const u8 data[] = { (u8)i, (u8)(i + 1), 0, 0, 0, 0, 0, 0 };
+			pipeline.AddFrame(data, 2 * (1 + i % 4), 1 + i % 4, 1);
+		}
+	}
+
+	ASSERT_EQ(100u, numbers.size());
+	for (u32 i = 0; i < 100; ++i)
+	{
+		EXPECT_EQ(i, numbers[i]);
+		EXPECT_EQ((u8)i, contents[i]);
+	}
+}
+
+// A slow encoder makes AddFrame wait once the buffers are used up, and the
+// waits are counted. No frame is dropped.
+TEST(FrameDumpPipeline, BackPressure)
+{
+	u32 encoded = 0;
+	FrameDumpPipeline pipeline(2, NoConversion, [&](FrameDumpPipeline::Frame&) {
+		Common::SleepCurrentThread(5);
+		encoded++;
+	});
+
+	const u8 data[4] = {};
+	for (int i = 0; i < 10; ++i)
+		pipeline.AddFrame(data, sizeof(data), 1, 1);
+	pipeline.Flush();
+
+	FrameDumpPipeline::Stats stats = pipeline.GetStats();
+	EXPECT_EQ(10u, encoded);
+	EXPECT_EQ(10u, stats.frames_added);
+	EXPECT_EQ(10u, stats.frames_encoded);
+	EXPECT_GE(stats.stalls, 6u);
+	EXPECT_GT(stats.stall_us, 0u);
+}
+
+// Frames from the software renderer's EFB, read back as the frame dumpers
+// get them, converted and compressed on the rendering thread and then through
+// the pipeline. Run with --gtest_also_run_disabled_tests.
+TEST(FrameDumpPipeline, DISABLED_Benchmark)
+{
+	memset(&bpmem, 0, sizeof(bpmem));
+	bpmem.zcontrol.pixel_format = PEControl::RGB8_Z24;
+	bpmem.blendmode.colorupdate = 1;
+	bpmem.blendmode.alphaupdate = 1;
+
+	const int frames = 120;
+	const int width = EFB_WIDTH, height = EFB_HEIGHT;
+	std::vector<u8> rgba(width * height * 4), bgr(width * height * 3);
+	EFBRectangle rect(0, 0, width, height);
+
+	// Renders a frame and reads it back bottom up, as BGR.
+	auto render = [&](int frame) {
+		for (int y = 0; y < height; ++y)
+		{
+			for (int x = 0; x < width; ++x)
+			{
+				u8 color[4] = { 0xFF, (u8)(x + frame), (u8)(y * 2), (u8)((x ^ y) + frame * 3) };
+				EfbInterface::SetColor(x, y, color);
+			}
+		}
+		EfbInterface::BypassXFB(rgba.data(), width, height, rect, 1.0f);
+		for (int y = 0; y < height; ++y)
+		{
+			const u8* src = &rgba[(height - 1 - y) * width * 4];
+			u8* dst = &bgr[y * width * 3];
+			for (int x = 0; x < width; ++x, src += 4, dst += 3)
+			{
+				dst[0] = src[2];
+				dst[1] = src[1];
+				dst[2] = src[0];
+			}
+		}
+	};
+
+	double ms[3];
+	u64 compressed[2];
+
+	auto start = std::chrono::high_resolution_clock::now();
+	for (int i = 0; i < frames; ++i)
+		render(i);
+	ms[0] = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+	{
+		Compressor compressor;
+		FrameDumpPipeline::Frame frame;
+		start = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < frames; ++i)
+		{
+			render(i);
+			frame.data.assign(bgr.begin(), bgr.end());
+			frame.width = width;
+			frame.height = height;
+			ConvertToYUV(frame);
+			compressor(frame);
+		}
+		ms[1] = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		compressed[0] = compressor.total;
+	}
+
+	FrameDumpPipeline::Stats stats;
+	{
+		Compressor compressor;
+		FrameDumpPipeline pipeline(6, ConvertToYUV, std::ref(compressor));
+		start = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < frames; ++i)
+		{
+			render(i);
+			pipeline.AddFrame(bgr.data(), bgr.size(), width, height);
+		}
+		pipeline.Flush();
+		ms[2] = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		stats = pipeline.GetStats();
+		compressed[1] = compressor.total;
+	}
+
+	EXPECT_EQ(compressed[0], compressed[1]);
+	printf("%d frames of %dx%d: rendering alone %.1f ms, dumping on the rendering thread %.1f ms, "
+	       "through the pipeline %.1f ms (%u stalls, %u ms waiting)\n",
+	       frames, width, height, ms[0], ms[1], ms[2], (u32)stats.stalls, (u32)(stats.stall_us / 1000));
+}
@@ -0,0 +1,169 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "Common/CommonTypes.h"
+#include "Common/ParallelFor.h"
+#include "VideoCommon/TextureDecoder.h"
+
+extern u8 texMem[TMEM_SIZE];
+
+namespace
+{
+
+const int FORMATS[] = {
+	GX_TF_I4, GX_TF_I8, GX_TF_IA4, GX_TF_IA8, GX_TF_RGB565, GX_TF_RGB5A3,
+	GX_TF_RGBA8, GX_TF_C4, GX_TF_C8, GX_TF_C14X2, GX_TF_CMPR,
+};
+
+const int TLUT_ADDRESS = 0x80000;
+
+std::vector<u8> RandomBytes(size_t size, u32 seed)
+{
+	std::mt19937 rng(seed);
+	std::vector<u8> data(size);
+	for (u8& b : data)
+		b = (u8)rng();
+	return data;
+}
+
+std::vector<u8> Decode(const std::vector<u8>& src, int width, int height, int format, int tlutfmt, bool rgba)
+{
+	// Poisoned, so writes past the image would show up as a mismatch.
+	std::vector<u8> dst(width * height * 4 + 64, 0xCD);
+	TexDecoder_Decode(&dst[0], &src[0], width, height, format, TLUT_ADDRESS, tlutfmt, rgba);
+	return dst;
+}
+
+bool IsPaletted(int format)
+{
+	return format == GX_TF_C4 || format == GX_TF_C8 || format == GX_TF_C14X2;
+}
+
+class TextureDecoderTest : public testing::Test
+{
+protected:
+	virtual void SetUp()
+	{
+		std::vector<u8> palette = RandomBytes(0x8000, 1);
+		memcpy(texMem + TLUT_ADDRESS, &palette[0], palette.size());
+	}
+
+	virtual void TearDown()
+	{
+		TexDecoder_SetNumThreads(1);
+	}
+};
+
+}
+
+// Splitting a texture into bands must not change a single texel, for every
+// format and for sizes that don't split evenly.
+TEST_F(TextureDecoderTest, ThreadedMatchesSerial)
+{
+	const int sizes[][2] = { { 8, 8 }, { 256, 256 }, { 1000, 600 } };
+	const int thread_counts[] = { 3, 8 };
+
+	for (int format : FORMATS)
+	{
+		for (const auto& size : sizes)
+		{
+			const int width = size[0], height = size[1];
+			std::vector<u8> src = RandomBytes(TexDecoder_GetTextureSizeInBytes(width, height, format), format + width);
+
+			for (int tlutfmt = 0; tlutfmt < (IsPaletted(format) ? 3 : 1); ++tlutfmt)
+			{
+				for (int rgba = 0; rgba < 2; ++rgba)
+				{
+					TexDecoder_SetNumThreads(1);
+					std::vector<u8> expected = Decode(src, width, height, format, tlutfmt, rgba != 0);
+
+					for (int threads : thread_counts)
+					{
+						TexDecoder_SetNumThreads(threads);
+						EXPECT_TRUE(expected == Decode(src, width, height, format, tlutfmt, rgba != 0))
+							<< "format " << format << ", " << width << "x" << height << ", tlut format " << tlutfmt
+							<< ", rgba " << rgba << ", " << threads << " threads";
+					}
+				}
+			}
+		}
+	}
+}
+
+TEST_F(TextureDecoderTest, LevelsMatchSingleDecodes)
+{
+	TexDecoder_SetNumThreads(4);
+
+	for (int format : FORMATS)
+	{
+		const int bw = TexDecoder_GetBlockWidthInTexels(format) - 1;
+		const int bh = TexDecoder_GetBlockHeightInTexels(format) - 1;
+
+		std::vector<TexDecoderLevel> levels;
+		std::vector<std::vector<u8>> sources, outputs;
+		for (int width = 1024, height = 512; width; width /= 2, height = std::max(1, height / 2))
+		{
+			const int expanded_width = (width + bw) & ~bw;
+			const int expanded_height = (height + bh) & ~bh;
+			sources.push_back(RandomBytes(TexDecoder_GetTextureSizeInBytes(expanded_width, expanded_height, format), width));
+			outputs.push_back(std::vector<u8>(expanded_width * expanded_height * 4));
+			TexDecoderLevel level = { nullptr, nullptr, expanded_width, expanded_height };
+			levels.push_back(level);
+		}
+		for (size_t i = 0; i < levels.size(); ++i)
+		{
+			levels[i].dst = &outputs[i][0];
+			levels[i].src = &sources[i][0];
+		}
+
+		TexDecoder_DecodeLevels(&levels[0], (int)levels.size(), format, TLUT_ADDRESS, 1);
+
+		for (size_t i = 0; i < levels.size(); ++i)
+		{
+			std::vector<u8> expected(outputs[i].size());
+			TexDecoder_Decode(&expected[0], &sources[i][0], levels[i].width, levels[i].height, format, TLUT_ADDRESS, 1);
+			EXPECT_TRUE(expected == outputs[i]) << "format " << format << ", level " << i;
+		}
+	}
+}
+
+// Decoding speed of every format, on one thread and on all of them.
+// Run with --gtest_also_run_disabled_tests.
+TEST_F(TextureDecoderTest, DISABLED_Benchmark)
+{
+	const int sizes[] = { 128, 256, 512, 1024 };
+	const int repeats = 20;
+	const int all_threads = (int)Common::GetNumWorkerThreads();
+
+	for (int format : FORMATS)
+	{
+		for (int size : sizes)
+		{
+			std::vector<u8> src = RandomBytes(TexDecoder_GetTextureSizeInBytes(size, size, format), format);
+			std::vector<u8> dst(size * size * 4);
+
+			long long us[2];
+			for (int pass = 0; pass < 2; ++pass)
+			{
+				TexDecoder_SetNumThreads(pass ? all_threads : 1);
+				auto start = std::chrono::high_resolution_clock::now();
+				for (int i = 0; i < repeats; ++i)
+					TexDecoder_Decode(&dst[0], &src[0], size, size, format, TLUT_ADDRESS, 1);
+				auto end = std::chrono::high_resolution_clock::now();
+				us[pass] = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / repeats;
+			}
+
+			printf("format %2d %4dx%-4d: 1 thread %6lld us, %d threads %6lld us\n",
+			       format, size, size, us[0], all_threads, us[1]);
+		}
+	}
+}
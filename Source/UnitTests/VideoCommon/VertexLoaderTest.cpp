@@ -0,0 +1,244 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/CPUDetect.h"
+#include "VideoCommon/CPMemory.h"
+#include "VideoCommon/DataReader.h"
+#include "VideoCommon/NativeVertexFormat.h"
+#include "VideoCommon/VertexLoader.h"
+#include "VideoCommon/VertexManagerBase.h"
+#include "VideoCommon/VideoConfig.h"
+
+// After the emitter, which has an instruction named after the gtest macro.
+#include <gtest/gtest.h>
+
+extern NativeVertexFormat *g_nativeVertexFmt;
+
+namespace
+{
+
+class TestVertexFormat : public NativeVertexFormat
+{
+public:
+	void Initialize(const PortableVertexDeclaration &vtx_decl) override { vertex_stride = vtx_decl.stride; }
+	void SetupVertexPointers() override {}
+};
+
+class TestVertexManager : public VertexManager
+{
+public:
+	NativeVertexFormat* CreateNativeVertexFormat() override { return new TestVertexFormat; }
+
+protected:
+	void ResetBuffer(u32 stride) override {}
+
+private:
+	void vFlush(bool useDstAlpha) override {}
+};
+
+// Enough for any 16 bit index with any of the strides below, and the 16
+// bytes the SSE loaders read at a time.
+const size_t ARRAY_SIZE = 0x10000 * 8 + 64;
+
+// Arrays for every attribute, with random data and strides.
+struct Arrays
+{
+	std::vector<u8> data[12];
+
+	explicit Arrays(std::mt19937 &rng)
+	{
+		for (int i = 0; i < 12; ++i)
+		{
+			data[i].resize(ARRAY_SIZE);
+			for (u8 &b : data[i])
+				b = (u8)rng();
+			cached_arraybases[i] = data[i].data();
+			arraystrides[i] = rng() % 8;
+		}
+	}
+};
+
+// A vertex description and attribute formats, all valid but otherwise
+// random, with a position always.
+void RandomFormat(std::mt19937 &rng, TVtxDesc &desc, VAT &vat)
+{
+	desc.Hex = ((u64)rng() << 32 | rng()) & ((1ull << 33) - 1);
+	if (desc.Position == NOT_PRESENT)
+		desc.Position = 1 + rng() % 3;
+
+	vat.g0.Hex = rng();
+	vat.g1.Hex = rng();
+	vat.g2.Hex = rng();
+	vat.g0.ByteDequant = 1;
+	vat.g0.PosFormat %= 5;
+	vat.g0.NormalFormat %= 5;
+	vat.g0.Color0Comp %= 6;
+	vat.g0.Color1Comp %= 6;
+	vat.g0.Tex0CoordFormat %= 5;
+	vat.g1.Tex1CoordFormat %= 5;
+	vat.g1.Tex2CoordFormat %= 5;
+	vat.g1.Tex3CoordFormat %= 5;
+	vat.g1.Tex4CoordFormat %= 5;
+	vat.g2.Tex5CoordFormat %= 5;
+	vat.g2.Tex6CoordFormat %= 5;
+	vat.g2.Tex7CoordFormat %= 5;
+}
+
+// Converts the vertices in src with a loader generated with or without the
+// attributes in line, and returns what it wrote.
+std::vector<u8> Convert(const TVtxDesc &desc, const VAT &vat, bool inlined, const std::vector<u8> &src, int count)
+{
+	g_ActiveConfig.bInlineVertexLoaders = inlined;
+	std::unique_ptr<VertexLoader> loader(new VertexLoader(desc, vat));
+
+	// Poisoned, so a difference in what isn't written shows up too.
+	std::vector<u8> dst(count * sizeof(float) * 64 + 64, 0xCD);
+	g_pVideoData = const_cast<u8*>(src.data());
+	VertexManager::s_pCurBufferPointer = dst.data();
+	g_VtxAttr[0] = vat;
+	g_nativeVertexFmt = nullptr;
+	loader->SetupRunVertices(0, 0, count);
+	loader->ConvertVertices(count);
+
+	EXPECT_EQ(src.data() + count * loader->GetVertexSize(), g_pVideoData);
+	const int stride = g_nativeVertexFmt->GetVertexStride();
+	EXPECT_EQ(dst.data() + count * stride, VertexManager::s_pCurBufferPointer);
+	dst.resize(count * stride);
+	return dst;
+}
+
+class VertexLoaderTest : public testing::Test
+{
+protected:
+	virtual void SetUp()
+	{
+		m_vertex_manager.reset(new TestVertexManager);
+		g_vertex_manager = m_vertex_manager.get();
+		g_ActiveConfig.bUseBBox = false;
+	}
+
+	virtual void TearDown()
+	{
+		g_ActiveConfig.bInlineVertexLoaders = true;
+		g_vertex_manager = nullptr;
+		m_vertex_manager.reset();
+	}
+
+	std::unique_ptr<VertexManager> m_vertex_manager;
+};
+
+}
+
+// Loaders with the attributes generated in line must load every format
+// exactly as the ones calling the C loaders.
+TEST_F(VertexLoaderTest, InlineMatchesCalls)
+{
+	if (!cpu_info.bSSSE3)
+		return;
+
+	std::mt19937 rng(0);
+	Arrays arrays(rng);
+
+	for (int i = 0; i < 3000; ++i)
+	{
+		TVtxDesc desc;
+		VAT vat;
+		RandomFormat(rng, desc, vat);
+		const int count = 1 + rng() % 20;
+
+		// Random vertices, with room for reading past the last one.
+		std::vector<u8> src(count * 128 + 16);
+		for (u8 &b : src)
+			b = (u8)rng();
+
+		const std::vector<u8> expected = Convert(desc, vat, false, src, count);
+		const std::vector<u8> output = Convert(desc, vat, true, src, count);
+		ASSERT_TRUE(expected == output) << "case " << i << ", desc " << std::hex << desc.Hex
+			<< ", vat " << vat.g0.Hex << " " << vat.g1.Hex << " " << vat.g2.Hex;
+	}
+}
+
+// Time to load the vertex formats games commonly use, with and without the
+// attributes in line. Run with --gtest_also_run_disabled_tests.
+TEST_F(VertexLoaderTest, DISABLED_Benchmark)
+{
+	std::mt19937 rng(1);
+	Arrays arrays(rng);
+
+	struct Format
+	{
+		const char *name;
+		TVtxDesc desc;
+		VAT vat;
+	};
+	Format formats[3];
+	for (Format &format : formats)
+	{
+		format.desc.Hex = 0;
+		format.vat.g0.Hex = 0;
+		format.vat.g1.Hex = 0;
+		format.vat.g2.Hex = 0;
+		format.vat.g0.ByteDequant = 1;
+		format.vat.g0.PosElements = 1;
+	}
+
+	formats[0].name = "P I16-s16 N I16-s8 C0 I16-8888 T0 I16-s16";
+	formats[0].desc.Position = INDEX16;
+	formats[0].desc.Normal = INDEX16;
+	formats[0].desc.Color0 = INDEX16;
+	formats[0].desc.Tex0Coord = INDEX16;
+	formats[0].vat.g0.PosFormat = FORMAT_SHORT;
+	formats[0].vat.g0.PosFrac = 8;
+	formats[0].vat.g0.NormalFormat = FORMAT_BYTE;
+	formats[0].vat.g0.Color0Elements = 1;
+	formats[0].vat.g0.Color0Comp = FORMAT_32B_8888;
+	formats[0].vat.g0.Tex0CoordElements = 1;
+	formats[0].vat.g0.Tex0CoordFormat = FORMAT_SHORT;
+	formats[0].vat.g0.Tex0Frac = 10;
+
+	formats[1].name = "PM P flt T0 flt";
+	formats[1].desc.PosMatIdx = 1;
+	formats[1].desc.Position = DIRECT;
+	formats[1].desc.Tex0Coord = DIRECT;
+	formats[1].vat.g0.PosFormat = FORMAT_FLOAT;
+	formats[1].vat.g0.Tex0CoordElements = 1;
+	formats[1].vat.g0.Tex0CoordFormat = FORMAT_FLOAT;
+
+	formats[2].name = "P I16-flt N I16-flt T0 I16-flt";
+	formats[2].desc.Position = INDEX16;
+	formats[2].desc.Normal = INDEX16;
+	formats[2].desc.Tex0Coord = INDEX16;
+	formats[2].vat.g0.PosFormat = FORMAT_FLOAT;
+	formats[2].vat.g0.NormalFormat = FORMAT_FLOAT;
+	formats[2].vat.g0.Tex0CoordElements = 1;
+	formats[2].vat.g0.Tex0CoordFormat = FORMAT_FLOAT;
+
+	const int count = 10000;
+	std::vector<u8> src(count * 128 + 16);
+	for (u8 &b : src)
+		b = (u8)rng();
+
+	for (const Format &format : formats)
+	{
+		long long us[2];
+		for (int inlined = 0; inlined < 2; ++inlined)
+		{
+			auto start = std::chrono::high_resolution_clock::now();
+			for (int i = 0; i < 100; ++i)
+				Convert(format.desc, format.vat, inlined != 0, src, count);
+			auto end = std::chrono::high_resolution_clock::now();
+			us[inlined] = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+		}
+
+		printf("%s: calls %lld us, in line %lld us (%.2fx)\n", format.name, us[0], us[1], (double)us[0] / us[1]);
+	}
+}